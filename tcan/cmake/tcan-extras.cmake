@@ -0,0 +1,10 @@
+# tcan_allocation_tracker replaces the global operator new, so it is not part of tcan_LIBRARIES. Link ${tcan_ALLOCATION_TRACKER_LIBRARIES}
+# only to tests and debug builds (see AllocationTracker.hpp).
+if(TARGET tcan_allocation_tracker)
+  set(tcan_ALLOCATION_TRACKER_LIBRARIES tcan_allocation_tracker)
+else()
+  find_library(tcan_ALLOCATION_TRACKER_LIBRARIES tcan_allocation_tracker
+    PATHS "${CMAKE_CURRENT_LIST_DIR}/../../../lib"
+    NO_DEFAULT_PATH
+  )
+endif()
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tcan {
+
+/*!
+ * Debug tool which records heap allocations of the real-time threads of tcan (see markRealtimeThread()) after a steady state marker.
+ * Linking the library tcan_allocation_tracker replaces the global operator new and delete of the executable. Use it in tests and debug
+ * builds only.
+ */
+class AllocationTracker {
+ public:
+    static constexpr unsigned int maxNumFrames = 16;
+    static constexpr unsigned int maxNumRecords = 64;
+
+    //! Allocation with the backtrace of the allocating thread. Return addresses can be resolved with addr2line or getReport().
+    struct Record {
+        std::size_t size_;
+        int numFrames_;
+        void* frames_[maxNumFrames];
+    };
+
+    /*!
+     * Steady state marker: clears the recorded allocations and starts recording. Call this after all buses and devices are initialized
+     * and the cyclic operation has run for a few cycles (queues have grown to their steady state size, etc.).
+     */
+    static void markSteadyState();
+
+    //! Stops recording. The recorded allocations are kept.
+    static void stopRecording();
+
+    static bool isRecording();
+
+    //! @return number of allocations since the steady state marker. May be larger than the number of records.
+    static unsigned int getNumAllocations();
+
+    //! @return the first maxNumRecords allocations since the steady state marker
+    static std::vector<Record> getRecords();
+
+    //! @return list of the recorded allocations with symbolized backtraces
+    static std::string getReport();
+};
+
+} // namespace tcan
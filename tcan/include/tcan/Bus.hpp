@@ -1,25 +1,40 @@
 #pragma once
 
-#include <deque>
+#include <algorithm> // min(..)
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <limits>
 #include <memory>
+#include <poll.h>
 
 #include "tcan/BusOptions.hpp"
+#include "tcan/Clock.hpp"
+#include "tcan/IoUringEngine.hpp"
+#include "tcan/PriorityInheritanceMutex.hpp"
+#include "tcan/RingBuffer.hpp"
+#include "tcan/TraceRecorder.hpp"
 #include "tcan/helper_functions.hpp"
+#include "tcan/probes.hpp"
 
 #include "message_logger/message_logger.hpp"
 
 
 namespace tcan {
 
+class DeviceStateTable;
+
+//! Identifier of a message shown in traces (see TraceRecorder). Overload it in the namespace of the message type, e.g. with the COB id.
+template <class Msg>
+inline uint32_t getTraceId(const Msg& /*msg*/) { return 0; }
+
 template <class Msg>
-class Bus {
+class Bus : public IoUringEngine::Client {
  public:
 
-    using MsgQueue = std::deque<Msg>;
+    using MsgQueue = RingBuffer<Msg>;
 
     Bus() = delete;
     Bus(std::unique_ptr<BusOptions>&& options):
@@ -34,15 +49,27 @@ class Bus {
             receiveThread_(),
             transmitThread_(),
             sanityCheckThread_(),
+            threadStartMutex_(),
             running_{false},
             condTransmitThread_(),
             condOutputQueueEmpty_(),
+            ioUringEngine_{nullptr},
+            numIoUringTransmitsInFlight_(0),
             errorMsgFlagPersistent_{false},
-            errorMsgFlag_(false)
+            errorMsgFlag_(false),
+            nextSanityCheckTime_(Clock::now() + std::chrono::milliseconds(options_->sanityCheckInterval_)),
+            traceTrack_(TraceRecorder::getTrack(options_->name_))
     {
+        // the output queue is shared between the real-time bus threads and the application
+        if(!outgoingMsgsMutex_.isPriorityInheritanceEnabled()) {
+            MELO_WARN("Failed to enable priority inheritance on output queue mutex of bus %s", options_->name_.c_str());
+        }
+
+        // sending messages does not allocate memory as long as the queue does not exceed its maximum size
+        outgoingMsgs_.reserve(options_->maxQueueSize_);
     }
 
-    virtual ~Bus()
+    ~Bus() override
     {
         stopThreads(true);
     }
@@ -65,20 +92,67 @@ class Bus {
     virtual bool sanityCheck() = 0;
 
     /*!
-     * Starts threads for this bus (send, recieve, sanity check) if it is configured to be asynchronous
+     * Lets an io_uring engine read and write the interface instead of the receive and transmit threads (see BusOptions::useIoUring_).
+     * Is called by the BusManager before startThreads(). The engine serves the bus until stopThreads(true).
+     * @return false if the bus is not asynchronous, already running or does not support io_uring. It then uses its threads.
+     */
+    bool attachIoUringEngine(IoUringEngine& engine) {
+        if(ioUringEngine_ != nullptr) {
+            return (ioUringEngine_ == &engine);
+        }
+        if(!isAsynchronous() || running_) {
+            return false;
+        }
+
+        IoUringEngine::Endpoint endpoint;
+        if(!initializeIoUringEndpoint(endpoint)) {
+            MELO_WARN("Bus %s does not support io_uring in its configuration. It uses its receive and transmit threads.", options_->name_.c_str());
+            return false;
+        }
+        if(!engine.addClient(this, endpoint)) {
+            MELO_WARN("Failed to add bus %s to the io_uring engine. It uses its receive and transmit threads.", options_->name_.c_str());
+            return false;
+        }
+        ioUringEngine_ = &engine;
+        return true;
+    }
+
+    //! @return true if the bus is read and written by an io_uring engine
+    inline bool isIoUringEngineAttached() const { return ioUringEngine_ != nullptr; }
+
+    /*!
+     * Starts threads for this bus (send, recieve, sanity check) if it is configured to be asynchronous. Without receive and transmit
+     * thread if an io_uring engine is attached.
      */
     void startThreads() {
         if(isAsynchronous() && !running_) {
+            // the threads wait for this lock before entering their loop, such that priority and affinity are set when they start
+            std::lock_guard<std::mutex> guard(threadStartMutex_);
             running_ = true;
 
-            receiveThread_ = std::thread(&Bus::receiveWorker, this);
-            if(!setThreadPriority(receiveThread_, options_->priorityReceiveThread_)) {
-                MELO_WARN("Failed to set receive thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
+            if(options_->lockMemory_ && !lockMemory()) {
+                MELO_WARN("Failed to lock memory for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
             }
 
-            transmitThread_ = std::thread(&Bus::transmitWorker, this);
-            if (!setThreadPriority(transmitThread_, options_->priorityTransmitThread_)) {
-                MELO_WARN("Failed to set transmit thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
+            if(ioUringEngine_ != nullptr) {
+                // the engine reads and writes the interface, and submits the messages queued before the start
+                ioUringEngine_.load()->notify();
+            }else{
+                receiveThread_ = std::thread(&Bus::receiveWorker, this);
+                if(!setThreadPriority(receiveThread_, options_->priorityReceiveThread_)) {
+                    MELO_WARN("Failed to set receive thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
+                }
+                if(!setThreadAffinity(receiveThread_, options_->cpuReceiveThread_)) {
+                    MELO_WARN("Failed to pin receive thread of bus %s to CPU %d:\n  %s", options_->name_.c_str(), options_->cpuReceiveThread_, strerror(errno));
+                }
+
+                transmitThread_ = std::thread(&Bus::transmitWorker, this);
+                if (!setThreadPriority(transmitThread_, options_->priorityTransmitThread_)) {
+                    MELO_WARN("Failed to set transmit thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
+                }
+                if(!setThreadAffinity(transmitThread_, options_->cpuTransmitThread_)) {
+                    MELO_WARN("Failed to pin transmit thread of bus %s to CPU %d:\n  %s", options_->name_.c_str(), options_->cpuTransmitThread_, strerror(errno));
+                }
             }
 
             if(options_->sanityCheckInterval_ > 0) {
@@ -86,18 +160,25 @@ class Bus {
                 if (!setThreadPriority(sanityCheckThread_, options_->prioritySanityCheckThread_)) {
                     MELO_WARN("Failed to set sanity check thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
                 }
+                if(!setThreadAffinity(sanityCheckThread_, options_->cpuSanityCheckThread_)) {
+                    MELO_WARN("Failed to pin sanity check thread of bus %s to CPU %d:\n  %s", options_->name_.c_str(), options_->cpuSanityCheckThread_, strerror(errno));
+                }
             }
+
+            startAdditionalThreads();
         }
     }
 
     /*!
      * Stops all threads handled by this bus (send, receive, sanity check)
-     * @param wait  whether the function shall wait for the the threads to terminate or return immediately.
+     * @param wait  whether the function shall wait for the the threads to terminate or return immediately. Also detaches the io_uring
+     *              engine, messages which were not written yet are dropped.
      */
     void stopThreads(const bool wait=true) {
         running_ = false;
         condTransmitThread_.notify_all();
         condOutputQueueEmpty_.notify_all();
+        Clock::notifySleepers();
 
         if(wait) {
             if(receiveThread_.joinable()) {
@@ -111,6 +192,13 @@ class Bus {
             if(sanityCheckThread_.joinable()) {
                 sanityCheckThread_.join();
             }
+
+            joinAdditionalThreads();
+
+            IoUringEngine* engine = ioUringEngine_.exchange(nullptr);
+            if(engine != nullptr) {
+                engine->removeClient(this);
+            }
         }
     }
 
@@ -118,7 +206,7 @@ class Bus {
      * @param msg	const reference to the message to be sent
      */
     inline bool sendMessage(const Msg& msg) {
-        std::lock_guard<std::mutex> guard(outgoingMsgsMutex_);
+        std::lock_guard<PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
         return sendMessageWithoutLock(msg);
     }
 
@@ -127,7 +215,7 @@ class Bus {
      * @param msg   message to be sent
      */
     inline bool emplaceMessage(Msg&& msg) {
-        std::lock_guard<std::mutex> guard(outgoingMsgsMutex_);
+        std::lock_guard<PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
         return emplaceMessageWithoutLock(std::forward<Msg>(msg));
     }
 
@@ -136,7 +224,7 @@ class Bus {
      */
     inline void activate() {
         isPassive_ = false;
-        condTransmitThread_.notify_all(); // kick off transmit thread in case it has been waiting because the bus was passive
+        notifyTransmitter(); // kick off transmit thread in case it has been waiting because the bus was passive
     }
 
     /*!
@@ -191,6 +279,17 @@ class Bus {
      */
     unsigned int getNumOutgoingMessagesWithoutLock() const { return isPassive() ? 0 : outgoingMsgs_.size(); }
 
+    /*!
+     * Checks whether a message of the output queue may be written now and moves it to the front of the queue. Derived buses may hold
+     * back messages (e.g. for rate limiting), see releaseFrontMessageWithoutLock(..). Call it only before writeMessages(..), as it
+     * reorders the queue. The output queue has to be locked by the caller (if protected).
+     * @return  true if the message at the front of the output queue may be written. false if the queue is empty or the bus is passive
+     */
+    inline bool hasMessageToWriteWithoutLock() {
+        std::chrono::steady_clock::time_point retryTime;
+        return getNumOutgoingMessagesWithoutLock() > 0 && releaseFrontMessageWithoutLock(retryTime);
+    }
+
     /*!
      * @return  returns the name of the bus
      */
@@ -219,13 +318,13 @@ class Bus {
 
 public: /// Internal functions
     /*!
-     * write the message(s) at the front of the queue to the CAN bus
+     * write the message(s) at the front of the queue to the CAN bus. Check hasMessageToWriteWithoutLock() before calling this function.
      * @param lock
      * @return true if a message was successfully written to the bus or if the bus is passive
      */
-    inline bool writeMessages(std::unique_lock<std::mutex>* lock)
+    inline bool writeMessages(std::unique_lock<PriorityInheritanceMutex>* lock)
     {
-        return isPassive_ ? true : writeData( lock );
+        return isPassive_ ? true : writeFrontMessage( lock );
     }
 
     /*! read and parse a message from the bus
@@ -234,10 +333,7 @@ public: /// Internal functions
     inline bool readMessage()
     {
         if(readData()) {
-            if(isPassive_ && options_->activateBusOnReception_ && !errorMsgFlag_) {
-                isPassive_ = false;
-                MELO_WARN("Auto-activated bus %s", options_->name_.c_str());
-            }
+            handleReception();
             return true;
         }
         return false;
@@ -247,10 +343,10 @@ public: /// Internal functions
      * Waits until the output queue is empty, locks the queue and returns the lock.
      * This function shall only be called for asynchronous buses.
      */
-    void waitForEmptyQueue(std::unique_lock<std::mutex>& lock)
+    void waitForEmptyQueue(std::unique_lock<PriorityInheritanceMutex>& lock)
     {
-        lock = std::unique_lock<std::mutex>(outgoingMsgsMutex_);
-        condOutputQueueEmpty_.wait(lock, [this]{ return getNumOutgoingMessagesWithoutLock() == 0 || !running_; });
+        lock = std::unique_lock<PriorityInheritanceMutex>(outgoingMsgsMutex_);
+        condOutputQueueEmpty_.wait(lock, [this]{ return (getNumOutgoingMessagesWithoutLock() == 0 && numIoUringTransmitsInFlight_ == 0) || !running_; });
     }
 
     /*! Get a file descriptor, used for polling multiple buses for incoming messages. Required for semi-synchronous buses.
@@ -261,7 +357,181 @@ public: /// Internal functions
         return 0;
     }
 
-    inline std::mutex& getOutgoingMsgsMutex() { return outgoingMsgsMutex_; }
+    inline PriorityInheritanceMutex& getOutgoingMsgsMutex() { return outgoingMsgsMutex_; }
+
+    /*!
+     * Registers the devices of the bus in a state table, which they update on state transitions (see BusManager::getDeviceStateTable()).
+     * Devices added later are registered as well. Is called by the bus manager when the bus is added, and with nullptr when it is removed.
+     * Call this function from the thread adding and removing devices.
+     * @param table state table, nullptr to unregister the devices
+     */
+    virtual void setDeviceStateTable(DeviceStateTable* /*table*/) { }
+
+    /*! @name External event loop integration
+     * Lets a host event loop (epoll, asio, ..) drive a synchronous bus instead of calling the BusManager's synchronous functions from
+     * a timer. tcan creates no threads for synchronous buses, and the functions below do not block if
+     * BusOptions::synchronousBlockingWrite_ is false.
+     * The host loop waits for getPollEvents() on getPollableFileDescriptor() and until getNextTimerDeadline(), then calls onReadable(),
+     * onWritable() and onTimer() accordingly. getPollEvents() and getNextTimerDeadline() change when messages are queued, so query
+     * them again after each iteration.
+     */
+    ///@{
+
+    //! @return POLLIN, combined with POLLOUT if a message of the output queue may be written now
+    short getPollEvents() {
+        std::lock_guard<PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+        std::chrono::steady_clock::time_point retryTime;
+        return (getNumOutgoingMessagesWithoutLock() > 0 && peekReleasableMessageWithoutLock(retryTime)) ? (POLLIN | POLLOUT) : POLLIN;
+    }
+
+    /*!
+     * @return the time at which onTimer() has to be called: the next sanity check (which also checks SDO timeouts of the devices),
+     *         or the time at which a held back message of the output queue may be written. time_point::max() if there is none.
+     */
+    std::chrono::steady_clock::time_point getNextTimerDeadline() {
+        std::chrono::steady_clock::time_point deadline = (options_->sanityCheckInterval_ > 0) ? nextSanityCheckTime_ : std::chrono::steady_clock::time_point::max();
+
+        std::lock_guard<PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+        std::chrono::steady_clock::time_point retryTime;
+        if(getNumOutgoingMessagesWithoutLock() > 0 && !peekReleasableMessageWithoutLock(retryTime)) {
+            deadline = std::min(deadline, retryTime);
+        }
+        return deadline;
+    }
+
+    /*!
+     * Reads and handles the messages available on the interface.
+     * @param maxNumMessages    maximum number of messages to handle, to bound the time spent in this call on a flooded bus
+     * @return number of messages handled
+     */
+    unsigned int onReadable(const unsigned int maxNumMessages = std::numeric_limits<unsigned int>::max()) {
+        unsigned int numMessages = 0;
+        while(numMessages < maxNumMessages && readMessage()) {
+            ++numMessages;
+        }
+        return numMessages;
+    }
+
+    /*!
+     * Writes messages of the output queue until it is empty, the interface would block or the remaining messages are held back.
+     * @return false if a write error occurred
+     */
+    bool onWritable() {
+        std::unique_lock<PriorityInheritanceMutex> lock(outgoingMsgsMutex_);
+        while(hasMessageToWriteWithoutLock()) {
+            if(!writeMessages(&lock)) {
+                return !hasBusError_;
+            }
+        }
+        return true;
+    }
+
+    /*!
+     * Runs the sanity check if it is due. Held back messages which became writable are reported by getPollEvents().
+     * @param now   current time
+     */
+    void onTimer(const std::chrono::steady_clock::time_point& now = Clock::now()) {
+        if(options_->sanityCheckInterval_ > 0 && now >= nextSanityCheckTime_) {
+            sanityCheck();
+            // do not catch up on missed checks
+            const std::chrono::milliseconds interval(options_->sanityCheckInterval_);
+            nextSanityCheckTime_ += interval;
+            if(nextSanityCheckTime_ <= now) {
+                nextSanityCheckTime_ = now + interval;
+            }
+        }
+    }
+    ///@}
+
+    /*! @name io_uring engine client
+     * Called by the completion loop of the attached io_uring engine, see attachIoUringEngine(..).
+     */
+    ///@{
+
+    unsigned int prepareIoUringTransmits(IoUringEngine::TransmitBuffer* buffers, const unsigned int numBuffers,
+                                         std::chrono::steady_clock::time_point& wakeupTime) override {
+        std::lock_guard<PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+        if(!running_) {
+            return 0;
+        }
+
+        std::chrono::steady_clock::time_point scheduleTime = std::chrono::steady_clock::time_point::max();
+        queueScheduledMessagesWithoutLock(scheduleTime);
+        wakeupTime = std::min(wakeupTime, scheduleTime);
+
+        // a message counts as written when it is submitted, so rate limits and schedules see it in time
+        unsigned int numPrepared = 0;
+        while(numPrepared < numBuffers && getNumOutgoingMessagesWithoutLock() > 0) {
+            std::chrono::steady_clock::time_point retryTime;
+            if(!releaseFrontMessageWithoutLock(retryTime)) {
+                wakeupTime = std::min(wakeupTime, retryTime);
+                break;
+            }
+
+            IoUringEngine::TransmitBuffer& buffer = buffers[numPrepared];
+            buffer.traceId_ = getTraceId(outgoingMsgs_.front());
+            TCAN_PROBE2(dequeued, options_->name_.c_str(), buffer.traceId_);
+            const int length = encodeIoUringMessage(outgoingMsgs_.front(), buffer.data_, buffer.capacity_);
+            outgoingMsgs_.pop_front();
+            if(length < 0) {
+                MELO_ERROR("Message %x of bus %s does not fit into an io_uring transmit buffer. Dropping message!", buffer.traceId_, options_->name_.c_str());
+                TCAN_PROBE2(write_failed, options_->name_.c_str(), buffer.traceId_);
+                TraceRecorder::instant("write failed", traceTrack_, buffer.traceId_);
+                continue;
+            }
+
+            buffer.length_ = length;
+            TraceRecorder::instant("submit", traceTrack_, buffer.traceId_);
+            handleFrontMessageWritten();
+            ++numPrepared;
+        }
+
+        numIoUringTransmitsInFlight_ += numPrepared;
+        if(numIoUringTransmitsInFlight_ == 0 && getNumOutgoingMessagesWithoutLock() == 0) {
+            condOutputQueueEmpty_.notify_all();
+        }
+        return numPrepared;
+    }
+
+    void handleIoUringWritten(const IoUringEngine::TransmitBuffer& buffer, const int result) override {
+        if(result == static_cast<int>(buffer.length_)) {
+            hasBusError_ = false;
+            TCAN_PROBE2(written, options_->name_.c_str(), buffer.traceId_);
+        }else{
+            // the writes linked to a failed one are cancelled
+            if(result != -ECANCELED) {
+                MELO_ERROR("Error at sending message %x on bus %s (return value=%d):\n  %s", buffer.traceId_, options_->name_.c_str(), result,
+                           (result < 0) ? strerror(-result) : "incomplete write");
+                hasBusError_ = true;
+            }
+            TCAN_PROBE2(write_failed, options_->name_.c_str(), buffer.traceId_);
+            TraceRecorder::instant("write failed", traceTrack_, buffer.traceId_);
+        }
+
+        std::lock_guard<PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+        if(--numIoUringTransmitsInFlight_ == 0 && getNumOutgoingMessagesWithoutLock() == 0) {
+            condOutputQueueEmpty_.notify_all();
+        }
+    }
+
+    void handleIoUringReceived(uint8_t* data, const unsigned int length) override {
+        if(!running_) {
+            return;
+        }
+        hasBusError_ = false;
+        handleIoUringData(data, length);
+        handleReception();
+    }
+
+    void handleIoUringReceiveError(const int error) override {
+        if(error == 0) {
+            MELO_ERROR("Interface of bus %s was closed.", options_->name_.c_str());
+        }else{
+            MELO_ERROR("Failed to read data from bus %s: (%d)\n  %s", options_->name_.c_str(), -error, strerror(-error));
+        }
+        hasBusError_ = true;
+    }
+    ///@}
 
  protected:
     /*! Initialized the device driver
@@ -283,13 +553,93 @@ public: /// Internal functions
      *                  Use nullptr if queue is unprotected.
      * @return          True if no error occurred
      */
-    virtual bool writeData(std::unique_lock<std::mutex>* lock) = 0;
+    virtual bool writeData(std::unique_lock<PriorityInheritanceMutex>* lock) = 0;
 
     /*! Is called after reception of a message, routes the message to the callbacks.
      * @param cmsg  reference to the can message
      */
     virtual void handleMessage(const Msg& msg) = 0;
 
+    /*! Is called before the message at the front of the output queue is written, with the output queue locked (if protected) and not empty.
+     * Derived buses may hold back messages by moving a message which is allowed to be written now to the front of the queue.
+     * @param retryTime earliest time at which a held back message may be written. Only valid if false is returned.
+     * @return          true if the message at the front of the output queue may be written now
+     */
+    virtual bool releaseFrontMessageWithoutLock(std::chrono::steady_clock::time_point& /*retryTime*/) { return true; }
+
+    /*! Like releaseFrontMessageWithoutLock(..), but neither reorders the output queue nor changes the state of the bus. Is called by
+     * queries like getPollEvents(), with the output queue locked (if protected) and not empty.
+     * @param retryTime earliest time at which a held back message may be written. Only valid if false is returned.
+     * @return          true if a message of the output queue may be written now
+     */
+    virtual bool peekReleasableMessageWithoutLock(std::chrono::steady_clock::time_point& /*retryTime*/) const { return true; }
+
+    /*! Is called by the transmit thread of asynchronous buses with the output queue locked. Derived buses may put time-triggered
+     * messages which are due into the output queue.
+     * @param wakeupTime    shall be set to the time at which the next time-triggered message is due. Is time_point::max() if there is none.
+     */
+    virtual void queueScheduledMessagesWithoutLock(std::chrono::steady_clock::time_point& /*wakeupTime*/) { }
+
+    /*! Is called after the message released by releaseFrontMessageWithoutLock(..) has been written successfully, with the output queue locked (if protected).
+     */
+    virtual void handleFrontMessageWritten() { }
+
+    /*! Is called by attachIoUringEngine(..). Buses supporting io_uring set the file descriptor and the buffer sizes of their interface.
+     * @return false if the bus does not support io_uring in its configuration
+     */
+    virtual bool initializeIoUringEndpoint(IoUringEngine::Endpoint& /*endpoint*/) { return false; }
+
+    /*! Is called by the io_uring engine for every chunk received on the interface. Parses it and calls handleMessage(..).
+     * @param data      received data, followed by a spare byte
+     */
+    virtual void handleIoUringData(uint8_t* /*data*/, const unsigned int /*length*/) { }
+
+    /*! Is called by the io_uring engine to serialize a message of the output queue into a transmit buffer.
+     * @return number of bytes, -1 if the message does not fit into the buffer
+     */
+    virtual int encodeIoUringMessage(const Msg& /*msg*/, uint8_t* /*buffer*/, const unsigned int /*capacity*/) { return -1; }
+
+    /*! Is called by startThreads() while threadStartMutex_ is locked. Derived buses may start additional worker threads here, which
+     * shall call initializeWorkerThread(..) and run while running_ is true.
+     */
+    virtual void startAdditionalThreads() { }
+
+    /*! Is called by stopThreads(true) after running_ was cleared, to join the threads started in startAdditionalThreads().
+     * Derived buses with additional threads have to call stopThreads() in their destructor.
+     */
+    virtual void joinAdditionalThreads() { }
+
+    inline bool writeFrontMessage(std::unique_lock<PriorityInheritanceMutex>* lock) {
+        const uint32_t traceId = getTraceId(outgoingMsgs_.front());
+        TraceRecorder::Scope trace("write", traceTrack_, traceId);
+        TCAN_PROBE2(dequeued, options_->name_.c_str(), traceId);
+        if(writeData(lock)) {
+            TCAN_PROBE2(written, options_->name_.c_str(), traceId);
+            handleFrontMessageWritten();
+            return true;
+        }
+        TCAN_PROBE2(write_failed, options_->name_.c_str(), traceId);
+        trace.setName("write failed");
+        return false;
+    }
+
+    //! Wakes up the transmit thread or the io_uring engine after messages were queued or the conditions to write them changed
+    inline void notifyTransmitter() {
+        condTransmitThread_.notify_all();
+        IoUringEngine* engine = ioUringEngine_;
+        if(engine != nullptr) {
+            engine->notify();
+        }
+    }
+
+    //! Is called after a message was received. Activates the bus if configured.
+    inline void handleReception() {
+        if(isPassive_ && options_->activateBusOnReception_ && !errorMsgFlag_) {
+            isPassive_ = false;
+            MELO_WARN("Auto-activated bus %s", options_->name_.c_str());
+        }
+    }
+
     inline bool checkOutgoingMsgsSize() const {
         if(outgoingMsgs_.size() >= options_->maxQueueSize_) {
             MELO_WARN_THROTTLE(options_->errorThrottleTime_, "Exceeding max queue size on bus %s! Dropping message!", getName().c_str());
@@ -301,25 +651,59 @@ public: /// Internal functions
     inline bool sendMessageWithoutLock(const Msg& msg) {
         if(checkOutgoingMsgsSize()) {
             outgoingMsgs_.push_back( msg );
-            condTransmitThread_.notify_all();
+            TraceRecorder::instant("enqueue", traceTrack_, getTraceId(msg));
+            TCAN_PROBE3(enqueued, options_->name_.c_str(), getTraceId(msg), outgoingMsgs_.size() - 1);
+            notifyTransmitter();
             return true;
         }
 
+        TraceRecorder::instant("drop", traceTrack_, getTraceId(msg));
+        TCAN_PROBE3(dropped, options_->name_.c_str(), getTraceId(msg), outgoingMsgs_.size());
         return false;
     }
 
     inline bool emplaceMessageWithoutLock(Msg&& msg) {
         if(checkOutgoingMsgsSize()) {
             outgoingMsgs_.emplace_back( std::forward<Msg>(msg) );
-            condTransmitThread_.notify_all();
+            TraceRecorder::instant("enqueue", traceTrack_, getTraceId(outgoingMsgs_.back()));
+            TCAN_PROBE3(enqueued, options_->name_.c_str(), getTraceId(outgoingMsgs_.back()), outgoingMsgs_.size() - 1);
+            notifyTransmitter();
             return true;
         }
 
+        TraceRecorder::instant("drop", traceTrack_, getTraceId(msg));
+        TCAN_PROBE3(dropped, options_->name_.c_str(), getTraceId(msg), outgoingMsgs_.size());
         return false;
     }
 
     // thread loop functions
+    /*!
+     * Called by the receive and transmit threads before entering their loop. Switches to SCHED_DEADLINE if configured, prefaults the
+     * stack and reports the effective settings.
+     */
+    void initializeWorkerThread(const char* threadName, const int priority, const int cpu, const DeadlineParameters& deadline) {
+        {
+            std::lock_guard<std::mutex> guard(threadStartMutex_);
+        }
+        markRealtimeThread();
+        TraceRecorder::registerThread();
+
+        if(deadline.isEnabled() && !setCurrentThreadDeadline(deadline)) {
+            MELO_WARN("Failed to set SCHED_DEADLINE for %s thread of bus %s:\n  %s", threadName, options_->name_.c_str(), strerror(errno));
+        }
+
+        if(options_->stackPrefaultSize_ > 0) {
+            prefaultStack(options_->stackPrefaultSize_);
+        }
+
+        if(options_->reportRealtimeSettings_) {
+            reportRealtimeSettings(options_->name_ + " " + threadName + " thread", priority, cpu, deadline, options_->lockMemory_);
+        }
+    }
+
     void receiveWorker() {
+        initializeWorkerThread("receive", options_->priorityReceiveThread_, options_->cpuReceiveThread_, options_->deadlineReceiveThread_);
+
         while(running_) {
             readMessage();
         }
@@ -328,33 +712,51 @@ public: /// Internal functions
     }
 
     void transmitWorker() {
-        std::unique_lock<std::mutex> lock(outgoingMsgsMutex_);
+        initializeWorkerThread("transmit", options_->priorityTransmitThread_, options_->cpuTransmitThread_, options_->deadlineTransmitThread_);
+
+        std::unique_lock<PriorityInheritanceMutex> lock(outgoingMsgsMutex_);
 
         while(running_) {
-            while(getNumOutgoingMessagesWithoutLock() == 0 && running_) {
+            // put time-triggered messages which are due to the front of the queue
+            std::chrono::steady_clock::time_point scheduleTime = std::chrono::steady_clock::time_point::max();
+            queueScheduledMessagesWithoutLock(scheduleTime);
+
+            if(getNumOutgoingMessagesWithoutLock() == 0) {
                 condOutputQueueEmpty_.notify_all();
-                condTransmitThread_.wait(lock);
+                waitForTransmitThreadWakeup(lock, scheduleTime);
+                continue; // after the wait function we own the lock. Check running_ and the schedule again.
             }
 
-            // after the wait function we own the lock.
-
-            if(running_) { // check if running_ is still true, otherwise leave loop immediately
-                if(!isPassive_) {
-                    writeData(&lock);
-                }
+            std::chrono::steady_clock::time_point retryTime;
+            if(releaseFrontMessageWithoutLock(retryTime)) {
+                writeFrontMessage(&lock);
+            }else{
+                // all queued messages are held back. Sleep until the first of them may be sent or a new message is queued.
+                waitForTransmitThreadWakeup(lock, std::min(retryTime, scheduleTime));
             }
-
         }
 
         MELO_INFO("transmit thread for bus %s terminated", options_->name_.c_str());
     }
 
+    inline void waitForTransmitThreadWakeup(std::unique_lock<PriorityInheritanceMutex>& lock, const std::chrono::steady_clock::time_point& wakeupTime) {
+        if(wakeupTime == std::chrono::steady_clock::time_point::max()) {
+            condTransmitThread_.wait(lock);
+        }else{
+            Clock::waitUntil(condTransmitThread_, lock, wakeupTime);
+        }
+    }
+
     void sanityCheckWorker() {
-        auto nextLoop = std::chrono::steady_clock::now();
+        markRealtimeThread();
+        TraceRecorder::registerThread();
+        auto nextLoop = Clock::now();
 
         while(running_) {
             nextLoop += std::chrono::milliseconds(options_->sanityCheckInterval_);
-            std::this_thread::sleep_until(nextLoop);
+            if(!Clock::sleepUntil(nextLoop, &running_)) {
+                break;
+            }
 
             sanityCheck();
         }
@@ -381,27 +783,39 @@ public: /// Internal functions
     const std::unique_ptr<BusOptions> options_;
 
     //! output queue containing all messages to be sent by the transmitThread_
-    std::mutex outgoingMsgsMutex_;
+    PriorityInheritanceMutex outgoingMsgsMutex_;
     MsgQueue outgoingMsgs_;
 
     //! threads for message reception and transmission and device sanity checking
     std::thread receiveThread_;
     std::thread transmitThread_;
     std::thread sanityCheckThread_;
+    std::mutex threadStartMutex_;
     std::atomic<bool> running_;
 
     //! variable to wake the transmitThread after inserting something to the message output queue
-    std::condition_variable condTransmitThread_;
+    std::condition_variable_any condTransmitThread_;
 
     //! variable to wait for empty output queues (required for global sync)
-    std::condition_variable condOutputQueueEmpty_;
+    std::condition_variable_any condOutputQueueEmpty_;
+
+    //! io_uring engine reading and writing the interface instead of the receive and transmit threads, nullptr if not attached
+    std::atomic<IoUringEngine*> ioUringEngine_;
+    //! messages submitted to the engine which did not complete yet, protected by outgoingMsgsMutex_
+    unsigned int numIoUringTransmitsInFlight_;
 
     //! flag to indicate the reception of an error message. Can be cleared with resetError().
     std::atomic<bool> errorMsgFlagPersistent_;
 
     //! flag indicating that the last received message was an error message. This flag is reset upon successfull
-    // reception of a non-error message. (No need for thread safety, is only used in readMessage(..) and its sub functions)
-    bool errorMsgFlag_;
+    // reception of a non-error message. Atomic, as buses with several receive threads clear it from each of them.
+    std::atomic<bool> errorMsgFlag_;
+
+    //! time of the next sanity check if the bus is driven by an external event loop, see onTimer()
+    std::chrono::steady_clock::time_point nextSanityCheckTime_;
+
+    //! track of the events of this bus in traces, see TraceRecorder
+    const uint16_t traceTrack_;
 };
 
 } /* namespace tcan */
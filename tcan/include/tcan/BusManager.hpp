@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
+#include <chrono>
+#include <condition_variable>
 #include <poll.h>
 
 #include "tcan/Bus.hpp"
+#include "tcan/DeviceStateTable.hpp"
+#include "tcan/RcuPointer.hpp"
 #include "tcan/helper_functions.hpp"
 
 namespace tcan {
@@ -12,13 +17,64 @@ namespace tcan {
 template <class Msg>
 class BusManager {
  public:
+    //! Execution times of the read and write phase of a bus in parallel synchronous mode
+    struct PhaseTiming {
+        std::chrono::nanoseconds lastRead_{0};
+        std::chrono::nanoseconds maxRead_{0};
+        std::chrono::nanoseconds lastWrite_{0};
+        std::chrono::nanoseconds maxWrite_{0};
+    };
+
+    //! Outcome of the initialization of a bus by initRegisteredBuses()
+    struct BusInitResult {
+        enum class Status : uint8_t {
+            Initialized,
+            Failed,     // initBus() returned false
+            TimedOut    // initBus() did not return before the timeout
+        };
+
+        Bus<Msg>* bus_;
+        Status status_;
+
+        //! execution time of initBus(). Time until the timeout if the initialization timed out.
+        std::chrono::nanoseconds duration_;
+    };
+
     BusManager():
         buses_(),
+        semiSynchronousBuses_(),
         receiveThread_(),
         sanityCheckThread_(),
         running_{false},
-        sanityCheckInterval_(100)
+        sanityCheckInterval_(100),
+        threadStartMutex_(),
+        priorityReceiveThread_(0),
+        cpuReceiveThread_(-1),
+        receiveThreadStackPrefaultSize_(0),
+        reportRealtimeSettings_(false),
+        memoryLocked_(false),
+        synchronousWorkers_(),
+        numBusesWithSynchronousWorkers_(0),
+        synchronousPhaseMutex_(),
+        condSynchronousPhaseStart_(),
+        condSynchronousPhaseDone_(),
+        synchronousPhase_(SynchronousPhase::Read),
+        synchronousPhaseGeneration_(0),
+        numPendingSynchronousWorkers_(0),
+        synchronousWorkersRunning_(false),
+        registeredBuses_(),
+        timedOutInitializations_(),
+        initMutex_(),
+        condInitDone_(),
+        deviceStateEvents_(),
+        deviceStates_(),
+        ioUringEngine_()
     {
+        deviceStates_.setEventQueue(&deviceStateEvents_);
+
+        if(!synchronousPhaseMutex_.isPriorityInheritanceEnabled()) {
+            MELO_WARN("Failed to enable priority inheritance on synchronous phase mutex of bus manager");
+        }
     }
 
     virtual ~BusManager()
@@ -26,14 +82,142 @@ class BusManager {
         closeBuses();
     }
 
+    /*!
+     * Adds and initializes a bus. Semi-synchronous buses may also be added after startThreads(). The receive thread of the bus manager
+     * picks them up without stopping, but uses the thread settings of the buses which existed at startThreads(). If there was no
+     * semi-synchronous bus at that time, call startThreads() again.
+     * Call this function from the thread calling the synchronous functions (control thread).
+     */
     bool addBus(Bus<Msg>* bus) {
-        if(bus->isSemiSynchronous() && running_) {
-            MELO_FATAL("Tried to add a semi-synchronous bus after calling startThreads. This is not allowed due to data concurrency!");
+        if(!bus->isAsynchronous() && synchronousWorkersRunning_) {
+            MELO_WARN("Bus %s was added after startParallelSynchronous(). It is read and written by the calling thread.", bus->getName().c_str());
         }
 
-        buses_.push_back( bus );
-        return bus->initBus();
+        const bool initialized = bus->initBus();
+        insertInitializedBus(bus);
+        return initialized;
     }
+
+    /*!
+     * Registers a bus for initialization by initRegisteredBuses(). The bus is not initialized and not handled by the bus manager before.
+     * The bus manager takes ownership of the bus.
+     */
+    void registerBus(Bus<Msg>* bus) {
+        registeredBuses_.push_back(bus);
+    }
+
+    /*!
+     * Initializes all buses registered by registerBus() concurrently, one thread per bus, and adds them to the bus manager like addBus().
+     * The startup time is thus given by the slowest bus instead of the sum over all buses.
+     * A bus whose initialization does not return before the timeout is not added. Its initialization thread keeps running and the bus
+     * is deleted by closeBuses() after the thread returned.
+     * @param timeout   maximum time to wait for all initializations
+     * @param results   result per registered bus, in the order of registration (output parameter, optional)
+     * @return true if all registered buses were initialized successfully
+     */
+    bool initRegisteredBuses(const std::chrono::milliseconds& timeout, std::vector<BusInitResult>* results = nullptr) {
+        std::vector<std::unique_ptr<BusInitialization>> initializations;
+        initializations.reserve(registeredBuses_.size());
+
+        const auto start = std::chrono::steady_clock::now();
+        for(auto bus : registeredBuses_) {
+            initializations.emplace_back(new BusInitialization(bus));
+            BusInitialization* initialization = initializations.back().get();
+            initialization->thread_ = std::thread(&BusManager::initializationWorker, this, initialization);
+        }
+        registeredBuses_.clear();
+
+        {
+            std::unique_lock<std::mutex> lock(initMutex_);
+            condInitDone_.wait_until(lock, start + timeout, [&initializations]{
+                return std::all_of(initializations.begin(), initializations.end(),
+                                   [](const std::unique_ptr<BusInitialization>& initialization){ return initialization->done_; });
+            });
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        bool allInitialized = true;
+        if(results != nullptr) {
+            results->clear();
+        }
+
+        for(auto& initialization : initializations) {
+            Bus<Msg>* bus = initialization->bus_;
+            BusInitResult result{bus, BusInitResult::Status::TimedOut, end - start};
+            {
+                std::lock_guard<std::mutex> lock(initMutex_);
+                if(initialization->done_) {
+                    result.status_ = initialization->initialized_ ? BusInitResult::Status::Initialized : BusInitResult::Status::Failed;
+                    result.duration_ = initialization->duration_;
+                }
+            }
+
+            if(result.status_ == BusInitResult::Status::TimedOut) {
+                MELO_ERROR("Initialization of bus %s timed out after %lld ms.", bus->getName().c_str(),
+                           static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(result.duration_).count()));
+                timedOutInitializations_.push_back(std::move(initialization));
+                allInitialized = false;
+            }else{
+                initialization->thread_.join();
+                if(result.status_ == BusInitResult::Status::Failed) {
+                    MELO_WARN("Failed to initialize bus %s.", bus->getName().c_str());
+                    allInitialized = false;
+                }
+                insertInitializedBus(bus);
+            }
+
+            if(results != nullptr) {
+                results->push_back(result);
+            }
+        }
+
+        return allInitialized;
+    }
+
+    /*!
+     * Removes a bus while the threads of the bus manager keep running. Stops the threads of the bus. When the function returns, the
+     * bus manager threads no longer access the bus and the caller owns it (i.e. has to delete it).
+     * Call this function from the thread calling the synchronous functions (control thread), not from a callback.
+     * @return false if the bus was not added or the parallel synchronous workers are running (see stopParallelSynchronous())
+     */
+    bool removeBus(Bus<Msg>* bus) {
+        auto it = std::find(buses_.begin(), buses_.end(), bus);
+        if(it == buses_.end()) {
+            return false;
+        }
+        if(synchronousWorkersRunning_) {
+            MELO_ERROR("Cannot remove bus %s while the parallel synchronous workers are running.", bus->getName().c_str());
+            return false;
+        }
+
+        buses_.erase(it);
+        bus->setDeviceStateTable(nullptr);
+        if(bus->isSemiSynchronous()) {
+            semiSynchronousBuses_.update([bus](std::vector<Bus<Msg>*>& buses){
+                buses.erase(std::remove(buses.begin(), buses.end(), bus), buses.end());
+                return true;
+            });
+            semiSynchronousBuses_.synchronize();
+        }
+        bus->stopThreads();
+        return true;
+    }
+    /*!
+     * @return states of the devices of all buses, updated by the devices on state transitions. Use it to publish device states (e.g.
+     *   tcan_msgs/DeviceStates) without iterating the devices of every bus.
+     */
+    DeviceStateTable& getDeviceStateTable() { return deviceStates_; }
+    const DeviceStateTable& getDeviceStateTable() const { return deviceStates_; }
+
+    /*!
+     * @return timestamped state transitions of the devices of all buses, including devices being added and removed. Drain it from a
+     *   single thread instead of polling the device states. Overflows are counted, see DeviceStateEventQueue::takeNumDroppedEvents().
+     */
+    DeviceStateEventQueue& getDeviceStateEvents() { return deviceStateEvents_; }
+
+    //! @return io_uring engine serving the buses with BusOptions::useIoUring_, e.g. for its statistics
+    IoUringEngine& getIoUringEngine() { return ioUringEngine_; }
+
     /*! Gets the number of buses
      * @return	number of buses
      */
@@ -42,32 +226,39 @@ class BusManager {
     /*! Read and parse messages from all buses. Call this function in the control loop if synchronous mode is used.
      */
     void readMessagesSynchronous() {
+        if(synchronousWorkersRunning_) {
+            runSynchronousPhase(SynchronousPhase::Read);
+            return;
+        }
+
         for(auto bus : buses_) {
-            if(bus->isSynchronous()) {
-                while(bus->readMessage()) {
-                }
-            }
+            readMessagesSynchronous(bus);
         }
     }
     /*!
      * Send the messages in the output queue on all buses. Call this function in the control loop if synchronous mode is used.
      * Note that this function may not send all the messages in the output queue if BlockingWrite is disabled (see BusOptions)
+     * or if the bus holds back messages (e.g. rate limited messages, see CanBusOptions::transmitLimits_).
      * @return  False if at least one write error occurred
      */
     bool writeMessagesSynchronous() {
+        if(synchronousWorkersRunning_) {
+            return runSynchronousPhase(SynchronousPhase::Write);
+        }
+
         bool sendingData = true;
         bool noError = true;
         while(sendingData) {
             sendingData = false;
 
             for(auto bus : buses_) {
-                if(bus->isSynchronous() && bus->getNumOutgoingMessagesWithoutLock() > 0) {
+                if(bus->isSynchronous() && bus->hasMessageToWriteWithoutLock()) {
                     noError &= bus->writeMessages( nullptr );
                     sendingData = true;
                 }else if(bus->isSemiSynchronous()) {
                     // we need to acquire lock here because the callbacks of incoming messages may put new messages in the output queue
-                    std::unique_lock<std::mutex> lock( bus->getOutgoingMsgsMutex() );
-                    if(bus->getNumOutgoingMessagesWithoutLock() > 0) {
+                    std::unique_lock<PriorityInheritanceMutex> lock(bus->getOutgoingMsgsMutex());
+                    if(bus->hasMessageToWriteWithoutLock()) {
                         noError &= bus->writeMessages( &lock );
                         sendingData = true;
                     }
@@ -77,6 +268,89 @@ class BusManager {
         return noError;
     }
 
+    /*!
+     * Creates one worker thread per synchronous and semi-synchronous bus. Afterwards, readMessagesSynchronous() and writeMessagesSynchronous()
+     * read/write all buses concurrently and return when all buses are done (barrier). The execution time of a phase is thus the maximum instead of
+     * the sum over the buses. Note that the callbacks of different buses are executed concurrently in this mode!
+     * The worker threads use BusOptions::prioritySynchronousWorkerThread_ and cpuSynchronousWorkerThread_.
+     * Call this function after all buses have been added.
+     * @return false if the workers are already running
+     */
+    bool startParallelSynchronous() {
+        if(synchronousWorkersRunning_) {
+            return false;
+        }
+
+        {
+            std::lock_guard<PriorityInheritanceMutex> lock(synchronousPhaseMutex_);
+            synchronousWorkersRunning_ = true;
+            synchronousPhaseGeneration_ = 0;
+            numPendingSynchronousWorkers_ = 0;
+        }
+
+        // the workers wait for this lock before entering their loop, such that priority and affinity are set when they start
+        std::lock_guard<std::mutex> guard(threadStartMutex_);
+        numBusesWithSynchronousWorkers_ = buses_.size();
+        for(unsigned int i=0; i<buses_.size(); ++i) {
+            Bus<Msg>* bus = buses_[i];
+            if(bus->isAsynchronous()) {
+                continue;
+            }
+
+            const BusOptions* options = bus->getOptions();
+            synchronousWorkers_.emplace_back(new SynchronousWorker(i, bus));
+            SynchronousWorker* worker = synchronousWorkers_.back().get();
+            worker->thread_ = std::thread(&BusManager::synchronousWorker, this, worker);
+            if(!setThreadPriority(worker->thread_, options->prioritySynchronousWorkerThread_)) {
+                MELO_WARN("Failed to set synchronous worker thread priority for bus %s:\n  %s", options->name_.c_str(), strerror(errno));
+            }
+            if(!setThreadAffinity(worker->thread_, options->cpuSynchronousWorkerThread_)) {
+                MELO_WARN("Failed to pin synchronous worker thread of bus %s to CPU %d:\n  %s", options->name_.c_str(), options->cpuSynchronousWorkerThread_, strerror(errno));
+            }
+        }
+
+        return true;
+    }
+
+    /*!
+     * Stops the worker threads created by startParallelSynchronous(). readMessagesSynchronous() and writeMessagesSynchronous() handle the buses
+     * one after another afterwards.
+     */
+    void stopParallelSynchronous() {
+        {
+            std::lock_guard<PriorityInheritanceMutex> lock(synchronousPhaseMutex_);
+            if(!synchronousWorkersRunning_) {
+                return;
+            }
+            synchronousWorkersRunning_ = false;
+        }
+        condSynchronousPhaseStart_.notify_all();
+
+        for(auto& worker : synchronousWorkers_) {
+            if(worker->thread_.joinable()) {
+                worker->thread_.join();
+            }
+        }
+        synchronousWorkers_.clear();
+    }
+
+    /*!
+     * Gets the execution times of the last read/write phase of a bus in parallel synchronous mode. Call this function from the thread
+     * calling readMessagesSynchronous() and writeMessagesSynchronous().
+     * @param busIndex  index of the bus
+     * @param timing    execution times (output parameter)
+     * @return false if the bus has no synchronous worker
+     */
+    bool getSynchronousPhaseTiming(const unsigned int busIndex, PhaseTiming& timing) const {
+        for(const auto& worker : synchronousWorkers_) {
+            if(worker->busIndex_ == busIndex) {
+                timing = worker->timing_;
+                return true;
+            }
+        }
+        return false;
+    }
+
     /*! Call sanityCheck(..) on all buses. Call this function in the control loop if synchronous mode is used.
      * @return True if no device is missing or has error nor any bus has any errors
      */
@@ -148,6 +422,8 @@ class BusManager {
      * Close all buses and stop threads associated to them.
      */
     void closeBuses() {
+        stopParallelSynchronous();
+
         // tell all threads to stop
         stopThreads(false);
         for(Bus<Msg>* bus : buses_) {
@@ -159,15 +435,30 @@ class BusManager {
         for(Bus<Msg>* bus : buses_) {
             delete bus;
         }
+        for(Bus<Msg>* bus : registeredBuses_) {
+            delete bus;
+        }
+        for(auto& initialization : timedOutInitializations_) {
+            MELO_INFO("Waiting for initialization of bus %s to return.", initialization->bus_->getName().c_str());
+            initialization->thread_.join();
+            delete initialization->bus_;
+        }
 
         buses_.clear();
+        registeredBuses_.clear();
+        timedOutInitializations_.clear();
+        semiSynchronousBuses_.update([](std::vector<Bus<Msg>*>& buses){ buses.clear(); return true; });
+        semiSynchronousBuses_.reclaim();
     }
 
     /*
-     * Start threads for buses which are asynchronous or semi-synchronous.
+     * Start threads for buses which are asynchronous or semi-synchronous. Asynchronous buses with BusOptions::useIoUring_ are served
+     * by the io_uring engine instead of their receive and transmit threads.
      */
     void startThreads() {
 
+        startIoUringEngine();
+
         for(auto bus : buses_) {
             bus->startThreads();
         }
@@ -179,6 +470,8 @@ class BusManager {
         bool hasSemiSyncBus = false;
         int priorityReceiveThread = 0;
         int prioritySanityCheckThread = 0;
+        int cpuReceiveThread = -1;
+        bool lockMemoryOfProcess = false;
         sanityCheckInterval_ = 0;
 
         std::once_flag flag;
@@ -189,6 +482,14 @@ class BusManager {
 
                 priorityReceiveThread = std::max(priorityReceiveThread, options->priorityReceiveThread_);
                 prioritySanityCheckThread = std::max(prioritySanityCheckThread, options->prioritySanityCheckThread_);
+                lockMemoryOfProcess |= options->lockMemory_;
+                receiveThreadStackPrefaultSize_ = std::max(receiveThreadStackPrefaultSize_, options->stackPrefaultSize_);
+                reportRealtimeSettings_ |= options->reportRealtimeSettings_;
+
+                // the receive thread is shared, use the first CPU specified by a bus
+                if(cpuReceiveThread < 0) {
+                    cpuReceiveThread = options->cpuReceiveThread_;
+                }
 
                 std::call_once(flag, [&](){ sanityCheckInterval_ = options->sanityCheckInterval_; });
 
@@ -205,12 +506,23 @@ class BusManager {
         }
 
         if(hasSemiSyncBus) {
+            std::lock_guard<std::mutex> guard(threadStartMutex_);
             running_ = true;
 
+            memoryLocked_ = lockMemoryOfProcess;
+            if(lockMemoryOfProcess && !lockMemory()) {
+                MELO_WARN("Failed to lock memory for bus manager\n  %s", strerror(errno));
+            }
+
+            priorityReceiveThread_ = priorityReceiveThread;
+            cpuReceiveThread_ = cpuReceiveThread;
             receiveThread_ = std::thread(&BusManager::receiveWorker, this);
             if (!setThreadPriority(receiveThread_, priorityReceiveThread)) {
                 MELO_WARN("Failed to set receive thread priority for bus manager\n  %s", strerror(errno));
             }
+            if(!setThreadAffinity(receiveThread_, cpuReceiveThread)) {
+                MELO_WARN("Failed to pin receive thread of bus manager to CPU %d:\n  %s", cpuReceiveThread, strerror(errno));
+            }
 
             if (sanityCheckInterval_ > 0) {
                 sanityCheckThread_ = std::thread(&BusManager::sanityCheckWorker, this);
@@ -224,11 +536,13 @@ class BusManager {
     }
 
     /*!
-     * Stop all threads associated with buses
+     * Stop all threads associated with buses, including the io_uring engine
      * @param wait  Whether to wait for the threads to stop or return immediately
      */
     void stopThreads(const bool wait=true) {
         running_ = false;
+        Clock::notifySleepers();
+        ioUringEngine_.stop(wait);
 
         if(wait) {
             if(receiveThread_.joinable()) {
@@ -242,33 +556,255 @@ class BusManager {
     }
 
  protected:
+    enum class SynchronousPhase : uint8_t {
+        Read,
+        Write
+    };
+
+    /*!
+     * Attaches the asynchronous buses with BusOptions::useIoUring_ which are not running yet to the io_uring engine and starts its
+     * thread. The buses use their threads if io_uring is not available.
+     */
+    void startIoUringEngine() {
+        bool hasIoUringBus = false;
+        int priority = 0;
+        int cpu = -1;
+        for(auto bus : buses_) {
+            const BusOptions* options = bus->getOptions();
+            if(bus->isAsynchronous() && options->useIoUring_) {
+                hasIoUringBus = true;
+                priority = std::max(priority, options->priorityReceiveThread_);
+                // the engine thread is shared, use the first CPU specified by a bus
+                if(cpu < 0) {
+                    cpu = options->cpuReceiveThread_;
+                }
+            }
+        }
+        if(!hasIoUringBus) {
+            return;
+        }
+
+        if(!ioUringEngine_.isInitialized() && !ioUringEngine_.initialize()) {
+            MELO_WARN("io_uring is not available. The buses use their receive and transmit threads.");
+            return;
+        }
+
+        bool hasAttachedBus = false;
+        for(auto bus : buses_) {
+            if(bus->isAsynchronous() && bus->getOptions()->useIoUring_) {
+                hasAttachedBus |= bus->attachIoUringEngine(ioUringEngine_);
+            }
+        }
+
+        if(hasAttachedBus && !ioUringEngine_.isRunning() && !ioUringEngine_.start(priority, cpu)) {
+            MELO_ERROR("Failed to start the io_uring engine.");
+        }
+    }
+
+    struct SynchronousWorker {
+        SynchronousWorker(const unsigned int busIndex, Bus<Msg>* bus):
+            busIndex_(busIndex),
+            bus_(bus),
+            thread_(),
+            noError_(true),
+            timing_()
+        {
+        }
+
+        const unsigned int busIndex_;
+        Bus<Msg>* const bus_;
+        std::thread thread_;
+
+        //! result of the last phase
+        bool noError_;
+        PhaseTiming timing_;
+    };
+
+    //! Initialization of a bus in a separate thread, see initRegisteredBuses(). The results are protected by initMutex_.
+    struct BusInitialization {
+        explicit BusInitialization(Bus<Msg>* bus):
+            bus_(bus),
+            thread_(),
+            done_(false),
+            initialized_(false),
+            duration_(0)
+        {
+        }
+
+        Bus<Msg>* const bus_;
+        std::thread thread_;
+        bool done_;
+        bool initialized_;
+        std::chrono::nanoseconds duration_;
+    };
+
+    /*! Adds an initialized bus to the bus list. Semi-synchronous buses are published to the receive and sanity check threads.
+     */
+    void insertInitializedBus(Bus<Msg>* bus) {
+        buses_.push_back( bus );
+        bus->setDeviceStateTable(&deviceStates_);
+
+        if(bus->isSemiSynchronous()) {
+            semiSynchronousBuses_.update([bus](std::vector<Bus<Msg>*>& buses){ buses.push_back(bus); return true; });
+        }
+    }
+
+    /*! Read all messages of a synchronous bus
+     */
+    void readMessagesSynchronous(Bus<Msg>* bus) {
+        if(bus->isSynchronous()) {
+            while(bus->readMessage()) {
+            }
+        }
+    }
+
+    /*! Write all messages of a synchronous or semi-synchronous bus
+     * @return  False if at least one write error occurred
+     */
+    bool writeMessagesSynchronous(Bus<Msg>* bus) {
+        bool noError = true;
+        if(bus->isSynchronous()) {
+            while(bus->hasMessageToWriteWithoutLock()) {
+                noError &= bus->writeMessages( nullptr );
+            }
+        }else if(bus->isSemiSynchronous()) {
+            std::unique_lock<PriorityInheritanceMutex> lock(bus->getOutgoingMsgsMutex());
+            while(bus->hasMessageToWriteWithoutLock()) {
+                noError &= bus->writeMessages( &lock );
+            }
+        }
+        return noError;
+    }
+
+    /*! Lets all synchronous workers execute a phase and waits until all of them are done.
+     * @return  False if at least one bus had a write error
+     */
+    bool runSynchronousPhase(const SynchronousPhase phase) {
+        {
+            std::lock_guard<PriorityInheritanceMutex> lock(synchronousPhaseMutex_);
+            synchronousPhase_ = phase;
+            ++synchronousPhaseGeneration_;
+            numPendingSynchronousWorkers_ = synchronousWorkers_.size();
+        }
+        condSynchronousPhaseStart_.notify_all();
+
+        // buses added after startParallelSynchronous() are handled by the calling thread
+        bool noError = true;
+        for(unsigned int i=numBusesWithSynchronousWorkers_; i<buses_.size(); ++i) {
+            if(phase == SynchronousPhase::Read) {
+                readMessagesSynchronous(buses_[i]);
+            }else{
+                noError &= writeMessagesSynchronous(buses_[i]);
+            }
+        }
+
+        std::unique_lock<PriorityInheritanceMutex> lock(synchronousPhaseMutex_);
+        condSynchronousPhaseDone_.wait(lock, [this]{ return numPendingSynchronousWorkers_ == 0; });
+
+        for(const auto& worker : synchronousWorkers_) {
+            noError &= worker->noError_;
+        }
+        return noError;
+    }
 
     // thread loop functions
-    void receiveWorker() {
-        unsigned int numFds = 0;
-        pollfd fds[buses_.size()];
-        std::vector<unsigned int> busIndices;
+    void synchronousWorker(SynchronousWorker* worker) {
+        {
+            // wait until startParallelSynchronous() has set priority and affinity
+            std::lock_guard<std::mutex> guard(threadStartMutex_);
+        }
+        markRealtimeThread();
+        TraceRecorder::registerThread();
+        unsigned int generation = 0;
+        std::unique_lock<PriorityInheritanceMutex> lock(synchronousPhaseMutex_);
+
+        while(true) {
+            condSynchronousPhaseStart_.wait(lock, [&]{ return !synchronousWorkersRunning_ || synchronousPhaseGeneration_ != generation; });
+            if(!synchronousWorkersRunning_) {
+                break;
+            }
+            generation = synchronousPhaseGeneration_;
+            const SynchronousPhase phase = synchronousPhase_;
+            lock.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+            if(phase == SynchronousPhase::Read) {
+                readMessagesSynchronous(worker->bus_);
+                worker->timing_.lastRead_ = std::chrono::steady_clock::now() - start;
+                worker->timing_.maxRead_ = std::max(worker->timing_.maxRead_, worker->timing_.lastRead_);
+            }else{
+                worker->noError_ = writeMessagesSynchronous(worker->bus_);
+                worker->timing_.lastWrite_ = std::chrono::steady_clock::now() - start;
+                worker->timing_.maxWrite_ = std::max(worker->timing_.maxWrite_, worker->timing_.lastWrite_);
+            }
 
-        for(unsigned int i=0; i<buses_.size(); ++i) {
-            if(buses_[i]->isSemiSynchronous()) {
-                fds[numFds] = {buses_[i]->getPollableFileDescriptor(), POLLIN, 0};
-                busIndices.push_back(i);
-                ++numFds;
+            lock.lock();
+            if(--numPendingSynchronousWorkers_ == 0) {
+                condSynchronousPhaseDone_.notify_one();
             }
         }
+    }
+
+    void initializationWorker(BusInitialization* initialization) {
+        const auto start = std::chrono::steady_clock::now();
+        const bool initialized = initialization->bus_->initBus();
+        const auto duration = std::chrono::steady_clock::now() - start;
+
+        {
+            std::lock_guard<std::mutex> lock(initMutex_);
+            initialization->done_ = true;
+            initialization->initialized_ = initialized;
+            initialization->duration_ = duration;
+        }
+        condInitDone_.notify_all();
+    }
+
+    void receiveWorker() {
+        {
+            // wait until startThreads() has set priority and affinity
+            std::lock_guard<std::mutex> guard(threadStartMutex_);
+        }
+        markRealtimeThread();
+        TraceRecorder::registerThread();
+        if(receiveThreadStackPrefaultSize_ > 0) {
+            prefaultStack(receiveThreadStackPrefaultSize_);
+        }
+        if(reportRealtimeSettings_) {
+            reportRealtimeSettings("bus manager receive thread", priorityReceiveThread_, cpuReceiveThread_, DeadlineParameters(), memoryLocked_);
+        }
+
+        // local copy of the bus list snapshot, rebuilt only when a bus was added or removed
+        std::vector<pollfd> fds;
+        std::vector<Bus<Msg>*> polledBuses;
 
         while(running_) {
-            int ret = poll( fds, numFds, 500 /*timeout [ms]*/ );
+            {
+                auto buses = semiSynchronousBuses_.read();
+                if(*buses != polledBuses) {
+                    polledBuses.assign(buses->begin(), buses->end());
+                    fds.clear();
+                    for(auto bus : polledBuses) {
+                        fds.push_back({bus->getPollableFileDescriptor(), POLLIN, 0});
+                    }
+                }
+            }
+
+            // no snapshot is held while waiting, such that removeBus() does not have to wait for the poll timeout
+            int ret = poll( fds.data(), fds.size(), 500 /*timeout [ms]*/ );
 
             if ( ret == -1 ) {
                 MELO_ERROR("polling for fileDescriptor readability failed in bus manager:\n  %s", strerror(errno));
             }else if ( ret == 0 ) {
                 // poll timed out, without being able to read => continue silently
             }else{
+                // only buses of the current snapshot are read, such that a bus removed during poll() is skipped. The read guard keeps
+                // removeBus() from returning while a bus is read.
+                auto buses = semiSynchronousBuses_.read();
+
                 // there is something in the fd ready to be read
-                for(unsigned int i=0; i<numFds; ++i) {
-                    if(fds[i].revents & POLLIN) {
-                        buses_[busIndices[i]]->readMessage();
+                for(unsigned int i=0; i<fds.size(); ++i) {
+                    if((fds[i].revents & POLLIN) && std::find(buses->begin(), buses->end(), polledBuses[i]) != buses->end()) {
+                        polledBuses[i]->readMessage();
                     }
 
                     fds[i].revents = 0;
@@ -280,17 +816,23 @@ class BusManager {
     }
 
     void sanityCheckWorker() {
-        auto nextLoop = std::chrono::steady_clock::now();
+        markRealtimeThread();
+        TraceRecorder::registerThread();
+        auto nextLoop = Clock::now();
 
         while(running_) {
             nextLoop += std::chrono::milliseconds(sanityCheckInterval_);
-            std::this_thread::sleep_until(nextLoop);
+            if(!Clock::sleepUntil(nextLoop, &running_)) {
+                break;
+            }
 
-            for(auto bus : buses_) {
-                if(bus->isSemiSynchronous()) {
+            {
+                auto buses = semiSynchronousBuses_.read();
+                for(auto bus : *buses) {
                     bus->sanityCheck();
                 }
             }
+            semiSynchronousBuses_.reclaim();
         }
 
         MELO_INFO("SanityCheck thread for bus manager terminated");
@@ -299,12 +841,47 @@ class BusManager {
  protected:
     std::vector<Bus<Msg>*> buses_;
 
+    //! semi-synchronous buses, read by the receive and sanity check threads without locking
+    RcuPointer<std::vector<Bus<Msg>*>> semiSynchronousBuses_;
+
     //! threads for message reception and device sanity checking
     std::thread receiveThread_;
     std::thread sanityCheckThread_;
     std::atomic<bool> running_;
 
     unsigned int sanityCheckInterval_;
+
+    //! settings of the receive thread, combined from the options of the semi-synchronous buses
+    std::mutex threadStartMutex_;
+    int priorityReceiveThread_;
+    int cpuReceiveThread_;
+    std::size_t receiveThreadStackPrefaultSize_;
+    bool reportRealtimeSettings_;
+    bool memoryLocked_;
+
+    //! worker threads for parallel synchronous mode, see startParallelSynchronous()
+    std::vector<std::unique_ptr<SynchronousWorker>> synchronousWorkers_;
+    unsigned int numBusesWithSynchronousWorkers_;
+    PriorityInheritanceMutex synchronousPhaseMutex_;
+    std::condition_variable_any condSynchronousPhaseStart_;
+    std::condition_variable_any condSynchronousPhaseDone_;
+    SynchronousPhase synchronousPhase_;
+    unsigned int synchronousPhaseGeneration_;
+    unsigned int numPendingSynchronousWorkers_;
+    std::atomic<bool> synchronousWorkersRunning_;
+
+    //! buses waiting for initRegisteredBuses(), and initializations which did not return before the timeout
+    std::vector<Bus<Msg>*> registeredBuses_;
+    std::vector<std::unique_ptr<BusInitialization>> timedOutInitializations_;
+    std::mutex initMutex_;
+    std::condition_variable condInitDone_;
+
+    //! states and state transitions of the devices of all buses, see getDeviceStateTable() and getDeviceStateEvents()
+    DeviceStateEventQueue deviceStateEvents_;
+    DeviceStateTable deviceStates_;
+
+    //! completion loop reading and writing the buses with BusOptions::useIoUring_, see startIoUringEngine()
+    IoUringEngine ioUringEngine_;
 };
 
 } /* namespace tcan */
@@ -3,6 +3,8 @@
 #include <string>
 #include <sys/time.h> // for timeval
 
+#include "tcan/helper_functions.hpp"
+
 namespace tcan {
 
 struct BusOptions {
@@ -24,6 +26,17 @@ struct BusOptions {
         priorityReceiveThread_(99),
         priorityTransmitThread_(98),
         prioritySanityCheckThread_(1),
+        cpuReceiveThread_(-1),
+        cpuTransmitThread_(-1),
+        cpuSanityCheckThread_(-1),
+        deadlineReceiveThread_(),
+        deadlineTransmitThread_(),
+        lockMemory_(false),
+        stackPrefaultSize_(0),
+        reportRealtimeSettings_(false),
+        useIoUring_(false),
+        prioritySynchronousWorkerThread_(98),
+        cpuSynchronousWorkerThread_(-1),
         maxQueueSize_(1000),
         name_(name),
         startPassive_(false),
@@ -31,7 +44,9 @@ struct BusOptions {
         synchronousBlockingWrite_(true),
         readTimeout_{1, 0},
         writeTimeout_{1,0},
-        errorThrottleTime_(0.0)
+        errorThrottleTime_(0.0),
+        profileCallbacks_(false),
+        slowCallbackThreshold_(0)
     {
     }
 
@@ -54,6 +69,36 @@ struct BusOptions {
     int priorityTransmitThread_;
     int prioritySanityCheckThread_;
 
+    //! CPU the threads are pinned to. -1 = not pinned
+    int cpuReceiveThread_;
+    int cpuTransmitThread_;
+    int cpuSanityCheckThread_;
+
+    //! if enabled, the receive / transmit thread uses SCHED_DEADLINE with these parameters instead of SCHED_FIFO with the priority above.
+    //! The kernel rejects SCHED_DEADLINE for threads pinned to a subset of the root domain, so leave the CPU unset or use cpusets.
+    DeadlineParameters deadlineReceiveThread_;
+    DeadlineParameters deadlineTransmitThread_;
+
+    //! lock the memory of the process (mlockall) when starting the threads
+    bool lockMemory_;
+
+    //! stack size prefaulted by the receive and transmit threads before entering their loop [bytes]. 0 to disable.
+    //! Should be combined with lockMemory_.
+    std::size_t stackPrefaultSize_;
+
+    //! log the effective scheduling settings of the threads after they started and warn about deviations from the options
+    bool reportRealtimeSettings_;
+
+    //! Asynchronous mode only: the io_uring engine of the BusManager reads and writes the interface instead of a receive and a transmit
+    //! thread per bus, see tcan::IoUringEngine. The engine thread of all these buses uses the highest priorityReceiveThread_ and the first
+    //! cpuReceiveThread_ set. The bus falls back to its threads if the kernel or the bus does not support io_uring.
+    bool useIoUring_;
+
+    //! priority and CPU (-1 = not pinned) of the worker thread which reads and writes this bus if BusManager::startParallelSynchronous() is used
+    //! (synchronous and semi-synchronous mode only)
+    int prioritySynchronousWorkerThread_;
+    int cpuSynchronousWorkerThread_;
+
     //! max size of the output queue
     unsigned int maxQueueSize_;
 
@@ -76,6 +121,13 @@ struct BusOptions {
 
     //! throttle time for MELO outputs
     double errorThrottleTime_;
+
+    //! measure the execution time of every message callback, per callback and per device (see tcan::CallbackProfile). Only costs a
+    //! pointer comparison per message if disabled.
+    bool profileCallbacks_;
+
+    //! if profileCallbacks_ is set, the sanity check warns about callbacks which took longer than this [us]. 0 to disable.
+    unsigned int slowCallbackThreshold_;
 };
 
 } /* namespace tcan */
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tcan/ExecutionTimeHistogram.hpp"
+
+namespace tcan {
+
+/*!
+ * Execution time statistics of a message callback (or of all callbacks of a device), see BusOptions::profileCallbacks_.
+ * add(..) is called by the receive thread and does not allocate or lock. The histogram is kept in atomic counters, which are copied
+ * into an ExecutionTimeHistogram when it is read. A copy taken while calls are added may count a call in some fields only.
+ */
+class CallbackProfile {
+ public:
+    /*!
+     * @param slowThreshold execution time from which on a call is counted as slow. 0 to disable.
+     * @param binWidth      width of a histogram bin [us]
+     * @param numBins       number of histogram bins
+     */
+    CallbackProfile(const std::chrono::nanoseconds& slowThreshold, const unsigned int binWidth = 1, const unsigned int numBins = 200);
+
+    CallbackProfile(const CallbackProfile&) = delete;
+    CallbackProfile& operator=(const CallbackProfile&) = delete;
+
+    //! Adds the execution time of a call.
+    void add(const std::chrono::nanoseconds& duration);
+
+    //! @return copy of the histogram
+    ExecutionTimeHistogram getHistogram() const;
+
+    //! Not synchronized with add(..), calls added concurrently may be partially counted.
+    void reset();
+
+    //! @return number of calls which took longer than the slow threshold
+    inline unsigned int getNumSlowCalls() const { return numSlowCalls_; }
+
+    //! @return number of slow calls since the previous call of this function, used for the slow callback alarm
+    inline unsigned int takeNumNewSlowCalls() { return numNewSlowCalls_.exchange(0); }
+
+    //! @return longest slow call [us]
+    inline double getMaxSlowCallDuration() const { return std::chrono::duration<double, std::micro>(std::chrono::nanoseconds(maxSlowCallDuration_.load())).count(); }
+
+ private:
+    const std::chrono::nanoseconds slowThreshold_;
+
+    // counters of the histogram, see ExecutionTimeHistogram
+    const unsigned int binWidth_;
+    const unsigned int numBins_;
+    std::unique_ptr<std::atomic<unsigned int>[]> bins_;
+    std::atomic<unsigned int> numSamples_;
+    std::atomic<unsigned int> numOverflows_;
+    std::atomic<int64_t> minDuration_;
+    std::atomic<int64_t> maxDuration_;
+    std::atomic<int64_t> sumDuration_;
+
+    std::atomic<unsigned int> numSlowCalls_;
+    std::atomic<unsigned int> numNewSlowCalls_;
+    std::atomic<int64_t> maxSlowCallDuration_;
+};
+
+/*!
+ * Calls a callback with a return value and adds its execution time to the profiles. Does not measure the time if there is no profile.
+ * @param callback      callback to be called
+ * @param profile       profile of the callback, may be nullptr
+ * @param deviceProfile profile of all callbacks of the device, may be nullptr
+ * @param args          arguments of the callback
+ * @return return value of the callback
+ */
+template <class Callback, class... Args>
+inline auto callProfiled(const Callback& callback, CallbackProfile* profile, CallbackProfile* deviceProfile, Args&&... args)
+    -> decltype(callback(std::forward<Args>(args)...))
+{
+    if(profile == nullptr && deviceProfile == nullptr) {
+        return callback(std::forward<Args>(args)...);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto result = callback(std::forward<Args>(args)...);
+    const std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - start;
+    if(profile != nullptr) {
+        profile->add(duration);
+    }
+    if(deviceProfile != nullptr) {
+        deviceProfile->add(duration);
+    }
+    return result;
+}
+
+} // namespace tcan
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "tcan/PriorityInheritanceMutex.hpp"
+
+namespace tcan {
+
+/*!
+ * Time source of all timers of tcan: sanity check cycles, transmit schedules, rate limits, configuration sequence timeouts, ..
+ * By default, it is the steady clock. Tests switch it to virtual time, which only advances when advanceTo(..) or advance(..) is called,
+ * so a bring-up that takes a minute in real time is simulated as fast as the CPU allows.
+ * Threads waiting with sleepUntil(..) or waitUntil(..) for a virtual time are woken when the time is advanced past their deadline.
+ * The simulation is deterministic if the buses are driven from the test thread (synchronous mode or the external event loop functions).
+ * With bus threads, call waitForSleepers(..) before advancing the time, such that all threads finished the work of the previous step.
+ * Execution times (callback profiles, traces, the phases of the CycleRunner) are always measured in real time, the wake-up latency,
+ * cycle time and overruns of the CycleRunner in virtual time.
+ */
+class Clock {
+ public:
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    //! @return current virtual time if enabled, current time of the steady clock otherwise
+    static inline time_point now() {
+        return isVirtual() ? time_point(duration(virtualTime_.load(std::memory_order_acquire))) : std::chrono::steady_clock::now();
+    }
+
+    /*!
+     * Sleeps until a time.
+     * @param time      time to wake up at
+     * @param running   optional flag of the calling worker. With virtual time, the function returns early if it is cleared and
+     *                  notifySleepers() is called.
+     * @return false if the function returned early because running was cleared
+     */
+    static bool sleepUntil(const time_point& time, const std::atomic<bool>* running = nullptr);
+
+    //! Waits until a time or until the condition variable is notified. May return spuriously like std::condition_variable::wait_until.
+    static void waitUntil(std::condition_variable_any& cond, std::unique_lock<PriorityInheritanceMutex>& lock, const time_point& time);
+
+    //! Wakes the threads in sleepUntil(..), such that they check their running flag. Call it after clearing the flag of a worker.
+    static void notifySleepers();
+
+    /*! @name Virtual time
+     */
+    ///@{
+
+    //! Switches to virtual time, starting at the given time.
+    static void startVirtualTime(const time_point& start = std::chrono::steady_clock::now());
+
+    //! Switches back to the steady clock and wakes all waiting threads.
+    static void stopVirtualTime();
+
+    static inline bool isVirtual() { return isVirtual_.load(std::memory_order_acquire); }
+
+    //! Advances the virtual time and wakes the threads whose deadline passed. Does nothing if the time is in the past.
+    static void advanceTo(const time_point& time);
+
+    static inline void advance(const duration& duration) { advanceTo(now() + duration); }
+
+    /*!
+     * Advances the virtual time to the earliest deadline of the waiting threads.
+     * @return false if no thread is waiting
+     */
+    static bool advanceToNextDeadline();
+
+    //! @return number of threads waiting for a virtual time
+    static unsigned int getNumSleepers();
+
+    /*!
+     * Waits until at least a number of threads wait for a virtual time, i.e. are done with their work up to the current time.
+     * @param numSleepers   number of threads
+     * @param timeout       maximum (real) time to wait
+     * @return false on timeout
+     */
+    static bool waitForSleepers(const unsigned int numSleepers, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(1000));
+    ///@}
+
+ private:
+    static std::atomic<bool> isVirtual_;
+    //! [ns] since the epoch of the steady clock
+    static std::atomic<int64_t> virtualTime_;
+};
+
+} /* namespace tcan */
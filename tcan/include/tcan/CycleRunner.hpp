@@ -0,0 +1,270 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "tcan/BusManager.hpp"
+#include "tcan/Clock.hpp"
+#include "tcan/CycleRunnerOptions.hpp"
+#include "tcan/ExecutionTimeHistogram.hpp"
+#include "tcan/helper_functions.hpp"
+#include "tcan/PriorityInheritanceMutex.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan {
+
+//! Execution time statistics of the cycles run by a CycleRunner
+struct CycleStatistics {
+    CycleStatistics(const unsigned int binWidth, const unsigned int numBins):
+        wakeupLatency_(binWidth, numBins),
+        read_(binWidth, numBins),
+        sanityCheck_(binWidth, numBins),
+        callback_(binWidth, numBins),
+        write_(binWidth, numBins),
+        total_(binWidth, numBins),
+        numCycles_(0),
+        numOverruns_(0),
+        numSkippedCycles_(0)
+    {
+    }
+
+    //! time between the planned start of a cycle and the actual start (see Clock)
+    ExecutionTimeHistogram wakeupLatency_;
+
+    //! execution times of the phases, in real time
+    ExecutionTimeHistogram read_;
+    ExecutionTimeHistogram sanityCheck_;
+    ExecutionTimeHistogram callback_;
+    ExecutionTimeHistogram write_;
+
+    //! time between the planned start of a cycle and the end of the write phase (see Clock)
+    ExecutionTimeHistogram total_;
+
+    unsigned int numCycles_;
+
+    //! number of cycles which did not finish before the start of the next cycle (deadline misses)
+    unsigned int numOverruns_;
+
+    //! number of cycles which were not run due to an overrun (OverrunPolicy::Skip only)
+    unsigned int numSkippedCycles_;
+};
+
+/*!
+ * Runs the synchronous read - sanity check - application - write cycle of a BusManager at a fixed rate.
+ * The start times of the cycles are absolute, such that the execution time of a cycle does not accumulate as drift.
+ */
+template <class Msg>
+class CycleRunner {
+ public:
+    using CycleCallback = std::function<void()>;
+
+    CycleRunner(BusManager<Msg>& busManager, const CycleRunnerOptions& options = CycleRunnerOptions()):
+        busManager_(busManager),
+        options_(options),
+        callback_(),
+        running_(false),
+        thread_(),
+        threadStartMutex_(),
+        stopMutex_(),
+        condStop_(),
+        statisticsMutex_(),
+        statistics_(options.histogramBinWidth_, options.histogramNumBins_)
+    {
+        if(!statisticsMutex_.isPriorityInheritanceEnabled() || !stopMutex_.isPriorityInheritanceEnabled()) {
+            MELO_WARN("Failed to enable priority inheritance on the mutexes of cycle runner");
+        }
+    }
+
+    virtual ~CycleRunner()
+    {
+        stop();
+    }
+
+    /*! Sets the application function, which is called in every cycle after reading and checking the buses and before writing the
+     * output queues. Do not call while the runner is active.
+     */
+    void setCycleCallback(const CycleCallback& callback) { callback_ = callback; }
+
+    /*! Runs cycles in the calling thread until stop() is called (e.g. from a signal handler or another thread).
+     * @return false if the runner is already running or the period is 0
+     */
+    bool run() {
+        if(options_.period_ == 0) {
+            MELO_ERROR("Cannot run cycles with a period of 0.");
+            return false;
+        }
+        if(running_.exchange(true)) {
+            MELO_ERROR("Cycle runner is already running.");
+            return false;
+        }
+        runCycles();
+        return true;
+    }
+
+    /*! Runs cycles in a new thread with CycleRunnerOptions::priority_ and cpu_.
+     * @return false if the runner is already running or the period is 0
+     */
+    bool start() {
+        if(options_.period_ == 0) {
+            MELO_ERROR("Cannot run cycles with a period of 0.");
+            return false;
+        }
+        if(running_.exchange(true)) {
+            MELO_ERROR("Cycle runner is already running.");
+            return false;
+        }
+
+        // the thread waits for this lock before running the first cycle, such that priority and affinity are set when it starts
+        std::lock_guard<std::mutex> guard(threadStartMutex_);
+        thread_ = std::thread(&CycleRunner::runCycles, this);
+        if(!setThreadPriority(thread_, options_.priority_)) {
+            MELO_WARN("Failed to set cycle runner thread priority:\n  %s", strerror(errno));
+        }
+        if(!setThreadAffinity(thread_, options_.cpu_)) {
+            MELO_WARN("Failed to pin cycle runner thread to CPU %d:\n  %s", options_.cpu_, strerror(errno));
+        }
+        return true;
+    }
+
+    //! Stops the runner after the current cycle, or wakes it if it waits for the next cycle. Joins the thread created by start().
+    void stop() {
+        {
+            // the runner checks the flag with the mutex locked before it waits, so the notification is not missed
+            std::lock_guard<PriorityInheritanceMutex> guard(stopMutex_);
+            running_ = false;
+        }
+        condStop_.notify_all();
+        Clock::notifySleepers();
+        if(thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+            thread_.join();
+        }
+    }
+
+    inline bool isRunning() const { return running_; }
+
+    inline const CycleRunnerOptions& getOptions() const { return options_; }
+
+    //! @return a copy of the statistics of all cycles since the start or the last call to resetStatistics()
+    CycleStatistics getStatistics() const {
+        std::lock_guard<PriorityInheritanceMutex> guard(statisticsMutex_);
+        return statistics_;
+    }
+
+    void resetStatistics() {
+        std::lock_guard<PriorityInheritanceMutex> guard(statisticsMutex_);
+        statistics_ = CycleStatistics(options_.histogramBinWidth_, options_.histogramNumBins_);
+    }
+
+ protected:
+    void runCycles() {
+        {
+            // wait until start() has set priority and affinity
+            std::lock_guard<std::mutex> guard(threadStartMutex_);
+        }
+        const std::chrono::microseconds period(options_.period_);
+        const std::chrono::microseconds spinTime(options_.spinTime_);
+
+        // run() executes the cycles in the calling thread, which is only marked while the cycles run
+        const bool wasRealtimeThread = isRealtimeThread();
+        markRealtimeThread();
+        TraceRecorder::registerThread();
+
+        Clock::time_point cycleStart = Clock::now();
+        while(running_) {
+            if(!sleepUntilCycleStart(cycleStart, spinTime)) {
+                break;
+            }
+            const Clock::time_point wakeup = Clock::now();
+
+            // the phases are measured in real time, also if the cycles are driven by virtual time
+            const std::chrono::steady_clock::time_point readStart = std::chrono::steady_clock::now();
+            busManager_.readMessagesSynchronous();
+            const std::chrono::steady_clock::time_point readDone = std::chrono::steady_clock::now();
+
+            busManager_.sanityCheckSynchronous();
+            const std::chrono::steady_clock::time_point sanityCheckDone = std::chrono::steady_clock::now();
+
+            if(callback_) {
+                callback_();
+            }
+            const std::chrono::steady_clock::time_point callbackDone = std::chrono::steady_clock::now();
+
+            busManager_.writeMessagesSynchronous();
+            const std::chrono::steady_clock::time_point writeDone = std::chrono::steady_clock::now();
+            const Clock::time_point cycleDone = Clock::now();
+
+            Clock::time_point nextCycleStart = cycleStart + period;
+            const bool overrun = (cycleDone > nextCycleStart);
+            unsigned int numSkippedCycles = 0;
+            if(overrun && options_.overrunPolicy_ == CycleRunnerOptions::OverrunPolicy::Skip) {
+                // continue with the first period boundary in the future. The cycles starting in between are dropped.
+                numSkippedCycles = static_cast<unsigned int>((cycleDone - cycleStart) / period);
+                nextCycleStart = cycleStart + (numSkippedCycles + 1)*period;
+            }
+
+            {
+                std::lock_guard<PriorityInheritanceMutex> guard(statisticsMutex_);
+                statistics_.wakeupLatency_.add(wakeup - cycleStart);
+                statistics_.read_.add(readDone - readStart);
+                statistics_.sanityCheck_.add(sanityCheckDone - readDone);
+                statistics_.callback_.add(callbackDone - sanityCheckDone);
+                statistics_.write_.add(writeDone - callbackDone);
+                statistics_.total_.add(cycleDone - cycleStart);
+                ++statistics_.numCycles_;
+                if(overrun) {
+                    ++statistics_.numOverruns_;
+                    statistics_.numSkippedCycles_ += numSkippedCycles;
+                }
+            }
+
+            cycleStart = nextCycleStart;
+        }
+
+        markRealtimeThread(wasRealtimeThread);
+    }
+
+    /*!
+     * Sleeps until the start of a cycle, busy-waiting for the last spinTime.
+     * @return false if the function returned early because stop() was called
+     */
+    bool sleepUntilCycleStart(const Clock::time_point& cycleStart, const std::chrono::microseconds& spinTime) {
+        if(Clock::isVirtual()) {
+            return Clock::sleepUntil(cycleStart, &running_);
+        }
+
+        {
+            // the condition variable waits on the steady clock (CLOCK_MONOTONIC) with an absolute timeout, like sleepUntil(..)
+            const Clock::time_point wakeupTime = cycleStart - spinTime;
+            std::unique_lock<PriorityInheritanceMutex> lock(stopMutex_);
+            while(running_ && Clock::now() < wakeupTime) {
+                condStop_.wait_until(lock, wakeupTime);
+            }
+        }
+        while(running_ && Clock::now() < cycleStart) {
+        }
+        return running_;
+    }
+
+ protected:
+    BusManager<Msg>& busManager_;
+    const CycleRunnerOptions options_;
+    CycleCallback callback_;
+
+    std::atomic<bool> running_;
+    std::thread thread_;
+    std::mutex threadStartMutex_;
+
+    // wakes the runner waiting for the next cycle on stop()
+    PriorityInheritanceMutex stopMutex_;
+    std::condition_variable_any condStop_;
+
+    mutable PriorityInheritanceMutex statisticsMutex_;
+    CycleStatistics statistics_;
+};
+
+} /* namespace tcan */
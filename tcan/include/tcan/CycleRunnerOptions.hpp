@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace tcan {
+
+struct CycleRunnerOptions {
+    enum class OverrunPolicy : uint8_t {
+        Skip,   // after an overrun, continue with the next period boundary in the future. Missed cycles are dropped.
+        CatchUp // keep the original schedule and run the missed cycles back-to-back until the runner has caught up
+    };
+
+    CycleRunnerOptions():
+        CycleRunnerOptions(1000)
+    {
+    }
+
+    CycleRunnerOptions(const unsigned int period):
+        period_(period),
+        spinTime_(0),
+        overrunPolicy_(OverrunPolicy::Skip),
+        priority_(90),
+        cpu_(-1),
+        histogramBinWidth_(10),
+        histogramNumBins_(200)
+    {
+    }
+
+    virtual ~CycleRunnerOptions() = default;
+
+    //! cycle period [us]
+    unsigned int period_;
+
+    //! duration before the start of a cycle in which the runner busy-waits instead of sleeping [us]. 0 to always sleep.
+    unsigned int spinTime_;
+
+    //! behavior if a cycle took longer than the period
+    OverrunPolicy overrunPolicy_;
+
+    //! priority and CPU (-1 = not pinned) of the thread created by CycleRunner::start()
+    int priority_;
+    int cpu_;
+
+    //! bin width [us] and number of bins of the execution time histograms
+    unsigned int histogramBinWidth_;
+    unsigned int histogramNumBins_;
+};
+
+} /* namespace tcan */
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tcan {
+
+/*!
+ * Queue of the state transitions of the devices of a bus manager, filled by the DeviceStateTable. Applications drain it instead of
+ * polling the state of every device, and see short transitions (e.g. Missing -> Active -> Missing) which polling would miss.
+ * push(..) is lock-free, does not allocate and may be called from several threads. There must only be one consumer.
+ * If the queue is full, new events are dropped and counted, see takeNumDroppedEvents().
+ */
+class DeviceStateEventQueue {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        enum class Type : uint8_t {
+            Registered,     // device added, previousState_ equals state_
+            StateChanged,
+            Unregistered    // device removed, state_ is the last state
+        };
+
+        Type type_;
+        //! name of the device. Valid for the lifetime of the bus manager.
+        const std::string* name_;
+        //! slot of the device in the DeviceStateTable
+        int slot_;
+        int32_t previousState_;
+        int32_t state_;
+        Clock::time_point stamp_;
+    };
+
+    /*!
+     * @param capacity  maximum number of queued events, rounded up to a power of two
+     */
+    explicit DeviceStateEventQueue(const unsigned int capacity = 1024);
+
+    DeviceStateEventQueue(const DeviceStateEventQueue&) = delete;
+    DeviceStateEventQueue& operator=(const DeviceStateEventQueue&) = delete;
+
+    //! @return false if the queue is full and the event was dropped
+    bool push(const Event& event);
+
+    //! @return false if the queue is empty
+    bool pop(Event& event);
+
+    /*!
+     * Takes all queued events. Does not allocate if events has enough capacity.
+     * @param events    events in the order they were pushed (output parameter, cleared first)
+     * @return          number of events
+     */
+    unsigned int popAll(std::vector<Event>& events);
+
+    //! @return number of events dropped because the queue was full, since the previous call
+    inline uint64_t takeNumDroppedEvents() { return numDroppedEvents_.exchange(0, std::memory_order_relaxed); }
+
+    inline unsigned int getCapacity() const { return mask_ + 1; }
+
+ protected:
+    struct Cell {
+        //! position of the event if written, position+1 if readable, position+capacity when read
+        std::atomic<uint64_t> sequence_;
+        Event event_;
+    };
+
+ protected:
+    const unsigned int mask_;
+    std::unique_ptr<Cell[]> cells_;
+    std::atomic<uint64_t> pushPosition_;
+    //! only accessed by the consumer
+    uint64_t popPosition_;
+    std::atomic<uint64_t> numDroppedEvents_;
+};
+
+} /* namespace tcan */
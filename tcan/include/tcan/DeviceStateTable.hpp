@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tcan/DeviceStateEventQueue.hpp"
+
+namespace tcan {
+
+/*!
+ * Contiguous table of the states of all devices of a bus manager, updated by the devices on state transitions.
+ * Every change increments the version of the table, and each entry stores the version of its last change. Publishers (e.g. of
+ * tcan_msgs/DeviceStates) copy a consistent snapshot of the table or only the entries which changed since the version of their previous
+ * copy, without calling into the devices.
+ * setState(..) is lock-free and does not allocate. Readers retry while a state is written, so they do not block the writers.
+ * Slots are not reused, the capacity limits the number of devices registered over the lifetime of the table.
+ * Every change is also pushed to an optional event queue, see setEventQueue(..).
+ */
+class DeviceStateTable {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        //! name of the device. Valid for the lifetime of the table.
+        const std::string* name_;
+        int32_t state_;
+        //! version of the table at the last change of the entry
+        uint64_t version_;
+        //! time of the last change
+        Clock::time_point stamp_;
+        //! false if the device was removed
+        bool isRegistered_;
+    };
+
+    explicit DeviceStateTable(const unsigned int capacity = 256);
+
+    DeviceStateTable(const DeviceStateTable&) = delete;
+    DeviceStateTable& operator=(const DeviceStateTable&) = delete;
+
+    /*!
+     * Sets the queue the changes are pushed to. Must be called before any device is registered.
+     * @param queue event queue, nullptr to not queue events
+     */
+    inline void setEventQueue(DeviceStateEventQueue* queue) { eventQueue_ = queue; }
+
+    /*!
+     * Adds a device. Not real-time safe.
+     * @param name  name of the device
+     * @param state initial state
+     * @return      slot of the device, -1 if the table is full
+     */
+    int registerDevice(const std::string& name, const int32_t state);
+
+    //! Marks a device as removed. Later calls of setState(..) with the slot are ignored.
+    void unregisterDevice(const int slot);
+
+    //! Sets the state of a device. Does nothing if the state did not change.
+    void setState(const int slot, const int32_t state);
+
+    //! @return number of changes since construction
+    inline uint64_t getVersion() const { return completed_.load(std::memory_order_acquire); }
+
+    /*!
+     * Copies the registered devices. Does not allocate if entries has enough capacity.
+     * @param entries   states of the devices, in the order of registration (output parameter)
+     * @return          version of the snapshot
+     */
+    uint64_t getSnapshot(std::vector<Entry>& entries) const;
+
+    /*!
+     * Copies the entries which changed after a version, including the devices which were removed.
+     * @param version   version of the previous snapshot or changes, 0 for all entries
+     * @param entries   changed entries, in the order of registration (output parameter)
+     * @return          version of the copy, pass it to the next call
+     */
+    uint64_t getChanges(const uint64_t version, std::vector<Entry>& entries) const;
+
+    //! @return number of registered and removed devices
+    inline unsigned int getSize() const { return size_.load(std::memory_order_acquire); }
+
+    inline unsigned int getCapacity() const { return capacity_; }
+
+ protected:
+    struct Slot {
+        Slot():
+            name_(),
+            state_(0),
+            version_(0),
+            stamp_(0),
+            isRegistered_(false)
+        {
+        }
+
+        //! written before the slot is published by size_
+        std::string name_;
+        std::atomic<int32_t> state_;
+        std::atomic<uint64_t> version_;
+        //! [ns] of Clock
+        std::atomic<int64_t> stamp_;
+        std::atomic<bool> isRegistered_;
+    };
+
+    void pushEvent(const DeviceStateEventQueue::Event::Type type, const int slot, const int32_t previousState, const int32_t state,
+                   const int64_t stamp);
+
+    //! Starts a change, returns its version
+    uint64_t beginChange();
+    void endChange();
+
+    //! Copies the entries with a version larger than minVersion and returns the version of the copy
+    uint64_t copyEntries(const uint64_t minVersion, const bool includeUnregistered, std::vector<Entry>& entries) const;
+
+ protected:
+    const unsigned int capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<unsigned int> size_;
+
+    //! number of started and completed changes. Equal if no change is in progress.
+    std::atomic<uint64_t> begun_;
+    std::atomic<uint64_t> completed_;
+
+    //! serializes registerDevice(..)
+    std::mutex registerMutex_;
+
+    DeviceStateEventQueue* eventQueue_;
+};
+
+} /* namespace tcan */
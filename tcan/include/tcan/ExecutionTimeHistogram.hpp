@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace tcan {
+
+//! Histogram of execution times with bins of equal width. Not thread safe.
+class ExecutionTimeHistogram {
+ public:
+    /*!
+     * @param binWidth  width of a bin [us]
+     * @param numBins   number of bins. Samples larger than binWidth*numBins are counted as overflows.
+     */
+    ExecutionTimeHistogram(const unsigned int binWidth = 10, const unsigned int numBins = 100);
+
+    //! Adds a sample. Does not allocate memory.
+    void add(const std::chrono::nanoseconds& duration);
+
+    void reset();
+
+    inline unsigned int getNumSamples() const { return numSamples_; }
+
+    //! @return number of samples larger than the range of the histogram
+    inline unsigned int getNumOverflows() const { return numOverflows_; }
+
+    //! @return minimum, maximum and mean sample [us]. 0 if there are no samples.
+    double getMin() const;
+    double getMax() const;
+    double getMean() const;
+
+    /*!
+     * @param percentile    percentile in [0, 100]
+     * @return  upper edge of the bin containing the percentile [us]. Returns the maximum if the percentile lies in the overflow.
+     */
+    double getPercentile(const double percentile) const;
+
+    inline unsigned int getBinWidth() const { return binWidth_; }
+    inline const std::vector<unsigned int>& getBins() const { return bins_; }
+
+    //! @return one-line summary (samples, min, mean, p99, max, overflows)
+    std::string getSummary() const;
+
+ private:
+    // assembles a histogram from its atomic counters
+    friend class CallbackProfile;
+
+    unsigned int binWidth_;
+    std::vector<unsigned int> bins_;
+    unsigned int numSamples_;
+    unsigned int numOverflows_;
+    std::chrono::nanoseconds min_;
+    std::chrono::nanoseconds max_;
+    std::chrono::nanoseconds sum_;
+};
+
+} // namespace tcan
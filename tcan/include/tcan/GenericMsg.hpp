@@ -9,9 +9,13 @@ namespace tcan {
 
 class GenericMsg {
  public:
+    //! payloads up to this length are stored in the message itself, so copying such a message does not allocate memory
+    static constexpr unsigned int InlineCapacity = 64;
+
 	GenericMsg():
         length_(0),
-        data_(nullptr)
+        capacity_(InlineCapacity),
+        data_(inlineData_)
     {
     }
 
@@ -21,61 +25,90 @@ class GenericMsg {
 	 * @param data      data to be copied
 	 */
 	GenericMsg(const unsigned int length, const uint8_t* data):
-        length_(length),
-        data_(new uint8_t[length_])
+        GenericMsg()
     {
-        std::copy(&data[0], &data[length_], data_);
+        assign(length, data);
     }
 
 	GenericMsg(const std::string msg):
-        length_(msg.length()),
-        data_(new uint8_t[length_])
+        GenericMsg()
     {
-        std::copy(&msg.c_str()[0], &msg.c_str()[length_], data_);
+        assign(msg.length(), reinterpret_cast<const uint8_t*>(msg.c_str()));
     }
 
 	GenericMsg(const GenericMsg& other):
-        length_(other.length_),
-        data_(new uint8_t[length_])
+        GenericMsg()
     {
-        std::copy(&other.data_[0], &other.data_[length_], data_);
+        assign(other.length_, other.data_);
     }
 
 	GenericMsg(GenericMsg&& other):
-	    length_(other.length_),
-	    data_(other.data_)
+	    GenericMsg()
 	{
+	    if(other.data_ == other.inlineData_) {
+	        assign(other.length_, other.data_);
+	    }else{
+	        length_ = other.length_;
+	        capacity_ = other.capacity_;
+	        data_ = other.data_;
+	        other.data_ = other.inlineData_;
+	        other.capacity_ = InlineCapacity;
+	    }
 	    other.length_ = 0;
-	    other.data_ = nullptr;
 	}
 
     virtual ~GenericMsg() {
-        if(data_) {
-            delete[] data_;
-        }
+        release();
     }
 
     inline void operator=(const GenericMsg& other) {
-        if(data_) {
-            delete[] data_;
+        if(this != &other) {
+            assign(other.length_, other.data_);
         }
-        length_ = other.length_;
-        data_ = new uint8_t[length_];
-        std::copy(&other.data_[0], &other.data_[length_], data_);
     }
 
+    /*!
+     * Copies data into the message. The buffer of the message is reused if it is large enough, so a message which is assigned
+     * repeatedly (e.g. a member of a bus) only allocates when the payload grows beyond all previous ones.
+     * @param length    data length
+     * @param data      data to be copied
+     */
+    inline void assign(const unsigned int length, const uint8_t* data) {
+        if(length > capacity_) {
+            release();
+            data_ = new uint8_t[length];
+            capacity_ = length;
+        }
+        std::copy(data, data + length, data_);
+        length_ = length;
+    }
+
+    //! Takes ownership of data, which has to be allocated with new[]
     inline void emplaceData(const unsigned int length, uint8_t* data) {
+        release();
         length_ = length;
+        capacity_ = length;
         data_ = data;
-        data = nullptr;
     }
 
     inline unsigned int getLength() const { return length_; }
     inline const uint8_t* getData() const { return data_; }
 
+ private:
+    inline void release() {
+        if(data_ != inlineData_) {
+            delete[] data_;
+            data_ = inlineData_;
+            capacity_ = InlineCapacity;
+        }
+        length_ = 0;
+    }
+
  private:
     unsigned int length_;
+    unsigned int capacity_;
     uint8_t* data_;
+    uint8_t inlineData_[InlineCapacity];
 
 };
 
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tcan/IoUringEngineOptions.hpp"
+#include "tcan/PriorityInheritanceMutex.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace tcan {
+
+/*!
+ * I/O engine based on io_uring, which reads and writes the interfaces of many buses in a single completion loop, as an alternative to a
+ * receive and a transmit thread per bus (see BusOptions::useIoUring_).
+ * Sockets are read with a multishot receive into a ring of provided buffers, so a single submission yields a completion per received
+ * frame or chunk. Other files (e.g. serial ports), and sockets if the kernel lacks multishot receive, are read with a receive which is
+ * re-armed after every completion. The messages queued on all buses are copied into registered transmit buffers and submitted with a
+ * single system call per loop iteration. The writes of a bus are linked, such that they are executed in the order of the queue.
+ * io_uring is used through its system calls, without liburing. Requires Linux 5.19 (provided buffer rings), multishot receive Linux 6.0.
+ */
+class IoUringEngine {
+ public:
+    //! Transmit buffer of a client, filled by Client::prepareIoUringTransmits(..)
+    struct TransmitBuffer {
+        uint8_t* data_;
+        unsigned int capacity_;
+        //! number of bytes to write
+        unsigned int length_;
+        //! identifier of the message in traces (see TraceRecorder)
+        uint32_t traceId_;
+    };
+
+    //! Bus served by the engine. The functions are called by the completion loop.
+    class Client {
+     public:
+        virtual ~Client() = default;
+
+        /*!
+         * Copies the messages which may be written now from the output queue into the transmit buffers and removes them from the queue.
+         * @param buffers       free transmit buffers
+         * @param numBuffers    number of free transmit buffers
+         * @param wakeupTime    shall be lowered to the time at which a held back message may be written
+         * @return number of buffers filled, in the order they shall be written
+         */
+        virtual unsigned int prepareIoUringTransmits(TransmitBuffer* buffers, const unsigned int numBuffers,
+                                                     std::chrono::steady_clock::time_point& wakeupTime) = 0;
+
+        /*!
+         * Is called for every prepared transmit buffer, in order.
+         * @param result    number of bytes written, or the negative error number
+         */
+        virtual void handleIoUringWritten(const TransmitBuffer& buffer, const int result) = 0;
+
+        /*!
+         * Is called for every received chunk. For datagram sockets (e.g. SocketCAN) this is a single frame.
+         * @param data      received data. Valid during the call only, one spare byte follows the data (e.g. for a terminating \0).
+         */
+        virtual void handleIoUringReceived(uint8_t* data, const unsigned int length) = 0;
+
+        /*!
+         * Is called if a receive failed.
+         * @param error     negative error number, 0 if the connection was closed (not re-armed)
+         */
+        virtual void handleIoUringReceiveError(const int error) = 0;
+    };
+
+    //! Interface of a client
+    struct Endpoint {
+        Endpoint():
+            fileDescriptor_(-1),
+            isSocket_(false),
+            receiveBufferSize_(0),
+            transmitBufferSize_(0)
+        {
+        }
+
+        //! file descriptor of the interface. Blocking, the engine waits for it in the kernel.
+        int fileDescriptor_;
+        //! sockets are read with a multishot receive
+        bool isSocket_;
+        //! maximum number of bytes of a single receive and of a single write
+        unsigned int receiveBufferSize_;
+        unsigned int transmitBufferSize_;
+    };
+
+    //! Counters of the completion loop, to compare the number of system calls with the thread-per-direction model
+    struct Statistics {
+        //! io_uring_enter calls of the loop
+        uint64_t numEnterCalls_;
+        //! submitted operations and handled completions
+        uint64_t numSubmissions_;
+        uint64_t numCompletions_;
+        //! receives armed after the first one of a client, e.g. because a multishot receive ran out of buffers
+        uint64_t numReceiveRearms_;
+        //! wake-ups of the loop by notify(), which cost a system call of the notifying thread
+        uint64_t numWakeups_;
+    };
+
+    IoUringEngine(const IoUringEngineOptions& options = IoUringEngineOptions());
+
+    virtual ~IoUringEngine();
+
+    IoUringEngine(const IoUringEngine&) = delete;
+    IoUringEngine& operator=(const IoUringEngine&) = delete;
+
+    /*!
+     * Sets up the rings and checks the features of the kernel.
+     * @return false if the kernel does not support io_uring with provided buffer rings, or tcan was compiled with kernel headers
+     *         older than Linux 6.0
+     */
+    bool initialize();
+
+    inline bool isInitialized() const { return ringFileDescriptor_ >= 0; }
+
+    //! @return true if sockets are read with a multishot receive. Only valid after initialize().
+    inline bool isMultishotReceiveSupported() const { return isMultishotReceiveSupported_; }
+
+    /*!
+     * Adds a client and registers its buffers. May be called while the loop is running, but not from the loop.
+     * @return false if the engine is not initialized, the maximum number of clients is reached or the buffers could not be registered
+     */
+    bool addClient(Client* client, const Endpoint& endpoint);
+
+    /*!
+     * Removes a client. Cancels its operations and waits until they completed, such that the loop no longer accesses the client when the
+     * function returns. Queued transmits which were not written yet are dropped. Must not be called from the loop.
+     * @return false if the client was not added
+     */
+    bool removeClient(Client* client);
+
+    /*!
+     * Wakes up the loop to submit the messages queued on the clients. Only the first call after an iteration of the loop costs a system
+     * call, so it is cheap to call it for every queued message.
+     */
+    inline void notify() {
+        if(!isNotified_.exchange(true)) {
+            wakeUp();
+        }
+    }
+
+    /*!
+     * Creates the thread running the completion loop.
+     * @param priority  SCHED_FIFO priority of the thread
+     * @param cpu       CPU the thread is pinned to, -1 = not pinned
+     * @return false if not initialized or already running
+     */
+    bool start(const int priority, const int cpu);
+
+    /*!
+     * Stops the completion loop. The operations of the clients are cancelled when the loop terminates.
+     * @param wait  whether to wait for the thread to terminate
+     */
+    void stop(const bool wait=true);
+
+    inline bool isRunning() const { return running_; }
+
+    void getStatistics(Statistics& statistics) const;
+
+ protected:
+    enum class Operation : uint8_t {
+        Wakeup = 0,
+        Receive = 1,
+        Write = 2,
+        Cancel = 3
+    };
+
+    //! buffers and operations of a client. Accessed by the loop only while it is running, see clientsMutex_.
+    struct ClientState {
+        Client* client_;
+        Endpoint endpoint_;
+        //! buffer group of the provided receive buffers and index of the registered transmit buffer
+        uint16_t index_;
+
+        io_uring_buf_ring* receiveRing_;
+        std::size_t receiveRingSize_;
+        std::unique_ptr<uint8_t[]> receiveMemory_;
+        std::size_t receiveStride_;
+        bool isReceiveArmed_;
+        bool isReceiveStarted_;
+
+        std::unique_ptr<uint8_t[]> transmitMemory_;
+        std::vector<TransmitBuffer> transmitBuffers_;
+        //! oldest written buffer and number of buffers in flight. A new batch is submitted when the previous one completed.
+        unsigned int transmitHead_;
+        unsigned int numTransmitsInFlight_;
+
+        //! the receive is not re-armed after the connection was closed or the file can not be read
+        bool isReceiveClosed_;
+
+        bool isRemoving_;
+        bool isCancelSubmitted_;
+    };
+
+    inline uint64_t encodeUserData(const ClientState* state, const Operation operation) const {
+        return reinterpret_cast<uint64_t>(state) | static_cast<uint64_t>(operation);
+    }
+
+    //! Unmaps the rings and closes the ring and the eventfd, such that isInitialized() returns false
+    void releaseRing();
+
+    //! Writes to the eventfd read by the loop
+    void wakeUp();
+
+    //! @return free submission queue entry, submits the queue first if it is full. nullptr if submission failed.
+    io_uring_sqe* getSubmissionEntry();
+
+    /*!
+     * Submits the queued entries and waits for completions.
+     * @param minComplete   number of completions to wait for
+     * @param timeout       maximum time to wait, negative to wait without timeout
+     * @return result of io_uring_enter, negative error number on failure
+     */
+    int submitAndWait(const unsigned int minComplete, const std::chrono::nanoseconds& timeout);
+
+    //! Handles the available completions. @return number of completions
+    unsigned int processCompletions();
+
+    void handleCompletion(const io_uring_cqe& cqe);
+
+    void armWakeup();
+    void armReceive(ClientState& state);
+    void recycleReceiveBuffer(ClientState& state, const uint16_t bufferId);
+    void submitTransmits(ClientState& state, std::chrono::steady_clock::time_point& wakeupTime);
+    void submitCancel(ClientState& state);
+
+    //! Registers the provided receive buffers and the transmit buffer of a client
+    bool registerBuffers(ClientState& state);
+    void unregisterBuffers(ClientState& state);
+
+    //! Checks if a multishot receive on a socket pair is supported
+    bool probeMultishotReceive();
+
+    //! Activates added clients and finalizes removed clients. @return false if there is no client
+    bool updateClients();
+
+    //! Cancels all operations of the clients and waits until they completed, see IoUringEngineOptions::drainTimeout_
+    void drain();
+
+    void loop();
+
+ protected:
+    const IoUringEngineOptions options_;
+
+    int ringFileDescriptor_;
+    unsigned int numSubmissionEntries_;
+    void* submissionRing_;
+    std::size_t submissionRingSize_;
+    void* completionRing_;
+    std::size_t completionRingSize_;
+    io_uring_sqe* submissionEntries_;
+    std::size_t submissionEntriesSize_;
+
+    //! fields of the mapped rings
+    unsigned int* submissionHead_;
+    unsigned int* submissionTail_;
+    unsigned int submissionMask_;
+    unsigned int* submissionArray_;
+    unsigned int* completionHead_;
+    unsigned int* completionTail_;
+    unsigned int completionMask_;
+    io_uring_cqe* completionEntries_;
+
+    //! tail of the submission queue including the entries which were not submitted yet
+    unsigned int submissionTailLocal_;
+
+    bool isMultishotReceiveSupported_;
+
+    //! eventfd read by the loop, written by notify()
+    int wakeupFileDescriptor_;
+    uint64_t wakeupValue_;
+    bool isWakeupArmed_;
+    std::atomic<bool> isNotified_;
+
+    //! clients in the loop and clients to add, protected by clientsMutex_ while the loop is running
+    PriorityInheritanceMutex clientsMutex_;
+    std::condition_variable_any condClientsChanged_;
+    std::vector<std::unique_ptr<ClientState>> clients_;
+    std::vector<std::unique_ptr<ClientState>> addedClients_;
+    std::vector<bool> usedIndices_;
+    //! whether the loop owns the clients, protected by clientsMutex_
+    bool isLoopActive_;
+
+    //! the thread waits for this mutex, such that it runs with its priority and affinity from the start
+    std::mutex threadStartMutex_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    std::atomic<uint64_t> numEnterCalls_;
+    std::atomic<uint64_t> numSubmissions_;
+    std::atomic<uint64_t> numCompletions_;
+    std::atomic<uint64_t> numReceiveRearms_;
+    std::atomic<uint64_t> numWakeups_;
+};
+
+} /* namespace tcan */
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace tcan {
+
+struct IoUringEngineOptions {
+    IoUringEngineOptions():
+        numEntries_(256),
+        maxNumClients_(64),
+        numReceiveBuffers_(64),
+        numTransmitBuffers_(32),
+        drainTimeout_(1000)
+    {
+    }
+
+    virtual ~IoUringEngineOptions() = default;
+
+    //! size of the submission queue. The completion queue has twice the size.
+    unsigned int numEntries_;
+
+    //! maximum number of buses served at the same time
+    unsigned int maxNumClients_;
+
+    //! number of provided receive buffers per bus (power of two). A burst of more frames than this between two iterations of the
+    //! completion loop stays in the socket until the receive is re-armed.
+    unsigned int numReceiveBuffers_;
+
+    //! number of registered transmit buffers per bus, i.e. the maximum number of messages of a bus submitted at once
+    unsigned int numTransmitBuffers_;
+
+    //! time the completion loop waits for the cancelled operations of the buses when it stops [ms]
+    unsigned int drainTimeout_;
+};
+
+} /* namespace tcan */
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <pthread.h>
+
+namespace tcan {
+
+/*!
+ * Mutex with the PTHREAD_PRIO_INHERIT protocol, such that a thread holding the mutex inherits the priority of the highest-priority thread
+ * waiting for it. This bounds the blocking time of real-time threads which share a mutex with normal-priority threads.
+ * Satisfies Lockable, use it with std::lock_guard, std::unique_lock and std::condition_variable_any.
+ * Falls back to the default protocol if the system does not support priority inheritance, see isPriorityInheritanceEnabled().
+ */
+class PriorityInheritanceMutex {
+ public:
+    PriorityInheritanceMutex();
+    ~PriorityInheritanceMutex();
+
+    PriorityInheritanceMutex(const PriorityInheritanceMutex&) = delete;
+    PriorityInheritanceMutex& operator=(const PriorityInheritanceMutex&) = delete;
+
+    inline void lock() { pthread_mutex_lock(&mutex_); }
+    inline bool try_lock() { return pthread_mutex_trylock(&mutex_) == 0; }
+    inline void unlock() { pthread_mutex_unlock(&mutex_); }
+
+    //! @return false if the mutex uses the default protocol, because priority inheritance is not supported
+    inline bool isPriorityInheritanceEnabled() const { return isPriorityInheritanceEnabled_; }
+
+    inline pthread_mutex_t* native_handle() { return &mutex_; }
+
+ private:
+    pthread_mutex_t mutex_;
+    bool isPriorityInheritanceEnabled_;
+};
+
+} /* namespace tcan */
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tcan/PriorityInheritanceMutex.hpp"
+
+namespace tcan {
+
+/*!
+ * Read-copy-update container for data which is read on the real-time path and rarely modified (e.g. dispatch tables).
+ * Readers take a snapshot with read(), which costs two atomic read-modify-writes and no lock. Writers copy the current value, modify the
+ * copy and publish it atomically. Replaced values are freed after a grace period, i.e. once all readers which started before their
+ * replacement have finished, so a reader may keep using its snapshot while a writer publishes a new one.
+ * The readers are counted per phase. A grace period switches the phase, so new readers are counted separately, and ends when the
+ * count of the previous phase drops to zero. It thus ends also while other readers overlap continuously.
+ * Writers are serialized by a mutex and never wait for readers, so a value may be updated from within a read section (e.g. in a
+ * message callback). The grace periods are advanced by the writers and in reclaim().
+ */
+template <class T>
+class RcuPointer {
+ public:
+    //! Keeps the snapshot alive while the guard exists. Do not keep a guard longer than necessary, as it delays reclamation.
+    class ReadGuard {
+     public:
+        ReadGuard(const RcuPointer& rcu):
+            rcu_(&rcu)
+        {
+            // a reader which registers in the previous phase while a writer switches it retries, otherwise the writer could miss it
+            phase_ = rcu_->phase_.load();
+            rcu_->numReaders_[phase_].fetch_add(1);
+            while(rcu_->phase_.load() != phase_) {
+                rcu_->numReaders_[phase_].fetch_sub(1);
+                phase_ = rcu_->phase_.load();
+                rcu_->numReaders_[phase_].fetch_add(1);
+            }
+            value_ = rcu_->value_.load();
+        }
+
+        ReadGuard(ReadGuard&& other):
+            rcu_(other.rcu_),
+            value_(other.value_),
+            phase_(other.phase_)
+        {
+            other.rcu_ = nullptr;
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        ~ReadGuard()
+        {
+            if(rcu_ != nullptr) {
+                rcu_->numReaders_[phase_].fetch_sub(1);
+            }
+        }
+
+        inline const T& operator*() const { return *value_; }
+        inline const T* operator->() const { return value_; }
+        inline const T* get() const { return value_; }
+
+     private:
+        const RcuPointer* rcu_;
+        const T* value_;
+        unsigned int phase_;
+    };
+
+    RcuPointer():
+        RcuPointer(T())
+    {
+    }
+
+    explicit RcuPointer(const T& value):
+        value_(new T(value)),
+        phase_(0),
+        numReaders_(),
+        writeMutex_(),
+        retired_(),
+        expiring_()
+    {
+        numReaders_[0].store(0);
+        numReaders_[1].store(0);
+    }
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    ~RcuPointer()
+    {
+        delete value_.load();
+    }
+
+    //! @return snapshot of the current value
+    inline ReadGuard read() const { return ReadGuard(*this); }
+
+    /*!
+     * Copies the current value, applies modify(T&) to the copy and publishes it.
+     * @param modify    function object bool(T&)
+     * @return return value of modify
+     */
+    template <class F>
+    bool update(F&& modify) {
+        std::lock_guard<PriorityInheritanceMutex> guard(writeMutex_);
+        T* copy = new T(*value_.load());
+        const bool result = modify(*copy);
+        retired_.emplace_back(value_.exchange(copy));
+        reclaimWithoutLock();
+        return result;
+    }
+
+    //! Frees replaced values whose grace period has ended. Call this periodically from a non real-time thread if writers are rare.
+    void reclaim() {
+        std::lock_guard<PriorityInheritanceMutex> guard(writeMutex_);
+        reclaimWithoutLock();
+    }
+
+    /*!
+     * Waits until all readers which may still use a replaced value have finished, e.g. before deleting an object the old value
+     * pointed to. Readers which started later do not delay it. Must not be called from within a read section.
+     */
+    void synchronize() {
+        // the mutex is released while waiting, so readers may still update the value
+        while(true) {
+            {
+                std::lock_guard<PriorityInheritanceMutex> guard(writeMutex_);
+                reclaimWithoutLock();
+                if(retired_.empty() && expiring_.empty()) {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+ protected:
+    //! Advances the grace periods without waiting
+    void reclaimWithoutLock() {
+        // the values in expiring_ were replaced before the last phase switch. The readers which may use them are counted in the previous phase.
+        if(!expiring_.empty() && numReaders_[1 - phase_.load()].load() == 0) {
+            expiring_.clear();
+        }
+        if(expiring_.empty() && !retired_.empty()) {
+            expiring_.swap(retired_);
+            phase_.store(1 - phase_.load());
+            if(numReaders_[1 - phase_.load()].load() == 0) {
+                expiring_.clear();
+            }
+        }
+    }
+
+ protected:
+    std::atomic<T*> value_;
+    //! phase in which new readers are counted, only switched by the writers
+    std::atomic<unsigned int> phase_;
+    mutable std::atomic<unsigned int> numReaders_[2];
+    PriorityInheritanceMutex writeMutex_;
+    //! values replaced in the current phase
+    std::vector<std::unique_ptr<T>> retired_;
+    //! values replaced before the last phase switch, freed when the readers of the previous phase have finished
+    std::vector<std::unique_ptr<T>> expiring_;
+};
+
+} /* namespace tcan */
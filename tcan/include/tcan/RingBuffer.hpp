@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace tcan {
+
+/*!
+ * Double-ended queue on a contiguous ring of slots, with the subset of the std::deque interface used for the message queues.
+ * In contrast to std::deque, which allocates and frees blocks while elements pass through, the storage is only reallocated if the
+ * number of elements exceeds the capacity. Pushing and popping does thus not allocate once the queue has reached its steady state
+ * size or if enough capacity was reserved.
+ */
+template <class T>
+class RingBuffer {
+ public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    template <class Value, class Buffer>
+    class Iterator {
+     public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename std::remove_const<Value>::type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iterator(Buffer* buffer, const size_type index):
+            buffer_(buffer),
+            index_(index)
+        {
+        }
+
+        //! conversion of iterator to const_iterator
+        template <class OtherValue, class OtherBuffer>
+        Iterator(const Iterator<OtherValue, OtherBuffer>& other):
+            buffer_(other.buffer_),
+            index_(other.index_)
+        {
+        }
+
+        inline reference operator*() const { return (*buffer_)[index_]; }
+        inline pointer operator->() const { return &(*buffer_)[index_]; }
+        inline reference operator[](const difference_type n) const { return (*buffer_)[index_ + n]; }
+
+        inline Iterator& operator++() { ++index_; return *this; }
+        inline Iterator operator++(int) { Iterator it(*this); ++index_; return it; }
+        inline Iterator& operator--() { --index_; return *this; }
+        inline Iterator operator--(int) { Iterator it(*this); --index_; return it; }
+        inline Iterator& operator+=(const difference_type n) { index_ += n; return *this; }
+        inline Iterator& operator-=(const difference_type n) { index_ -= n; return *this; }
+        inline Iterator operator+(const difference_type n) const { return Iterator(buffer_, index_ + n); }
+        inline Iterator operator-(const difference_type n) const { return Iterator(buffer_, index_ - n); }
+        inline difference_type operator-(const Iterator& other) const { return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_); }
+
+        inline bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        inline bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+        inline bool operator<(const Iterator& other) const { return index_ < other.index_; }
+
+     private:
+        template <class, class> friend class Iterator;
+        friend class RingBuffer;
+
+        Buffer* buffer_;
+        size_type index_;
+    };
+
+    using iterator = Iterator<T, RingBuffer>;
+    using const_iterator = Iterator<const T, const RingBuffer>;
+
+    RingBuffer():
+        slots_(),
+        capacity_(0),
+        head_(0),
+        size_(0)
+    {
+    }
+
+    RingBuffer(const RingBuffer& other):
+        RingBuffer()
+    {
+        reserve(other.size_);
+        for(const T& element : other) {
+            push_back(element);
+        }
+    }
+
+    RingBuffer& operator=(const RingBuffer& other) {
+        if(this != &other) {
+            clear();
+            reserve(other.size_);
+            for(const T& element : other) {
+                push_back(element);
+            }
+        }
+        return *this;
+    }
+
+    ~RingBuffer()
+    {
+        clear();
+    }
+
+    inline size_type size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+    inline size_type capacity() const { return capacity_; }
+
+    //! Allocates storage for at least capacity elements. Does nothing if the capacity is already large enough.
+    void reserve(const size_type capacity) {
+        if(capacity <= capacity_) {
+            return;
+        }
+
+        std::unique_ptr<Slot[]> slots(new Slot[capacity]);
+        for(size_type i=0; i<size_; ++i) {
+            new(&slots[i]) T(std::move((*this)[i]));
+            (*this)[i].~T();
+        }
+        slots_ = std::move(slots);
+        capacity_ = capacity;
+        head_ = 0;
+    }
+
+    inline reference operator[](const size_type index) { return *reinterpret_cast<T*>(&slots_[wrap(head_ + index)]); }
+    inline const_reference operator[](const size_type index) const { return *reinterpret_cast<const T*>(&slots_[wrap(head_ + index)]); }
+
+    inline reference front() { return (*this)[0]; }
+    inline const_reference front() const { return (*this)[0]; }
+    inline reference back() { return (*this)[size_ - 1]; }
+    inline const_reference back() const { return (*this)[size_ - 1]; }
+
+    inline iterator begin() { return iterator(this, 0); }
+    inline iterator end() { return iterator(this, size_); }
+    inline const_iterator begin() const { return const_iterator(this, 0); }
+    inline const_iterator end() const { return const_iterator(this, size_); }
+
+    inline void push_back(const T& element) { emplace_back(element); }
+    inline void push_back(T&& element) { emplace_back(std::move(element)); }
+
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        growIfFull();
+        new(&slots_[wrap(head_ + size_)]) T(std::forward<Args>(args)...);
+        ++size_;
+    }
+
+    inline void push_front(const T& element) { emplace_front(element); }
+    inline void push_front(T&& element) { emplace_front(std::move(element)); }
+
+    template <class... Args>
+    void emplace_front(Args&&... args) {
+        growIfFull();
+        const size_type head = wrap(head_ + capacity_ - 1);
+        new(&slots_[head]) T(std::forward<Args>(args)...);
+        head_ = head;
+        ++size_;
+    }
+
+    void pop_front() {
+        front().~T();
+        head_ = wrap(head_ + 1);
+        --size_;
+    }
+
+    void pop_back() {
+        back().~T();
+        --size_;
+    }
+
+    //! Removes all elements. Keeps the storage.
+    void clear() {
+        while(!empty()) {
+            pop_back();
+        }
+        head_ = 0;
+    }
+
+    //! Inserts an element before position. Moves the following elements.
+    //! @return iterator to the inserted element
+    iterator insert(const_iterator position, const T& element) {
+        const size_type index = position.index_;
+        if(index == 0) {
+            push_front(element);
+            return begin();
+        }
+
+        push_back(element);
+        for(size_type i=size_-1; i>index; --i) {
+            std::swap((*this)[i], (*this)[i-1]);
+        }
+        return iterator(this, index);
+    }
+
+    //! @return iterator to the element following the erased one
+    inline iterator erase(const_iterator position) { return erase(position, position + 1); }
+
+    //! @return iterator to the element following the erased range
+    iterator erase(const_iterator first, const_iterator last) {
+        const size_type numErased = last.index_ - first.index_;
+        if(first.index_ == 0) {
+            for(size_type i=0; i<numErased; ++i) {
+                pop_front();
+            }
+            return begin();
+        }
+
+        for(size_type i=last.index_; i<size_; ++i) {
+            (*this)[i - numErased] = std::move((*this)[i]);
+        }
+        for(size_type i=0; i<numErased; ++i) {
+            pop_back();
+        }
+        return iterator(this, first.index_);
+    }
+
+ private:
+    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    inline size_type wrap(const size_type index) const { return (index >= capacity_) ? index - capacity_ : index; }
+
+    void growIfFull() {
+        if(size_ == capacity_) {
+            reserve(capacity_ == 0 ? 16 : 2*capacity_);
+        }
+    }
+
+ private:
+    std::unique_ptr<Slot[]> slots_;
+    size_type capacity_;
+    size_type head_;
+    size_type size_;
+};
+
+} /* namespace tcan */
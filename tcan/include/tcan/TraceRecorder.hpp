@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace tcan {
+
+/*!
+ * Records timestamped events of all buses (enqueue, drop, write, dispatch, sanity check, SYNC, ..) and writes them as Chrome trace-event JSON,
+ * which can be opened in chrome://tracing or the Perfetto UI (ui.perfetto.dev) to inspect a control cycle on a single timeline.
+ * Every thread writes its events into its own lock-free buffer. Real-time threads register with registerThread() before entering their loop,
+ * their buffers are allocated there or by start(..), other threads are registered on their first event. The buffer of a thread is freed
+ * after the thread exited and its events were written.
+ * A background thread drains the buffers into the file without blocking the recording threads. If a buffer is full, events are dropped and counted.
+ * Recording is started and stopped at runtime. If it is stopped, recording an event costs a relaxed atomic load.
+ */
+class TraceRecorder {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    /*!
+     * Starts recording. Does nothing if already recording.
+     * @param filename      output file, overwritten
+     * @param bufferSize    number of events per thread buffer. Only applied to buffers which are not allocated yet.
+     * @param flushInterval interval in which the background thread drains the buffers [ms]
+     * @return false if the file could not be opened
+     */
+    static bool start(const std::string& filename, const unsigned int bufferSize = 8192, const unsigned int flushInterval = 10);
+
+    //! Stops recording, writes the remaining events and closes the file.
+    static void stop();
+
+    /*!
+     * Registers the calling thread, allocating its event buffer if recording. Call it before the thread enters its real-time loop,
+     * otherwise the thread is registered (and memory allocated) on its first event. Events of a registered thread which are recorded
+     * before its buffer is allocated by start(..) are dropped.
+     */
+    static void registerThread();
+
+    static inline bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /*!
+     * @param name  name of the track (e.g. the bus name), shown as event category
+     * @return      id of the track. The same name always gives the same id.
+     */
+    static uint16_t getTrack(const std::string& name);
+
+    /*!
+     * Records an instantaneous event. Does nothing if not recording.
+     * @param name  name of the event. Must be a string literal, only the pointer is stored.
+     * @param track track of the event, see getTrack(..)
+     * @param id    identifier shown with the event, e.g. the COB id of a CAN frame
+     */
+    static void instant(const char* name, const uint16_t track, const uint32_t id);
+
+    //! Records an event from start until now. Does nothing if not recording.
+    static void complete(const char* name, const uint16_t track, const uint32_t id, const Clock::time_point& start);
+
+    //! @return number of events dropped because a thread buffer was full, since start(..)
+    static uint64_t getNumDroppedEvents();
+
+    //! Records a complete event for the lifetime of the scope. Only reads the clock if recording.
+    class Scope {
+     public:
+        Scope(const char* name, const uint16_t track, const uint32_t id):
+            name_(name),
+            track_(track),
+            id_(id),
+            enabled_(isEnabled()),
+            start_()
+        {
+            if(enabled_) {
+                start_ = Clock::now();
+            }
+        }
+
+        ~Scope()
+        {
+            if(enabled_) {
+                complete(name_, track_, id_, start_);
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        //! Changes the name of the event, e.g. if the operation failed. Must be a string literal.
+        inline void setName(const char* name) { name_ = name; }
+
+     private:
+        const char* name_;
+        const uint16_t track_;
+        const uint32_t id_;
+        const bool enabled_;
+        Clock::time_point start_;
+    };
+
+ private:
+    static std::atomic<bool> enabled_;
+};
+
+} // namespace tcan
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <thread>
 
 namespace tcan {
@@ -7,6 +11,89 @@ namespace tcan {
 bool setThreadPriority(std::thread& thread, const int priority);
 bool raiseThreadPriority(std::thread& thread, const int priority);
 
+/*!
+ * Pins a thread to a single CPU.
+ * @param thread    thread to be pinned
+ * @param cpu       index of the CPU. Negative values leave the affinity unchanged.
+ * @return true if successful
+ */
+bool setThreadAffinity(std::thread& thread, const int cpu);
+
+/*!
+ * Sleeps until an absolute time of the steady clock using clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, ..), which is not affected by
+ * the time spent before the call. Optionally busy-waits for the last part to reduce the wake-up latency.
+ * @param time      time to wake up at
+ * @param spinTime  duration before time in which the thread busy-waits instead of sleeping
+ */
+void sleepUntil(const std::chrono::steady_clock::time_point& time, const std::chrono::nanoseconds& spinTime = std::chrono::nanoseconds(0));
+
+//! @return smallest power of two which is not smaller than value, e.g. the size of a table indexed with a mask
+unsigned int roundUpToPowerOfTwo(const unsigned int value);
+
+//! Parameters of the SCHED_DEADLINE policy [us]. A runtime of 0 disables the policy.
+struct DeadlineParameters {
+    DeadlineParameters():
+        DeadlineParameters(0, 0, 0)
+    {
+    }
+
+    DeadlineParameters(const uint64_t runtime, const uint64_t deadline, const uint64_t period):
+        runtime_(runtime),
+        deadline_(deadline),
+        period_(period)
+    {
+    }
+
+    inline bool isEnabled() const { return runtime_ > 0; }
+
+    uint64_t runtime_;
+    uint64_t deadline_;
+    uint64_t period_;
+};
+
+/*!
+ * Switches the calling thread to the SCHED_DEADLINE policy. This overrides a previously set SCHED_FIFO priority.
+ * The kernel requires runtime <= deadline <= period and rejects the policy if the admission test fails.
+ * @return true if successful
+ */
+bool setCurrentThreadDeadline(const DeadlineParameters& parameters);
+
+/*!
+ * Locks all current and future pages of the process into RAM (mlockall), such that page faults do not occur in time-critical code.
+ * @return true if successful
+ */
+bool lockMemory();
+
+/*!
+ * Touches the given amount of stack of the calling thread, such that the pages are mapped before the thread enters its loop.
+ * Only prevents page faults on the stack if the memory is locked (see lockMemory()).
+ * @param size  number of bytes to prefault
+ */
+void prefaultStack(const std::size_t size);
+
+/*!
+ * Logs the effective scheduling policy, priority, CPU affinity and locked memory of the calling thread and warns about deviations from
+ * the requested settings.
+ * @param threadName    name used in the output
+ * @param priority      requested SCHED_FIFO priority (ignored if the deadline parameters are enabled)
+ * @param cpu           requested CPU, negative if the thread is not pinned
+ * @param deadline      requested SCHED_DEADLINE parameters
+ * @param memoryLocked  whether the memory is expected to be locked
+ * @return true if the effective settings match the requested ones
+ */
+bool reportRealtimeSettings(const std::string& threadName, const int priority, const int cpu, const DeadlineParameters& deadline,
+                            const bool memoryLocked);
+
+/*!
+ * Marks the calling thread as real-time thread. All threads created by tcan (bus, bus manager and cycle runner threads) mark themselves.
+ * Used by debug tools, e.g. the AllocationTracker records allocations of real-time threads only.
+ * @param isRealtime    false to remove the mark
+ */
+void markRealtimeThread(const bool isRealtime = true);
+
+//! @return true if the calling thread was marked by markRealtimeThread()
+bool isRealtimeThread();
+
 inline int calculatePollTimeoutMs(const timeval& tv) {
     // normal infinity timeout is specified with timeout of 0. poll has infinity for negative values, so subtract 1ms
     return (tv.tv_sec*1000 + tv.tv_usec/1000)-1;
@@ -0,0 +1,44 @@
+#pragma once
+
+/*!
+ * Statically defined tracing probes (USDT) at the key events of the buses, to be attached with bpftrace, perf or SystemTap, e.g.
+ *   bpftrace -e 'usdt:/path/to/libtcan_can.so:tcan:written { @[str(arg0)] = count(); }'
+ * See tcan_utils/bpftrace for example scripts.
+ * A probe compiles to a single nop if no tracer is attached. Its arguments are evaluated anyway, so only pass values which are
+ * already at hand. The probes are compiled in if <sys/sdt.h> (systemtap-sdt-dev) is available and TCAN_DISABLE_PROBES is not defined.
+ *
+ * Probes of the provider 'tcan' and their arguments:
+ *   enqueued(bus, id, queueSize)          message put into the output queue (queue size before the message was added)
+ *   dropped(bus, id, queueSize)           message dropped because the output queue is full
+ *   dequeued(bus, id)                     message taken from the output queue to be written
+ *   written(bus, id)                      message written successfully
+ *   write_failed(bus, id)                 writing the message failed
+ *   received(bus, id)                     message received, before dispatching
+ *   dispatched(bus, id, handled)          callback of the message returned, handled is 0 for unmapped messages
+ *   unmapped(bus, id)                     message received which no callback is registered for
+ *   device_state(device, nodeId, state)   state of a device changed (see CanDevice::State)
+ *   sdo_sent(device, nodeId, index, subindex)
+ *   sdo_answered(device, nodeId, index, subindex, error)
+ *   sdo_timeout(device, nodeId, index, subindex)
+ * bus and device are names (const char*), id is the COB id of CAN messages and 0 for other buses (see getTraceId(..)).
+ * NMT commands, which are queued as SdoMsg but have no index, do not fire sdo_sent.
+ */
+
+#if !defined(TCAN_DISABLE_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TCAN_HAS_PROBES 1
+#endif
+#endif
+
+#ifdef TCAN_HAS_PROBES
+#define TCAN_PROBE2(name, a1, a2) DTRACE_PROBE2(tcan, name, a1, a2)
+#define TCAN_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(tcan, name, a1, a2, a3)
+#define TCAN_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(tcan, name, a1, a2, a3, a4)
+#define TCAN_PROBE5(name, a1, a2, a3, a4, a5) DTRACE_PROBE5(tcan, name, a1, a2, a3, a4, a5)
+#else
+#define TCAN_PROBE2(name, a1, a2) do {} while(0)
+#define TCAN_PROBE3(name, a1, a2, a3) do {} while(0)
+#define TCAN_PROBE4(name, a1, a2, a3, a4) do {} while(0)
+#define TCAN_PROBE5(name, a1, a2, a3, a4, a5) do {} while(0)
+#endif
@@ -0,0 +1,161 @@
+#include "tcan/AllocationTracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <execinfo.h>
+#include <new>
+#include <sstream>
+
+#include "tcan/helper_functions.hpp"
+
+namespace {
+
+std::atomic<bool> recording{false};
+std::atomic<unsigned int> numAllocations{0};
+tcan::AllocationTracker::Record records[tcan::AllocationTracker::maxNumRecords];
+
+// set while the tracker itself allocates (backtrace, report), such that it does not record itself
+thread_local bool trackerActive = false;
+
+class TrackerActiveGuard {
+ public:
+    TrackerActiveGuard():
+        wasActive_(trackerActive)
+    {
+        trackerActive = true;
+    }
+
+    ~TrackerActiveGuard()
+    {
+        trackerActive = wasActive_;
+    }
+
+ private:
+    const bool wasActive_;
+};
+
+void recordAllocation(const std::size_t size) {
+    if(!recording.load(std::memory_order_relaxed) || trackerActive || !tcan::isRealtimeThread()) {
+        return;
+    }
+
+    TrackerActiveGuard guard;
+    const unsigned int index = numAllocations.fetch_add(1);
+    if(index < tcan::AllocationTracker::maxNumRecords) {
+        tcan::AllocationTracker::Record& record = records[index];
+        record.size_ = size;
+        record.numFrames_ = backtrace(record.frames_, tcan::AllocationTracker::maxNumFrames);
+    }
+}
+
+void* allocate(const std::size_t size) {
+    recordAllocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    void* ptr = allocate(size);
+    if(ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t& /*tag*/) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& /*tag*/) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+    std::free(ptr);
+}
+
+namespace tcan {
+
+constexpr unsigned int AllocationTracker::maxNumFrames;
+constexpr unsigned int AllocationTracker::maxNumRecords;
+
+void AllocationTracker::markSteadyState() {
+    recording = false;
+
+    {
+        // the first call of backtrace() loads libgcc, which allocates
+        TrackerActiveGuard guard;
+        void* frame;
+        backtrace(&frame, 1);
+    }
+
+    numAllocations = 0;
+    recording = true;
+}
+
+void AllocationTracker::stopRecording() {
+    recording = false;
+}
+
+bool AllocationTracker::isRecording() {
+    return recording;
+}
+
+unsigned int AllocationTracker::getNumAllocations() {
+    return numAllocations;
+}
+
+std::vector<AllocationTracker::Record> AllocationTracker::getRecords() {
+    TrackerActiveGuard guard;
+    const unsigned int numRecords = std::min(getNumAllocations(), maxNumRecords);
+    return std::vector<Record>(&records[0], &records[numRecords]);
+}
+
+std::string AllocationTracker::getReport() {
+    TrackerActiveGuard guard;
+    std::stringstream report;
+    const std::vector<Record> recordsCopy = getRecords();
+    report << getNumAllocations() << " allocations in real-time threads since the steady state marker";
+    if(recordsCopy.size() < getNumAllocations()) {
+        report << " (first " << recordsCopy.size() << " listed)";
+    }
+    report << std::endl;
+
+    for(unsigned int i=0; i<recordsCopy.size(); ++i) {
+        report << "allocation " << i << ": " << recordsCopy[i].size_ << " bytes" << std::endl;
+        char** symbols = backtrace_symbols(recordsCopy[i].frames_, recordsCopy[i].numFrames_);
+        for(int j=0; j<recordsCopy[i].numFrames_; ++j) {
+            report << "  " << (symbols != nullptr ? symbols[j] : "?") << std::endl;
+        }
+        std::free(symbols);
+    }
+    return report.str();
+}
+
+} // namespace tcan
@@ -0,0 +1,90 @@
+#include "tcan/CallbackProfile.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace tcan {
+
+namespace {
+
+//! lowers or raises value to sample, depending on isBetter
+template <class Compare>
+void updateExtremum(std::atomic<int64_t>& value, const int64_t sample, Compare isBetter) {
+    int64_t current = value.load(std::memory_order_relaxed);
+    while(isBetter(sample, current) && !value.compare_exchange_weak(current, sample, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+CallbackProfile::CallbackProfile(const std::chrono::nanoseconds& slowThreshold, const unsigned int binWidth, const unsigned int numBins):
+    slowThreshold_(slowThreshold),
+    binWidth_(std::max(1u, binWidth)),
+    numBins_(std::max(1u, numBins)),
+    bins_(new std::atomic<unsigned int>[numBins_]),
+    numSamples_(0),
+    numOverflows_(0),
+    minDuration_(std::numeric_limits<int64_t>::max()),
+    maxDuration_(0),
+    sumDuration_(0),
+    numSlowCalls_(0),
+    numNewSlowCalls_(0),
+    maxSlowCallDuration_(0)
+{
+    for(unsigned int i=0; i<numBins_; ++i) {
+        bins_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void CallbackProfile::add(const std::chrono::nanoseconds& duration) {
+    // same binning as ExecutionTimeHistogram::add(..)
+    const long long bin = std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / binWidth_;
+    if(bin < 0) {
+        bins_[0].fetch_add(1, std::memory_order_relaxed);
+    }else if(bin < static_cast<long long>(numBins_)) {
+        bins_[bin].fetch_add(1, std::memory_order_relaxed);
+    }else{
+        numOverflows_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    numSamples_.fetch_add(1, std::memory_order_relaxed);
+    updateExtremum(minDuration_, duration.count(), std::less<int64_t>());
+    updateExtremum(maxDuration_, duration.count(), std::greater<int64_t>());
+    sumDuration_.fetch_add(duration.count(), std::memory_order_relaxed);
+
+    if(slowThreshold_.count() > 0 && duration >= slowThreshold_) {
+        ++numSlowCalls_;
+        ++numNewSlowCalls_;
+        updateExtremum(maxSlowCallDuration_, duration.count(), std::greater<int64_t>());
+    }
+}
+
+ExecutionTimeHistogram CallbackProfile::getHistogram() const {
+    ExecutionTimeHistogram histogram(binWidth_, numBins_);
+    for(unsigned int i=0; i<numBins_; ++i) {
+        histogram.bins_[i] = bins_[i].load(std::memory_order_relaxed);
+    }
+    histogram.numSamples_ = numSamples_.load(std::memory_order_relaxed);
+    histogram.numOverflows_ = numOverflows_.load(std::memory_order_relaxed);
+    histogram.min_ = std::chrono::nanoseconds(minDuration_.load(std::memory_order_relaxed));
+    histogram.max_ = std::chrono::nanoseconds(maxDuration_.load(std::memory_order_relaxed));
+    histogram.sum_ = std::chrono::nanoseconds(sumDuration_.load(std::memory_order_relaxed));
+    return histogram;
+}
+
+void CallbackProfile::reset() {
+    for(unsigned int i=0; i<numBins_; ++i) {
+        bins_[i].store(0, std::memory_order_relaxed);
+    }
+    numSamples_ = 0;
+    numOverflows_ = 0;
+    minDuration_ = std::numeric_limits<int64_t>::max();
+    maxDuration_ = 0;
+    sumDuration_ = 0;
+    numSlowCalls_ = 0;
+    numNewSlowCalls_ = 0;
+    maxSlowCallDuration_ = 0;
+}
+
+} // namespace tcan
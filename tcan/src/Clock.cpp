@@ -0,0 +1,211 @@
+#include "tcan/Clock.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace tcan {
+
+std::atomic<bool> Clock::isVirtual_{false};
+std::atomic<int64_t> Clock::virtualTime_{0};
+
+namespace {
+
+//! a thread waiting for a virtual time. Lives on the stack of the waiting thread.
+struct Sleeper {
+    Clock::time_point deadline_;
+    //! condition variable and its mutex for waitUntil(..), nullptr for sleepUntil(..)
+    std::condition_variable_any* cond_;
+    PriorityInheritanceMutex* mutex_;
+    const std::atomic<bool>* running_;
+    //! set when the deadline passed
+    bool isWoken_;
+    //! set while the advancing thread notifies cond_. The sleeper must not return before.
+    bool isNotifying_;
+};
+
+struct State {
+    std::mutex mutex_;
+    //! notified on every change of the time or the sleepers
+    std::condition_variable cond_;
+    std::vector<Sleeper*> sleepers_;
+    //! sleepers which are not woken yet
+    unsigned int numSleepers_ = 0;
+};
+
+// never destroyed, such that threads may still wait during static destruction
+State& getState() {
+    static State* state = new State();
+    return *state;
+}
+
+inline int64_t toNanoseconds(const Clock::time_point& time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void addSleeperWithoutLock(State& state, Sleeper& sleeper) {
+    state.sleepers_.push_back(&sleeper);
+    ++state.numSleepers_;
+    state.cond_.notify_all();
+}
+
+void removeSleeperWithoutLock(State& state, Sleeper& sleeper) {
+    state.sleepers_.erase(std::remove(state.sleepers_.begin(), state.sleepers_.end(), &sleeper), state.sleepers_.end());
+    if(!sleeper.isWoken_) {
+        --state.numSleepers_;
+    }
+}
+
+/*!
+ * Wakes the sleepers whose deadline passed and notifies the condition variables of the woken waitUntil(..) calls. The condition variables
+ * are notified with their mutex locked, such that a thread which registered itself but did not start waiting yet does not miss it.
+ */
+void wakeSleepers(const Clock::time_point& time) {
+    State& state = getState();
+    std::vector<Sleeper*> notifiedSleepers;
+    {
+        std::lock_guard<std::mutex> guard(state.mutex_);
+        for(Sleeper* sleeper : state.sleepers_) {
+            if(!sleeper->isWoken_ && sleeper->deadline_ <= time) {
+                sleeper->isWoken_ = true;
+                --state.numSleepers_;
+                if(sleeper->cond_ != nullptr) {
+                    sleeper->isNotifying_ = true;
+                    notifiedSleepers.push_back(sleeper);
+                }
+            }
+        }
+        state.cond_.notify_all();
+    }
+
+    if(notifiedSleepers.empty()) {
+        return;
+    }
+    for(Sleeper* sleeper : notifiedSleepers) {
+        std::lock_guard<PriorityInheritanceMutex> guard(*sleeper->mutex_);
+        sleeper->cond_->notify_all();
+    }
+
+    std::lock_guard<std::mutex> guard(state.mutex_);
+    for(Sleeper* sleeper : notifiedSleepers) {
+        sleeper->isNotifying_ = false;
+    }
+    state.cond_.notify_all();
+}
+
+} /* namespace */
+
+bool Clock::sleepUntil(const time_point& time, const std::atomic<bool>* running) {
+    if(!isVirtual()) {
+        std::this_thread::sleep_until(time);
+        return true;
+    }
+
+    State& state = getState();
+    std::unique_lock<std::mutex> lock(state.mutex_);
+    if(now() >= time) {
+        return true;
+    }
+
+    Sleeper sleeper{time, nullptr, nullptr, running, false, false};
+    addSleeperWithoutLock(state, sleeper);
+    state.cond_.wait(lock, [&sleeper]{
+        return sleeper.isWoken_ || !isVirtual() || (sleeper.running_ != nullptr && !*sleeper.running_);
+    });
+    removeSleeperWithoutLock(state, sleeper);
+    return sleeper.running_ == nullptr || *sleeper.running_;
+}
+
+void Clock::waitUntil(std::condition_variable_any& cond, std::unique_lock<PriorityInheritanceMutex>& lock, const time_point& time) {
+    if(!isVirtual()) {
+        cond.wait_until(lock, time);
+        return;
+    }
+
+    State& state = getState();
+    Sleeper sleeper{time, &cond, lock.mutex(), nullptr, false, false};
+    {
+        std::lock_guard<std::mutex> guard(state.mutex_);
+        if(now() >= time) {
+            return;
+        }
+        addSleeperWithoutLock(state, sleeper);
+    }
+
+    // the caller's mutex is held until the wait starts, so a wake-up by wakeSleepers(..) is not missed
+    cond.wait(lock);
+
+    std::unique_lock<std::mutex> guard(state.mutex_);
+    if(sleeper.isNotifying_) {
+        // wakeSleepers(..) needs the caller's mutex to notify the condition variable
+        lock.unlock();
+        state.cond_.wait(guard, [&sleeper]{ return !sleeper.isNotifying_; });
+        guard.unlock();
+        lock.lock();
+        guard.lock();
+    }
+    removeSleeperWithoutLock(state, sleeper);
+}
+
+void Clock::notifySleepers() {
+    State& state = getState();
+    std::lock_guard<std::mutex> guard(state.mutex_);
+    state.cond_.notify_all();
+}
+
+void Clock::startVirtualTime(const time_point& start) {
+    virtualTime_.store(toNanoseconds(start), std::memory_order_release);
+    isVirtual_.store(true, std::memory_order_release);
+}
+
+void Clock::stopVirtualTime() {
+    {
+        std::lock_guard<std::mutex> guard(getState().mutex_);
+        isVirtual_.store(false, std::memory_order_release);
+    }
+    wakeSleepers(time_point::max());
+}
+
+void Clock::advanceTo(const time_point& time) {
+    {
+        std::lock_guard<std::mutex> guard(getState().mutex_);
+        if(toNanoseconds(time) <= virtualTime_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        virtualTime_.store(toNanoseconds(time), std::memory_order_release);
+    }
+    wakeSleepers(time);
+}
+
+bool Clock::advanceToNextDeadline() {
+    time_point deadline = time_point::max();
+    {
+        State& state = getState();
+        std::lock_guard<std::mutex> guard(state.mutex_);
+        for(const Sleeper* sleeper : state.sleepers_) {
+            if(!sleeper->isWoken_) {
+                deadline = std::min(deadline, sleeper->deadline_);
+            }
+        }
+    }
+
+    if(deadline == time_point::max()) {
+        return false;
+    }
+    advanceTo(deadline);
+    return true;
+}
+
+unsigned int Clock::getNumSleepers() {
+    State& state = getState();
+    std::lock_guard<std::mutex> guard(state.mutex_);
+    return state.numSleepers_;
+}
+
+bool Clock::waitForSleepers(const unsigned int numSleepers, const std::chrono::milliseconds& timeout) {
+    State& state = getState();
+    std::unique_lock<std::mutex> lock(state.mutex_);
+    return state.cond_.wait_for(lock, timeout, [&state, numSleepers]{ return state.numSleepers_ >= numSleepers; });
+}
+
+} /* namespace tcan */
@@ -0,0 +1,63 @@
+#include "tcan/DeviceStateEventQueue.hpp"
+#include "tcan/helper_functions.hpp"
+
+#include <algorithm>
+
+namespace tcan {
+
+DeviceStateEventQueue::DeviceStateEventQueue(const unsigned int capacity):
+    mask_(roundUpToPowerOfTwo(std::max(1u, capacity)) - 1),
+    cells_(new Cell[mask_ + 1]),
+    pushPosition_(0),
+    popPosition_(0),
+    numDroppedEvents_(0)
+{
+    for(unsigned int i=0; i<=mask_; ++i) {
+        cells_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool DeviceStateEventQueue::push(const Event& event) {
+    uint64_t position = pushPosition_.load(std::memory_order_relaxed);
+    while(true) {
+        Cell& cell = cells_[position & mask_];
+        const uint64_t sequence = cell.sequence_.load(std::memory_order_acquire);
+        if(sequence == position) {
+            // the cell is free, claim it unless another producer was faster
+            if(pushPosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.event_ = event;
+                cell.sequence_.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }else if(sequence < position) {
+            // the cell was not read yet
+            numDroppedEvents_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }else{
+            position = pushPosition_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool DeviceStateEventQueue::pop(Event& event) {
+    Cell& cell = cells_[popPosition_ & mask_];
+    if(cell.sequence_.load(std::memory_order_acquire) != popPosition_ + 1) {
+        return false;
+    }
+
+    event = cell.event_;
+    cell.sequence_.store(popPosition_ + mask_ + 1, std::memory_order_release);
+    ++popPosition_;
+    return true;
+}
+
+unsigned int DeviceStateEventQueue::popAll(std::vector<Event>& events) {
+    events.clear();
+    Event event;
+    while(pop(event)) {
+        events.push_back(event);
+    }
+    return events.size();
+}
+
+} /* namespace tcan */
@@ -0,0 +1,142 @@
+#include "tcan/DeviceStateTable.hpp"
+
+#include <thread>
+
+namespace tcan {
+
+namespace {
+
+inline int64_t toNanoseconds(const DeviceStateTable::Clock::time_point& time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+} /* namespace */
+
+DeviceStateTable::DeviceStateTable(const unsigned int capacity):
+    capacity_(capacity),
+    slots_(new Slot[capacity]),
+    size_(0),
+    begun_(0),
+    completed_(0),
+    registerMutex_(),
+    eventQueue_(nullptr)
+{
+}
+
+int DeviceStateTable::registerDevice(const std::string& name, const int32_t state) {
+    std::lock_guard<std::mutex> guard(registerMutex_);
+    const unsigned int slot = size_.load(std::memory_order_relaxed);
+    if(slot >= capacity_) {
+        return -1;
+    }
+
+    Slot& entry = slots_[slot];
+    entry.name_ = name;
+    const int64_t stamp = toNanoseconds(Clock::now());
+    const uint64_t version = beginChange();
+    entry.state_.store(state, std::memory_order_relaxed);
+    entry.version_.store(version, std::memory_order_relaxed);
+    entry.stamp_.store(stamp, std::memory_order_relaxed);
+    entry.isRegistered_.store(true, std::memory_order_relaxed);
+    size_.store(slot + 1, std::memory_order_release);
+    endChange();
+    pushEvent(DeviceStateEventQueue::Event::Type::Registered, slot, state, state, stamp);
+    return static_cast<int>(slot);
+}
+
+void DeviceStateTable::unregisterDevice(const int slot) {
+    if(slot < 0 || static_cast<unsigned int>(slot) >= getSize()) {
+        return;
+    }
+
+    Slot& entry = slots_[slot];
+    const int64_t stamp = toNanoseconds(Clock::now());
+    const uint64_t version = beginChange();
+    entry.isRegistered_.store(false, std::memory_order_relaxed);
+    entry.version_.store(version, std::memory_order_relaxed);
+    entry.stamp_.store(stamp, std::memory_order_relaxed);
+    endChange();
+    const int32_t state = entry.state_.load(std::memory_order_relaxed);
+    pushEvent(DeviceStateEventQueue::Event::Type::Unregistered, slot, state, state, stamp);
+}
+
+void DeviceStateTable::setState(const int slot, const int32_t state) {
+    if(slot < 0 || static_cast<unsigned int>(slot) >= getSize()) {
+        return;
+    }
+
+    Slot& entry = slots_[slot];
+    if(!entry.isRegistered_.load(std::memory_order_relaxed) || entry.state_.load(std::memory_order_relaxed) == state) {
+        return;
+    }
+
+    const int64_t stamp = toNanoseconds(Clock::now());
+    const uint64_t version = beginChange();
+    const int32_t previousState = entry.state_.exchange(state, std::memory_order_relaxed);
+    entry.version_.store(version, std::memory_order_relaxed);
+    entry.stamp_.store(stamp, std::memory_order_relaxed);
+    endChange();
+    if(previousState != state) {
+        pushEvent(DeviceStateEventQueue::Event::Type::StateChanged, slot, previousState, state, stamp);
+    }
+}
+
+uint64_t DeviceStateTable::getSnapshot(std::vector<Entry>& entries) const {
+    return copyEntries(0, false, entries);
+}
+
+uint64_t DeviceStateTable::getChanges(const uint64_t version, std::vector<Entry>& entries) const {
+    return copyEntries(version, true, entries);
+}
+
+void DeviceStateTable::pushEvent(const DeviceStateEventQueue::Event::Type type, const int slot, const int32_t previousState,
+                                 const int32_t state, const int64_t stamp) {
+    if(eventQueue_ != nullptr) {
+        eventQueue_->push(DeviceStateEventQueue::Event{type, &slots_[slot].name_, slot, previousState, state,
+                                                       Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(stamp)))});
+    }
+}
+
+uint64_t DeviceStateTable::beginChange() {
+    const uint64_t version = begun_.fetch_add(1, std::memory_order_relaxed) + 1;
+    // the stores to the slot must not become visible before the increment (seqlock)
+    std::atomic_thread_fence(std::memory_order_release);
+    return version;
+}
+
+void DeviceStateTable::endChange() {
+    completed_.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t DeviceStateTable::copyEntries(const uint64_t minVersion, const bool includeUnregistered, std::vector<Entry>& entries) const {
+    while(true) {
+        const uint64_t completed = completed_.load(std::memory_order_acquire);
+        const uint64_t begun = begun_.load(std::memory_order_acquire);
+        if(begun != completed) {
+            // a change is in progress
+            std::this_thread::yield();
+            continue;
+        }
+
+        entries.clear();
+        const unsigned int size = size_.load(std::memory_order_acquire);
+        for(unsigned int i=0; i<size; ++i) {
+            const Slot& slot = slots_[i];
+            const uint64_t version = slot.version_.load(std::memory_order_relaxed);
+            const bool isRegistered = slot.isRegistered_.load(std::memory_order_relaxed);
+            if(version <= minVersion || (!isRegistered && !includeUnregistered)) {
+                continue;
+            }
+            entries.push_back(Entry{&slot.name_, slot.state_.load(std::memory_order_relaxed), version,
+                                    Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(slot.stamp_.load(std::memory_order_relaxed)))),
+                                    isRegistered});
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(begun_.load(std::memory_order_relaxed) == begun) {
+            return begun;
+        }
+    }
+}
+
+} /* namespace tcan */
@@ -0,0 +1,79 @@
+#include "tcan/ExecutionTimeHistogram.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace tcan {
+
+ExecutionTimeHistogram::ExecutionTimeHistogram(const unsigned int binWidth, const unsigned int numBins):
+    binWidth_(std::max(1u, binWidth)),
+    bins_(std::max(1u, numBins), 0),
+    numSamples_(0),
+    numOverflows_(0),
+    min_(std::chrono::nanoseconds::max()),
+    max_(0),
+    sum_(0)
+{
+}
+
+void ExecutionTimeHistogram::add(const std::chrono::nanoseconds& duration) {
+    const long long bin = std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / binWidth_;
+    if(bin < 0) {
+        ++bins_.front();
+    }else if(bin < static_cast<long long>(bins_.size())) {
+        ++bins_[bin];
+    }else{
+        ++numOverflows_;
+    }
+
+    ++numSamples_;
+    min_ = std::min(min_, duration);
+    max_ = std::max(max_, duration);
+    sum_ += duration;
+}
+
+void ExecutionTimeHistogram::reset() {
+    std::fill(bins_.begin(), bins_.end(), 0);
+    numSamples_ = 0;
+    numOverflows_ = 0;
+    min_ = std::chrono::nanoseconds::max();
+    max_ = std::chrono::nanoseconds(0);
+    sum_ = std::chrono::nanoseconds(0);
+}
+
+double ExecutionTimeHistogram::getMin() const {
+    return (numSamples_ == 0) ? 0.0 : std::chrono::duration<double, std::micro>(min_).count();
+}
+
+double ExecutionTimeHistogram::getMax() const {
+    return (numSamples_ == 0) ? 0.0 : std::chrono::duration<double, std::micro>(max_).count();
+}
+
+double ExecutionTimeHistogram::getMean() const {
+    return (numSamples_ == 0) ? 0.0 : std::chrono::duration<double, std::micro>(sum_).count() / numSamples_;
+}
+
+double ExecutionTimeHistogram::getPercentile(const double percentile) const {
+    if(numSamples_ == 0) {
+        return 0.0;
+    }
+
+    const double threshold = std::min(100.0, std::max(0.0, percentile)) / 100.0 * numSamples_;
+    double count = 0.0;
+    for(unsigned int i=0; i<bins_.size(); ++i) {
+        count += bins_[i];
+        if(count >= threshold) {
+            return static_cast<double>((i+1)*binWidth_);
+        }
+    }
+    return getMax();
+}
+
+std::string ExecutionTimeHistogram::getSummary() const {
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer), "n=%u min=%.1fus mean=%.1fus p99<=%.0fus max=%.1fus overflows=%u",
+                  numSamples_, getMin(), getMean(), getPercentile(99.0), getMax(), numOverflows_);
+    return std::string(buffer);
+}
+
+} // namespace tcan
@@ -0,0 +1,921 @@
+#include "tcan/IoUringEngine.hpp"
+#include "tcan/helper_functions.hpp"
+#include "tcan/TraceRecorder.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+#include <errno.h>
+#include <string.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+// the engine needs the uapi headers of Linux 6.0 (provided buffer rings, multishot receive, cancellation by file descriptor, sparse
+// buffer tables). With older headers a stub is compiled whose initialize() fails, such that the buses keep their threads.
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ASYNC_CANCEL_FD) && defined(IORING_RSRC_REGISTER_SPARSE) && \
+    defined(IORING_FEAT_EXT_ARG)
+#define TCAN_HAS_IO_URING
+#endif
+
+#ifdef TCAN_HAS_IO_URING
+#include <linux/time_types.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace tcan {
+
+IoUringEngine::IoUringEngine(const IoUringEngineOptions& options):
+    options_(options),
+    ringFileDescriptor_(-1),
+    numSubmissionEntries_(0),
+    submissionRing_(nullptr),
+    submissionRingSize_(0),
+    completionRing_(nullptr),
+    completionRingSize_(0),
+    submissionEntries_(nullptr),
+    submissionEntriesSize_(0),
+    submissionHead_(nullptr),
+    submissionTail_(nullptr),
+    submissionMask_(0),
+    submissionArray_(nullptr),
+    completionHead_(nullptr),
+    completionTail_(nullptr),
+    completionMask_(0),
+    completionEntries_(nullptr),
+    submissionTailLocal_(0),
+    isMultishotReceiveSupported_(false),
+    wakeupFileDescriptor_(-1),
+    wakeupValue_(0),
+    isWakeupArmed_(false),
+    isNotified_(false),
+    clientsMutex_(),
+    condClientsChanged_(),
+    clients_(),
+    addedClients_(),
+    usedIndices_(),
+    isLoopActive_(false),
+    threadStartMutex_(),
+    thread_(),
+    running_(false),
+    numEnterCalls_(0),
+    numSubmissions_(0),
+    numCompletions_(0),
+    numReceiveRearms_(0),
+    numWakeups_(0)
+{
+    // the clients are added by the application while the real-time completion loop runs
+    if(!clientsMutex_.isPriorityInheritanceEnabled()) {
+        MELO_WARN("Failed to enable priority inheritance on the clients mutex of the io_uring engine");
+    }
+}
+
+#ifdef TCAN_HAS_IO_URING
+
+namespace {
+
+// io_uring system calls, liburing is not a dependency
+inline int ioUringSetup(const unsigned int entries, io_uring_params* params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+inline int ioUringEnter(const int fd, const unsigned int toSubmit, const unsigned int minComplete, const unsigned int flags,
+                        const void* arg, const std::size_t argSize) {
+    return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+inline int ioUringRegister(const int fd, const unsigned int opcode, const void* arg, const unsigned int numArgs) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, numArgs);
+}
+
+//! offset of the read and write operations for files without position (sockets, serial ports)
+constexpr uint64_t currentPosition = static_cast<uint64_t>(-1);
+
+constexpr uint64_t operationMask = 3;
+
+inline std::size_t alignSize(const std::size_t size, const std::size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+} // anonymous namespace
+
+IoUringEngine::~IoUringEngine()
+{
+    stop(true);
+
+    for(auto& state : clients_) {
+        unregisterBuffers(*state);
+    }
+    for(auto& state : addedClients_) {
+        unregisterBuffers(*state);
+    }
+    clients_.clear();
+    addedClients_.clear();
+    releaseRing();
+}
+
+void IoUringEngine::releaseRing() {
+    // the registered buffers and the operations in flight are released by the kernel when the ring is closed
+    if(submissionEntries_ != nullptr) {
+        munmap(submissionEntries_, submissionEntriesSize_);
+        submissionEntries_ = nullptr;
+    }
+    if(completionRing_ != nullptr && completionRing_ != submissionRing_) {
+        munmap(completionRing_, completionRingSize_);
+    }
+    completionRing_ = nullptr;
+    if(submissionRing_ != nullptr) {
+        munmap(submissionRing_, submissionRingSize_);
+        submissionRing_ = nullptr;
+    }
+    if(ringFileDescriptor_ >= 0) {
+        close(ringFileDescriptor_);
+        ringFileDescriptor_ = -1;
+    }
+    if(wakeupFileDescriptor_ >= 0) {
+        close(wakeupFileDescriptor_);
+        wakeupFileDescriptor_ = -1;
+    }
+}
+
+bool IoUringEngine::initialize() {
+    if(isInitialized()) {
+        return true;
+    }
+    if(options_.numTransmitBuffers_ == 0 || options_.numTransmitBuffers_ > options_.numEntries_ ||
+       options_.numReceiveBuffers_ == 0 || (options_.numReceiveBuffers_ & (options_.numReceiveBuffers_ - 1)) != 0) {
+        MELO_ERROR("Invalid io_uring engine options: the number of receive buffers has to be a power of two, the number of transmit "
+                   "buffers at most the number of entries.");
+        return false;
+    }
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const int fd = ioUringSetup(options_.numEntries_, &params);
+    if(fd < 0) {
+        MELO_WARN("Failed to set up io_uring:\n  %s", strerror(errno));
+        return false;
+    }
+    ringFileDescriptor_ = fd;
+
+    if(!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+        MELO_WARN("io_uring of the kernel lacks required features (timeout argument, no dropped completions).");
+        releaseRing();
+        return false;
+    }
+
+    // map the submission and completion rings, which share a mapping on kernels with IORING_FEAT_SINGLE_MMAP
+    numSubmissionEntries_ = params.sq_entries;
+    submissionRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    completionRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool isSingleMapping = (params.features & IORING_FEAT_SINGLE_MMAP);
+    if(isSingleMapping) {
+        submissionRingSize_ = std::max(submissionRingSize_, completionRingSize_);
+        completionRingSize_ = submissionRingSize_;
+    }
+
+    void* submissionRing = mmap(nullptr, submissionRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    void* completionRing = MAP_FAILED;
+    void* submissionEntries = MAP_FAILED;
+    if(submissionRing != MAP_FAILED) {
+        submissionRing_ = submissionRing;
+        completionRing = isSingleMapping ? submissionRing :
+                         mmap(nullptr, completionRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    if(completionRing != MAP_FAILED) {
+        completionRing_ = completionRing;
+        submissionEntriesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        submissionEntries = mmap(nullptr, submissionEntriesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    }
+    if(submissionEntries == MAP_FAILED) {
+        MELO_WARN("Failed to map the io_uring rings:\n  %s", strerror(errno));
+        releaseRing();
+        return false;
+    }
+    submissionEntries_ = static_cast<io_uring_sqe*>(submissionEntries);
+
+    uint8_t* submissionBase = static_cast<uint8_t*>(submissionRing_);
+    submissionHead_ = reinterpret_cast<unsigned int*>(submissionBase + params.sq_off.head);
+    submissionTail_ = reinterpret_cast<unsigned int*>(submissionBase + params.sq_off.tail);
+    submissionMask_ = *reinterpret_cast<unsigned int*>(submissionBase + params.sq_off.ring_mask);
+    submissionArray_ = reinterpret_cast<unsigned int*>(submissionBase + params.sq_off.array);
+    submissionTailLocal_ = *submissionTail_;
+
+    uint8_t* completionBase = static_cast<uint8_t*>(completionRing_);
+    completionHead_ = reinterpret_cast<unsigned int*>(completionBase + params.cq_off.head);
+    completionTail_ = reinterpret_cast<unsigned int*>(completionBase + params.cq_off.tail);
+    completionMask_ = *reinterpret_cast<unsigned int*>(completionBase + params.cq_off.ring_mask);
+    completionEntries_ = reinterpret_cast<io_uring_cqe*>(completionBase + params.cq_off.cqes);
+
+    // one registered transmit buffer per client, updated when clients are added
+    io_uring_rsrc_register bufferTable;
+    memset(&bufferTable, 0, sizeof(bufferTable));
+    bufferTable.nr = options_.maxNumClients_;
+    bufferTable.flags = IORING_RSRC_REGISTER_SPARSE;
+    if(ioUringRegister(fd, IORING_REGISTER_BUFFERS2, &bufferTable, sizeof(bufferTable)) < 0) {
+        MELO_WARN("Failed to register the io_uring transmit buffer table:\n  %s", strerror(errno));
+        releaseRing();
+        return false;
+    }
+
+    wakeupFileDescriptor_ = eventfd(0, EFD_CLOEXEC);
+    if(wakeupFileDescriptor_ < 0) {
+        MELO_WARN("Failed to create the wake-up eventfd of the io_uring engine:\n  %s", strerror(errno));
+        releaseRing();
+        return false;
+    }
+
+    usedIndices_.assign(options_.maxNumClients_, false);
+    clients_.reserve(options_.maxNumClients_);
+    addedClients_.reserve(options_.maxNumClients_);
+
+    if(!probeMultishotReceive()) {
+        // the kernel lacks provided buffer rings
+        releaseRing();
+        return false;
+    }
+    if(!isMultishotReceiveSupported_) {
+        MELO_INFO("Kernel does not support multishot receive. The io_uring engine re-arms the receive after every completion.");
+    }
+    return true;
+}
+
+bool IoUringEngine::addClient(Client* client, const Endpoint& endpoint) {
+    if(!isInitialized() || client == nullptr || endpoint.fileDescriptor_ < 0 || endpoint.receiveBufferSize_ == 0 ||
+       endpoint.transmitBufferSize_ == 0) {
+        return false;
+    }
+
+    std::lock_guard<PriorityInheritanceMutex> lock(clientsMutex_);
+    const auto freeIndex = std::find(usedIndices_.begin(), usedIndices_.end(), false);
+    if(freeIndex == usedIndices_.end()) {
+        MELO_ERROR("The io_uring engine serves at most %u clients.", options_.maxNumClients_);
+        return false;
+    }
+
+    std::unique_ptr<ClientState> state(new ClientState());
+    state->client_ = client;
+    state->endpoint_ = endpoint;
+    state->index_ = freeIndex - usedIndices_.begin();
+    if(!registerBuffers(*state)) {
+        return false;
+    }
+
+    *freeIndex = true;
+    addedClients_.push_back(std::move(state));
+    if(isLoopActive_) {
+        wakeUp();
+    }
+    return true;
+}
+
+bool IoUringEngine::removeClient(Client* client) {
+    const auto matches = [client](const std::unique_ptr<ClientState>& state){ return state->client_ == client; };
+
+    std::unique_lock<PriorityInheritanceMutex> lock(clientsMutex_);
+    auto added = std::find_if(addedClients_.begin(), addedClients_.end(), matches);
+    if(added != addedClients_.end()) {
+        unregisterBuffers(**added);
+        usedIndices_[(*added)->index_] = false;
+        addedClients_.erase(added);
+        return true;
+    }
+
+    auto it = std::find_if(clients_.begin(), clients_.end(), matches);
+    if(it == clients_.end()) {
+        return false;
+    }
+
+    if(isLoopActive_) {
+        // the loop cancels the operations and removes the client when they completed
+        (*it)->isRemoving_ = true;
+        wakeUp();
+        condClientsChanged_.wait(lock, [this, &matches]{
+            return !isLoopActive_ || std::none_of(clients_.begin(), clients_.end(), matches);
+        });
+        it = std::find_if(clients_.begin(), clients_.end(), matches);
+        if(it == clients_.end()) {
+            return true;
+        }
+    }
+
+    // the loop is not running and has drained the operations
+    unregisterBuffers(**it);
+    usedIndices_[(*it)->index_] = false;
+    clients_.erase(it);
+    return true;
+}
+
+bool IoUringEngine::start(const int priority, const int cpu) {
+    if(!isInitialized() || running_) {
+        return false;
+    }
+    if(thread_.joinable()) {
+        thread_.join();
+    }
+
+    // the thread waits for this lock before entering its loop, such that priority and affinity are set when it starts
+    std::lock_guard<std::mutex> guard(threadStartMutex_);
+    {
+        std::lock_guard<PriorityInheritanceMutex> lock(clientsMutex_);
+        isLoopActive_ = true;
+    }
+    running_ = true;
+
+    thread_ = std::thread(&IoUringEngine::loop, this);
+    if(!setThreadPriority(thread_, priority)) {
+        MELO_WARN("Failed to set priority of the io_uring engine thread:\n  %s", strerror(errno));
+    }
+    if(!setThreadAffinity(thread_, cpu)) {
+        MELO_WARN("Failed to pin the io_uring engine thread to CPU %d:\n  %s", cpu, strerror(errno));
+    }
+    return true;
+}
+
+void IoUringEngine::stop(const bool wait) {
+    running_ = false;
+    if(isInitialized()) {
+        wakeUp();
+    }
+
+    if(wait && thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void IoUringEngine::getStatistics(Statistics& statistics) const {
+    statistics.numEnterCalls_ = numEnterCalls_.load(std::memory_order_relaxed);
+    statistics.numSubmissions_ = numSubmissions_.load(std::memory_order_relaxed);
+    statistics.numCompletions_ = numCompletions_.load(std::memory_order_relaxed);
+    statistics.numReceiveRearms_ = numReceiveRearms_.load(std::memory_order_relaxed);
+    statistics.numWakeups_ = numWakeups_.load(std::memory_order_relaxed);
+}
+
+void IoUringEngine::wakeUp() {
+    const uint64_t value = 1;
+    if(write(wakeupFileDescriptor_, &value, sizeof(value)) == sizeof(value)) {
+        numWakeups_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+io_uring_sqe* IoUringEngine::getSubmissionEntry() {
+    if(submissionTailLocal_ - __atomic_load_n(submissionHead_, __ATOMIC_ACQUIRE) >= numSubmissionEntries_) {
+        const int ret = submitAndWait(0, std::chrono::nanoseconds(-1));
+        if(ret < 0) {
+            MELO_ERROR("Failed to submit io_uring operations:\n  %s", strerror(-ret));
+            return nullptr;
+        }
+    }
+
+    const unsigned int index = submissionTailLocal_ & submissionMask_;
+    io_uring_sqe* entry = &submissionEntries_[index];
+    memset(entry, 0, sizeof(io_uring_sqe));
+    submissionArray_[index] = index;
+    ++submissionTailLocal_;
+    return entry;
+}
+
+int IoUringEngine::submitAndWait(const unsigned int minComplete, const std::chrono::nanoseconds& timeout) {
+    __atomic_store_n(submissionTail_, submissionTailLocal_, __ATOMIC_RELEASE);
+    const unsigned int numToSubmit = submissionTailLocal_ - __atomic_load_n(submissionHead_, __ATOMIC_ACQUIRE);
+
+    unsigned int flags = 0;
+    __kernel_timespec timespec;
+    io_uring_getevents_arg arg;
+    const void* argPointer = nullptr;
+    std::size_t argSize = 0;
+    if(minComplete > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if(timeout.count() >= 0) {
+            timespec.tv_sec = timeout.count() / 1000000000;
+            timespec.tv_nsec = timeout.count() % 1000000000;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = reinterpret_cast<uint64_t>(&timespec);
+            flags |= IORING_ENTER_EXT_ARG;
+            argPointer = &arg;
+            argSize = sizeof(arg);
+        }
+    }
+
+    const int ret = ioUringEnter(ringFileDescriptor_, numToSubmit, minComplete, flags, argPointer, argSize);
+    numEnterCalls_.fetch_add(1, std::memory_order_relaxed);
+    if(ret < 0) {
+        return -errno;
+    }
+    numSubmissions_.fetch_add(ret, std::memory_order_relaxed);
+    return ret;
+}
+
+unsigned int IoUringEngine::processCompletions() {
+    unsigned int numCompletions = 0;
+    unsigned int head = *completionHead_;
+    while(head != __atomic_load_n(completionTail_, __ATOMIC_ACQUIRE)) {
+        // the entry is copied, such that the kernel may reuse it while it is handled
+        const io_uring_cqe cqe = completionEntries_[head & completionMask_];
+        ++head;
+        __atomic_store_n(completionHead_, head, __ATOMIC_RELEASE);
+
+        handleCompletion(cqe);
+        ++numCompletions;
+    }
+    numCompletions_.fetch_add(numCompletions, std::memory_order_relaxed);
+    return numCompletions;
+}
+
+void IoUringEngine::handleCompletion(const io_uring_cqe& cqe) {
+    const Operation operation = static_cast<Operation>(cqe.user_data & operationMask);
+    ClientState* state = reinterpret_cast<ClientState*>(cqe.user_data & ~operationMask);
+
+    switch(operation) {
+        case Operation::Wakeup:
+            isWakeupArmed_ = false;
+            if(running_) {
+                armWakeup();
+            }
+            break;
+
+        case Operation::Receive: {
+            if(!(cqe.flags & IORING_CQE_F_MORE)) {
+                state->isReceiveArmed_ = false;
+            }
+
+            if(cqe.res > 0) {
+                const uint16_t bufferId = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                state->client_->handleIoUringReceived(state->receiveMemory_.get() + bufferId * state->receiveStride_, cqe.res);
+                recycleReceiveBuffer(*state, bufferId);
+            }else{
+                if(cqe.flags & IORING_CQE_F_BUFFER) {
+                    recycleReceiveBuffer(*state, cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                }
+
+                if(cqe.res == 0 || cqe.res == -EBADF || cqe.res == -EINVAL) {
+                    // connection closed, or the file can not be read. Re-arming would spin.
+                    state->isReceiveClosed_ = true;
+                    state->client_->handleIoUringReceiveError(cqe.res);
+                }else if(cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+                    // a multishot receive which ran out of buffers is re-armed, the frames wait in the socket
+                    state->client_->handleIoUringReceiveError(cqe.res);
+                }
+            }
+
+            if(!state->isReceiveArmed_ && !state->isReceiveClosed_ && !state->isCancelSubmitted_ && running_) {
+                armReceive(*state);
+            }
+            break;
+        }
+
+        case Operation::Write:
+            // the writes of a batch are linked, so they complete in order
+            --state->numTransmitsInFlight_;
+            state->client_->handleIoUringWritten(state->transmitBuffers_[state->transmitHead_++], cqe.res);
+            break;
+
+        case Operation::Cancel:
+            break;
+    }
+}
+
+void IoUringEngine::armWakeup() {
+    io_uring_sqe* entry = getSubmissionEntry();
+    if(entry == nullptr) {
+        return;
+    }
+    entry->opcode = IORING_OP_READ;
+    entry->fd = wakeupFileDescriptor_;
+    entry->addr = reinterpret_cast<uint64_t>(&wakeupValue_);
+    entry->len = sizeof(wakeupValue_);
+    entry->user_data = encodeUserData(nullptr, Operation::Wakeup);
+    isWakeupArmed_ = true;
+}
+
+void IoUringEngine::armReceive(ClientState& state) {
+    io_uring_sqe* entry = getSubmissionEntry();
+    if(entry == nullptr) {
+        return;
+    }
+
+    entry->fd = state.endpoint_.fileDescriptor_;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = state.index_;
+    entry->user_data = encodeUserData(&state, Operation::Receive);
+    if(state.endpoint_.isSocket_) {
+        entry->opcode = IORING_OP_RECV;
+        if(isMultishotReceiveSupported_) {
+            // the buffer size is given by the provided buffers
+            entry->ioprio = IORING_RECV_MULTISHOT;
+        }else{
+            entry->len = state.endpoint_.receiveBufferSize_;
+        }
+    }else{
+        entry->opcode = IORING_OP_READ;
+        entry->off = currentPosition;
+        entry->len = state.endpoint_.receiveBufferSize_;
+    }
+
+    if(state.isReceiveStarted_) {
+        numReceiveRearms_.fetch_add(1, std::memory_order_relaxed);
+    }
+    state.isReceiveStarted_ = true;
+    state.isReceiveArmed_ = true;
+}
+
+void IoUringEngine::recycleReceiveBuffer(ClientState& state, const uint16_t bufferId) {
+    // the ring is an array of buffers whose first entry overlays the tail. Not indexed by io_uring_buf_ring::bufs, which the uapi
+    // header declares behind an empty struct in C++, shifting it by 8 bytes.
+    io_uring_buf_ring* ring = state.receiveRing_;
+    const uint16_t tail = ring->tail;
+    io_uring_buf& buffer = reinterpret_cast<io_uring_buf*>(ring)[tail & (options_.numReceiveBuffers_ - 1)];
+    buffer.addr = reinterpret_cast<uint64_t>(state.receiveMemory_.get() + bufferId * state.receiveStride_);
+    buffer.len = state.endpoint_.receiveBufferSize_;
+    buffer.bid = bufferId;
+    __atomic_store_n(&ring->tail, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
+
+void IoUringEngine::submitTransmits(ClientState& state, std::chrono::steady_clock::time_point& wakeupTime) {
+    // a new batch is linked to nothing, so it is only submitted when the previous one completed
+    if(state.numTransmitsInFlight_ > 0) {
+        return;
+    }
+
+    // the batch has to be submitted by a single io_uring_enter, otherwise the link chain is split
+    if(submissionTailLocal_ - __atomic_load_n(submissionHead_, __ATOMIC_ACQUIRE) + state.transmitBuffers_.size() > numSubmissionEntries_) {
+        const int ret = submitAndWait(0, std::chrono::nanoseconds(-1));
+        if(ret < 0) {
+            MELO_ERROR("Failed to submit io_uring operations:\n  %s", strerror(-ret));
+            return;
+        }
+    }
+
+    // the kernel may not have consumed all entries, the messages which do not fit stay queued for the next iteration
+    const unsigned int numFree = numSubmissionEntries_ - (submissionTailLocal_ - __atomic_load_n(submissionHead_, __ATOMIC_ACQUIRE));
+    const unsigned int numBuffers = std::min(numFree, static_cast<unsigned int>(state.transmitBuffers_.size()));
+    if(numBuffers == 0) {
+        return;
+    }
+
+    unsigned int numPrepared = state.client_->prepareIoUringTransmits(state.transmitBuffers_.data(), numBuffers, wakeupTime);
+    io_uring_sqe* previousEntry = nullptr;
+    for(unsigned int i=0; i<numPrepared; ++i) {
+        const TransmitBuffer& buffer = state.transmitBuffers_[i];
+        io_uring_sqe* entry = getSubmissionEntry();
+        if(entry == nullptr) {
+            // the messages already left the queue, the chain ends at the previous write
+            if(previousEntry != nullptr) {
+                previousEntry->flags &= ~IOSQE_IO_LINK;
+            }
+            for(unsigned int j=i; j<numPrepared; ++j) {
+                state.client_->handleIoUringWritten(state.transmitBuffers_[j], -EBUSY);
+            }
+            numPrepared = i;
+            break;
+        }
+        entry->opcode = IORING_OP_WRITE_FIXED;
+        entry->fd = state.endpoint_.fileDescriptor_;
+        entry->off = currentPosition;
+        entry->addr = reinterpret_cast<uint64_t>(buffer.data_);
+        entry->len = buffer.length_;
+        entry->buf_index = state.index_;
+        entry->flags = (i + 1 < numPrepared) ? IOSQE_IO_LINK : 0;
+        entry->user_data = encodeUserData(&state, Operation::Write);
+        previousEntry = entry;
+    }
+    state.transmitHead_ = 0;
+    state.numTransmitsInFlight_ = numPrepared;
+}
+
+void IoUringEngine::submitCancel(ClientState& state) {
+    io_uring_sqe* entry = getSubmissionEntry();
+    if(entry == nullptr) {
+        return;
+    }
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = state.endpoint_.fileDescriptor_;
+    entry->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    entry->user_data = encodeUserData(nullptr, Operation::Cancel);
+    state.isCancelSubmitted_ = true;
+}
+
+bool IoUringEngine::registerBuffers(ClientState& state) {
+    state.receiveRing_ = nullptr;
+    state.receiveRingSize_ = 0;
+    state.isReceiveArmed_ = false;
+    state.isReceiveStarted_ = false;
+    state.isReceiveClosed_ = false;
+    state.transmitHead_ = 0;
+    state.numTransmitsInFlight_ = 0;
+    state.isRemoving_ = false;
+    state.isCancelSubmitted_ = false;
+
+    // receive buffers with a spare byte, aligned for the frames
+    const unsigned int numReceiveBuffers = options_.numReceiveBuffers_;
+    state.receiveStride_ = alignSize(state.endpoint_.receiveBufferSize_ + 1, 16);
+    state.receiveMemory_.reset(new uint8_t[state.receiveStride_ * numReceiveBuffers]);
+
+    // the buffer ring has to be page aligned
+    state.receiveRingSize_ = alignSize(numReceiveBuffers * sizeof(io_uring_buf), sysconf(_SC_PAGESIZE));
+    void* ring = mmap(nullptr, state.receiveRingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if(ring == MAP_FAILED) {
+        MELO_ERROR("Failed to allocate the io_uring receive buffer ring:\n  %s", strerror(errno));
+        state.receiveRingSize_ = 0;
+        return false;
+    }
+    state.receiveRing_ = static_cast<io_uring_buf_ring*>(ring);
+
+    io_uring_buf_reg bufferRing;
+    memset(&bufferRing, 0, sizeof(bufferRing));
+    bufferRing.ring_addr = reinterpret_cast<uint64_t>(ring);
+    bufferRing.ring_entries = numReceiveBuffers;
+    bufferRing.bgid = state.index_;
+    if(ioUringRegister(ringFileDescriptor_, IORING_REGISTER_PBUF_RING, &bufferRing, 1) < 0) {
+        MELO_WARN("Failed to register the io_uring receive buffer ring:\n  %s", strerror(errno));
+        munmap(ring, state.receiveRingSize_);
+        state.receiveRing_ = nullptr;
+        state.receiveRingSize_ = 0;
+        return false;
+    }
+    for(unsigned int i=0; i<numReceiveBuffers; ++i) {
+        recycleReceiveBuffer(state, i);
+    }
+
+    // the probe of the kernel features has no transmit buffers
+    if(state.index_ >= options_.maxNumClients_) {
+        return true;
+    }
+
+    const std::size_t transmitStride = alignSize(state.endpoint_.transmitBufferSize_, 16);
+    const std::size_t transmitSize = transmitStride * options_.numTransmitBuffers_;
+    state.transmitMemory_.reset(new uint8_t[transmitSize]);
+    state.transmitBuffers_.resize(options_.numTransmitBuffers_);
+    for(unsigned int i=0; i<options_.numTransmitBuffers_; ++i) {
+        state.transmitBuffers_[i] = {state.transmitMemory_.get() + i * transmitStride, state.endpoint_.transmitBufferSize_, 0, 0};
+    }
+
+    iovec transmitMemory {state.transmitMemory_.get(), transmitSize};
+    io_uring_rsrc_update2 update;
+    memset(&update, 0, sizeof(update));
+    update.offset = state.index_;
+    update.data = reinterpret_cast<uint64_t>(&transmitMemory);
+    update.nr = 1;
+    if(ioUringRegister(ringFileDescriptor_, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) < 0) {
+        MELO_ERROR("Failed to register the io_uring transmit buffers:\n  %s", strerror(errno));
+        state.transmitBuffers_.clear();
+        unregisterBuffers(state);
+        return false;
+    }
+    return true;
+}
+
+void IoUringEngine::unregisterBuffers(ClientState& state) {
+    if(state.receiveRing_ != nullptr) {
+        io_uring_buf_reg bufferRing;
+        memset(&bufferRing, 0, sizeof(bufferRing));
+        bufferRing.bgid = state.index_;
+        ioUringRegister(ringFileDescriptor_, IORING_UNREGISTER_PBUF_RING, &bufferRing, 1);
+        munmap(state.receiveRing_, state.receiveRingSize_);
+        state.receiveRing_ = nullptr;
+    }
+
+    if(!state.transmitBuffers_.empty()) {
+        // an empty buffer clears the slot of the table
+        iovec empty {nullptr, 0};
+        io_uring_rsrc_update2 update;
+        memset(&update, 0, sizeof(update));
+        update.offset = state.index_;
+        update.data = reinterpret_cast<uint64_t>(&empty);
+        update.nr = 1;
+        ioUringRegister(ringFileDescriptor_, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update));
+        state.transmitBuffers_.clear();
+    }
+}
+
+bool IoUringEngine::probeMultishotReceive() {
+    int sockets[2];
+    if(socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+        MELO_WARN("Failed to create a socket pair to probe io_uring:\n  %s", strerror(errno));
+        return false;
+    }
+
+    // buffer group after the ones of the clients
+    ClientState probe;
+    probe.client_ = nullptr;
+    probe.endpoint_.fileDescriptor_ = sockets[0];
+    probe.endpoint_.isSocket_ = true;
+    probe.endpoint_.receiveBufferSize_ = 16;
+    probe.index_ = options_.maxNumClients_;
+    if(!registerBuffers(probe)) {
+        close(sockets[0]);
+        close(sockets[1]);
+        return false;
+    }
+
+    isMultishotReceiveSupported_ = true;
+    armReceive(probe);
+    const char data = 0;
+    if(write(sockets[1], &data, sizeof(data)) != sizeof(data)) {
+        MELO_WARN("Failed to write to the socket pair probing io_uring:\n  %s", strerror(errno));
+    }
+
+    // the receive either delivers the byte and stays armed, or is rejected by kernels without multishot receive
+    bool isAnswered = false;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while(probe.isReceiveArmed_ && std::chrono::steady_clock::now() < deadline) {
+        submitAndWait(1, std::chrono::milliseconds(10));
+        unsigned int head = *completionHead_;
+        while(head != __atomic_load_n(completionTail_, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe cqe = completionEntries_[head & completionMask_];
+            ++head;
+            __atomic_store_n(completionHead_, head, __ATOMIC_RELEASE);
+            if((cqe.user_data & operationMask) != static_cast<uint64_t>(Operation::Receive)) {
+                continue;
+            }
+            if(!isAnswered) {
+                isAnswered = true;
+                isMultishotReceiveSupported_ = (cqe.res == 1 && (cqe.flags & IORING_CQE_F_MORE));
+                if(probe.isReceiveArmed_ && (cqe.flags & IORING_CQE_F_MORE)) {
+                    submitCancel(probe);
+                }
+            }
+            if(!(cqe.flags & IORING_CQE_F_MORE)) {
+                probe.isReceiveArmed_ = false;
+            }
+        }
+    }
+    if(!isAnswered) {
+        isMultishotReceiveSupported_ = false;
+    }
+
+    close(sockets[0]);
+    close(sockets[1]);
+    if(probe.isReceiveArmed_) {
+        // closing the sockets does not cancel the receive. Keep the buffers registered, as the kernel may still write into them.
+        MELO_WARN("The receive probing io_uring did not complete.");
+        probe.receiveMemory_.release();
+        return isAnswered;
+    }
+    unregisterBuffers(probe);
+    return true;
+}
+
+bool IoUringEngine::updateClients() {
+    std::lock_guard<PriorityInheritanceMutex> lock(clientsMutex_);
+    for(auto& state : addedClients_) {
+        clients_.push_back(std::move(state));
+    }
+    addedClients_.clear();
+
+    bool isRemoved = false;
+    for(auto it = clients_.begin(); it != clients_.end(); ) {
+        ClientState& state = **it;
+        if(state.isRemoving_) {
+            if(!state.isCancelSubmitted_) {
+                submitCancel(state);
+            }
+            if(!state.isReceiveArmed_ && state.numTransmitsInFlight_ == 0) {
+                unregisterBuffers(state);
+                usedIndices_[state.index_] = false;
+                it = clients_.erase(it);
+                isRemoved = true;
+                continue;
+            }
+        }else if(!state.isReceiveArmed_ && !state.isReceiveClosed_ && !state.isCancelSubmitted_) {
+            armReceive(state);
+        }
+        ++it;
+    }
+
+    if(isRemoved) {
+        condClientsChanged_.notify_all();
+    }
+    return !clients_.empty();
+}
+
+void IoUringEngine::drain() {
+    for(auto& state : clients_) {
+        if(state->isReceiveArmed_ || state->numTransmitsInFlight_ > 0) {
+            submitCancel(*state);
+        }
+    }
+    if(isWakeupArmed_) {
+        io_uring_sqe* entry = getSubmissionEntry();
+        if(entry != nullptr) {
+            entry->opcode = IORING_OP_ASYNC_CANCEL;
+            entry->addr = encodeUserData(nullptr, Operation::Wakeup);
+            entry->user_data = encodeUserData(nullptr, Operation::Cancel);
+        }
+    }
+
+    const auto isPending = [this]() {
+        return isWakeupArmed_ || std::any_of(clients_.begin(), clients_.end(), [](const std::unique_ptr<ClientState>& state){
+            return state->isReceiveArmed_ || state->numTransmitsInFlight_ > 0;
+        });
+    };
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options_.drainTimeout_);
+    while(isPending()) {
+        const auto now = std::chrono::steady_clock::now();
+        if(now >= deadline) {
+            MELO_WARN("Operations of the io_uring engine did not complete within %u ms after cancellation.", options_.drainTimeout_);
+            break;
+        }
+        submitAndWait(1, deadline - now);
+        processCompletions();
+    }
+}
+
+void IoUringEngine::loop() {
+    {
+        // wait until start() has set priority and affinity
+        std::lock_guard<std::mutex> guard(threadStartMutex_);
+    }
+    markRealtimeThread();
+    TraceRecorder::registerThread();
+
+    {
+        // operations cancelled by a previous stop() are armed again
+        std::lock_guard<PriorityInheritanceMutex> lock(clientsMutex_);
+        for(auto& state : clients_) {
+            state->isCancelSubmitted_ = state->isRemoving_;
+        }
+    }
+    if(!isWakeupArmed_) {
+        armWakeup();
+    }
+
+    while(running_) {
+        // notifications from now on wake up the next wait
+        isNotified_ = false;
+        updateClients();
+
+        std::chrono::steady_clock::time_point wakeupTime = std::chrono::steady_clock::time_point::max();
+        for(auto& state : clients_) {
+            if(!state->isCancelSubmitted_) {
+                submitTransmits(*state, wakeupTime);
+            }
+        }
+
+        std::chrono::nanoseconds timeout(-1);
+        if(wakeupTime != std::chrono::steady_clock::time_point::max()) {
+            timeout = std::max(std::chrono::nanoseconds(0), std::chrono::duration_cast<std::chrono::nanoseconds>(wakeupTime - std::chrono::steady_clock::now()));
+        }
+
+        const int ret = submitAndWait(1, timeout);
+        if(ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) {
+            MELO_ERROR("Failed to wait for io_uring completions:\n  %s", strerror(-ret));
+        }
+
+        // messages queued from now on, e.g. by the callbacks of the received messages, are submitted by the next iteration without
+        // a wake-up
+        isNotified_ = true;
+        processCompletions();
+    }
+
+    drain();
+
+    std::lock_guard<PriorityInheritanceMutex> lock(clientsMutex_);
+    isLoopActive_ = false;
+    condClientsChanged_.notify_all();
+}
+
+#else
+
+IoUringEngine::~IoUringEngine()
+{
+}
+
+bool IoUringEngine::initialize() {
+    MELO_WARN("tcan was compiled without io_uring support (kernel headers older than Linux 6.0).");
+    return false;
+}
+
+bool IoUringEngine::addClient(Client* /*client*/, const Endpoint& /*endpoint*/) {
+    return false;
+}
+
+bool IoUringEngine::removeClient(Client* /*client*/) {
+    return false;
+}
+
+bool IoUringEngine::start(const int /*priority*/, const int /*cpu*/) {
+    return false;
+}
+
+void IoUringEngine::stop(const bool /*wait*/) {
+}
+
+void IoUringEngine::getStatistics(Statistics& statistics) const {
+    statistics = Statistics();
+}
+
+void IoUringEngine::wakeUp() {
+}
+
+#endif /* TCAN_HAS_IO_URING */
+
+} /* namespace tcan */
@@ -0,0 +1,25 @@
+#include "tcan/PriorityInheritanceMutex.hpp"
+
+namespace tcan {
+
+PriorityInheritanceMutex::PriorityInheritanceMutex():
+    mutex_(),
+    isPriorityInheritanceEnabled_(false)
+{
+    pthread_mutexattr_t attr;
+    if(pthread_mutexattr_init(&attr) == 0) {
+        isPriorityInheritanceEnabled_ = (pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT) == 0 &&
+                                         pthread_mutex_init(&mutex_, &attr) == 0);
+        pthread_mutexattr_destroy(&attr);
+    }
+    if(!isPriorityInheritanceEnabled_) {
+        pthread_mutex_init(&mutex_, nullptr);
+    }
+}
+
+PriorityInheritanceMutex::~PriorityInheritanceMutex()
+{
+    pthread_mutex_destroy(&mutex_);
+}
+
+} /* namespace tcan */
@@ -0,0 +1,373 @@
+#include "tcan/TraceRecorder.hpp"
+#include "tcan/PriorityInheritanceMutex.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tcan {
+
+std::atomic<bool> TraceRecorder::enabled_{false};
+
+namespace {
+
+struct Event {
+    int64_t timestamp_; // [ns] of the steady clock
+    int64_t duration_;  // [ns], negative for instantaneous events
+    const char* name_;
+    uint32_t id_;
+    uint16_t track_;
+};
+
+//! single-producer single-consumer ring of the events of a thread
+struct ThreadBuffer {
+    ThreadBuffer(const long threadId, const std::string& threadName):
+        events_(nullptr),
+        capacity_(0),
+        head_(0),
+        tail_(0),
+        numDropped_(0),
+        isExited_(false),
+        threadId_(threadId),
+        threadName_(threadName),
+        isNameWritten_(false)
+    {
+    }
+
+    ~ThreadBuffer()
+    {
+        delete[] events_.load(std::memory_order_relaxed);
+    }
+
+    //! allocates the events if not done yet. Must be called with the state mutex locked.
+    void allocateWithoutLock(const unsigned int capacity) {
+        if(events_.load(std::memory_order_relaxed) == nullptr) {
+            capacity_ = capacity;
+            events_.store(new Event[capacity], std::memory_order_release);
+        }
+    }
+
+    //! set once, capacity_ is valid after it was read as non-null
+    std::atomic<Event*> events_;
+    uint64_t capacity_;
+    //! written by the owning thread
+    std::atomic<uint64_t> head_;
+    //! written by the flushing thread
+    std::atomic<uint64_t> tail_;
+    std::atomic<uint64_t> numDropped_;
+    //! set when the owning thread exits, the buffer is freed after its events were written
+    std::atomic<bool> isExited_;
+
+    const long threadId_;
+    const std::string threadName_;
+    //! whether the thread name was written to the current file. Only accessed by the flushing thread.
+    bool isNameWritten_;
+};
+
+/*!
+ * The recording threads only lock mutex_ to register and to get a track. The file is only accessed by the flushing thread and by
+ * start(..) and stop(), which are serialized by ioMutex_, such that no real-time thread waits for the file I/O.
+ */
+struct State {
+    State():
+        mutex_(),
+        buffers_(),
+        tracks_(),
+        bufferSize_(8192),
+        isRecording_(false),
+        ioMutex_(),
+        condFlush_(),
+        drainedBuffers_(),
+        drainedTracks_(),
+        file_(nullptr),
+        isFirstEvent_(true),
+        flushThread_(),
+        isFlushing_(false),
+        flushInterval_(10),
+        startTime_(0)
+    {
+        // a real-time thread waits for this mutex when it registers or gets a track
+        if(!mutex_.isPriorityInheritanceEnabled()) {
+            MELO_WARN("Failed to enable priority inheritance on the mutex of the trace recorder");
+        }
+    }
+
+    PriorityInheritanceMutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    std::vector<std::string> tracks_;
+    unsigned int bufferSize_;
+    //! whether buffers are allocated on registration
+    bool isRecording_;
+
+    std::mutex ioMutex_;
+    std::condition_variable condFlush_;
+    //! buffers and tracks copied by the flushing thread, such that the file is written without holding mutex_
+    std::vector<ThreadBuffer*> drainedBuffers_;
+    std::vector<std::string> drainedTracks_;
+    FILE* file_;
+    bool isFirstEvent_;
+    std::thread flushThread_;
+    bool isFlushing_;
+    unsigned int flushInterval_;
+    int64_t startTime_;
+};
+
+// never destroyed, such that threads may still record events during static destruction
+State& getState() {
+    static State* state = new State();
+    return *state;
+}
+
+//! marks the buffer of the thread as exited when the thread terminates
+struct ThreadBufferHandle {
+    ~ThreadBufferHandle()
+    {
+        if(buffer_ != nullptr) {
+            buffer_->isExited_.store(true, std::memory_order_release);
+        }
+    }
+
+    ThreadBuffer* buffer_ = nullptr;
+};
+
+thread_local ThreadBufferHandle currentBuffer;
+
+inline int64_t toNanoseconds(const TraceRecorder::Clock::time_point& time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+//! frees the buffers of exited threads, keeping those with unwritten events if onlyDrained is set
+void removeExitedBuffersWithoutLock(State& state, const bool onlyDrained) {
+    state.buffers_.erase(std::remove_if(state.buffers_.begin(), state.buffers_.end(),
+        [onlyDrained](const std::unique_ptr<ThreadBuffer>& buffer) {
+            return buffer->isExited_.load(std::memory_order_acquire) &&
+                (!onlyDrained || buffer->head_.load(std::memory_order_acquire) == buffer->tail_.load(std::memory_order_relaxed));
+        }), state.buffers_.end());
+}
+
+ThreadBuffer* getThreadBuffer() {
+    if(currentBuffer.buffer_ == nullptr) {
+        TraceRecorder::registerThread();
+    }
+    return currentBuffer.buffer_;
+}
+
+void push(const Event& event) {
+    ThreadBuffer* buffer = getThreadBuffer();
+    Event* events = buffer->events_.load(std::memory_order_acquire);
+    const uint64_t head = buffer->head_.load(std::memory_order_relaxed);
+    if(events == nullptr || head - buffer->tail_.load(std::memory_order_acquire) >= buffer->capacity_) {
+        buffer->numDropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    events[head % buffer->capacity_] = event;
+    buffer->head_.store(head + 1, std::memory_order_release);
+}
+
+//! writes a JSON string without the characters which would need escaping
+void writeString(FILE* file, const std::string& string) {
+    std::fputc('"', file);
+    for(const char c : string) {
+        if(c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20) {
+            std::fputc(c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+void beginEvent(State& state) {
+    std::fputs(state.isFirstEvent_ ? "\n" : ",\n", state.file_);
+    state.isFirstEvent_ = false;
+}
+
+//! writes the events of all buffers to the file. Must be called with ioMutex_ locked.
+void drainWithoutLock(State& state) {
+    {
+        // tracks are only appended
+        std::lock_guard<PriorityInheritanceMutex> guard(state.mutex_);
+        state.drainedBuffers_.clear();
+        for(const auto& buffer : state.buffers_) {
+            state.drainedBuffers_.push_back(buffer.get());
+        }
+        state.drainedTracks_.insert(state.drainedTracks_.end(), state.tracks_.begin() + state.drainedTracks_.size(), state.tracks_.end());
+    }
+
+    // the buffers are only removed by this function
+    const int pid = getpid();
+    for(ThreadBuffer* buffer : state.drainedBuffers_) {
+        const uint64_t tail = buffer->tail_.load(std::memory_order_relaxed);
+        const uint64_t head = buffer->head_.load(std::memory_order_acquire);
+        if(head == tail) {
+            continue;
+        }
+
+        if(!buffer->isNameWritten_) {
+            beginEvent(state);
+            std::fprintf(state.file_, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,\"args\":{\"name\":", pid, buffer->threadId_);
+            writeString(state.file_, buffer->threadName_.empty() ? std::to_string(buffer->threadId_) : buffer->threadName_);
+            std::fputs("}}", state.file_);
+            buffer->isNameWritten_ = true;
+        }
+
+        const Event* events = buffer->events_.load(std::memory_order_acquire);
+        for(uint64_t i=tail; i<head; ++i) {
+            const Event& event = events[i % buffer->capacity_];
+            if(event.timestamp_ < state.startTime_) {
+                continue;
+            }
+
+            beginEvent(state);
+            std::fprintf(state.file_, "{\"name\":\"%s\",\"cat\":", event.name_);
+            writeString(state.file_, (event.track_ < state.drainedTracks_.size()) ? state.drainedTracks_[event.track_] : std::string());
+            if(event.duration_ < 0) {
+                std::fprintf(state.file_, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", (event.timestamp_ - state.startTime_) / 1000.0);
+            }else{
+                std::fprintf(state.file_, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", (event.timestamp_ - state.startTime_) / 1000.0, event.duration_ / 1000.0);
+            }
+            std::fprintf(state.file_, ",\"pid\":%d,\"tid\":%ld,\"args\":{\"id\":\"0x%X\"}}", pid, buffer->threadId_, event.id_);
+        }
+        buffer->tail_.store(head, std::memory_order_release);
+    }
+    std::fflush(state.file_);
+
+    std::lock_guard<PriorityInheritanceMutex> guard(state.mutex_);
+    removeExitedBuffersWithoutLock(state, true);
+}
+
+void flushWorker() {
+    State& state = getState();
+    std::unique_lock<std::mutex> lock(state.ioMutex_);
+    while(state.isFlushing_) {
+        state.condFlush_.wait_for(lock, std::chrono::milliseconds(state.flushInterval_));
+        drainWithoutLock(state);
+    }
+}
+
+} // namespace
+
+bool TraceRecorder::start(const std::string& filename, const unsigned int bufferSize, const unsigned int flushInterval) {
+    State& state = getState();
+    std::lock_guard<std::mutex> ioGuard(state.ioMutex_);
+    if(state.isFlushing_) {
+        return true;
+    }
+
+    state.file_ = std::fopen(filename.c_str(), "w");
+    if(state.file_ == nullptr) {
+        return false;
+    }
+    std::fputs("[", state.file_);
+    state.isFirstEvent_ = true;
+
+    {
+        std::lock_guard<PriorityInheritanceMutex> guard(state.mutex_);
+        removeExitedBuffersWithoutLock(state, false);
+        state.bufferSize_ = std::max(1u, bufferSize);
+        state.isRecording_ = true;
+        for(const auto& buffer : state.buffers_) {
+            // discard the events recorded by threads which passed isEnabled() right before the previous stop()
+            buffer->tail_.store(buffer->head_.load(std::memory_order_acquire), std::memory_order_release);
+            buffer->numDropped_ = 0;
+            buffer->isNameWritten_ = false;
+            buffer->allocateWithoutLock(state.bufferSize_);
+        }
+    }
+
+    state.flushInterval_ = flushInterval;
+    state.startTime_ = toNanoseconds(Clock::now());
+    state.isFlushing_ = true;
+    state.flushThread_ = std::thread(&flushWorker);
+    enabled_ = true;
+    return true;
+}
+
+void TraceRecorder::stop() {
+    enabled_ = false;
+
+    State& state = getState();
+    std::unique_lock<std::mutex> ioLock(state.ioMutex_);
+    if(!state.isFlushing_) {
+        return;
+    }
+    state.isFlushing_ = false;
+    ioLock.unlock();
+    state.condFlush_.notify_all();
+    state.flushThread_.join();
+
+    ioLock.lock();
+    drainWithoutLock(state);
+    std::fputs("\n]\n", state.file_);
+    std::fclose(state.file_);
+    state.file_ = nullptr;
+
+    std::lock_guard<PriorityInheritanceMutex> guard(state.mutex_);
+    state.isRecording_ = false;
+}
+
+void TraceRecorder::registerThread() {
+    if(currentBuffer.buffer_ != nullptr) {
+        return;
+    }
+
+    char threadName[16] = "";
+    pthread_getname_np(pthread_self(), threadName, sizeof(threadName));
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer(syscall(SYS_gettid), threadName));
+
+    State& state = getState();
+    std::lock_guard<PriorityInheritanceMutex> guard(state.mutex_);
+    if(state.isRecording_) {
+        buffer->allocateWithoutLock(state.bufferSize_);
+    }else{
+        // nobody drains while not recording
+        removeExitedBuffersWithoutLock(state, false);
+    }
+    currentBuffer.buffer_ = buffer.get();
+    state.buffers_.push_back(std::move(buffer));
+}
+
+uint16_t TraceRecorder::getTrack(const std::string& name) {
+    State& state = getState();
+    std::lock_guard<PriorityInheritanceMutex> guard(state.mutex_);
+    for(std::size_t i=0; i<state.tracks_.size(); ++i) {
+        if(state.tracks_[i] == name) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+    state.tracks_.push_back(name);
+    return static_cast<uint16_t>(state.tracks_.size() - 1);
+}
+
+void TraceRecorder::instant(const char* name, const uint16_t track, const uint32_t id) {
+    if(isEnabled()) {
+        push(Event{toNanoseconds(Clock::now()), -1, name, id, track});
+    }
+}
+
+void TraceRecorder::complete(const char* name, const uint16_t track, const uint32_t id, const Clock::time_point& start) {
+    if(isEnabled()) {
+        const int64_t startTime = toNanoseconds(start);
+        push(Event{startTime, toNanoseconds(Clock::now()) - startTime, name, id, track});
+    }
+}
+
+uint64_t TraceRecorder::getNumDroppedEvents() {
+    State& state = getState();
+    std::lock_guard<PriorityInheritanceMutex> guard(state.mutex_);
+    uint64_t numDropped = 0;
+    for(const auto& buffer : state.buffers_) {
+        numDropped += buffer->numDropped_.load(std::memory_order_relaxed);
+    }
+    return numDropped;
+}
+
+} // namespace tcan
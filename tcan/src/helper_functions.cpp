@@ -1,7 +1,34 @@
 #include "tcan/helper_functions.hpp"
 
+#include <alloca.h>
+#include <errno.h>
+#include <cinttypes>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "message_logger/message_logger.hpp"
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
 namespace tcan {
 
+namespace {
+thread_local bool realtimeThread = false;
+} // anonymous namespace
+
+void markRealtimeThread(const bool isRealtime) {
+    realtimeThread = isRealtime;
+}
+
+bool isRealtimeThread() {
+    return realtimeThread;
+}
+
 bool setThreadPriority(std::thread& thread, const int priority) {
     sched_param sched;
     sched.sched_priority = priority;
@@ -22,4 +49,153 @@ bool raiseThreadPriority(std::thread& thread, const int priority) {
     return true;
 }
 
+bool setThreadAffinity(std::thread& thread, const int cpu) {
+    if(cpu < 0) {
+        return true;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    return (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet) == 0);
+}
+
+void sleepUntil(const std::chrono::steady_clock::time_point& time, const std::chrono::nanoseconds& spinTime) {
+    // std::chrono::steady_clock is based on CLOCK_MONOTONIC on linux
+    const auto wakeupTime = std::chrono::duration_cast<std::chrono::nanoseconds>((time - spinTime).time_since_epoch());
+    if(wakeupTime.count() > 0) {
+        timespec ts;
+        ts.tv_sec = wakeupTime.count() / 1000000000;
+        ts.tv_nsec = wakeupTime.count() % 1000000000;
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+    }
+
+    while(spinTime.count() > 0 && std::chrono::steady_clock::now() < time) {
+    }
+}
+
+unsigned int roundUpToPowerOfTwo(const unsigned int value) {
+    unsigned int result = 1;
+    while(result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+namespace {
+
+// glibc does not wrap sched_setattr/sched_getattr, use the kernel struct directly
+struct SchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+const char* getPolicyName(const uint32_t policy) {
+    switch(policy) {
+        case SCHED_OTHER: return "SCHED_OTHER";
+        case SCHED_FIFO: return "SCHED_FIFO";
+        case SCHED_RR: return "SCHED_RR";
+        case SCHED_BATCH: return "SCHED_BATCH";
+        case SCHED_IDLE: return "SCHED_IDLE";
+        case SCHED_DEADLINE: return "SCHED_DEADLINE";
+        default: return "unknown";
+    }
+}
+
+// @return locked memory of the process [kB] as reported in /proc/self/status, -1 if not available
+long getLockedMemory() {
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while(status >> key) {
+        if(key == "VmLck:") {
+            long size = -1;
+            status >> size;
+            return size;
+        }
+        status.ignore(256, '\n');
+    }
+    return -1;
+}
+
+} // anonymous namespace
+
+bool setCurrentThreadDeadline(const DeadlineParameters& parameters) {
+    SchedAttr attr{};
+    attr.size = sizeof(SchedAttr);
+    attr.sched_policy = SCHED_DEADLINE;
+    attr.sched_runtime = parameters.runtime_*1000;
+    attr.sched_deadline = parameters.deadline_*1000;
+    attr.sched_period = parameters.period_*1000;
+    return (syscall(SYS_sched_setattr, 0, &attr, 0) == 0);
+}
+
+bool lockMemory() {
+    return (mlockall(MCL_CURRENT | MCL_FUTURE) == 0);
+}
+
+void prefaultStack(const std::size_t size) {
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(size));
+    const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    for(std::size_t i=0; i<size; i+=pageSize) {
+        stack[i] = 0;
+    }
+}
+
+bool reportRealtimeSettings(const std::string& threadName, const int priority, const int cpu, const DeadlineParameters& deadline,
+                            const bool memoryLocked) {
+    bool valid = true;
+
+    SchedAttr attr{};
+    if(syscall(SYS_sched_getattr, 0, &attr, sizeof(SchedAttr), 0) != 0) {
+        MELO_WARN("%s: failed to get scheduling attributes:\n  %s", threadName.c_str(), strerror(errno));
+        return false;
+    }
+
+    if(deadline.isEnabled()) {
+        if(attr.sched_policy != SCHED_DEADLINE || attr.sched_runtime != deadline.runtime_*1000 ||
+           attr.sched_deadline != deadline.deadline_*1000 || attr.sched_period != deadline.period_*1000) {
+            MELO_WARN("%s: requested SCHED_DEADLINE with runtime %" PRIu64 " us, deadline %" PRIu64 " us and period %" PRIu64 " us, "
+                      "but the thread runs with %s",
+                      threadName.c_str(), deadline.runtime_, deadline.deadline_, deadline.period_, getPolicyName(attr.sched_policy));
+            valid = false;
+        }
+    }else if(attr.sched_policy != SCHED_FIFO || static_cast<int>(attr.sched_priority) != priority) {
+        MELO_WARN("%s: requested SCHED_FIFO with priority %d, but the thread runs with %s and priority %u",
+                  threadName.c_str(), priority, getPolicyName(attr.sched_policy), attr.sched_priority);
+        valid = false;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    std::string cpus;
+    if(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0) {
+        for(int i=0; i<CPU_SETSIZE; ++i) {
+            if(CPU_ISSET(i, &cpuSet)) {
+                cpus += (cpus.empty() ? "" : ",") + std::to_string(i);
+            }
+        }
+        if(cpu >= 0 && (CPU_COUNT(&cpuSet) != 1 || !CPU_ISSET(cpu, &cpuSet))) {
+            MELO_WARN("%s: requested CPU %d, but the thread may run on CPUs %s", threadName.c_str(), cpu, cpus.c_str());
+            valid = false;
+        }
+    }
+
+    const long lockedMemory = getLockedMemory();
+    if(memoryLocked && lockedMemory <= 0) {
+        MELO_WARN("%s: memory is not locked", threadName.c_str());
+        valid = false;
+    }
+
+    MELO_INFO("%s: policy %s, priority %u, CPUs %s, locked memory %ld kB", threadName.c_str(), getPolicyName(attr.sched_policy),
+              attr.sched_priority, cpus.c_str(), lockedMemory);
+    return valid;
+}
+
 } // namespace tcan
\ No newline at end of file
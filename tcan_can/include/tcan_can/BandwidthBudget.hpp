@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "tcan/Clock.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Worst-case length of a data frame including bit stuffing, in bits (without interframe space).
+ * @param length    number of data bytes
+ * @param extended  true for 29 bit identifiers
+ */
+inline unsigned int estimateFrameBits(const unsigned int length, const bool extended) {
+    const unsigned int numStuffableBits = (extended ? 54 : 34) + 8*length;
+    return numStuffableBits + 13 + (numStuffableBits - 1)/4;
+}
+
+//! Per-cycle bus time budget of background traffic (SDOs, diagnostics), see CanBusOptions::bandwidthBudget_
+struct BandwidthBudgetOptions {
+    BandwidthBudgetOptions():
+        bitrate_(1000000),
+        cycleTime_(0),
+        cyclicLoad_(0),
+        backgroundFrames_({{0x600, 0x780}}) // SDO requests
+    {
+    }
+
+    //! bit rate of the bus [bit/s]
+    unsigned int bitrate_;
+
+    //! length of a budget cycle [us], usually the control cycle. 0 to disable the budget.
+    unsigned int cycleTime_;
+
+    /*! bus time of the cyclic traffic per cycle (PDOs in both directions, SYNC) [us]. Background frames may only use the remaining time.
+     * Use estimateFrameBits(..) to compute it from the cyclic frames.
+     */
+    unsigned int cyclicLoad_;
+
+    //! frames counted as background traffic {identifier, mask}. A frame matches if (cob id & mask) == (identifier & mask).
+    std::vector<std::pair<uint32_t, uint32_t>> backgroundFrames_;
+};
+
+/*!
+ * Limits the bus time used by background frames per cycle. Background frames exceeding the budget of the current cycle are deferred to
+ * the next cycle. The cycles are free-running and re-aligned to every SYNC. Not thread safe.
+ */
+class BandwidthBudget {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit BandwidthBudget(const BandwidthBudgetOptions& options):
+        options_(options),
+        cycleTime_(options.cycleTime_),
+        budget_(0),
+        cycleStart_(tcan::Clock::now()),
+        used_(0),
+        isDeferring_(false),
+        numDeferredCycles_(0)
+    {
+        if(options_.cyclicLoad_ < options_.cycleTime_) {
+            budget_ = std::chrono::microseconds(options_.cycleTime_ - options_.cyclicLoad_);
+        }
+    }
+
+    inline bool isEnabled() const { return cycleTime_.count() > 0; }
+
+    inline bool isBackground(const uint32_t cobId) const {
+        for(const auto& frame : options_.backgroundFrames_) {
+            if((cobId & frame.second) == (frame.first & frame.second)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! @return bus time of a frame [ns]
+    inline std::chrono::nanoseconds getFrameTime(const uint32_t cobId, const unsigned int length) const {
+        return std::chrono::nanoseconds(static_cast<int64_t>(estimateFrameBits(length, cobId > 0x7FF))*1000000000/options_.bitrate_);
+    }
+
+    /*!
+     * @param frameTime bus time of the background frame
+     * @param now       current time
+     * @return          earliest time at which the frame may be sent. The frame may be sent if this is <= now.
+     */
+    inline Clock::time_point getReleaseTime(const std::chrono::nanoseconds& frameTime, const Clock::time_point& now) {
+        advanceCycle(now);
+        const Clock::time_point releaseTime = peekReleaseTime(frameTime, now);
+        if(releaseTime > now && !isDeferring_) {
+            isDeferring_ = true;
+            ++numDeferredCycles_;
+        }
+        return releaseTime;
+    }
+
+    //! Like getReleaseTime(..), but neither advances the cycle nor counts a deferred cycle
+    inline Clock::time_point peekReleaseTime(const std::chrono::nanoseconds& frameTime, const Clock::time_point& now) const {
+        Clock::time_point cycleStart = cycleStart_;
+        std::chrono::nanoseconds used = used_;
+        if(now >= cycleStart_ + cycleTime_) {
+            cycleStart = cycleStart_ + ((now - cycleStart_) / cycleTime_) * cycleTime_;
+            used = std::chrono::nanoseconds(0);
+        }
+
+        // a frame longer than the whole budget is sent at the start of a cycle
+        if(used + frameTime <= budget_ || used.count() == 0) {
+            return now;
+        }
+        return cycleStart + cycleTime_;
+    }
+
+    //! Accounts a background frame. Shall be called after the frame has been sent.
+    inline void consume(const std::chrono::nanoseconds& frameTime, const Clock::time_point& now) {
+        advanceCycle(now);
+        used_ += frameTime;
+    }
+
+    //! Starts a new cycle, e.g. on a SYNC.
+    inline void startCycle(const Clock::time_point& now) {
+        cycleStart_ = now;
+        used_ = std::chrono::nanoseconds(0);
+        isDeferring_ = false;
+    }
+
+    //! @return number of cycles in which background frames were deferred
+    inline unsigned int getNumDeferredCycles() const { return numDeferredCycles_; }
+
+ private:
+    inline void advanceCycle(const Clock::time_point& now) {
+        if(now >= cycleStart_ + cycleTime_) {
+            startCycle(cycleStart_ + ((now - cycleStart_) / cycleTime_) * cycleTime_);
+        }
+    }
+
+ private:
+    const BandwidthBudgetOptions options_;
+    const std::chrono::microseconds cycleTime_;
+    std::chrono::nanoseconds budget_;
+
+    Clock::time_point cycleStart_;
+    std::chrono::nanoseconds used_;
+    bool isDeferring_;
+    unsigned int numDeferredCycles_;
+};
+
+} /* namespace tcan_can */
@@ -4,12 +4,17 @@
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <string>
 #include <vector>
 
 #include "tcan/Bus.hpp"
+#include "tcan/CallbackProfile.hpp"
+#include "tcan/RcuPointer.hpp"
 #include "tcan_can/CanBusOptions.hpp"
 #include "tcan_can/CanMsg.hpp"
 #include "tcan_can/CanDevice.hpp"
+#include "tcan_can/TransmitLimiter.hpp"
+#include "tcan_can/UnmappedTrafficProfiler.hpp"
 
 namespace tcan_can {
 
@@ -36,8 +41,28 @@ class CanBus : public tcan::Bus<CanMsg> {
     };
 
     using CallbackPtr =  std::function<bool(const CanMsg&)>;
-    using CanFrameIdentifierToFunctionMap = std::unordered_map<CanFrameIdentifier, std::pair<CanDevice*, CallbackPtr>, CanFrameIdentifierHasher>;
+
+    //! registered callback of incoming messages
+    struct Handler {
+        CanDevice* device_;
+        CallbackPtr callback_;
+        //! execution time of this callback and of all callbacks of the device. nullptr if BusOptions::profileCallbacks_ is false.
+        std::shared_ptr<tcan::CallbackProfile> profile_;
+        std::shared_ptr<tcan::CallbackProfile> deviceProfile_;
+    };
+
+    using CanFrameIdentifierToFunctionMap = std::unordered_map<CanFrameIdentifier, Handler, CanFrameIdentifierHasher>;
     using DeviceContainer = std::vector<CanDevice*>;
+    using TransmitLimiterMap = std::unordered_map<uint32_t, TransmitLimiter>;
+    using TransmitCallbackMap = std::unordered_map<uint32_t, std::function<void()>>;
+
+    //! callbacks for incoming messages. Published as a whole with copy-on-write, see tcan::RcuPointer.
+    struct DispatchTable {
+        CanFrameIdentifierToFunctionMap callbacks_;
+        CallbackPtr unmappedMessageCallback_;
+        //! execution time of all callbacks per device, if BusOptions::profileCallbacks_ is set
+        std::unordered_map<CanDevice*, std::shared_ptr<tcan::CallbackProfile>> deviceProfiles_;
+    };
 
     CanBus() = delete;
     CanBus(std::unique_ptr<CanBusOptions>&& options);
@@ -56,15 +81,25 @@ class CanBus : public tcan::Bus<CanMsg> {
         return std::make_pair(dev, success);
     }
 
-    /*! Adds a device to the device vector and calls its initDevice function
+    /*! Adds a device to the device vector and calls its initDevice function. May be called while the bus threads are running.
      * @param device    Pointer to the device
      * @return true if init was successful
      */
     inline bool addDevice(CanDevice* device) {
-        devices_.push_back(device);
+        devices_.update([device](DeviceContainer& devices) { devices.push_back(device); return true; });
+        if(deviceStateTable_ != nullptr) {
+            device->setStateTableInternal(deviceStateTable_);
+        }
         return device->initDeviceInternal(this);
     }
 
+    /*! Removes a device and all its message callbacks from the bus and deletes it. Waits until the receive and sanity check threads do
+     * not use the device anymore, so it must not be called from a message callback or the sanity check.
+     * @param device    pointer to the device
+     * @return false if the device is not handled by this bus
+     */
+    bool removeDevice(CanDevice* device);
+
     /*! Adds a device and callback function for incoming messages identified by its CAN frame identifier. The timeout
      *  counter of the device is reset on reception of the message (treated as heartbeat).
      * @param canFrameId        29 or 11 bit frame ID of the message
@@ -75,13 +110,13 @@ class CanBus : public tcan::Bus<CanMsg> {
     template <class T>
     inline bool addCanMessage(const uint32_t canFrameId, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<!std::is_base_of<CanDevice, T>::value>::type* = 0)
     {
-        return canFrameIdentifierToFunctionMap_.emplace(CanFrameIdentifier{canFrameId }, std::make_pair(nullptr, std::bind(fp, device, std::placeholders::_1))).second;
+        return addCallback(CanFrameIdentifier{canFrameId}, nullptr, std::bind(fp, device, std::placeholders::_1));
     }
 
     template <class T>
     inline bool addCanMessage(const uint32_t canFrameId, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<std::is_base_of<CanDevice, T>::value>::type* = 0)
     {
-        return canFrameIdentifierToFunctionMap_.emplace(CanFrameIdentifier{canFrameId }, std::make_pair(device, std::bind(fp, device, std::placeholders::_1))).second;
+        return addCallback(CanFrameIdentifier{canFrameId}, device, std::bind(fp, device, std::placeholders::_1));
     }
 
     /*! Like addCanMessage with a specific CanId, but matches against a range of CanIds through a mask.
@@ -95,25 +130,45 @@ class CanBus : public tcan::Bus<CanMsg> {
     template <class T>
     inline bool addCanMessage(const CanFrameIdentifier matcher, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<!std::is_base_of<CanDevice, T>::value>::type* = 0)
     {
-        return canFrameIdentifierToFunctionMap_.emplace(matcher, std::make_pair(nullptr, std::bind(fp, device, std::placeholders::_1))).second;
+        return addCallback(matcher, nullptr, std::bind(fp, device, std::placeholders::_1));
     }
 
     template <class T>
     inline bool addCanMessage(const CanFrameIdentifier matcher, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<std::is_base_of<CanDevice, T>::value>::type* = 0)
     {
-        return canFrameIdentifierToFunctionMap_.emplace(matcher, std::make_pair(device, std::bind(fp, device, std::placeholders::_1))).second;
+        return addCallback(matcher, device, std::bind(fp, device, std::placeholders::_1));
     }
 
+    /*! Removes the callback of a message. May be called while the bus threads are running, also from a message callback.
+     * @param matcher   CanFrameIdentifier the callback was added with
+     * @return false if there is no callback for the identifier
+     */
+    bool removeCanMessage(const CanFrameIdentifier matcher);
+
+    inline bool removeCanMessage(const uint32_t canFrameId) { return removeCanMessage(CanFrameIdentifier{canFrameId}); }
+
     /*! Send a sync message on the bus. Is called by BusManager::sendSyncOnAllBuses or directly.
      */
     inline void sendSync() {
+        tcan::TraceRecorder::instant("SYNC queued", traceTrack_, 0x80);
         sendMessage(CanMsg(0x80, 0, nullptr));
     }
 
+    using DeviceContainerSnapshot = tcan::RcuPointer<DeviceContainer>::ReadGuard;
+
     /*!
-     * @return  Container with all devices handled by this bus
+     * @return  Container with all devices handled by this bus. Invalidated by addDevice(..) and removeDevice(..), use
+     *          getDeviceContainerSnapshot() if devices may be added or removed concurrently.
      */
-    const DeviceContainer& getDeviceContainer() const { return devices_; }
+    const DeviceContainer& getDeviceContainer() const { return *devices_.read(); }
+
+    /*!
+     * @return  Snapshot of the devices handled by this bus, which stays valid while it is held. Release it before calling
+     *          removeDevice(..), which waits for all snapshots.
+     */
+    DeviceContainerSnapshot getDeviceContainerSnapshot() const { return devices_.read(); }
+
+    void setDeviceStateTable(tcan::DeviceStateTable* table) override;
 
     /*!
      * Resets all devices handled by this bus to Initializing state and sends appropriate restart commands to the devices
@@ -125,21 +180,145 @@ class CanBus : public tcan::Bus<CanMsg> {
      * @param callbackPtr std::function wrapper containing the callback function pointer
      */
     inline void setUnmappedMessageCallback(const CallbackPtr& callbackPtr) {
-        // todo: protect this with a mutex? (also inside handleMessage)
-        unmappedMessageCallbackFunction_ = callbackPtr;
+        dispatchTable_.update([&callbackPtr](DispatchTable& table) { table.unmappedMessageCallback_ = callbackPtr; return true; });
     }
 
+    //! Counts the frame in the unmapped traffic profiler, see getUnmappedTrafficReport().
     bool defaultHandleUnmappedMessage(const CanMsg& msg);
 
+    /*!
+     * Formats the counters, rates and last payloads of the unhandled identifiers which were received since the previous report, and
+     * suggests receive filters which drop them in the kernel. Starts a new rate interval. Allocates, call it periodically from a non
+     * real-time thread of the application (or enable CanBusOptions::unmappedTrafficReportInterval_ outside of real-time use).
+     * @return  the report, or an empty string if no unhandled frame was received since the previous report
+     */
+    std::string getUnmappedTrafficReport();
+
+    //! @return profiler of the unhandled frames, e.g. to evaluate the counters in the application
+    inline UnmappedTrafficProfiler& getUnmappedTrafficProfiler() { return unmappedTraffic_; }
+
+    /*!
+     * @return  identifiers of all registered callbacks. Used as receive filter set (e.g. SocketBusOptions::canFilters_), they let the
+     *          kernel drop all unhandled frames.
+     */
+    std::vector<CanFrameIdentifier> getHandledFrameIdentifiers() const;
+
+    /*!
+     * Formats the execution time histograms of all callbacks and devices (see BusOptions::profileCallbacks_), sorted by the longest
+     * execution time. Allocates, do not call from a real-time thread.
+     * @return  the report, or an empty string if profiling is disabled
+     */
+    std::string getCallbackProfileReport() const;
+
+    /*!
+     * @param matcher   CanFrameIdentifier the callback was added with
+     * @return          execution time profile of the callback. nullptr if there is no such callback or profiling is disabled.
+     */
+    std::shared_ptr<tcan::CallbackProfile> getCallbackProfile(const CanFrameIdentifier& matcher) const;
+
+    //! @return execution time profile of all callbacks of a device. nullptr if the device has no callback or profiling is disabled.
+    std::shared_ptr<tcan::CallbackProfile> getDeviceCallbackProfile(CanDevice* device) const;
+
+    /*!
+     * Sets (or replaces) the inhibit time and rate limit of outgoing messages with the given identifier. See CanBusOptions::transmitLimits_.
+     * @param canFrameId    29 or 11 bit frame ID of the message
+     * @param limit         limit to be applied
+     */
+    void setTransmitLimit(const uint32_t canFrameId, const TransmitLimit& limit);
+
+    /*!
+     * Removes the transmit limit of messages with the given identifier
+     * @param canFrameId    29 or 11 bit frame ID of the message
+     */
+    void removeTransmitLimit(const uint32_t canFrameId);
+
+    /*!
+     * @param canFrameId    29 or 11 bit frame ID of the message
+     * @param limit         transmit limit of the identifier (output parameter)
+     * @return false if the identifier has no transmit limit
+     */
+    bool getTransmitLimit(const uint32_t canFrameId, TransmitLimit& limit);
+
+    /*!
+     * Sets (or replaces) a function which is called after a message with the given identifier was written, with the output queue locked.
+     * It may queue further messages with sendMessageWithoutLock(..), e.g. to feed the frames of a long transfer a bounded window at a
+     * time instead of filling the output queue with all of them. It must not call functions which lock the output queue.
+     * @param canFrameId    29 or 11 bit frame ID of the message
+     * @param callback      function to be called, an empty function to remove it
+     */
+    void setTransmitCallback(const uint32_t canFrameId, const std::function<void()>& callback);
+
+    /*!
+     * @return  number of times an outgoing message was held back because its identifier exceeded its transmit limit
+     */
+    inline unsigned int getNumThrottlingEvents() const { return numThrottlingEvents_; }
+
+    /*!
+     * @param canFrameId    29 or 11 bit frame ID of the message
+     * @return  number of times an outgoing message with the given identifier was held back. 0 if the identifier has no transmit limit.
+     */
+    unsigned int getNumThrottlingEvents(const uint32_t canFrameId);
+
+    /*!
+     * @return  number of budget cycles in which background frames were deferred because they exceeded the bandwidth budget
+     *          (see CanBusOptions::bandwidthBudget_)
+     */
+    unsigned int getNumBudgetDeferredCycles();
+
+    /*!
+     * Adds a time-triggered message to the transmit schedule of this bus. The message is sent once per cycle, at the given offset from the
+     * cycle start or SYNC (see CanBusOptions::scheduleReference_). The schedule is executed by the transmit thread and therefore only
+     * available in asynchronous mode.
+     * @param offset    offset from the cycle start [us]
+     * @param msg       initial message of the slot. Update it with setScheduleSlotMessage(..)
+     * @return          index of the slot
+     */
+    unsigned int addScheduleSlot(const unsigned int offset, const CanMsg& msg);
+
+    /*!
+     * Replaces the message of a schedule slot. The new message is sent in the next occurrence of the slot.
+     * @return false if the index is invalid
+     */
+    bool setScheduleSlotMessage(const unsigned int index, const CanMsg& msg);
+
+    /*!
+     * Starts the transmit schedule. With reference Cycle, the first cycle starts now. With reference Sync, the first SYNC starts the first cycle.
+     * @return false if the bus is not asynchronous or the schedule options are invalid
+     */
+    bool startSchedule();
+
+    void stopSchedule();
+
+    /*!
+     * @param index         index of the slot
+     * @param statistics    timing statistics of the slot (output parameter)
+     * @return false if the index is invalid
+     */
+    bool getScheduleSlotStatistics(const unsigned int index, ScheduleSlotStatistics& statistics);
+
+    /*!
+     * @return number of schedule slots which were skipped because they were late by more than a cycle, the bus was passive or a SYNC started a new cycle.
+     */
+    unsigned int getNumSkippedScheduleSlots();
+
 
  public:/// INTERNAL FUNCTIONS
     /*! Send a sync message on the bus without locking the queue.
      * This function is intended to be used by BusManager::sendSyncOnAllBuses, which locks the queue.
      */
     inline void sendSyncWithoutLock() {
+        tcan::TraceRecorder::instant("SYNC queued", traceTrack_, 0x80);
         sendMessageWithoutLock(CanMsg(0x80, 0, nullptr));
     }
 
+    //! Queues a message. The output queue has to be locked by the caller, e.g. in a transmit callback (see setTransmitCallback(..)).
+    using tcan::Bus<CanMsg>::sendMessageWithoutLock;
+
+    //! Like setTransmitLimit(..), removeTransmitLimit(..) and getTransmitLimit(..). The output queue has to be locked by the caller.
+    void setTransmitLimitWithoutLock(const uint32_t canFrameId, const TransmitLimit& limit);
+    void removeTransmitLimitWithoutLock(const uint32_t canFrameId);
+    bool getTransmitLimitWithoutLock(const uint32_t canFrameId, TransmitLimit& limit) const;
+
     /*! Is called after reception of a message. Routes the message to the callback and clears the errorMsgFlag_
      * @param cmsg	reference to the can message
      */
@@ -150,14 +329,81 @@ class CanBus : public tcan::Bus<CanMsg> {
     bool sanityCheck() override;
 
  protected:
-    // vector containing all devices
-    DeviceContainer devices_;
+    bool addCallback(const CanFrameIdentifier& matcher, CanDevice* device, const CallbackPtr& callback);
+
+    //! Warns about callbacks which exceeded BusOptions::slowCallbackThreshold_ since the previous check.
+    void checkSlowCallbacks();
+
+    /*! Moves the first message of the output queue which does not exceed its transmit limit to the front of the queue.
+     */
+    bool releaseFrontMessageWithoutLock(std::chrono::steady_clock::time_point& retryTime) override;
+
+    bool peekReleasableMessageWithoutLock(std::chrono::steady_clock::time_point& retryTime) const override;
+
+    /*! @return position of the first message of the output queue which does not exceed its transmit limit or the background budget,
+     * the size of the queue if all messages are held back. Does not change the queue, the limiters or the budget.
+     */
+    std::size_t findReleasableMessageWithoutLock(const std::chrono::steady_clock::time_point& now,
+                                                 std::chrono::steady_clock::time_point& retryTime) const;
+
+    /*! Removes a written message from the output queue. This is usually the front, but the queue may have been changed while it was
+     * unlocked during the write.
+     */
+    void removeWrittenMessageWithoutLock(const CanMsg& msg);
+
+    void handleFrontMessageWritten() override;
+
+    void queueScheduledMessagesWithoutLock(std::chrono::steady_clock::time_point& wakeupTime) override;
+
+    /*! @return true if the queued messages may be written in a single batch, i.e. the order of the output queue is final and no
+     * message needs to be accounted individually after it was written (no transmit limits, transmit callbacks or running schedule).
+     */
+    inline bool isBatchWriteAllowedWithoutLock() const {
+        return transmitLimiters_.empty() && transmitCallbacks_.empty() && !schedule_.isRunning() && !budget_.isEnabled();
+    }
+
+ protected:
+    // vector containing all devices. Copy-on-write, such that devices can be added while the threads are running.
+    tcan::RcuPointer<DeviceContainer> devices_;
+
+    // maps COB ids to parse functions, and function to be called for unmapped COB ids. Read without locking by the receive thread.
+    tcan::RcuPointer<DispatchTable> dispatchTable_;
+
+    // transmit limiters of rate limited COB ids. Protected by outgoingMsgsMutex_.
+    TransmitLimiterMap transmitLimiters_;
+
+    // functions called after a message with the identifier was written. Protected by outgoingMsgsMutex_.
+    TransmitCallbackMap transmitCallbacks_;
+
+    // limiter of the message released by releaseFrontMessageWithoutLock(..). nullptr if the message is not rate limited.
+    TransmitLimiter* releasedLimiter_;
+
+    // total number of throttling events
+    std::atomic<unsigned int> numThrottlingEvents_;
+
+    // identifier of the message released by releaseFrontMessageWithoutLock(..)
+    uint32_t releasedCobId_;
+
+    // tag of the message released by releaseFrontMessageWithoutLock(..), see TransmitSchedule
+    uint16_t releasedTag_;
+
+    // bus time budget of background frames. Protected by outgoingMsgsMutex_.
+    BandwidthBudget budget_;
+
+    // bus time of the released message if it is a background frame, 0 otherwise
+    std::chrono::nanoseconds releasedBackgroundTime_;
+
+    // time-triggered messages. Protected by outgoingMsgsMutex_.
+    TransmitSchedule schedule_;
+    std::atomic<bool> isScheduleTriggeredBySync_;
 
-    // map mapping COB id to parse functions
-    CanFrameIdentifierToFunctionMap canFrameIdentifierToFunctionMap_;
+    // counters of unhandled frames, and time of the next report in the sanity check. The report is protected by unmappedReportMutex_.
+    UnmappedTrafficProfiler unmappedTraffic_;
+    tcan::PriorityInheritanceMutex unmappedReportMutex_;
+    std::chrono::steady_clock::time_point nextUnmappedReportTime_;
 
-    // function pointer to be called for unmapped COB ids
-    CallbackPtr unmappedMessageCallbackFunction_;
+    // state table the devices are registered in, see setDeviceStateTable(..). Accessed by the thread adding and removing devices.
+    tcan::DeviceStateTable* deviceStateTable_;
 };
 
 } /* namespace tcan_can */
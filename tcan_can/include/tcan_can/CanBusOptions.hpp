@@ -1,6 +1,12 @@
 #pragma once
 
+#include <stdint.h>
+#include <unordered_map>
+
 #include "tcan/BusOptions.hpp"
+#include "tcan_can/BandwidthBudget.hpp"
+#include "tcan_can/TransmitLimiter.hpp"
+#include "tcan_can/TransmitSchedule.hpp"
 
 namespace tcan_can {
 
@@ -13,7 +19,13 @@ struct CanBusOptions : public tcan::BusOptions {
     CanBusOptions(const std::string& name):
         BusOptions(name),
         passivateOnBusError_(false),
-        passivateIfNoDevices_(false)
+        passivateIfNoDevices_(false),
+        transmitLimits_(),
+        scheduleReference_(TransmitSchedule::Reference::Cycle),
+        scheduleCycleTime_(0),
+        bandwidthBudget_(),
+        unmappedTrafficTableSize_(64),
+        unmappedTrafficReportInterval_(0)
     {
     }
 
@@ -24,6 +36,30 @@ struct CanBusOptions : public tcan::BusOptions {
 
     //! If set to true, bus goes to passive mode (no messages are sent on the bus) if all devices are missing.
     bool passivateIfNoDevices_;
+
+    //! Per-identifier inhibit times and rate limits of outgoing messages {can_id, limit}. Messages exceeding the limit are held back
+    // in the output queue (without blocking messages with other identifiers) until they may be sent.
+    std::unordered_map<uint32_t, TransmitLimit> transmitLimits_;
+
+    //! Reference of the slot offsets of the transmit schedule (see CanBus::addScheduleSlot(..)): a free-running cycle or SYNC messages
+    // (sent or received on this bus).
+    TransmitSchedule::Reference scheduleReference_;
+
+    //! Cycle time of the transmit schedule [us]. Required for reference Cycle. For reference Sync, slots with a larger offset are skipped (0 = no limit).
+    unsigned int scheduleCycleTime_;
+
+    //! Per-cycle bus time budget of background frames (SDOs by default). Frames exceeding the budget are held back in the output queue
+    // until the next cycle, such that they do not delay the cyclic frames. Disabled by default (cycle time 0).
+    BandwidthBudgetOptions bandwidthBudget_;
+
+    //! Number of distinct identifiers of unhandled frames which are profiled individually (see CanBus::getUnmappedTrafficReport()).
+    unsigned int unmappedTrafficTableSize_;
+
+    /*! Interval in which the sanity check logs the report of unhandled frames, if there were any [ms]. 0 (default) to disable the report.
+     * Formatting the report allocates on the sanity check thread, which runs with real-time priority (or in the synchronous cycle).
+     * Prefer calling CanBus::getUnmappedTrafficReport() periodically from a non real-time thread of the application.
+     */
+    unsigned int unmappedTrafficReportInterval_;
 };
 
 } /* namespace tcan_can */
@@ -7,6 +7,8 @@
 
 #include "tcan_can/CanMsg.hpp"
 #include "tcan_can/CanDeviceOptions.hpp"
+#include "tcan/DeviceStateTable.hpp"
+#include "tcan/probes.hpp"
 
 #include "message_logger/message_logger.hpp"
 
@@ -38,7 +40,9 @@ class CanDevice {
         options_(std::move(options)),
         deviceTimeoutCounter_(0),
         state_(Initializing),
-        bus_(nullptr)
+        bus_(nullptr),
+        stateTable_(nullptr),
+        stateSlot_(-1)
     {
     }
 
@@ -69,7 +73,7 @@ class CanDevice {
     virtual bool sanityCheck() {
         if(!isMissing()) {
             if(isTimedOut()) {
-                state_ = Missing;
+                setState(Missing);
                 MELO_WARN("Device %s timed out!", getName().c_str());
             }
         }
@@ -90,7 +94,7 @@ class CanDevice {
     /*!
      * Resets the device to Initializing state
      */
-    virtual void resetDevice() { state_ = Initializing; }
+    virtual void resetDevice() { setState(Initializing); }
 
  public: /// Internal functions
     /*! Initialize the device. This function is automatically called by Bus::addDevice(..).
@@ -104,7 +108,7 @@ class CanDevice {
     inline void configureDeviceInternal(const CanMsg& msg) {
         if(state_ != Active && state_ != Error) {
             if(configureDevice(msg)) {
-                state_ = Active;
+                setState(Active);
                 if(options_->printConfigInfo_) {
                     MELO_INFO("Device %s configured successfully.", options_->name_.c_str());
                 }
@@ -116,7 +120,43 @@ class CanDevice {
         deviceTimeoutCounter_ = 0;
     }
 
+    /*!
+     * Registers the device in a state table, which is updated with getStatus() on every state change, or unregisters it.
+     * This function is automatically called by the bus, see tcan::Bus::setDeviceStateTable(..).
+     * @param table state table, nullptr to unregister the device
+     */
+    inline void setStateTableInternal(tcan::DeviceStateTable* table) {
+        const int slot = stateSlot_.exchange(-1);
+        if(slot >= 0) {
+            stateTable_->unregisterDevice(slot);
+        }
+        if(table != nullptr) {
+            stateTable_ = table;
+            const int newSlot = table->registerDevice(getName(), getStatus());
+            if(newSlot < 0) {
+                MELO_WARN("Device state table is full, state of device %s is not published.", getName().c_str());
+            }
+            stateSlot_ = newSlot;
+        }
+    }
+
  protected:
+    //! Sets the state and fires the device_state probe if it changed (see tcan/probes.hpp)
+    inline void setState(const State state) {
+        if(state_.exchange(state) != state) {
+            TCAN_PROBE3(device_state, options_->name_.c_str(), options_->nodeId_, static_cast<int>(state));
+            updateStateTable();
+        }
+    }
+
+    //! Writes getStatus() to the state table. Call it if getStatus() changes without a change of the state (e.g. NMT state).
+    inline void updateStateTable() {
+        const int slot = stateSlot_;
+        if(slot >= 0) {
+            stateTable_->setState(slot, getStatus());
+        }
+    }
+
     /*!
      * @return True if the device timed out
      */
@@ -135,6 +175,10 @@ class CanDevice {
 
     //!  reference to the CAN bus the device is connected to
     CanBus* bus_;
+
+    //! state table the device is registered in, see setStateTableInternal(..). stateSlot_ is -1 if the device is not registered.
+    tcan::DeviceStateTable* stateTable_;
+    std::atomic<int> stateSlot_;
 };
 
 } /* namespace tcan_can */
@@ -21,14 +21,16 @@ class CanMsg {
     CanMsg(const uint32_t CobId):
         CobId_(CobId),
         length_{0},
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        data_{0, 0, 0, 0, 0, 0, 0, 0},
+        tag_(0)
     {
     }
 
     CanMsg(const uint32_t CobId, const uint8_t length):
           CobId_(CobId),
           length_(length),
-          data_{0, 0, 0, 0, 0, 0, 0, 0}
+          data_{0, 0, 0, 0, 0, 0, 0, 0},
+        tag_(0)
     {
         assert(length <= Capacity);
     }
@@ -36,7 +38,8 @@ class CanMsg {
     CanMsg(const uint32_t CobId, const uint8_t length, const uint8_t* data):
         CobId_(CobId),
         length_(length),
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        data_{0, 0, 0, 0, 0, 0, 0, 0},
+        tag_(0)
     {
         assert(length <= Capacity);
         std::copy(&data[0], &data[length], data_);
@@ -45,7 +48,8 @@ class CanMsg {
     CanMsg(const uint32_t CobId, const uint8_t length, const std::initializer_list<uint8_t> data):
         CobId_(CobId),
         length_(length),
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        data_{0, 0, 0, 0, 0, 0, 0, 0},
+        tag_(0)
     {
         assert(length <= Capacity);
         assert(length == data.size());
@@ -55,7 +59,8 @@ class CanMsg {
     CanMsg(const uint32_t CobId, const std::initializer_list<uint8_t> data):
         CobId_(CobId),
         length_(data.size()),
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        data_{0, 0, 0, 0, 0, 0, 0, 0},
+        tag_(0)
     {
         assert(data.size() <= Capacity);
         std::copy(data.begin(), data.end(), data_);
@@ -89,6 +94,13 @@ class CanMsg {
      */
     inline void setLength(const uint8_t length) { length_ = length; }
 
+    /*!
+     * Tag of the message, which is not transmitted. Identifies the messages of the transmit schedule in the output queue.
+     * @return 0 if the message is not tagged
+     */
+    constexpr uint16_t getTag() const { return tag_; }
+    inline void setTag(const uint16_t tag) { tag_ = tag; }
+
 
     /*! Sets the stack of values
      * @param value   array of length 8
@@ -277,6 +289,12 @@ class CanMsg {
     /*! Data of the CAN message
      */
     uint8_t data_[Capacity];
+
+    //! fits into the padding of the message
+    uint16_t tag_;
 };
 
+//! COB id shown in traces, see tcan::TraceRecorder
+inline uint32_t getTraceId(const CanMsg& msg) { return msg.getCobId(); }
+
 } /* namespace tcan_can */
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+
+#include "tcan_can/SdoMsg.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Asynchronous configuration sequence of a CANopen device (see DeviceCanOpen::startConfigSequence(..)).
+ * The steps are executed one after another, driven by the SDO answers, heartbeats and sanity checks of the device. No thread waits for
+ * an answer, such that the devices on a bus are configured concurrently.
+ * Steps added from within a callback are executed right after the step of the callback, before the remaining steps. This allows
+ * conditional configuration, e.g. reading a value and deciding what to write:
+ *
+ *   sequence.sdoRead(0x1018, 0x02, [](const SdoMsg& answer, ConfigSequence& s) {
+ *       if(answer.readuint32(4) == productCode) {
+ *           s.sdoWrite(SdoMsg::Command::WRITE_2_BYTE, 0x1017, 0x00, 100);
+ *       }
+ *       return true;
+ *   }).waitHeartbeat(1000);
+ */
+class ConfigSequence {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    //! callbacks return false to abort the sequence
+    using ReadCallback = std::function<bool(const SdoMsg& answer, ConfigSequence& sequence)>;
+    using StepCallback = std::function<bool(ConfigSequence& sequence)>;
+
+    //! called once when the sequence is done or failed, with the result
+    using DoneCallback = std::function<void(const bool success)>;
+
+    enum class Status : uint8_t {
+        Idle,
+        Running,
+        Done,
+        Failed
+    };
+
+    //! heartbeat state bytes for waitHeartbeat(..)
+    static constexpr int anyHeartbeatState = -1;
+    static constexpr int heartbeatBootUp = 0x00;
+    static constexpr int heartbeatStopped = 0x04;
+    static constexpr int heartbeatOperational = 0x05;
+    static constexpr int heartbeatPreOperational = 0x7F;
+
+    //! function sending an SDO on the bus, provided by the device
+    using SendSdoFunction = std::function<void(const SdoMsg& sdo)>;
+
+    ConfigSequence();
+
+    //! Writes an object and waits for the acknowledge.
+    ConfigSequence& sdoWrite(const SdoMsg::Command command, const uint16_t index, const uint8_t subIndex, const uint32_t data);
+
+    //! Reads an object and passes the answer to the callback.
+    ConfigSequence& sdoRead(const uint16_t index, const uint8_t subIndex, const ReadCallback& callback);
+
+    /*! Waits for the next heartbeat (or boot-up message) of the device.
+     * @param timeout   time until the sequence fails [ms]
+     * @param state     heartbeat state byte to wait for, anyHeartbeatState to accept every heartbeat
+     */
+    ConfigSequence& waitHeartbeat(const unsigned int timeout, const int state = anyHeartbeatState);
+
+    //! Calls a function, e.g. to send an NMT command or to add steps depending on values read before.
+    ConfigSequence& call(const StepCallback& callback);
+
+    //! Sets the function called when the sequence is done or failed.
+    ConfigSequence& onDone(const DoneCallback& callback);
+
+    inline Status getStatus() const { return status_; }
+    inline bool isRunning() const { return status_ == Status::Running; }
+
+    //! @return number of steps which are not executed yet
+    inline unsigned int getNumRemainingSteps() const { return steps_.size(); }
+
+ public: /// Internal functions, called by DeviceCanOpen
+    void start(const SendSdoFunction& sendSdo, const Clock::time_point& now);
+
+    //! answer (or error response if isError) of an SDO
+    void handleSdoAnswer(const SdoMsg& answer, const bool isError, const Clock::time_point& now);
+
+    //! SDO which was not answered after all retries
+    void handleSdoTimeout(const SdoMsg& request);
+
+    void handleHeartbeat(const uint8_t state, const Clock::time_point& now);
+
+    //! fails the sequence if a heartbeat did not arrive in time
+    void checkTimeout(const Clock::time_point& now);
+
+    //! fails the sequence, e.g. if the device was reset
+    void abort();
+
+ protected:
+    enum class StepType : uint8_t {
+        SdoWrite,
+        SdoRead,
+        WaitHeartbeat,
+        Call
+    };
+
+    struct Step {
+        Step(const StepType type):
+            type_(type),
+            sdo_(),
+            readCallback_(),
+            callback_(),
+            timeout_(0),
+            heartbeatState_(anyHeartbeatState)
+        {
+        }
+
+        StepType type_;
+        SdoMsg sdo_;
+        ReadCallback readCallback_;
+        StepCallback callback_;
+        unsigned int timeout_;
+        int heartbeatState_;
+    };
+
+    //! appends a step, or inserts it after the steps added before by the running callback
+    void addStep(Step&& step);
+
+    //! executes steps until one has to wait for the device
+    void advance(const Clock::time_point& now);
+
+    void finish(const bool success);
+
+    bool isWaitingForSdo(const SdoMsg& msg) const;
+
+ protected:
+    std::deque<Step> steps_;
+    Status status_;
+    SendSdoFunction sendSdo_;
+    DoneCallback doneCallback_;
+
+    //! step waiting for an answer of the device
+    bool waiting_;
+    Step currentStep_;
+    Clock::time_point deadline_;
+
+    //! position in steps_ at which steps added by the running callback are inserted. Negative if no callback is running.
+    int insertPosition_;
+};
+
+} /* namespace tcan_can */
@@ -7,9 +7,11 @@
 #include <unordered_map>
 #include <memory>
 
+#include "tcan/PriorityInheritanceMutex.hpp"
 #include "tcan_can/DeviceCanOpenOptions.hpp"
 #include "tcan_can/CanDevice.hpp"
 #include "tcan_can/CanBus.hpp"
+#include "tcan_can/ConfigSequence.hpp"
 #include "tcan_can/SdoMsg.hpp"
 
 
@@ -87,6 +89,21 @@ class DeviceCanOpen : public CanDevice {
      */
     virtual void handleSdoError(const SdoMsg& request, const SdoMsg& answer);
 
+    /*! Starts an asynchronous configuration sequence. The steps are executed by the bus threads (or the synchronous read and sanity check
+     * calls) on reception of SDO answers and heartbeats, so this function returns immediately and the sequences of several devices run
+     * concurrently. The callbacks of the sequence must not call startConfigSequence(..) or abortConfigSequence().
+     * An SDO error or timeout fails the sequence, in addition to the handling by handleSdoError(..) and handleTimedoutSdo(..).
+     * @param sequence  sequence to be executed
+     * @return false if another sequence is running
+     */
+    bool startConfigSequence(ConfigSequence&& sequence);
+
+    //! Fails the running configuration sequence, if any.
+    void abortConfigSequence();
+
+    //! @return status of the last started configuration sequence
+    ConfigSequence::Status getConfigSequenceStatus() const;
+
     /*! Get the SDO answer and erase it from the SDO answer map if it has been received.
      * @param sdoAnswer SDO answer if it has been found (output parameter).
      * @return true if SDO answer has been found.
@@ -168,12 +185,16 @@ class DeviceCanOpen : public CanDevice {
     std::atomic<unsigned int> sdoTimeoutCounter_;
     std::atomic<unsigned int> sdoSentCounter_;
 
-    std::mutex sdoMsgsMutex_;
+    tcan::PriorityInheritanceMutex sdoMsgsMutex_;
     std::queue<SdoMsg> sdoMsgs_;
 
     // Map from SDO answer id to SDO answer.
-    std::mutex sdoAnswerMapMutex_;
+    tcan::PriorityInheritanceMutex sdoAnswerMapMutex_;
     std::unordered_map<uint32_t, SdoMsg> sdoAnswerMap_;
+
+    // configuration sequence, see startConfigSequence(..). Never locked while sdoMsgsMutex_ is held.
+    mutable tcan::PriorityInheritanceMutex configSequenceMutex_;
+    ConfigSequence configSequence_;
 };
 
 } /* namespace tcan_can */
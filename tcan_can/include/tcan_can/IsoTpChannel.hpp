@@ -0,0 +1,187 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tcan/PriorityInheritanceMutex.hpp"
+#include "tcan_can/CanDevice.hpp"
+#include "tcan_can/IsoTpChannelOptions.hpp"
+#include "tcan_can/TransmitLimiter.hpp"
+
+namespace tcan_can {
+
+/*!
+ * ISO-TP (ISO 15765-2) transport of messages longer than a CAN frame, e.g. for UDS diagnostics and calibration downloads.
+ * The channel is added to a CanBus like a device. It uses a kernel CAN_ISOTP socket on the interface of the bus if available
+ * (see IsoTpChannelOptions::implementation_), which segments the messages and handles the flow control in the kernel. Otherwise, the
+ * channel sends and receives the frames through the bus. Then the separation time requested by the receiver is enforced as inhibit time
+ * of the transmit identifier during the transfer (see CanBus::setTransmitLimit(..)), and the consecutive frames are queued as the
+ * previous ones are written, at most IsoTpChannelOptions::maxQueuedFrames_ at a time. The transmit identifier is reserved to the channel.
+ * The userspace implementation needs the bus threads (or the synchronous read and write calls) to progress, so the waiting functions
+ * must not be called from the thread driving a synchronous bus.
+ * One message is sent at a time. Received messages are queued until they are taken with receive(..).
+ */
+class IsoTpChannel : public CanDevice {
+ public:
+    enum class FrameType : uint8_t {
+        Single = 0,
+        First = 1,
+        Consecutive = 2,
+        FlowControl = 3
+    };
+
+    enum class FlowStatus : uint8_t {
+        ContinueToSend = 0,
+        Wait = 1,
+        Overflow = 2
+    };
+
+    IsoTpChannel(std::unique_ptr<IsoTpChannelOptions>&& options);
+
+    ~IsoTpChannel() override;
+
+    bool initDevice() override;
+
+    bool configureDevice(const CanMsg& msg) override;
+
+    //! Checks the flow control and reception timeouts of the userspace implementation.
+    bool sanityCheck() override;
+
+    /*!
+     * Starts sending a message. Does not block.
+     * @param data      payload
+     * @param length    length of the payload [bytes]
+     * @return false if a message is being sent, the message is too long or could not be queued
+     */
+    bool startTransmission(const uint8_t* data, const std::size_t length);
+
+    /*!
+     * Waits until the message started with startTransmission(..) is sent.
+     * @param timeout   maximum time to wait
+     * @return false on timeout, or if the receiver aborted the transfer or did not send flow control
+     */
+    bool waitForTransmission(const std::chrono::milliseconds& timeout);
+
+    //! Starts sending a message and waits until it is sent. See startTransmission(..) and waitForTransmission(..).
+    bool send(const uint8_t* data, const std::size_t length, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(1000));
+
+    inline bool send(const std::vector<uint8_t>& data, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(1000)) {
+        return send(data.data(), data.size(), timeout);
+    }
+
+    /*!
+     * Takes the oldest received message.
+     * @param data      payload of the message (output parameter)
+     * @param timeout   maximum time to wait for a message. 0 to return immediately.
+     * @return false if no message was received
+     */
+    bool receive(std::vector<uint8_t>& data, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(0));
+
+    //! @return true if the kernel CAN_ISOTP socket is used
+    inline bool isKernelImplementation() const { return socket_ >= 0; }
+
+    //! @return number of transfers which failed because of a timeout, an overflow or a wrong sequence number
+    inline unsigned int getNumFailedTransfers() const { return numFailedTransfers_; }
+
+    /*!
+     * Converts a separation time to the STmin byte of a flow control frame.
+     * @param separationTime    [us], rounded up to the next value supported by ISO 15765-2
+     */
+    static uint8_t encodeSeparationTime(const unsigned int separationTime);
+
+    //! @return separation time of the STmin byte of a flow control frame [us]. Reserved values are interpreted as 127ms.
+    static unsigned int decodeSeparationTime(const uint8_t stMin);
+
+ public: /// Internal functions
+    //! Handles a frame of the receive identifier (userspace implementation)
+    bool parseFrame(const CanMsg& msg);
+
+ protected:
+    enum class TransmitState : uint8_t {
+        Idle,
+        WaitForFlowControl,
+        SendConsecutive,
+        Done,
+        Failed
+    };
+
+    bool initializeKernelSocket();
+
+    void handleSingleFrame(const CanMsg& msg);
+    void handleFirstFrame(const CanMsg& msg);
+    void handleConsecutiveFrame(const CanMsg& msg);
+
+    //! Handles a flow control frame. The output queue of the bus has to be locked by the caller.
+    void handleFlowControlWithoutLock(const CanMsg& msg);
+
+    //! Transmit callback of the bus, is called after a frame of the channel was written. The output queue of the bus is locked.
+    void handleFrameWrittenWithoutLock();
+
+    //! Queues consecutive frames until the window or the block is full. The output queue of the bus has to be locked by the caller.
+    void queueConsecutiveFramesWithoutLock();
+
+    //! Enforces the separation time requested by the receiver on txId_. The output queue of the bus has to be locked by the caller.
+    void setSeparationTimeWithoutLock(const unsigned int separationTime);
+
+    //! Restores the transmit limit txId_ had before the transfer. The output queue of the bus has to be locked by the caller.
+    void restoreTransmitLimitWithoutLock();
+
+    //! Queues a frame, padded if padding_ is set. sendFrameWithoutLock(..) has to be called with the output queue of the bus locked.
+    bool sendFrame(const uint8_t* data, const uint8_t length);
+    bool sendFrameWithoutLock(const uint8_t* data, const uint8_t length);
+    bool sendFlowControl(const FlowStatus status);
+
+    //! Queues a received message for receive(..). mutex_ has to be locked by the caller.
+    void pushReceivedMessageWithoutLock(const uint8_t* data, const std::size_t length);
+
+    //! Aborts the current transmission. The output queue of the bus has to be locked by the caller.
+    void failTransmissionWithoutLock(const char* reason);
+
+    inline const IsoTpChannelOptions* getOptions() const { return static_cast<const IsoTpChannelOptions*>(options_.get()); }
+
+ protected:
+    //! kernel CAN_ISOTP socket, -1 for the userspace implementation
+    int socket_;
+
+    //! protects the receive state of the userspace implementation and the received messages
+    tcan::PriorityInheritanceMutex mutex_;
+    std::condition_variable_any cond_;
+
+    //! transmit state of the userspace implementation. Protected by the output queue mutex of the bus, such that the consecutive frames
+    // can be queued from the transmit callback. The channel does not lock mutex_ while the output queue is locked.
+    TransmitState transmitState_;
+    std::condition_variable_any txCond_;
+    std::vector<uint8_t> txData_;
+    std::size_t txOffset_;
+    uint8_t txSequenceNumber_;
+    std::chrono::steady_clock::time_point txDeadline_;
+    //! block size requested by the receiver, and number of consecutive frames queued in the current block
+    unsigned int txBlockSize_;
+    unsigned int txBlockCounter_;
+    //! frames of the channel in the output queue of the bus
+    unsigned int numQueuedFrames_;
+    //! separation time requested by the receiver, enforced as inhibit time of txId_ [us]
+    unsigned int txSeparationTime_;
+    //! transmit limit of txId_ before the separation time was enforced, restored after the transfer
+    bool isTransmitLimitChanged_;
+    bool hasPreviousTransmitLimit_;
+    TransmitLimit previousTransmitLimit_;
+
+    //! message being received, and its announced length. rxLength_ is 0 if no message is being received.
+    std::vector<uint8_t> rxData_;
+    std::size_t rxLength_;
+    uint8_t rxSequenceNumber_;
+    unsigned int rxBlockCounter_;
+    std::chrono::steady_clock::time_point rxDeadline_;
+
+    std::deque<std::vector<uint8_t>> receivedMessages_;
+
+    std::atomic<unsigned int> numFailedTransfers_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "tcan_can/CanDeviceOptions.hpp"
+
+namespace tcan_can {
+
+class IsoTpChannelOptions : public CanDeviceOptions {
+ public:
+    enum class Implementation : uint8_t {
+        Auto,       // kernel CAN_ISOTP socket if available, userspace otherwise
+        Kernel,     // kernel CAN_ISOTP socket, initialization fails if it is not available
+        Userspace   // segmentation and flow control by the channel, frames are sent and received through the CanBus
+    };
+
+    IsoTpChannelOptions() = delete;
+
+    /*!
+     * @param txId  CAN identifier of the frames sent by the channel
+     * @param rxId  CAN identifier of the frames received by the channel
+     * @param name  name of the channel
+     */
+    IsoTpChannelOptions(
+        const uint32_t txId,
+        const uint32_t rxId,
+        const std::string& name):
+        CanDeviceOptions(txId, name, 0),
+        txId_(txId),
+        rxId_(rxId),
+        implementation_(Implementation::Auto),
+        blockSize_(0),
+        separationTime_(0),
+        padding_(false),
+        paddingByte_(0xCC),
+        frameLength_(8),
+        timeout_(1000),
+        maxMessageLength_(4095),
+        maxQueuedMessages_(16),
+        maxQueuedFrames_(8)
+    {
+    }
+
+    ~IsoTpChannelOptions() override = default;
+
+    //! CAN identifier of the frames sent and received by the channel (normal addressing)
+    uint32_t txId_;
+    uint32_t rxId_;
+
+    Implementation implementation_;
+
+    //! number of consecutive frames the sender may send before it waits for the next flow control frame. 0 = no limit.
+    // Sent in the flow control frames of received messages.
+    uint8_t blockSize_;
+
+    //! minimum time between two consecutive frames the sender has to respect (STmin) [us]. Sent in the flow control frames of
+    // received messages. ISO 15765-2 supports 100-900us and 1-127ms, other values are rounded up.
+    unsigned int separationTime_;
+
+    //! pad all sent frames to the full frame length with paddingByte_
+    bool padding_;
+    uint8_t paddingByte_;
+
+    //! data length of the sent frames [bytes]. 8 for classic CAN, 12, 16, 20, 24, 32, 48 or 64 for CAN FD (kernel implementation only).
+    uint8_t frameLength_;
+
+    //! time to wait for a flow control frame of the receiver (N_Bs) or the next consecutive frame of the sender (N_Cr) [ms].
+    // Checked by sanityCheck(), so the resolution is the sanity check interval (userspace implementation only).
+    unsigned int timeout_;
+
+    //! maximum length of a received message [bytes]. Longer messages are rejected with an overflow flow control frame.
+    // Messages longer than 4095 bytes use the escape sequence of ISO 15765-2:2016.
+    unsigned int maxMessageLength_;
+
+    //! maximum number of received messages which were not taken with receive(..). Further messages are dropped.
+    unsigned int maxQueuedMessages_;
+
+    //! maximum number of frames of the channel in the output queue of the bus. The consecutive frames of a message are queued as the
+    // previous ones are written, so long messages do not need to fit into BusOptions::maxQueueSize_ (userspace implementation only).
+    unsigned int maxQueuedFrames_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tcan/PriorityInheritanceMutex.hpp"
+#include "tcan_can/CanDevice.hpp"
+#include "tcan_can/LssMasterOptions.hpp"
+
+namespace tcan_can {
+
+//! LSS address of a slave, i.e. its identity object (0x1018)
+struct LssAddress {
+    uint32_t vendorId_;
+    uint32_t productCode_;
+    uint32_t revisionNumber_;
+    uint32_t serialNumber_;
+
+    bool operator==(const LssAddress& rhs) const {
+        return vendorId_ == rhs.vendorId_ && productCode_ == rhs.productCode_ && revisionNumber_ == rhs.revisionNumber_ &&
+               serialNumber_ == rhs.serialNumber_;
+    }
+};
+
+//! slave configured by LssMaster::configureUnconfiguredSlaves(..)
+struct LssSlave {
+    LssAddress address_;
+    uint8_t nodeId_;
+};
+
+/*!
+ * Layer setting services master (CiA 305). Discovers the slaves without node-ID by their identity with Fastscan, which needs 133 steps
+ * per slave independent of the number of slaves (69 if the vendor-ID and product code are known) of LssMasterOptions::fastscanTimeout_
+ * each, and assigns node-IDs and bit rates.
+ * So the node-IDs of the CanDeviceOptions do not have to be configured with vendor tools beforehand.
+ * The master is added to a CanBus like a device. The services block until the slaves answered or the timeout passed, so they need the
+ * bus threads and must not be called from a message callback or the thread driving a synchronous bus. They must be called from a single
+ * thread.
+ */
+class LssMaster : public CanDevice {
+ public:
+    static constexpr uint32_t TxId = 0x7E5;
+    static constexpr uint32_t RxId = 0x7E4;
+
+    //! bit timing table of CiA 305
+    enum class BitRate : uint8_t {
+        Kbps1000 = 0,
+        Kbps800 = 1,
+        Kbps500 = 2,
+        Kbps250 = 3,
+        Kbps125 = 4,
+        Kbps50 = 6,
+        Kbps20 = 7,
+        Kbps10 = 8,
+        Automatic = 9
+    };
+
+    //! returns the node-ID [1, 127] to assign to a slave
+    using NodeIdAssigner = std::function<uint8_t(const LssAddress&)>;
+
+    LssMaster(std::unique_ptr<LssMasterOptions>&& options);
+
+    ~LssMaster() override = default;
+
+    bool initDevice() override;
+
+    bool configureDevice(const CanMsg& msg) override;
+
+    /*!
+     * Switches all slaves to the waiting or configuration state. Not confirmed by the slaves.
+     * @param configuration true for the configuration state
+     */
+    bool switchStateGlobal(const bool configuration);
+
+    //! Switches the slave with the given address to the configuration state. @return false if no slave answered
+    bool switchStateSelective(const LssAddress& address);
+
+    //! Sets the node-ID of the slaves in configuration state. It is active after the slaves were switched to the waiting state.
+    bool configureNodeId(const uint8_t nodeId);
+
+    //! Sets the bit rate of the slaves in configuration state. It is active after activateBitTiming(..).
+    bool configureBitTiming(const BitRate bitRate);
+
+    /*!
+     * Makes the slaves in configuration state switch to the configured bit rate. Not confirmed by the slaves.
+     * @param switchDelay   time the slaves wait before and after switching [ms]. The master has to switch within this time.
+     */
+    bool activateBitTiming(const uint16_t switchDelay);
+
+    //! Stores the configured node-ID and bit rate of the slaves in configuration state in their non-volatile memory.
+    bool storeConfiguration();
+
+    /*!
+     * @param nodeId    node-ID of the slave in configuration state (output parameter), 0xFF if it has none
+     * @return false if no slave answered
+     */
+    bool inquireNodeId(uint8_t& nodeId);
+
+    //! @return true if a slave without node-ID answered
+    bool identifyUnconfiguredSlaves();
+
+    /*!
+     * Finds the slave without node-ID with the lowest address and switches it to the configuration state.
+     * @param address   address of the slave (output parameter)
+     * @return false if there is no slave without node-ID
+     */
+    bool fastscan(LssAddress& address);
+
+    /*!
+     * Discovers the slaves without node-ID one after the other with Fastscan, and assigns and stores their node-IDs. The slaves are
+     * switched back to the waiting state, where they apply the node-ID and boot up.
+     * @param assigner  node-ID of a slave, e.g. from a table of serial numbers, or counting up from a first node-ID
+     * @param slaves    configured slaves, in the order of their addresses (output parameter)
+     * @return false if a slave could not be configured or was lost during the scan, e.g. because fastscanTimeout_ is too short
+     */
+    bool configureUnconfiguredSlaves(const NodeIdAssigner& assigner, std::vector<LssSlave>& slaves);
+
+    /*!
+     * Configures, stores and activates the bit rate of all slaves in one go. The slaves stay in configuration state at the new bit rate,
+     * call switchStateGlobal(false) after the master switched.
+     * @param bitRate       new bit rate
+     * @param switchDelay   see activateBitTiming(..)
+     */
+    bool configureBitRateOfAllSlaves(const BitRate bitRate, const uint16_t switchDelay);
+
+    //! @return number of sent Fastscan requests, and those of them no slave answered
+    inline unsigned int getNumFastscanSteps() const { return numFastscanSteps_; }
+    inline unsigned int getNumUnansweredFastscanSteps() const { return numUnansweredFastscanSteps_; }
+
+ public: /// Internal functions
+    bool parseResponse(const CanMsg& msg);
+
+ protected:
+    /*!
+     * Sends a request and waits for the answer.
+     * @param request           request, the first byte is the command specifier
+     * @param responseCommand   command specifier of the answer, 0 if the service is not confirmed
+     * @param timeout           time to wait for the answer
+     * @param response          answer (output parameter, may be nullptr)
+     * @param waitForAllAnswers wait for the full timeout, also if a slave answered
+     * @return false if no answer was received
+     */
+    bool request(const CanMsg& request, const uint8_t responseCommand, const std::chrono::milliseconds& timeout, CanMsg* response = nullptr,
+                 const bool waitForAllAnswers = false);
+
+    //! Sends a configuration request and checks the error code of the answer
+    bool requestConfiguration(const CanMsg& request, const char* service);
+
+    //! @return true if a slave answered the Fastscan step
+    bool sendFastscan(const uint32_t idNumber, const uint8_t bitChecked, const uint8_t lssSub, const uint8_t lssNext);
+
+    inline const LssMasterOptions* getOptions() const { return static_cast<const LssMasterOptions*>(options_.get()); }
+
+ protected:
+    //! expected and received answer, protected by responseMutex_
+    tcan::PriorityInheritanceMutex responseMutex_;
+    std::condition_variable_any responseCond_;
+    uint8_t expectedCommand_;
+    bool isAnswered_;
+    uint8_t response_[CanMsg::Capacity];
+
+    std::atomic<unsigned int> numFastscanSteps_;
+    std::atomic<unsigned int> numUnansweredFastscanSteps_;
+};
+
+} /* namespace tcan_can */
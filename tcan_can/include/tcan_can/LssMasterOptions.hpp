@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "tcan_can/CanDeviceOptions.hpp"
+
+namespace tcan_can {
+
+class LssMasterOptions : public CanDeviceOptions {
+ public:
+    LssMasterOptions():
+        LssMasterOptions("LSS master")
+    {
+    }
+
+    explicit LssMasterOptions(const std::string& name):
+        CanDeviceOptions(0, name, 0),
+        timeout_(100),
+        fastscanTimeout_(10),
+        isVendorIdKnown_(false),
+        vendorId_(0),
+        isProductCodeKnown_(false),
+        productCode_(0),
+        storeConfiguration_(true)
+    {
+    }
+
+    ~LssMasterOptions() override = default;
+
+    //! time to wait for the answer of a confirmed service (e.g. configure node-ID) [ms]
+    unsigned int timeout_;
+
+    //! duration of a Fastscan step [ms]. Every step waits for the full time, so the discovery takes 133 times this per slave. It has to
+    // be longer than the answer time of the slaves.
+    unsigned int fastscanTimeout_;
+
+    //! Vendor-ID and product code of the unconfigured slaves, if known. Fastscan then only searches the revision and serial numbers,
+    // which halves the number of steps. Slaves of other vendors or products are not found.
+    bool isVendorIdKnown_;
+    uint32_t vendorId_;
+    bool isProductCodeKnown_;
+    uint32_t productCode_;
+
+    //! store the assigned node-IDs in the non-volatile memory of the slaves
+    bool storeConfiguration_;
+};
+
+} /* namespace tcan_can */
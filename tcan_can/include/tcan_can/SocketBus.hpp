@@ -1,5 +1,10 @@
 #pragma once
 
+#include <sys/socket.h> // for mmsghdr
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "tcan_can/CanBus.hpp"
 #include "tcan_can/SocketBusOptions.hpp"
 
@@ -7,18 +12,63 @@ namespace tcan_can {
 
 class SocketBus : public CanBus {
  public:
+    //! Counters of the receive thread to relate the reception latency to the CPU time spent spinning.
+    //! Only counted in ReceiveMode::BusyPoll and ReceiveMode::Hybrid.
+    struct ReceiveStatistics {
+        //! frames received by a blocking read
+        unsigned int numBlockingReceptions_;
+        //! frames received by a non-blocking read while spinning
+        unsigned int numSpinReceptions_;
+        //! non-blocking reads which returned without a frame
+        unsigned int numEmptyPolls_;
+    };
 
     SocketBus(const std::string& interface);
     SocketBus(std::unique_ptr<SocketBusOptions>&& options);
 
     ~SocketBus() override;
 
-    int getPollableFileDescriptor() const override { return socket_; }
+    int getPollableFileDescriptor() const override {
+        if(pollSocket_ >= 0) {
+            return pollSocket_;
+        }
+        return (ringSocket_ >= 0) ? ringSocket_ : socket_;
+    }
+
+    void getReceiveStatistics(ReceiveStatistics& statistics) const;
+
+    //! @return number of frames received by a receive group (see SocketBusOptions::receiveGroups_)
+    unsigned int getNumReceiveGroupFrames(const unsigned int group) const;
 
 protected:
+    //! buffers for batched reads, allocated once in the constructor
+    struct ReceiveBuffer {
+        void resize(const unsigned int batchSize);
+
+        std::vector<can_frame> frames_;
+        std::vector<iovec> iovecs_;
+        std::vector<mmsghdr> msgs_;
+    };
+
+    //! socket and receive thread of a receive group
+    struct ReceiveGroup {
+        ReceiveGroup(const SocketBusOptions::ReceiveGroup& options, const unsigned int batchSize);
+
+        const SocketBusOptions::ReceiveGroup& options_;
+        int socket_;
+        ReceiveBuffer buffer_;
+        std::thread thread_;
+        std::atomic<unsigned int> numFrames_;
+    };
+
     bool initializeInterface() override;
     bool readData() override;
-    bool writeData(std::unique_lock<std::mutex>* lock) override;
+    bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) override;
+
+    //! Only the main socket in ReceiveMode::Blocking without receive ring is served by the io_uring engine
+    bool initializeIoUringEndpoint(tcan::IoUringEngine::Endpoint& endpoint) override;
+    void handleIoUringData(uint8_t* data, const unsigned int length) override;
+    int encodeIoUringMessage(const CanMsg& msg, uint8_t* buffer, const unsigned int capacity) override;
 
     /*!
      * Is called on reception of a bus error message. Sets the flag
@@ -26,10 +76,93 @@ protected:
      */
     void handleBusErrorMessage(const can_frame& msg);
 
+    //! Routes a received frame to handleBusErrorMessage(..) or handleMessage(..)
+    inline void handleFrame(const can_frame& frame) {
+        if(frame.can_id > CAN_ERR_FLAG && frame.can_id < CAN_RTR_FLAG) {
+            handleBusErrorMessage( frame );
+        }else{
+            handleMessage( CanMsg(frame.can_id, frame.can_dlc, frame.data) );
+        }
+    }
+
+    /*!
+     * Creates the AF_PACKET socket with the TPACKET_V3 receive ring (see SocketBusOptions::useReceiveRing_)
+     * @param interfaceIndex    index of the CAN netdevice
+     */
+    bool initializeReceiveRing(const int interfaceIndex);
+
+    /*!
+     * Handles all frames of the next filled block of the receive ring in place and returns the block to the kernel.
+     * @param recvFlag  MSG_DONTWAIT to return immediately if no block is filled
+     * @return number of frames handled, <= 0 on error or if no block is filled (see errno)
+     */
+    int readReceiveRing(const int recvFlag);
+
+    /*!
+     * Reads up to batchSize_ frames from a socket.
+     * @param socket    socket to read from
+     * @param buffer    buffer the frames are read into
+     * @param recvFlag  flags of the read
+     * @return number of frames read, <= 0 on error (see errno)
+     */
+    static int receiveFrames(const int socket, ReceiveBuffer& buffer, const int recvFlag);
+
+    //! Reads and handles the frames of the main socket or the receive ring.
+    bool readMainSocket();
+
+    //! Opens and binds the sockets of the receive groups and excludes their frames from the main socket.
+    bool initializeReceiveGroups(const int interfaceIndex);
+
+    //! Creates the epoll descriptor returned by getPollableFileDescriptor() if there are receive groups (non-asynchronous modes only).
+    bool initializePollSocket();
+
+    /*!
+     * Reads and handles frames of a receive group.
+     * @param recvFlag  MSG_DONTWAIT for a non-blocking read
+     * @return true if frames were read
+     */
+    bool readReceiveGroup(ReceiveGroup& group, const int recvFlag);
+
+    void startAdditionalThreads() override;
+    void joinAdditionalThreads() override;
+
+    //! loop of the receive thread of a receive group
+    void receiveGroupWorker(ReceiveGroup* group);
+
+    /*!
+     * Writes up to batchSize_ messages from the front of the output queue with a single sendmmsg call and removes the written
+     * messages from the queue.
+     */
+    bool writeBatch(std::unique_lock<tcan::PriorityInheritanceMutex>* lock);
+
  protected:
     int socket_;
     int recvFlag_;
     int sendFlag_;
+
+    SocketBusOptions::ReceiveMode receiveMode_;
+    std::chrono::steady_clock::duration hybridSpinWindow_;
+    std::chrono::steady_clock::time_point lastReceptionTime_;
+
+    std::atomic<unsigned int> numBlockingReceptions_;
+    std::atomic<unsigned int> numSpinReceptions_;
+    std::atomic<unsigned int> numEmptyPolls_;
+
+    //! buffers for batched reads and writes, allocated once in the constructor
+    ReceiveBuffer rxBuffer_;
+    std::vector<can_frame> txFrames_;
+    std::vector<iovec> txIovecs_;
+    std::vector<mmsghdr> txMsgs_;
+
+    //! AF_PACKET socket and memory-mapped TPACKET_V3 ring. -1 / nullptr if not used.
+    int ringSocket_;
+    uint8_t* ring_;
+    std::size_t ringSize_;
+    unsigned int ringBlockIndex_;
+
+    //! receive groups in the order of SocketBusOptions::receiveGroups_, and epoll descriptor of all sockets (-1 if not used)
+    std::vector<std::unique_ptr<ReceiveGroup>> receiveGroups_;
+    int pollSocket_;
 };
 
 } /* namespace tcan_can */
@@ -9,6 +9,33 @@
 namespace tcan_can {
 
 struct SocketBusOptions : public CanBusOptions {
+    enum class ReceiveMode : uint8_t {
+        Blocking,   // the receive thread blocks in recv(..) until a frame arrives
+        BusyPoll,   // the receive thread spins on non-blocking reads. Occupies a full CPU, use with cpuReceiveThread_ on an isolated core.
+        Hybrid      // spins for hybridSpinWindow_ after the last received frame and blocks when the bus is idle
+    };
+
+    //! additional receive socket for a group of frames, see receiveGroups_
+    struct ReceiveGroup {
+        ReceiveGroup():
+            canFilters_(),
+            priority_(99),
+            cpu_(-1),
+            rcvBufLength_(0)
+        {
+        }
+
+        //! frames received by this group
+        std::vector<can_filter> canFilters_;
+
+        //! priority and CPU (-1 = not pinned) of the receive thread of this group (asynchronous mode only)
+        int priority_;
+        int cpu_;
+
+        //! length of the receive buffer of the socket [bytes], bounds the number of queued frames of this group. 0 to keep the default.
+        unsigned int rcvBufLength_;
+    };
+
     SocketBusOptions():
         SocketBusOptions(std::string())
     {
@@ -19,7 +46,16 @@ struct SocketBusOptions : public CanBusOptions {
         loopback_(false),
         sndBufLength_(0),
         canErrorMask_(CAN_ERR_MASK),
-        canFilters_()
+        canFilters_(),
+        receiveMode_(ReceiveMode::Blocking),
+        busyPollTime_(0),
+        hybridSpinWindow_(1000),
+        batchSize_(1),
+        useReceiveRing_(false),
+        ringBlockSize_(1 << 16),
+        ringNumBlocks_(16),
+        ringBlockTimeout_(1),
+        receiveGroups_()
     {
     }
 
@@ -42,6 +78,45 @@ struct SocketBusOptions : public CanBusOptions {
     //! vector of can filters to be applied
     // see https://www.kernel.org/doc/Documentation/networking/can.txt
     std::vector<can_filter> canFilters_;
+
+    //! how the receive thread waits for frames (asynchronous mode only)
+    ReceiveMode receiveMode_;
+
+    //! SO_BUSY_POLL time of the socket [us]. The kernel busy-polls the device queue for this duration in blocking reads.
+    // Only effective with drivers supporting busy polling. 0 to keep the default.
+    unsigned int busyPollTime_;
+
+    //! time after the last received frame during which the receive thread spins in ReceiveMode::Hybrid [us]
+    unsigned int hybridSpinWindow_;
+
+    //! maximum number of frames read or written per system call (recvmmsg / sendmmsg). 1 to use recv / send.
+    // Batched writes are only used if the bus has no transmit limits and no running transmit schedule.
+    unsigned int batchSize_;
+
+    //! receive frames from a memory-mapped TPACKET_V3 ring of an AF_PACKET socket instead of the CAN_RAW socket. Saves a copy and a
+    // system call per frame on high-rate buses. Requires CAP_NET_RAW. canFilters_ are not applied to the ring, and the CAN_RAW socket
+    // is only used for writing. The frames sent on the interface from this host are not received, unlike on a CAN_RAW socket this
+    // includes the frames of other local sockets.
+    bool useReceiveRing_;
+
+    //! size of a ring block [bytes], must be a multiple of the page size, and number of blocks
+    unsigned int ringBlockSize_;
+    unsigned int ringNumBlocks_;
+
+    //! time after which the kernel hands over a partially filled block [ms]. Bounds the reception latency at low frame rates.
+    unsigned int ringBlockTimeout_;
+
+    /*! Each group opens an additional CAN_RAW socket on the interface which only receives the frames matching the filters of the group.
+     * The groups have their own kernel receive queues, so a burst of frames of one group (e.g. diagnostics) neither delays nor overflows
+     * the queue of another (e.g. PDOs). In asynchronous mode, each group has its own receive thread. In synchronous and semi-synchronous
+     * mode, the groups are read before the main socket, in the order of this vector, and getPollableFileDescriptor() returns an epoll
+     * descriptor of all sockets.
+     * The main socket receives the error frames and all frames matching none of the groups. If canFilters_ is set, it has to exclude the
+     * frames of the groups, otherwise they are handled twice.
+     * Callbacks of different groups run concurrently in asynchronous mode, so a device whose frames are split over several groups has to
+     * protect its state. Not available with useReceiveRing_.
+     */
+    std::vector<ReceiveGroup> receiveGroups_;
 };
 
 } /* namespace tcan_can */
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm> // std::min, std::max
+#include <chrono>
+
+#include "tcan/Clock.hpp"
+
+namespace tcan_can {
+
+//! Transmit limits of a single CAN frame identifier
+struct TransmitLimit {
+    TransmitLimit():
+        TransmitLimit(0)
+    {
+    }
+
+    /*!
+     * @param inhibitTime   minimum time between two frames [us]. 0 to disable.
+     * @param rate          sustained frame rate of the token bucket [frames/s]. 0 to disable.
+     * @param burst         size of the token bucket, i.e. number of frames which may be sent back-to-back
+     */
+    TransmitLimit(const unsigned int inhibitTime, const double rate = 0.0, const unsigned int burst = 1):
+        inhibitTime_(inhibitTime),
+        rate_(rate),
+        burst_(burst)
+    {
+    }
+
+    //! minimum time between two consecutive frames with this identifier [us] (CANopen specifies inhibit times in multiples of 100us). 0 to disable.
+    unsigned int inhibitTime_;
+
+    //! sustained rate of the token bucket [frames/s]. 0 to disable.
+    double rate_;
+
+    //! maximum number of tokens in the bucket (frames which may be sent back-to-back). Is at least 1.
+    unsigned int burst_;
+};
+
+//! Enforces a TransmitLimit on the frames of a single identifier. Not thread safe.
+class TransmitLimiter {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    TransmitLimiter() = delete;
+
+    explicit TransmitLimiter(const TransmitLimit& limit):
+        limit_(limit),
+        tokens_(std::max(1u, limit.burst_)),
+        lastTransmit_(),
+        lastRefill_(tcan::Clock::now()),
+        isThrottled_(false),
+        numThrottlingEvents_(0)
+    {
+    }
+
+    /*!
+     * @param now   current time
+     * @return      earliest time at which the next frame may be sent. Frames may be sent if this is <= now.
+     */
+    inline Clock::time_point getReleaseTime(const Clock::time_point& now) const {
+        Clock::time_point releaseTime = lastTransmit_ + std::chrono::microseconds(limit_.inhibitTime_);
+
+        if(limit_.rate_ > 0.0) {
+            const double tokens = getTokens(now);
+            if(tokens < 1.0) {
+                releaseTime = std::max(releaseTime, now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((1.0 - tokens) / limit_.rate_)));
+            }
+        }
+
+        return releaseTime;
+    }
+
+    /*!
+     * Marks the identifier as throttled. Only the first call after a sent frame is counted as throttling event.
+     * @return true if this is a new throttling event
+     */
+    inline bool throttle() {
+        if(isThrottled_) {
+            return false;
+        }
+        isThrottled_ = true;
+        ++numThrottlingEvents_;
+        return true;
+    }
+
+    /*!
+     * Consumes a token and restarts the inhibit time. Shall be called after a frame has been sent.
+     * @param now   current time
+     */
+    inline void consume(const Clock::time_point& now) {
+        if(limit_.rate_ > 0.0) {
+            refill(now);
+            tokens_ = std::max(0.0, tokens_ - 1.0);
+        }
+        lastTransmit_ = now;
+        isThrottled_ = false;
+    }
+
+    inline const TransmitLimit& getLimit() const { return limit_; }
+
+    //! @return number of times the identifier has been throttled
+    inline unsigned int getNumThrottlingEvents() const { return numThrottlingEvents_; }
+
+ private:
+    //! @return tokens in the bucket at the given time
+    inline double getTokens(const Clock::time_point& now) const {
+        const double elapsed = std::chrono::duration<double>(now - lastRefill_).count();
+        return std::min(static_cast<double>(std::max(1u, limit_.burst_)), tokens_ + elapsed*limit_.rate_);
+    }
+
+    inline void refill(const Clock::time_point& now) {
+        tokens_ = getTokens(now);
+        lastRefill_ = now;
+    }
+
+ private:
+    TransmitLimit limit_;
+
+    double tokens_;
+    Clock::time_point lastTransmit_;
+    Clock::time_point lastRefill_;
+
+    bool isThrottled_;
+    unsigned int numThrottlingEvents_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+
+#include "tcan/RingBuffer.hpp"
+#include "tcan_can/CanMsg.hpp"
+
+namespace tcan_can {
+
+//! Timing statistics of a schedule slot. Lateness is the time between the slot time and the completed write operation [us].
+struct ScheduleSlotStatistics {
+    unsigned int numSent_ = 0;
+    double minLateness_ = 0.0;
+    double maxLateness_ = 0.0;
+    double meanLateness_ = 0.0;
+};
+
+//! Table of cyclic, time-triggered messages which are sent at fixed offsets from the start of a cycle. Not thread safe.
+class TransmitSchedule {
+ public:
+    using Clock = std::chrono::steady_clock;
+    using MsgQueue = tcan::RingBuffer<CanMsg>;
+
+    enum class Reference : uint8_t {
+        Cycle, // free-running cycle with fixed cycle time, started with start(..)
+        Sync   // every SYNC message starts a new cycle, see trigger(..)
+    };
+
+    TransmitSchedule() = delete;
+
+    /*!
+     * @param reference     reference of the slot offsets
+     * @param cycleTime     cycle time [us]. Required for reference Cycle. For reference Sync, slots with an offset larger than
+     *                      cycleTime are skipped (0 = no limit).
+     */
+    TransmitSchedule(const Reference reference, const unsigned int cycleTime);
+
+    /*!
+     * Adds a slot to the schedule. Allocates memory, but may be called while the schedule is running.
+     * @param offset    offset from the cycle start [us]
+     * @param msg       initial message of the slot
+     * @return          index of the slot
+     */
+    unsigned int addSlot(const unsigned int offset, const CanMsg& msg);
+
+    /*!
+     * Replaces the message (identifier and payload) of a slot. The new message is sent in the next occurrence of the slot.
+     * @return false if the index is invalid
+     */
+    bool setSlotMessage(const unsigned int index, const CanMsg& msg);
+
+    /*!
+     * Starts the schedule. For reference Cycle, the first cycle starts at cycleStart. For reference Sync, the
+     * schedule waits for the first call to trigger(..).
+     * @return false if reference is Cycle and the cycle time is 0
+     */
+    bool start(const Clock::time_point& cycleStart);
+
+    void stop();
+
+    /*!
+     * Starts a new cycle on a SYNC message. Slots of the previous cycle which have not been sent yet are skipped.
+     * Is ignored for reference Cycle.
+     * @param syncTime  time at which the SYNC was sent or received
+     */
+    void trigger(const Clock::time_point& syncTime);
+
+    /*!
+     * Inserts the messages of all due slots at the front of the queue (in order of their slot time). Slots which do not fit into the
+     * queue are skipped. The messages are tagged (see CanMsg::getTag()) to identify them in handleMessageWritten(..).
+     * @param now           current time
+     * @param queue         output queue
+     * @param maxQueueSize  maximum number of messages in the queue
+     * @param wakeupTime    set to the time of the next slot if it is earlier than the passed value
+     * @return  number of queued messages
+     */
+    unsigned int queueDueMessages(const Clock::time_point& now, MsgQueue& queue, const unsigned int maxQueueSize, Clock::time_point& wakeupTime);
+
+    /*!
+     * Skips all due slots without sending them (e.g. if the bus is passive).
+     */
+    void skipDueMessages(const Clock::time_point& now, Clock::time_point& wakeupTime);
+
+    /*!
+     * Updates the timing statistics. Shall be called after a message of the output queue has been written.
+     * @param tag       tag of the written message, messages which were not queued by the schedule are ignored
+     * @param now       time at which the write operation completed
+     */
+    void handleMessageWritten(const uint16_t tag, const Clock::time_point& now);
+
+    /*!
+     * @return false if the index is invalid
+     */
+    bool getSlotStatistics(const unsigned int index, ScheduleSlotStatistics& statistics) const;
+
+    //! @return number of slots which were not sent because they were more than one cycle late, replaced by the next SYNC or the queue was full
+    inline unsigned int getNumSkippedSlots() const { return numSkippedSlots_; }
+
+    inline unsigned int getNumSlots() const { return slots_.size(); }
+    inline bool isRunning() const { return isRunning_; }
+    inline Reference getReference() const { return reference_; }
+
+ private:
+    struct Slot {
+        Slot(const unsigned int offset, const CanMsg& msg);
+
+        std::chrono::microseconds offset_;
+        CanMsg msg_;
+
+        unsigned int numSent_;
+        Clock::duration minLateness_;
+        Clock::duration maxLateness_;
+        Clock::duration sumLateness_;
+    };
+
+    struct PendingSlot {
+        unsigned int index_;
+        Clock::time_point slotTime_;
+    };
+
+    static uint16_t getTag(const unsigned int index);
+
+    unsigned int processDueSlots(const Clock::time_point& now, MsgQueue* queue, const unsigned int maxQueueSize, Clock::time_point& wakeupTime);
+
+ private:
+    const Reference reference_;
+    const std::chrono::microseconds cycleTime_;
+
+    // slots in order of insertion (index is stable)
+    std::vector<Slot> slots_;
+    // slot indices in order of their offset
+    std::vector<unsigned int> order_;
+
+    bool isRunning_;
+    Clock::time_point cycleStart_;
+    // position in order_ of the next slot to be sent. order_.size() if all slots of the cycle have been processed.
+    unsigned int nextSlot_;
+
+    // queued slots waiting for the write operation, in order of queueing
+    tcan::RingBuffer<PendingSlot> pendingSlots_;
+
+    unsigned int numSkippedSlots_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "tcan/Clock.hpp"
+#include "tcan_can/CanMsg.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Aggregates received frames which are not handled by any callback of a bus, instead of logging every frame.
+ * record(..) is called on the receive path: it is lock-free, does not allocate and may be called from several receive threads.
+ * The counters are kept in a fixed-size table. Frames of identifiers which do not fit into the table are only counted in total.
+ * getEntries(..) is meant to be called periodically from a non real-time context and computes the rates since its previous call.
+ */
+class UnmappedTrafficProfiler {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    //! statistics of an unmapped identifier
+    struct Entry {
+        uint32_t cobId_;
+        //! frames received in total and since the previous call of getEntries(..)
+        uint64_t numFrames_;
+        uint64_t numNewFrames_;
+        //! frames per second since the previous call of getEntries(..)
+        double rate_;
+        //! last received payload
+        uint8_t length_;
+        uint8_t data_[8];
+    };
+
+    /*!
+     * @param capacity  maximum number of distinct identifiers, rounded up to a power of two
+     */
+    explicit UnmappedTrafficProfiler(const unsigned int capacity);
+
+    UnmappedTrafficProfiler(const UnmappedTrafficProfiler&) = delete;
+    UnmappedTrafficProfiler& operator=(const UnmappedTrafficProfiler&) = delete;
+
+    //! Counts an unmapped frame and stores its payload.
+    void record(const CanMsg& msg);
+
+    /*!
+     * @param now   current time
+     * @return      statistics of all identifiers received so far, sorted by identifier. Starts a new rate interval.
+     */
+    std::vector<Entry> getEntries(const Clock::time_point& now = tcan::Clock::now());
+
+    //! @return number of unmapped frames received in total
+    inline uint64_t getNumFrames() const { return numFrames_.load(std::memory_order_relaxed); }
+
+    //! @return number of frames whose identifier did not fit into the table
+    inline uint64_t getNumOverflowFrames() const { return numOverflowFrames_.load(std::memory_order_relaxed); }
+
+ protected:
+    struct Slot {
+        Slot():
+            cobId_(emptyCobId),
+            numFrames_(0),
+            data_(0),
+            length_(0),
+            numReportedFrames_(0)
+        {
+        }
+
+        std::atomic<uint32_t> cobId_;
+        std::atomic<uint64_t> numFrames_;
+        //! payload packed into a single word, such that it is never read torn
+        std::atomic<uint64_t> data_;
+        std::atomic<uint8_t> length_;
+
+        //! numFrames_ at the previous call of getEntries(..). Only accessed by getEntries(..).
+        uint64_t numReportedFrames_;
+    };
+
+    //! marks an unused slot. All flag bits set, which is never the identifier of a data frame.
+    static constexpr uint32_t emptyCobId = 0xFFFFFFFFu;
+
+ protected:
+    std::unique_ptr<Slot[]> slots_;
+    const unsigned int mask_;
+
+    std::atomic<uint64_t> numFrames_;
+    std::atomic<uint64_t> numOverflowFrames_;
+
+    Clock::time_point lastEntriesTime_;
+};
+
+} /* namespace tcan_can */
@@ -1,51 +1,180 @@
 #include "tcan_can/CanBus.hpp"
+#include "tcan/probes.hpp"
 #include "message_logger/message_logger.hpp"
 
+#include <iomanip>
+#include <sstream>
+
 namespace tcan_can {
 
 CanBus::CanBus(std::unique_ptr<CanBusOptions>&& options):
     tcan::Bus<CanMsg>( std::move(options) ),
     devices_(),
-    canFrameIdentifierToFunctionMap_(),
-    unmappedMessageCallbackFunction_(std::bind(&CanBus::defaultHandleUnmappedMessage, this, std::placeholders::_1))
+    dispatchTable_(DispatchTable{CanFrameIdentifierToFunctionMap(), std::bind(&CanBus::defaultHandleUnmappedMessage, this, std::placeholders::_1), {}}),
+    transmitLimiters_(),
+    releasedLimiter_(nullptr),
+    numThrottlingEvents_(0),
+    releasedCobId_(0),
+    releasedTag_(0),
+    budget_(static_cast<const CanBusOptions*>(options_.get())->bandwidthBudget_),
+    releasedBackgroundTime_(0),
+    schedule_(static_cast<const CanBusOptions*>(options_.get())->scheduleReference_, static_cast<const CanBusOptions*>(options_.get())->scheduleCycleTime_),
+    isScheduleTriggeredBySync_{false},
+    unmappedTraffic_(static_cast<const CanBusOptions*>(options_.get())->unmappedTrafficTableSize_),
+    unmappedReportMutex_(),
+    nextUnmappedReportTime_(tcan::Clock::now() + std::chrono::milliseconds(static_cast<const CanBusOptions*>(options_.get())->unmappedTrafficReportInterval_)),
+    deviceStateTable_(nullptr)
 {
+    for(const auto& limit : static_cast<const CanBusOptions*>(options_.get())->transmitLimits_) {
+        transmitLimiters_.emplace(limit.first, TransmitLimiter(limit.second));
+    }
+
+    // the report is built by the sanity check thread
+    if(!unmappedReportMutex_.isPriorityInheritanceEnabled()) {
+        MELO_WARN("Failed to enable priority inheritance on unmapped traffic report mutex of bus %s", options_->name_.c_str());
+    }
 }
 
 CanBus::~CanBus()
 {
-    for(auto device : devices_) {
+    for(auto device : *devices_.read()) {
         delete device;
     }
 }
 
+bool CanBus::addCallback(const CanFrameIdentifier& matcher, CanDevice* device, const CallbackPtr& callback) {
+    return dispatchTable_.update([&](DispatchTable& table) {
+        Handler handler{device, callback, nullptr, nullptr};
+        if(options_->profileCallbacks_) {
+            const std::chrono::microseconds slowThreshold(options_->slowCallbackThreshold_);
+            handler.profile_ = std::make_shared<tcan::CallbackProfile>(slowThreshold);
+            if(device != nullptr) {
+                auto& deviceProfile = table.deviceProfiles_[device];
+                if(!deviceProfile) {
+                    deviceProfile = std::make_shared<tcan::CallbackProfile>(slowThreshold);
+                }
+                handler.deviceProfile_ = deviceProfile;
+            }
+        }
+        return table.callbacks_.emplace(matcher, std::move(handler)).second;
+    });
+}
+
+bool CanBus::removeCanMessage(const CanFrameIdentifier matcher) {
+    return dispatchTable_.update([&matcher](DispatchTable& table) {
+        return table.callbacks_.erase(matcher) > 0;
+    });
+}
+
+bool CanBus::removeDevice(CanDevice* device) {
+    const bool found = devices_.update([device](DeviceContainer& devices) {
+        auto it = std::find(devices.begin(), devices.end(), device);
+        if(it == devices.end()) {
+            return false;
+        }
+        devices.erase(it);
+        return true;
+    });
+    if(!found) {
+        return false;
+    }
+
+    dispatchTable_.update([device](DispatchTable& table) {
+        for(auto it = table.callbacks_.begin(); it != table.callbacks_.end();) {
+            it = (it->second.device_ == device) ? table.callbacks_.erase(it) : std::next(it);
+        }
+        table.deviceProfiles_.erase(device);
+        return true;
+    });
+
+    device->setStateTableInternal(nullptr);
+
+    // callbacks of the device may still be executed with the previous tables
+    dispatchTable_.synchronize();
+    devices_.synchronize();
+    delete device;
+    return true;
+}
+
+void CanBus::setDeviceStateTable(tcan::DeviceStateTable* table) {
+    deviceStateTable_ = table;
+    for(auto device : *devices_.read()) {
+        device->setStateTableInternal(table);
+    }
+}
+
 void CanBus::handleMessage(const CanMsg& msg) {
+    tcan::TraceRecorder::Scope trace("dispatch", traceTrack_, msg.getCobId());
+    TCAN_PROBE2(received, options_->name_.c_str(), msg.getCobId());
 
     errorMsgFlag_ = false;
 
-    // Check if CAN message is handled.
-    auto it = std::find_if(canFrameIdentifierToFunctionMap_.cbegin(), canFrameIdentifierToFunctionMap_.cend(), [&msg](auto p){
+    if(msg.getCobId() == 0x80) {
+        tcan::TraceRecorder::instant("SYNC received", traceTrack_, 0x80);
+    }
+
+    if((isScheduleTriggeredBySync_ || budget_.isEnabled()) && msg.getCobId() == 0x80) {
+        // SYNC sent by another node starts a new schedule and budget cycle
+        std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+        const auto now = tcan::Clock::now();
+        if(isScheduleTriggeredBySync_) {
+            schedule_.trigger(now);
+        }
+        if(budget_.isEnabled()) {
+            budget_.startCycle(now);
+        }
+        notifyTransmitter();
+    }
+
+    // Check if CAN message is handled. The snapshot stays valid while callbacks are added or removed.
+    const auto table = dispatchTable_.read();
+    auto it = std::find_if(table->callbacks_.cbegin(), table->callbacks_.cend(), [&msg](const auto& p){
         return !((msg.getCobId() ^ p.first.identifier) & p.first.mask);
     });
 
-    if (it != canFrameIdentifierToFunctionMap_.end()) {
-        if(it->second.first) {
-            it->second.first->resetDeviceTimeoutCounter();
-            it->second.first->configureDeviceInternal(msg);
+    if (it != table->callbacks_.cend()) {
+        const Handler& handler = it->second;
+        if(handler.device_) {
+            handler.device_->resetDeviceTimeoutCounter();
+            handler.device_->configureDeviceInternal(msg);
         }
-        it->second.second(msg); // call function pointer
+        tcan::callProfiled(handler.callback_, handler.profile_.get(), handler.deviceProfile_.get(), msg); // call function pointer
+        TCAN_PROBE3(dispatched, options_->name_.c_str(), msg.getCobId(), 1);
     } else {
-        unmappedMessageCallbackFunction_(msg);
+        TCAN_PROBE2(unmapped, options_->name_.c_str(), msg.getCobId());
+        table->unmappedMessageCallback_(msg);
+        TCAN_PROBE3(dispatched, options_->name_.c_str(), msg.getCobId(), 0);
     }
 }
 
 bool CanBus::sanityCheck() {
+    tcan::TraceRecorder::Scope trace("sanity check", traceTrack_, 0);
     bool isMissingOrError = false;
     bool allMissing = true;
     bool allActive = true;
-    for(auto device : devices_) {
-        isMissingOrError |= !device->sanityCheck();
-        allMissing &= device->isMissing();
-        allActive &= device->isActive();
+    {
+        const auto devices = devices_.read();
+        for(auto device : *devices) {
+            isMissingOrError |= !device->sanityCheck();
+            allMissing &= device->isMissing();
+            allActive &= device->isActive();
+        }
+    }
+
+    // free tables replaced by devices or callbacks added at runtime
+    devices_.reclaim();
+    dispatchTable_.reclaim();
+
+    checkSlowCallbacks();
+
+    // opt-in, the report allocates (see CanBusOptions::unmappedTrafficReportInterval_)
+    const unsigned int reportInterval = static_cast<const CanBusOptions*>(options_.get())->unmappedTrafficReportInterval_;
+    if(reportInterval > 0 && tcan::Clock::now() >= nextUnmappedReportTime_) {
+        nextUnmappedReportTime_ = tcan::Clock::now() + std::chrono::milliseconds(reportInterval);
+        const std::string report = getUnmappedTrafficReport();
+        if(!report.empty()) {
+            MELO_INFO("%s", report.c_str());
+        }
     }
 
     if(!isPassive() && allMissing && static_cast<const CanBusOptions*>(options_.get())->passivateIfNoDevices_) {
@@ -61,17 +190,368 @@ bool CanBus::sanityCheck() {
 }
 
 void CanBus::resetAllDevices() {
-    for(auto device : devices_) {
+    for(auto device : *devices_.read()) {
         device->resetDevice();
     }
 }
 
-bool CanBus::defaultHandleUnmappedMessage(const CanMsg& msg) {
-    auto value = msg.getData();
-    MELO_INFO("Received CAN message on bus %s that is not handled: COB_ID: 0x%02X, code: 0x%02X%02X, message: 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X",
-              options_->name_.c_str(), msg.getCobId(), value[1], value[0], value[0], value[1], value[2], value[3], value[4], value[5], value[6], value[7]);
+void CanBus::setTransmitLimit(const uint32_t canFrameId, const TransmitLimit& limit) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    setTransmitLimitWithoutLock(canFrameId, limit);
+}
+
+void CanBus::removeTransmitLimit(const uint32_t canFrameId) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    removeTransmitLimitWithoutLock(canFrameId);
+}
+
+bool CanBus::getTransmitLimit(const uint32_t canFrameId, TransmitLimit& limit) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    return getTransmitLimitWithoutLock(canFrameId, limit);
+}
+
+void CanBus::setTransmitLimitWithoutLock(const uint32_t canFrameId, const TransmitLimit& limit) {
+    releasedLimiter_ = nullptr;
+    transmitLimiters_.erase(canFrameId);
+    transmitLimiters_.emplace(canFrameId, TransmitLimiter(limit));
+    notifyTransmitter(); // the transmit thread may be waiting for a message with the old limit
+}
+
+void CanBus::removeTransmitLimitWithoutLock(const uint32_t canFrameId) {
+    releasedLimiter_ = nullptr;
+    transmitLimiters_.erase(canFrameId);
+    notifyTransmitter();
+}
+
+bool CanBus::getTransmitLimitWithoutLock(const uint32_t canFrameId, TransmitLimit& limit) const {
+    auto it = transmitLimiters_.find(canFrameId);
+    if(it == transmitLimiters_.end()) {
+        return false;
+    }
+    limit = it->second.getLimit();
+    return true;
+}
+
+void CanBus::setTransmitCallback(const uint32_t canFrameId, const std::function<void()>& callback) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    if(callback) {
+        transmitCallbacks_[canFrameId] = callback;
+    }else{
+        transmitCallbacks_.erase(canFrameId);
+    }
+}
+
+unsigned int CanBus::getNumThrottlingEvents(const uint32_t canFrameId) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    auto it = transmitLimiters_.find(canFrameId);
+    return (it == transmitLimiters_.end()) ? 0 : it->second.getNumThrottlingEvents();
+}
+
+unsigned int CanBus::getNumBudgetDeferredCycles() {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    return budget_.getNumDeferredCycles();
+}
+
+bool CanBus::releaseFrontMessageWithoutLock(std::chrono::steady_clock::time_point& retryTime) {
+    releasedLimiter_ = nullptr;
+    releasedBackgroundTime_ = std::chrono::nanoseconds(0);
+    if(transmitLimiters_.empty() && !budget_.isEnabled()) {
+        releasedCobId_ = outgoingMsgs_.front().getCobId();
+        releasedTag_ = outgoingMsgs_.front().getTag();
+        return true;
+    }
 
+    const auto now = tcan::Clock::now();
+    const std::size_t index = findReleasableMessageWithoutLock(now, retryTime);
+
+    // account the messages held back in front of the released one
+    for(std::size_t i=0; i<index; ++i) {
+        const CanMsg& msg = outgoingMsgs_[i];
+        auto limiter = transmitLimiters_.find(msg.getCobId());
+        if(limiter != transmitLimiters_.end() && limiter->second.getReleaseTime(now) > now) {
+            if(limiter->second.throttle()) {
+                ++numThrottlingEvents_;
+            }
+        }else if(budget_.isEnabled() && budget_.isBackground(msg.getCobId())) {
+            budget_.getReleaseTime(budget_.getFrameTime(msg.getCobId(), msg.getLength()), now);
+        }
+    }
+    if(index == outgoingMsgs_.size()) {
+        return false;
+    }
+
+    auto it = outgoingMsgs_.begin() + index;
+    auto limiter = transmitLimiters_.find(it->getCobId());
+    releasedLimiter_ = (limiter != transmitLimiters_.end()) ? &limiter->second : nullptr;
+    if(budget_.isEnabled() && budget_.isBackground(it->getCobId())) {
+        releasedBackgroundTime_ = budget_.getFrameTime(it->getCobId(), it->getLength());
+    }
+
+    // move the message to the front of the queue. Messages with the same identifier are never overtaken, because
+    // they are held back as well.
+    if(index != 0) {
+        CanMsg msg = std::move(*it);
+        outgoingMsgs_.erase(it);
+        outgoingMsgs_.push_front(std::move(msg));
+    }
+    releasedCobId_ = outgoingMsgs_.front().getCobId();
+    releasedTag_ = outgoingMsgs_.front().getTag();
     return true;
 }
 
+bool CanBus::peekReleasableMessageWithoutLock(std::chrono::steady_clock::time_point& retryTime) const {
+    if(transmitLimiters_.empty() && !budget_.isEnabled()) {
+        return true;
+    }
+    return findReleasableMessageWithoutLock(tcan::Clock::now(), retryTime) < outgoingMsgs_.size();
+}
+
+std::size_t CanBus::findReleasableMessageWithoutLock(const std::chrono::steady_clock::time_point& now,
+                                                     std::chrono::steady_clock::time_point& retryTime) const {
+    bool isHoldingBack = false;
+    for(std::size_t i=0; i<outgoingMsgs_.size(); ++i) {
+        const CanMsg& msg = outgoingMsgs_[i];
+        auto releaseTime = now;
+        auto limiter = transmitLimiters_.find(msg.getCobId());
+        if(limiter != transmitLimiters_.end()) {
+            releaseTime = limiter->second.getReleaseTime(now);
+        }
+
+        // background frames exceeding the budget of the current cycle are deferred. Frames with the same identifier have the same
+        // length in practice (e.g. SDOs), so they are not reordered.
+        if(releaseTime <= now && budget_.isEnabled() && budget_.isBackground(msg.getCobId())) {
+            releaseTime = budget_.peekReleaseTime(budget_.getFrameTime(msg.getCobId(), msg.getLength()), now);
+        }
+
+        if(releaseTime <= now) {
+            return i;
+        }
+        retryTime = isHoldingBack ? std::min(retryTime, releaseTime) : releaseTime;
+        isHoldingBack = true;
+    }
+    return outgoingMsgs_.size();
+}
+
+void CanBus::removeWrittenMessageWithoutLock(const CanMsg& msg) {
+    const auto isWritten = [&msg](const CanMsg& queued) {
+        return queued.getCobId() == msg.getCobId() && queued.getLength() == msg.getLength() &&
+               std::equal(queued.getData(), queued.getData() + queued.getLength(), msg.getData());
+    };
+
+    if(!outgoingMsgs_.empty() && isWritten(outgoingMsgs_.front())) {
+        outgoingMsgs_.pop_front();
+        return;
+    }
+    auto it = std::find_if(outgoingMsgs_.begin(), outgoingMsgs_.end(), isWritten);
+    if(it != outgoingMsgs_.end()) {
+        outgoingMsgs_.erase(it);
+    }
+}
+
+void CanBus::handleFrontMessageWritten() {
+    if(releasedLimiter_ == nullptr && transmitCallbacks_.empty() && !schedule_.isRunning() && !budget_.isEnabled()) {
+        return;
+    }
+
+    const auto now = tcan::Clock::now();
+    if(releasedLimiter_ != nullptr) {
+        releasedLimiter_->consume(now);
+        releasedLimiter_ = nullptr;
+    }
+
+    if(budget_.isEnabled()) {
+        if(releasedBackgroundTime_.count() > 0) {
+            budget_.consume(releasedBackgroundTime_, now);
+            releasedBackgroundTime_ = std::chrono::nanoseconds(0);
+        }else if(releasedCobId_ == 0x80) {
+            // a SYNC sent on this bus starts a new budget cycle
+            budget_.startCycle(now);
+        }
+    }
+
+    if(schedule_.isRunning()) {
+        schedule_.handleMessageWritten(releasedTag_, now);
+        if(releasedCobId_ == 0x80) {
+            // a SYNC sent on this bus starts a new schedule cycle
+            schedule_.trigger(now);
+        }
+    }
+
+    // called last, the callback may change the transmit limits
+    if(!transmitCallbacks_.empty()) {
+        auto callback = transmitCallbacks_.find(releasedCobId_);
+        if(callback != transmitCallbacks_.end()) {
+            callback->second();
+        }
+    }
+}
+
+unsigned int CanBus::addScheduleSlot(const unsigned int offset, const CanMsg& msg) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    const unsigned int index = schedule_.addSlot(offset, msg);
+    notifyTransmitter();
+    return index;
+}
+
+bool CanBus::setScheduleSlotMessage(const unsigned int index, const CanMsg& msg) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    return schedule_.setSlotMessage(index, msg);
+}
+
+bool CanBus::startSchedule() {
+    if(!isAsynchronous()) {
+        MELO_WARN("Transmit schedule of bus %s requires asynchronous mode.", options_->name_.c_str());
+        return false;
+    }
+
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    if(!schedule_.start(tcan::Clock::now())) {
+        MELO_WARN("Failed to start transmit schedule of bus %s: cycle time is 0.", options_->name_.c_str());
+        return false;
+    }
+    isScheduleTriggeredBySync_ = (schedule_.getReference() == TransmitSchedule::Reference::Sync);
+    notifyTransmitter();
+    return true;
+}
+
+void CanBus::stopSchedule() {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    isScheduleTriggeredBySync_ = false;
+    schedule_.stop();
+}
+
+bool CanBus::getScheduleSlotStatistics(const unsigned int index, ScheduleSlotStatistics& statistics) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    return schedule_.getSlotStatistics(index, statistics);
+}
+
+unsigned int CanBus::getNumSkippedScheduleSlots() {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(outgoingMsgsMutex_);
+    return schedule_.getNumSkippedSlots();
+}
+
+void CanBus::queueScheduledMessagesWithoutLock(std::chrono::steady_clock::time_point& wakeupTime) {
+    if(!schedule_.isRunning()) {
+        return;
+    }
+
+    if(isPassive_) {
+        schedule_.skipDueMessages(tcan::Clock::now(), wakeupTime);
+    }else{
+        const unsigned int numSkippedSlots = schedule_.getNumSkippedSlots();
+        schedule_.queueDueMessages(tcan::Clock::now(), outgoingMsgs_, options_->maxQueueSize_, wakeupTime);
+        if(schedule_.getNumSkippedSlots() != numSkippedSlots && outgoingMsgs_.size() >= options_->maxQueueSize_) {
+            MELO_WARN_THROTTLE(options_->errorThrottleTime_, "Exceeding max queue size on bus %s! Skipping schedule slot!", options_->name_.c_str());
+        }
+    }
+}
+
+bool CanBus::defaultHandleUnmappedMessage(const CanMsg& msg) {
+    unmappedTraffic_.record(msg);
+    return true;
+}
+
+std::string CanBus::getUnmappedTrafficReport() {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(unmappedReportMutex_);
+    const auto entries = unmappedTraffic_.getEntries();
+
+    std::stringstream report;
+    unsigned int numIdentifiers = 0;
+    report << std::hex << std::uppercase << std::setfill('0');
+    for(const auto& entry : entries) {
+        if(entry.numNewFrames_ == 0) {
+            continue;
+        }
+        ++numIdentifiers;
+        report << "\n  COB_ID 0x" << std::setw(3) << entry.cobId_ << std::dec << ": " << entry.numNewFrames_ << " frames ("
+               << std::fixed << std::setprecision(1) << entry.rate_ << "/s, " << entry.numFrames_ << " in total), last payload:" << std::hex;
+        for(unsigned int i=0; i<entry.length_ && i<8; ++i) {
+            report << " 0x" << std::setw(2) << static_cast<int>(entry.data_[i]);
+        }
+    }
+    if(numIdentifiers == 0) {
+        return std::string();
+    }
+
+    const uint64_t numOverflowFrames = unmappedTraffic_.getNumOverflowFrames();
+    if(numOverflowFrames > 0) {
+        report << "\n  " << std::dec << numOverflowFrames << " frames of further identifiers in total (increase unmappedTrafficTableSize_)";
+    }
+
+    report << "\n  Receive filters {id, mask} dropping the unhandled frames in the kernel:" << std::hex;
+    for(const auto& identifier : getHandledFrameIdentifiers()) {
+        report << " {0x" << (identifier.identifier & identifier.mask) << ", 0x" << identifier.mask << "}";
+    }
+
+    return "Unhandled CAN frames on bus " + options_->name_ + ":" + report.str();
+}
+
+void CanBus::checkSlowCallbacks() {
+    if(!options_->profileCallbacks_ || options_->slowCallbackThreshold_ == 0) {
+        return;
+    }
+
+    const auto table = dispatchTable_.read();
+    for(const auto& callback : table->callbacks_) {
+        const unsigned int numNewSlowCalls = callback.second.profile_->takeNumNewSlowCalls();
+        if(numNewSlowCalls > 0) {
+            MELO_WARN("Callback of COB_ID 0x%X (mask 0x%X, device %s) on bus %s exceeded %u us %u times (longest call %.1f us).",
+                      callback.first.identifier, callback.first.mask, (callback.second.device_ != nullptr) ? callback.second.device_->getName().c_str() : "-",
+                      options_->name_.c_str(), options_->slowCallbackThreshold_, numNewSlowCalls, callback.second.profile_->getMaxSlowCallDuration());
+        }
+    }
+}
+
+std::string CanBus::getCallbackProfileReport() const {
+    if(!options_->profileCallbacks_) {
+        return std::string();
+    }
+
+    // sort the callbacks and devices by their longest execution time
+    std::vector<std::pair<tcan::ExecutionTimeHistogram, std::string>> profiles;
+    const auto table = dispatchTable_.read();
+    for(const auto& callback : table->callbacks_) {
+        std::stringstream name;
+        name << "COB_ID 0x" << std::hex << std::uppercase << callback.first.identifier << "/0x" << callback.first.mask;
+        if(callback.second.device_ != nullptr) {
+            name << " (" << callback.second.device_->getName() << ")";
+        }
+        profiles.emplace_back(callback.second.profile_->getHistogram(), name.str());
+    }
+    for(const auto& device : table->deviceProfiles_) {
+        profiles.emplace_back(device.second->getHistogram(), "device " + device.first->getName());
+    }
+    std::sort(profiles.begin(), profiles.end(), [](const auto& a, const auto& b) { return a.first.getMax() > b.first.getMax(); });
+
+    std::string report = "Callback execution times on bus " + options_->name_ + ":";
+    for(const auto& profile : profiles) {
+        report += "\n  " + profile.second + ": " + profile.first.getSummary();
+    }
+    return report;
+}
+
+std::shared_ptr<tcan::CallbackProfile> CanBus::getCallbackProfile(const CanFrameIdentifier& matcher) const {
+    const auto table = dispatchTable_.read();
+    auto it = table->callbacks_.find(matcher);
+    return (it != table->callbacks_.end()) ? it->second.profile_ : nullptr;
+}
+
+std::shared_ptr<tcan::CallbackProfile> CanBus::getDeviceCallbackProfile(CanDevice* device) const {
+    const auto table = dispatchTable_.read();
+    auto it = table->deviceProfiles_.find(device);
+    return (it != table->deviceProfiles_.end()) ? it->second : nullptr;
+}
+
+std::vector<CanBus::CanFrameIdentifier> CanBus::getHandledFrameIdentifiers() const {
+    std::vector<CanFrameIdentifier> identifiers;
+    const auto table = dispatchTable_.read();
+    for(const auto& callback : table->callbacks_) {
+        identifiers.push_back(callback.first);
+    }
+    std::sort(identifiers.begin(), identifiers.end(), [](const CanFrameIdentifier& a, const CanFrameIdentifier& b) {
+        return (a.identifier & a.mask) < (b.identifier & b.mask);
+    });
+    return identifiers;
+}
+
 } /* namespace tcan_can */
@@ -6,7 +6,7 @@ namespace tcan_can {
 
 void CanBusManager::sendSyncOnAllBuses(const bool waitForEmptyQueues) {
     const unsigned int bussize = buses_.size();
-    std::vector<std::unique_lock<std::mutex>> locks(bussize);
+    std::vector<std::unique_lock<tcan::PriorityInheritanceMutex>> locks(bussize);
 
     if(waitForEmptyQueues) {
         for(unsigned int i=0; i<bussize; i++) {
@@ -0,0 +1,182 @@
+#include "tcan_can/ConfigSequence.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan_can {
+
+constexpr int ConfigSequence::anyHeartbeatState;
+constexpr int ConfigSequence::heartbeatBootUp;
+constexpr int ConfigSequence::heartbeatStopped;
+constexpr int ConfigSequence::heartbeatOperational;
+constexpr int ConfigSequence::heartbeatPreOperational;
+
+ConfigSequence::ConfigSequence():
+    steps_(),
+    status_(Status::Idle),
+    sendSdo_(),
+    doneCallback_(),
+    waiting_(false),
+    currentStep_(StepType::Call),
+    deadline_(),
+    insertPosition_(-1)
+{
+}
+
+ConfigSequence& ConfigSequence::sdoWrite(const SdoMsg::Command command, const uint16_t index, const uint8_t subIndex, const uint32_t data) {
+    Step step(StepType::SdoWrite);
+    // the COB id is set by the send function of the device
+    step.sdo_ = SdoMsg(0, command, index, subIndex, data);
+    addStep(std::move(step));
+    return *this;
+}
+
+ConfigSequence& ConfigSequence::sdoRead(const uint16_t index, const uint8_t subIndex, const ReadCallback& callback) {
+    Step step(StepType::SdoRead);
+    step.sdo_ = SdoMsg(0, SdoMsg::Command::READ, index, subIndex, 0);
+    step.readCallback_ = callback;
+    addStep(std::move(step));
+    return *this;
+}
+
+ConfigSequence& ConfigSequence::waitHeartbeat(const unsigned int timeout, const int state) {
+    Step step(StepType::WaitHeartbeat);
+    step.timeout_ = timeout;
+    step.heartbeatState_ = state;
+    addStep(std::move(step));
+    return *this;
+}
+
+ConfigSequence& ConfigSequence::call(const StepCallback& callback) {
+    Step step(StepType::Call);
+    step.callback_ = callback;
+    addStep(std::move(step));
+    return *this;
+}
+
+ConfigSequence& ConfigSequence::onDone(const DoneCallback& callback) {
+    doneCallback_ = callback;
+    return *this;
+}
+
+void ConfigSequence::start(const SendSdoFunction& sendSdo, const Clock::time_point& now) {
+    sendSdo_ = sendSdo;
+    status_ = Status::Running;
+    waiting_ = false;
+    advance(now);
+}
+
+void ConfigSequence::handleSdoAnswer(const SdoMsg& answer, const bool isError, const Clock::time_point& now) {
+    if(!isWaitingForSdo(answer)) {
+        return;
+    }
+
+    waiting_ = false;
+    if(isError) {
+        finish(false);
+        return;
+    }
+
+    if(currentStep_.type_ == StepType::SdoRead && currentStep_.readCallback_) {
+        insertPosition_ = 0;
+        const bool success = currentStep_.readCallback_(answer, *this);
+        insertPosition_ = -1;
+        if(!success) {
+            finish(false);
+            return;
+        }
+    }
+
+    advance(now);
+}
+
+void ConfigSequence::handleSdoTimeout(const SdoMsg& request) {
+    if(isWaitingForSdo(request)) {
+        waiting_ = false;
+        finish(false);
+    }
+}
+
+void ConfigSequence::handleHeartbeat(const uint8_t state, const Clock::time_point& now) {
+    if(isRunning() && waiting_ && currentStep_.type_ == StepType::WaitHeartbeat &&
+       (currentStep_.heartbeatState_ == anyHeartbeatState || currentStep_.heartbeatState_ == state)) {
+        waiting_ = false;
+        advance(now);
+    }
+}
+
+void ConfigSequence::checkTimeout(const Clock::time_point& now) {
+    if(isRunning() && waiting_ && currentStep_.type_ == StepType::WaitHeartbeat && now > deadline_) {
+        MELO_WARN("Configuration sequence timed out waiting for heartbeat.");
+        waiting_ = false;
+        finish(false);
+    }
+}
+
+void ConfigSequence::abort() {
+    if(isRunning()) {
+        waiting_ = false;
+        finish(false);
+    }
+}
+
+void ConfigSequence::addStep(Step&& step) {
+    if(insertPosition_ < 0) {
+        steps_.push_back(std::move(step));
+    }else{
+        steps_.insert(steps_.begin() + insertPosition_, std::move(step));
+        ++insertPosition_;
+    }
+}
+
+void ConfigSequence::advance(const Clock::time_point& now) {
+    while(isRunning() && !waiting_) {
+        if(steps_.empty()) {
+            finish(true);
+            return;
+        }
+
+        currentStep_ = std::move(steps_.front());
+        steps_.pop_front();
+
+        switch(currentStep_.type_) {
+            case StepType::SdoWrite:
+            case StepType::SdoRead:
+                waiting_ = true;
+                sendSdo_(currentStep_.sdo_);
+                break;
+
+            case StepType::WaitHeartbeat:
+                waiting_ = true;
+                deadline_ = now + std::chrono::milliseconds(currentStep_.timeout_);
+                break;
+
+            case StepType::Call:
+            {
+                insertPosition_ = 0;
+                const bool success = !currentStep_.callback_ || currentStep_.callback_(*this);
+                insertPosition_ = -1;
+                if(!success) {
+                    finish(false);
+                }
+                break;
+            }
+        }
+    }
+}
+
+void ConfigSequence::finish(const bool success) {
+    status_ = success ? Status::Done : Status::Failed;
+    if(!success) {
+        steps_.clear();
+    }
+    if(doneCallback_) {
+        doneCallback_(success);
+    }
+}
+
+bool ConfigSequence::isWaitingForSdo(const SdoMsg& msg) const {
+    return isRunning() && waiting_ && (currentStep_.type_ == StepType::SdoWrite || currentStep_.type_ == StepType::SdoRead) &&
+           currentStep_.sdo_.getIndex() == msg.getIndex() && currentStep_.sdo_.getSubIndex() == msg.getSubIndex();
+}
+
+} /* namespace tcan_can */
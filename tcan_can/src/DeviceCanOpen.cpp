@@ -1,5 +1,7 @@
 #include "tcan_can/DeviceCanOpen.hpp"
 #include "tcan/Bus.hpp"
+#include "tcan/Clock.hpp"
+#include "tcan/probes.hpp"
 
 #include "message_logger/message_logger.hpp"
 
@@ -16,19 +18,30 @@ DeviceCanOpen::DeviceCanOpen(std::unique_ptr<DeviceCanOpenOptions>&& options):
     sdoTimeoutCounter_(0),
     sdoSentCounter_(0),
     sdoMsgsMutex_(),
-    sdoMsgs_()
+    sdoMsgs_(),
+    configSequenceMutex_(),
+    configSequence_()
 {
+    // the SDO queue, answers and configuration sequence are accessed by the bus threads and the application
+    if(!sdoMsgsMutex_.isPriorityInheritanceEnabled() || !sdoAnswerMapMutex_.isPriorityInheritanceEnabled() ||
+       !configSequenceMutex_.isPriorityInheritanceEnabled()) {
+        MELO_WARN("Failed to enable priority inheritance on SDO mutexes of device %s", getName().c_str());
+    }
 }
 
 bool DeviceCanOpen::sanityCheck() {
     if(!isMissing()) {
         if(isTimedOut()) {
-            state_ = Missing;
+            setState(Missing);
             MELO_WARN("Device %s timed out!", getName().c_str());
 
             clearSdoQueue();
+            abortConfigSequence();
         }else{
             checkSdoTimeout();
+
+            std::lock_guard<tcan::PriorityInheritanceMutex> guard(configSequenceMutex_);
+            configSequence_.checkTimeout(tcan::Clock::now());
         }
     }
 
@@ -41,7 +54,7 @@ void DeviceCanOpen::sendPdo(const CanMsg& pdoMsg) {
 
 void DeviceCanOpen::sendSdo(const SdoMsg& sdoMsg) {
 
-    std::lock_guard<std::mutex> guard(sdoMsgsMutex_);
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(sdoMsgsMutex_);
     sdoMsgs_.push(sdoMsg);
 
     if(sdoMsgs_.size() == 1) {
@@ -52,8 +65,10 @@ void DeviceCanOpen::sendSdo(const SdoMsg& sdoMsg) {
         bus_->sendMessage(sdoMsgs_.front());
 
         if(sdoMsg.getRequiresAnswer()) {
+            // NMT commands are queued as SdoMsg too, but have no index
+            TCAN_PROBE4(sdo_sent, options_->name_.c_str(), getNodeId(), sdoMsg.getIndex(), sdoMsg.getSubIndex());
             // if an answer to a previously sent similar sdo has been received but not fetched, erase it to prevent storing outdated data
-            std::lock_guard<std::mutex> guard(sdoAnswerMapMutex_);
+            std::lock_guard<tcan::PriorityInheritanceMutex> guard(sdoAnswerMapMutex_);
             sdoAnswerMap_.erase(getSdoAnswerId(sdoMsg.getIndex(), sdoMsg.getSubIndex()));
         }else{
             sdoMsgs_.pop();
@@ -66,7 +81,7 @@ void DeviceCanOpen::handleTimedoutSdo(const SdoMsg& msg) {
     if(state_ == Active) {
         // only set state to 'error' if state is 'active', to prevent overriding a 'Missing' state
         setNmtStopRemoteDevice();
-        state_ = Error;
+        setState(Error);
     }
 }
 
@@ -74,11 +89,35 @@ void DeviceCanOpen::handleSdoError(const SdoMsg& request, const SdoMsg& answer)
     const int32_t error = answer.readint32(4);
     MELO_WARN("Received SDO error from device %s: %s. COB=%x / index=%x / subindex=%x / error=%x / sent data=%x", options_->name_.c_str(), SdoMsg::getErrorName(error).c_str(), answer.getCobId(), answer.getIndex(), answer.getSubIndex(), error, request.readint32(4));
     setNmtStopRemoteDevice();
-    state_ = Error;
+    setState(Error);
+}
+
+bool DeviceCanOpen::startConfigSequence(ConfigSequence&& sequence) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(configSequenceMutex_);
+    if(configSequence_.isRunning()) {
+        MELO_WARN("Device %s: cannot start configuration sequence while another one is running.", getName().c_str());
+        return false;
+    }
+
+    configSequence_ = std::move(sequence);
+    configSequence_.start([this](const SdoMsg& sdo) {
+            sendSdo(SdoMsg(getNodeId(), static_cast<SdoMsg::Command>(sdo.getCommandByte()), sdo.getIndex(), sdo.getSubIndex(), sdo.readuint32(4)));
+        }, tcan::Clock::now());
+    return true;
+}
+
+void DeviceCanOpen::abortConfigSequence() {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(configSequenceMutex_);
+    configSequence_.abort();
+}
+
+ConfigSequence::Status DeviceCanOpen::getConfigSequenceStatus() const {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(configSequenceMutex_);
+    return configSequence_.getStatus();
 }
 
 bool DeviceCanOpen::getSdoAnswer(SdoMsg& sdoAnswer) {
-    std::lock_guard<std::mutex> guard(sdoAnswerMapMutex_);
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(sdoAnswerMapMutex_);
     auto it = sdoAnswerMap_.find(getSdoAnswerId(sdoAnswer.getIndex(), sdoAnswer.getSubIndex()));
     if (it == sdoAnswerMap_.end()) {
         return false;
@@ -95,6 +134,7 @@ void DeviceCanOpen::setNmtEnterPreOperational() {
     //   => assume that the state switch will be successful
     if(static_cast<const DeviceCanOpenOptions*>(options_.get())->producerHeartBeatTime_ == 0) {
         nmtState_ = NMTStates::preOperational;
+        updateStateTable();
     }
 }
 
@@ -105,6 +145,7 @@ void DeviceCanOpen::setNmtStartRemoteDevice() {
     //   => assume that the state switch will be successful
     if(static_cast<const DeviceCanOpenOptions*>(options_.get())->producerHeartBeatTime_ == 0) {
         nmtState_ = NMTStates::operational;
+        updateStateTable();
     }
 }
 
@@ -115,6 +156,7 @@ void DeviceCanOpen::setNmtStopRemoteDevice() {
     //   => assume that the state switch will be successful
     if(static_cast<const DeviceCanOpenOptions*>(options_.get())->producerHeartBeatTime_ == 0) {
         nmtState_ = NMTStates::stopped;
+        updateStateTable();
     }
 }
 
@@ -122,7 +164,7 @@ void DeviceCanOpen::setNmtResetRemoteCommunication() {
     clearSdoQueue();
     sendSdo( SdoMsg(static_cast<uint8_t>(getNodeId()), 0x82) );
 
-    state_ = Initializing;
+    setState(Initializing);
 }
 
 void DeviceCanOpen::setNmtRestartRemoteDevice() {
@@ -130,7 +172,7 @@ void DeviceCanOpen::setNmtRestartRemoteDevice() {
     deviceTimeoutCounter_ = 0;
     sendSdo( SdoMsg(static_cast<uint8_t>(getNodeId()), 0x81) );
 
-    state_ = Initializing;
+    setState(Initializing);
 }
 
 void DeviceCanOpen::resetDevice() {
@@ -165,7 +207,10 @@ bool DeviceCanOpen::parseHeartBeat(const CanMsg& cmsg) {
             return false;
             break;
     }
+    updateStateTable();
 
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(configSequenceMutex_);
+    configSequence_.handleHeartbeat(cmsg.readuint8(0), tcan::Clock::now());
     return true;
 }
 
@@ -174,15 +219,16 @@ bool DeviceCanOpen::parseSDOAnswer(const CanMsg& cmsg) {
     const uint16_t index = cmsg.readuint16(1);
     const uint8_t subindex = cmsg.readuint8(3);
 
-    std::unique_lock<std::mutex> guard(sdoMsgsMutex_); // lock sdoMsgsMutex_ to prevent checkSdoTimeout() from making changes on sdoMsgs_
+    std::unique_lock<tcan::PriorityInheritanceMutex> guard(sdoMsgsMutex_); // lock sdoMsgsMutex_ to prevent checkSdoTimeout() from making changes on sdoMsgs_
     if(sdoMsgs_.size() != 0) {
         const SdoMsg& sdo = sdoMsgs_.front();
 
         if(sdo.getIndex() == index && sdo.getSubIndex() == subindex) {
+            TCAN_PROBE5(sdo_answered, options_->name_.c_str(), getNodeId(), index, subindex, static_cast<int>(responseMode == 0x80));
 
             if(responseMode == 0x42 || responseMode == 0x43 || responseMode == 0x4B || responseMode == 0x4F) { // read responses (unspecified length, 4, 2 or 1 byte)
                 {
-                  std::lock_guard<std::mutex> mapGuard(sdoAnswerMapMutex_);
+                  std::lock_guard<tcan::PriorityInheritanceMutex> mapGuard(sdoAnswerMapMutex_);
                   sdoAnswerMap_[getSdoAnswerId(index, subindex)] = static_cast<const SdoMsg&>(cmsg);
                 }
                 guard.unlock(); // unlock guard here, otherwise the user will not be able to put any sdo in the sdo ouput queue
@@ -195,7 +241,10 @@ bool DeviceCanOpen::parseSDOAnswer(const CanMsg& cmsg) {
             }
 
             sendNextSdo();
+            guard.unlock();
 
+            std::lock_guard<tcan::PriorityInheritanceMutex> sequenceGuard(configSequenceMutex_);
+            configSequence_.handleSdoAnswer(static_cast<const SdoMsg&>(cmsg), responseMode == 0x80, tcan::Clock::now());
             return true;
         }
     }
@@ -209,14 +258,19 @@ bool DeviceCanOpen::checkSdoTimeout() {
     const DeviceCanOpenOptions* options = static_cast<const DeviceCanOpenOptions*>(options_.get());
 
     if(options->maxSdoTimeoutCounter_ != 0) {
-        std::unique_lock<std::mutex> guard(sdoMsgsMutex_); // lock sdoMsgsMutex_ to prevent parseSDOAnswer from making changes on sdoMsgs_
+        std::unique_lock<tcan::PriorityInheritanceMutex> guard(sdoMsgsMutex_); // lock sdoMsgsMutex_ to prevent parseSDOAnswer from making changes on sdoMsgs_
         if( sdoMsgs_.size() != 0 && (sdoTimeoutCounter_++ > options->maxSdoTimeoutCounter_) ) {
             // sdoTimeoutCounter_ is only increased if options_->maxSdoTimeoutCounter != 0 and sdoMsgs_.size() != 0
 
             const SdoMsg &msg = sdoMsgs_.front();
             if (sdoSentCounter_ > options->maxSdoSentCounter_) {
+                TCAN_PROBE4(sdo_timeout, options_->name_.c_str(), getNodeId(), msg.getIndex(), msg.getSubIndex());
                 guard.unlock(); // unlock guard here, otherwise the user will not be able to put any sdo in the sdo ouput queue
                 handleTimedoutSdo(msg);
+                {
+                    std::lock_guard<tcan::PriorityInheritanceMutex> sequenceGuard(configSequenceMutex_);
+                    configSequence_.handleSdoTimeout(msg);
+                }
                 guard.lock();
                 sendNextSdo();
 
@@ -225,6 +279,7 @@ bool DeviceCanOpen::checkSdoTimeout() {
                 sdoSentCounter_++;
 
                 bus_->sendMessage(msg);
+                TCAN_PROBE4(sdo_sent, options_->name_.c_str(), getNodeId(), msg.getIndex(), msg.getSubIndex());
             }
         }
     }
@@ -245,13 +300,14 @@ void DeviceCanOpen::sendNextSdo() {
         if(!sdoMsgs_.front().getRequiresAnswer()) {
             sdoMsgs_.pop(); // if sdo requires no answer (e.g. NMT state requests), pop it from the SDO queue and proceed to the next SDO
         }else{
+            TCAN_PROBE4(sdo_sent, options_->name_.c_str(), getNodeId(), sdoMsgs_.front().getIndex(), sdoMsgs_.front().getSubIndex());
             break; // if SDO requires answer, wait for it
         }
     }
 }
 
 void DeviceCanOpen::clearSdoQueue() {
-    std::lock_guard<std::mutex> guard(sdoMsgsMutex_);
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(sdoMsgsMutex_);
     // swap with an empty queue to clear it
     std::queue<SdoMsg>().swap(sdoMsgs_);
 }
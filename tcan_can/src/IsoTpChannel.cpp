@@ -0,0 +1,560 @@
+#include <sys/socket.h>
+#include <poll.h>
+#include <linux/can.h>
+#include <net/if.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+#if __has_include(<linux/can/isotp.h>)
+#include <linux/can/isotp.h>
+#define TCAN_CAN_HAS_ISOTP_SOCKET
+#endif
+
+#include "tcan_can/IsoTpChannel.hpp"
+#include "tcan_can/CanBus.hpp"
+#include "tcan/Clock.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan_can {
+
+IsoTpChannel::IsoTpChannel(std::unique_ptr<IsoTpChannelOptions>&& options):
+    CanDevice(std::move(options)),
+    socket_(-1),
+    mutex_(),
+    cond_(),
+    transmitState_(TransmitState::Idle),
+    txCond_(),
+    txData_(),
+    txOffset_(0),
+    txSequenceNumber_(0),
+    txDeadline_(),
+    txBlockSize_(0),
+    txBlockCounter_(0),
+    numQueuedFrames_(0),
+    txSeparationTime_(0),
+    isTransmitLimitChanged_(false),
+    hasPreviousTransmitLimit_(false),
+    previousTransmitLimit_(),
+    rxData_(),
+    rxLength_(0),
+    rxSequenceNumber_(0),
+    rxBlockCounter_(0),
+    rxDeadline_(),
+    receivedMessages_(),
+    numFailedTransfers_(0)
+{
+    // the transfer state is accessed by the receive and sanity check threads and the application
+    if(!mutex_.isPriorityInheritanceEnabled()) {
+        MELO_WARN("Failed to enable priority inheritance on the mutex of ISO-TP channel %s", getName().c_str());
+    }
+    rxData_.reserve(getOptions()->maxMessageLength_);
+}
+
+IsoTpChannel::~IsoTpChannel() {
+    if(socket_ >= 0) {
+        close(socket_);
+    }else if(bus_ != nullptr) {
+        bus_->setTransmitCallback(getOptions()->txId_, std::function<void()>());
+    }
+}
+
+bool IsoTpChannel::initDevice() {
+    const IsoTpChannelOptions* options = getOptions();
+    if(options->implementation_ != IsoTpChannelOptions::Implementation::Userspace && !initializeKernelSocket()) {
+        if(options->implementation_ == IsoTpChannelOptions::Implementation::Kernel) {
+            MELO_ERROR("Failed to open CAN_ISOTP socket of channel %s on interface %s:\n  %s", getName().c_str(), bus_->getName().c_str(), strerror(errno));
+            return false;
+        }
+        MELO_INFO("CAN_ISOTP socket not available on interface %s, channel %s uses the userspace implementation.", bus_->getName().c_str(), getName().c_str());
+    }
+
+    if(!isKernelImplementation() && options->frameLength_ != CanMsg::Capacity) {
+        MELO_ERROR("ISO-TP channel %s: frame length %u requires the kernel implementation.", getName().c_str(), options->frameLength_);
+        return false;
+    }
+
+    // with the kernel implementation, the frames of the receive identifier are ignored, but not reported as unhandled traffic
+    bus_->addCanMessage(options->rxId_, this, &IsoTpChannel::parseFrame);
+    if(!isKernelImplementation()) {
+        bus_->setTransmitCallback(options->txId_, std::bind(&IsoTpChannel::handleFrameWrittenWithoutLock, this));
+    }
+    setState(Active);
+    return true;
+}
+
+bool IsoTpChannel::configureDevice(const CanMsg& /*msg*/) {
+    return true;
+}
+
+bool IsoTpChannel::initializeKernelSocket() {
+#ifdef TCAN_CAN_HAS_ISOTP_SOCKET
+    const IsoTpChannelOptions* options = getOptions();
+    const unsigned int interfaceIndex = if_nametoindex(bus_->getName().c_str());
+    if(interfaceIndex == 0) {
+        return false;
+    }
+
+    const int sock = socket(PF_CAN, SOCK_DGRAM, CAN_ISOTP);
+    if(sock < 0) {
+        return false;
+    }
+
+    can_isotp_options isotpOptions;
+    memset(&isotpOptions, 0, sizeof(isotpOptions));
+    isotpOptions.flags = options->padding_ ? CAN_ISOTP_TX_PADDING : 0;
+    isotpOptions.frame_txtime = CAN_ISOTP_DEFAULT_FRAME_TXTIME;
+    isotpOptions.txpad_content = options->paddingByte_;
+    isotpOptions.rxpad_content = options->paddingByte_;
+
+    can_isotp_fc_options flowControlOptions;
+    flowControlOptions.bs = options->blockSize_;
+    flowControlOptions.stmin = encodeSeparationTime(options->separationTime_);
+    flowControlOptions.wftmax = 0;
+
+    can_isotp_ll_options linkLayerOptions;
+    linkLayerOptions.mtu = (options->frameLength_ > CAN_MAX_DLEN) ? CANFD_MTU : CAN_MTU;
+    linkLayerOptions.tx_dl = options->frameLength_;
+    linkLayerOptions.tx_flags = 0;
+
+    sockaddr_can address;
+    memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = interfaceIndex;
+    address.can_addr.tp.tx_id = options->txId_;
+    address.can_addr.tp.rx_id = options->rxId_;
+
+    if(setsockopt(sock, SOL_CAN_ISOTP, CAN_ISOTP_OPTS, &isotpOptions, sizeof(isotpOptions)) != 0 ||
+       setsockopt(sock, SOL_CAN_ISOTP, CAN_ISOTP_RECV_FC, &flowControlOptions, sizeof(flowControlOptions)) != 0 ||
+       setsockopt(sock, SOL_CAN_ISOTP, CAN_ISOTP_LL_OPTS, &linkLayerOptions, sizeof(linkLayerOptions)) != 0 ||
+       bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        const int error = errno;
+        close(sock);
+        errno = error;
+        return false;
+    }
+
+    socket_ = sock;
+    return true;
+#else
+    errno = EPROTONOSUPPORT;
+    return false;
+#endif
+}
+
+bool IsoTpChannel::sanityCheck() {
+    if(!isKernelImplementation()) {
+        const auto now = tcan::Clock::now();
+        {
+            std::lock_guard<tcan::PriorityInheritanceMutex> guard(bus_->getOutgoingMsgsMutex());
+            if(transmitState_ == TransmitState::WaitForFlowControl && now > txDeadline_) {
+                failTransmissionWithoutLock("no flow control received");
+            }
+        }
+        std::lock_guard<tcan::PriorityInheritanceMutex> guard(mutex_);
+        if(rxLength_ > 0 && now > rxDeadline_) {
+            rxLength_ = 0;
+            ++numFailedTransfers_;
+            MELO_WARN("ISO-TP channel %s: reception timed out after %zu bytes.", getName().c_str(), rxData_.size());
+        }
+    }
+    return CanDevice::sanityCheck();
+}
+
+bool IsoTpChannel::startTransmission(const uint8_t* data, const std::size_t length) {
+    if(length == 0 || length > 0xFFFFFFFFu) {
+        return false;
+    }
+
+    if(isKernelImplementation()) {
+        // the kernel sends the message in the background, and rejects it if a transfer is running
+        return ::send(socket_, data, length, MSG_DONTWAIT) == static_cast<ssize_t>(length);
+    }
+
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(bus_->getOutgoingMsgsMutex());
+    if(transmitState_ == TransmitState::WaitForFlowControl || transmitState_ == TransmitState::SendConsecutive) {
+        return false;
+    }
+
+    uint8_t frame[CanMsg::Capacity];
+    if(length < CanMsg::Capacity) {
+        frame[0] = static_cast<uint8_t>(length);
+        std::copy(data, data + length, &frame[1]);
+        const bool isSent = sendFrameWithoutLock(frame, static_cast<uint8_t>(length + 1));
+        transmitState_ = isSent ? TransmitState::Done : TransmitState::Failed;
+        return isSent;
+    }
+
+    txData_.assign(data, data + length);
+    if(length <= 0xFFF) {
+        frame[0] = static_cast<uint8_t>(0x10 | (length >> 8));
+        frame[1] = static_cast<uint8_t>(length & 0xFF);
+        txOffset_ = 6;
+    }else{
+        // escape sequence for messages longer than 4095 bytes
+        frame[0] = 0x10;
+        frame[1] = 0x00;
+        for(unsigned int i=0; i<4; ++i) {
+            frame[2 + i] = static_cast<uint8_t>((length >> (24 - 8*i)) & 0xFF);
+        }
+        txOffset_ = 2;
+    }
+    std::copy(data, data + txOffset_, &frame[CanMsg::Capacity - txOffset_]);
+
+    txSequenceNumber_ = 1;
+    txDeadline_ = tcan::Clock::now() + std::chrono::milliseconds(getOptions()->timeout_);
+    if(!sendFrameWithoutLock(frame, CanMsg::Capacity)) {
+        transmitState_ = TransmitState::Failed;
+        return false;
+    }
+    transmitState_ = TransmitState::WaitForFlowControl;
+    return true;
+}
+
+bool IsoTpChannel::waitForTransmission(const std::chrono::milliseconds& timeout) {
+    if(isKernelImplementation()) {
+        // the socket is writable again when the transfer is completed
+        pollfd fds{socket_, POLLOUT, 0};
+        if(poll(&fds, 1, static_cast<int>(timeout.count())) <= 0) {
+            return false;
+        }
+        if(fds.revents & POLLERR) {
+            int error = 0;
+            socklen_t errorLength = sizeof(error);
+            getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error, &errorLength);
+            ++numFailedTransfers_;
+            MELO_WARN("ISO-TP channel %s: transmission failed:\n  %s", getName().c_str(), strerror(error));
+            return false;
+        }
+        return true;
+    }
+
+    std::unique_lock<tcan::PriorityInheritanceMutex> lock(bus_->getOutgoingMsgsMutex());
+    const auto deadline = tcan::Clock::now() + timeout;
+    while((transmitState_ == TransmitState::WaitForFlowControl || transmitState_ == TransmitState::SendConsecutive) &&
+          tcan::Clock::now() < deadline) {
+        tcan::Clock::waitUntil(txCond_, lock, deadline);
+    }
+    return transmitState_ == TransmitState::Done;
+}
+
+bool IsoTpChannel::send(const uint8_t* data, const std::size_t length, const std::chrono::milliseconds& timeout) {
+    if(!startTransmission(data, length)) {
+        return false;
+    }
+    if(waitForTransmission(timeout)) {
+        return true;
+    }
+
+    if(!isKernelImplementation()) {
+        std::lock_guard<tcan::PriorityInheritanceMutex> guard(bus_->getOutgoingMsgsMutex());
+        if(transmitState_ == TransmitState::WaitForFlowControl || transmitState_ == TransmitState::SendConsecutive) {
+            failTransmissionWithoutLock("timeout");
+        }
+    }
+    return false;
+}
+
+bool IsoTpChannel::receive(std::vector<uint8_t>& data, const std::chrono::milliseconds& timeout) {
+    if(isKernelImplementation()) {
+        pollfd fds{socket_, POLLIN, 0};
+        if(poll(&fds, 1, static_cast<int>(timeout.count())) <= 0) {
+            return false;
+        }
+        data.resize(getOptions()->maxMessageLength_);
+        const ssize_t length = recv(socket_, data.data(), data.size(), MSG_DONTWAIT);
+        if(length <= 0) {
+            data.clear();
+            return false;
+        }
+        data.resize(length);
+        return true;
+    }
+
+    std::unique_lock<tcan::PriorityInheritanceMutex> lock(mutex_);
+    const auto deadline = tcan::Clock::now() + timeout;
+    while(receivedMessages_.empty() && tcan::Clock::now() < deadline) {
+        tcan::Clock::waitUntil(cond_, lock, deadline);
+    }
+    if(receivedMessages_.empty()) {
+        return false;
+    }
+    data.swap(receivedMessages_.front());
+    receivedMessages_.pop_front();
+    return true;
+}
+
+uint8_t IsoTpChannel::encodeSeparationTime(const unsigned int separationTime) {
+    if(separationTime == 0) {
+        return 0;
+    }
+    if(separationTime <= 900) {
+        return static_cast<uint8_t>(0xF0 + (separationTime + 99) / 100);
+    }
+    return static_cast<uint8_t>(std::min(127u, (separationTime + 999) / 1000));
+}
+
+unsigned int IsoTpChannel::decodeSeparationTime(const uint8_t stMin) {
+    if(stMin <= 0x7F) {
+        return stMin * 1000u;
+    }
+    if(stMin >= 0xF1 && stMin <= 0xF9) {
+        return (stMin - 0xF0) * 100u;
+    }
+    return 127000;
+}
+
+bool IsoTpChannel::parseFrame(const CanMsg& msg) {
+    if(isKernelImplementation() || msg.getLength() == 0) {
+        return true;
+    }
+
+    if(static_cast<FrameType>(msg.getData()[0] >> 4) == FrameType::FlowControl) {
+        std::lock_guard<tcan::PriorityInheritanceMutex> guard(bus_->getOutgoingMsgsMutex());
+        handleFlowControlWithoutLock(msg);
+        return true;
+    }
+
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(mutex_);
+    switch(static_cast<FrameType>(msg.getData()[0] >> 4)) {
+        case FrameType::Single:
+            handleSingleFrame(msg);
+            break;
+        case FrameType::First:
+            handleFirstFrame(msg);
+            break;
+        case FrameType::Consecutive:
+            handleConsecutiveFrame(msg);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+void IsoTpChannel::handleSingleFrame(const CanMsg& msg) {
+    const uint8_t length = msg.getData()[0] & 0x0F;
+    if(length == 0 || length >= msg.getLength()) {
+        return;
+    }
+    if(rxLength_ > 0) {
+        // a new message aborts the reception of the previous one
+        rxLength_ = 0;
+        ++numFailedTransfers_;
+    }
+    pushReceivedMessageWithoutLock(&msg.getData()[1], length);
+}
+
+void IsoTpChannel::handleFirstFrame(const CanMsg& msg) {
+    if(msg.getLength() != CanMsg::Capacity) {
+        return;
+    }
+    const uint8_t* data = msg.getData();
+    std::size_t length = ((data[0] & 0x0F) << 8) | data[1];
+    unsigned int dataStart = 2;
+    if(length == 0) {
+        length = (static_cast<uint32_t>(data[2]) << 24) | (data[3] << 16) | (data[4] << 8) | data[5];
+        dataStart = 6;
+    }
+    if(length < CanMsg::Capacity) {
+        return;
+    }
+
+    if(rxLength_ > 0) {
+        ++numFailedTransfers_;
+    }
+    rxLength_ = 0;
+    if(length > getOptions()->maxMessageLength_) {
+        ++numFailedTransfers_;
+        MELO_WARN("ISO-TP channel %s: rejected message of %zu bytes.", getName().c_str(), length);
+        sendFlowControl(FlowStatus::Overflow);
+        return;
+    }
+
+    rxData_.assign(&data[dataStart], &data[CanMsg::Capacity]);
+    rxLength_ = length;
+    rxSequenceNumber_ = 1;
+    rxBlockCounter_ = 0;
+    rxDeadline_ = tcan::Clock::now() + std::chrono::milliseconds(getOptions()->timeout_);
+    sendFlowControl(FlowStatus::ContinueToSend);
+}
+
+void IsoTpChannel::handleConsecutiveFrame(const CanMsg& msg) {
+    if(rxLength_ == 0) {
+        return;
+    }
+    if((msg.getData()[0] & 0x0F) != (rxSequenceNumber_ & 0x0F)) {
+        rxLength_ = 0;
+        ++numFailedTransfers_;
+        MELO_WARN("ISO-TP channel %s: wrong sequence number, reception aborted.", getName().c_str());
+        return;
+    }
+
+    const std::size_t length = std::min<std::size_t>(msg.getLength() - 1, rxLength_ - rxData_.size());
+    rxData_.insert(rxData_.end(), &msg.getData()[1], &msg.getData()[1 + length]);
+    ++rxSequenceNumber_;
+    if(rxData_.size() == rxLength_) {
+        rxLength_ = 0;
+        pushReceivedMessageWithoutLock(rxData_.data(), rxData_.size());
+        return;
+    }
+
+    rxDeadline_ = tcan::Clock::now() + std::chrono::milliseconds(getOptions()->timeout_);
+    const uint8_t blockSize = getOptions()->blockSize_;
+    if(blockSize > 0 && ++rxBlockCounter_ >= blockSize) {
+        rxBlockCounter_ = 0;
+        sendFlowControl(FlowStatus::ContinueToSend);
+    }
+}
+
+void IsoTpChannel::handleFlowControlWithoutLock(const CanMsg& msg) {
+    if(transmitState_ != TransmitState::WaitForFlowControl || msg.getLength() < 3) {
+        return;
+    }
+
+    const uint8_t* data = msg.getData();
+    switch(static_cast<FlowStatus>(data[0] & 0x0F)) {
+        case FlowStatus::ContinueToSend:
+            setSeparationTimeWithoutLock(decodeSeparationTime(data[2]));
+            txBlockSize_ = data[1];
+            txBlockCounter_ = 0;
+            transmitState_ = TransmitState::SendConsecutive;
+            queueConsecutiveFramesWithoutLock();
+            break;
+        case FlowStatus::Wait:
+            txDeadline_ = tcan::Clock::now() + std::chrono::milliseconds(getOptions()->timeout_);
+            break;
+        default:
+            failTransmissionWithoutLock("receiver overflow");
+            break;
+    }
+}
+
+void IsoTpChannel::handleFrameWrittenWithoutLock() {
+    if(numQueuedFrames_ > 0) {
+        --numQueuedFrames_;
+    }
+
+    if(transmitState_ == TransmitState::SendConsecutive) {
+        if(txOffset_ < txData_.size()) {
+            queueConsecutiveFramesWithoutLock();
+        }else if(numQueuedFrames_ == 0) {
+            // the last consecutive frame was written
+            transmitState_ = TransmitState::Done;
+            txCond_.notify_all();
+        }
+    }
+
+    // the separation time is enforced until all consecutive frames are written
+    if(numQueuedFrames_ == 0 && transmitState_ != TransmitState::WaitForFlowControl && transmitState_ != TransmitState::SendConsecutive) {
+        restoreTransmitLimitWithoutLock();
+    }
+}
+
+void IsoTpChannel::queueConsecutiveFramesWithoutLock() {
+    uint8_t frame[CanMsg::Capacity];
+    while(txOffset_ < txData_.size() && numQueuedFrames_ < getOptions()->maxQueuedFrames_) {
+        const std::size_t length = std::min<std::size_t>(CanMsg::Capacity - 1, txData_.size() - txOffset_);
+        frame[0] = static_cast<uint8_t>(0x20 | (txSequenceNumber_ & 0x0F));
+        std::copy(&txData_[txOffset_], &txData_[txOffset_] + length, &frame[1]);
+        if(!sendFrameWithoutLock(frame, static_cast<uint8_t>(length + 1))) {
+            // retried when a queued frame was written
+            if(numQueuedFrames_ == 0) {
+                failTransmissionWithoutLock("output queue full");
+            }
+            return;
+        }
+        txOffset_ += length;
+        ++txSequenceNumber_;
+
+        if(txBlockSize_ > 0 && ++txBlockCounter_ >= txBlockSize_ && txOffset_ < txData_.size()) {
+            transmitState_ = TransmitState::WaitForFlowControl;
+            txDeadline_ = tcan::Clock::now() + std::chrono::milliseconds(getOptions()->timeout_);
+            return;
+        }
+    }
+}
+
+void IsoTpChannel::setSeparationTimeWithoutLock(const unsigned int separationTime) {
+    if(separationTime == txSeparationTime_) {
+        return;
+    }
+    if(separationTime == 0) {
+        restoreTransmitLimitWithoutLock();
+        return;
+    }
+
+    const uint32_t txId = getOptions()->txId_;
+    if(!isTransmitLimitChanged_) {
+        hasPreviousTransmitLimit_ = bus_->getTransmitLimitWithoutLock(txId, previousTransmitLimit_);
+        isTransmitLimitChanged_ = true;
+    }
+    bus_->setTransmitLimitWithoutLock(txId, TransmitLimit(separationTime));
+    txSeparationTime_ = separationTime;
+}
+
+void IsoTpChannel::restoreTransmitLimitWithoutLock() {
+    if(!isTransmitLimitChanged_) {
+        return;
+    }
+
+    const uint32_t txId = getOptions()->txId_;
+    if(hasPreviousTransmitLimit_) {
+        bus_->setTransmitLimitWithoutLock(txId, previousTransmitLimit_);
+    }else{
+        bus_->removeTransmitLimitWithoutLock(txId);
+    }
+    isTransmitLimitChanged_ = false;
+    txSeparationTime_ = 0;
+}
+
+bool IsoTpChannel::sendFrame(const uint8_t* data, const uint8_t length) {
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(bus_->getOutgoingMsgsMutex());
+    return sendFrameWithoutLock(data, length);
+}
+
+bool IsoTpChannel::sendFrameWithoutLock(const uint8_t* data, const uint8_t length) {
+    const IsoTpChannelOptions* options = getOptions();
+    uint8_t frame[CanMsg::Capacity];
+    std::copy(data, data + length, frame);
+    uint8_t frameLength = length;
+    if(options->padding_) {
+        std::fill(&frame[length], &frame[CanMsg::Capacity], options->paddingByte_);
+        frameLength = CanMsg::Capacity;
+    }
+
+    if(!bus_->sendMessageWithoutLock(CanMsg(options->txId_, frameLength, frame))) {
+        return false;
+    }
+    ++numQueuedFrames_;
+    return true;
+}
+
+bool IsoTpChannel::sendFlowControl(const FlowStatus status) {
+    const uint8_t frame[3] = {static_cast<uint8_t>(0x30 | static_cast<uint8_t>(status)), getOptions()->blockSize_,
+                              encodeSeparationTime(getOptions()->separationTime_)};
+    return sendFrame(frame, 3);
+}
+
+void IsoTpChannel::pushReceivedMessageWithoutLock(const uint8_t* data, const std::size_t length) {
+    if(receivedMessages_.size() >= getOptions()->maxQueuedMessages_) {
+        ++numFailedTransfers_;
+        MELO_WARN("ISO-TP channel %s: receive queue full, message dropped.", getName().c_str());
+        return;
+    }
+    receivedMessages_.emplace_back(data, data + length);
+    cond_.notify_all();
+}
+
+void IsoTpChannel::failTransmissionWithoutLock(const char* reason) {
+    transmitState_ = TransmitState::Failed;
+    ++numFailedTransfers_;
+    MELO_WARN("ISO-TP channel %s: transmission failed after %zu of %zu bytes (%s).", getName().c_str(), txOffset_, txData_.size(), reason);
+    if(numQueuedFrames_ == 0) {
+        restoreTransmitLimitWithoutLock();
+    }
+    txCond_.notify_all();
+}
+
+} /* namespace tcan_can */
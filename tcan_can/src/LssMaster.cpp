@@ -0,0 +1,237 @@
+#include <algorithm>
+
+#include "tcan_can/LssMaster.hpp"
+#include "tcan_can/CanBus.hpp"
+#include "tcan/Clock.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan_can {
+
+namespace {
+
+// command specifiers of CiA 305
+constexpr uint8_t SwitchStateGlobal = 0x04;
+constexpr uint8_t ConfigureNodeId = 0x11;
+constexpr uint8_t ConfigureBitTiming = 0x13;
+constexpr uint8_t ActivateBitTiming = 0x15;
+constexpr uint8_t StoreConfiguration = 0x17;
+constexpr uint8_t SwitchStateSelectiveVendorId = 0x40;
+constexpr uint8_t SwitchStateSelectiveAnswer = 0x44;
+constexpr uint8_t IdentifyUnconfiguredSlaves = 0x4C;
+constexpr uint8_t IdentifySlave = 0x4F;
+constexpr uint8_t IdentifyUnconfiguredSlavesAnswer = 0x50;
+constexpr uint8_t Fastscan = 0x51;
+constexpr uint8_t InquireNodeId = 0x5E;
+
+// bitChecked of the Fastscan request which resets the scan of all slaves
+constexpr uint8_t FastscanReset = 0x80;
+
+//! LSS frame with the command specifier, a little endian value in bytes 1-4 and bytes 5-7
+CanMsg createRequest(const uint8_t command, const uint32_t value = 0, const uint8_t byte5 = 0, const uint8_t byte6 = 0, const uint8_t byte7 = 0) {
+    const uint8_t data[CanMsg::Capacity] = {command, static_cast<uint8_t>(value & 0xFF), static_cast<uint8_t>((value >> 8) & 0xFF),
+                                            static_cast<uint8_t>((value >> 16) & 0xFF), static_cast<uint8_t>((value >> 24) & 0xFF),
+                                            byte5, byte6, byte7};
+    return CanMsg(LssMaster::TxId, CanMsg::Capacity, data);
+}
+
+} /* namespace */
+
+LssMaster::LssMaster(std::unique_ptr<LssMasterOptions>&& options):
+    CanDevice(std::move(options)),
+    responseMutex_(),
+    responseCond_(),
+    expectedCommand_(0),
+    isAnswered_(false),
+    response_{0, 0, 0, 0, 0, 0, 0, 0},
+    numFastscanSteps_(0),
+    numUnansweredFastscanSteps_(0)
+{
+    // the answer is written by the receive thread
+    if(!responseMutex_.isPriorityInheritanceEnabled()) {
+        MELO_WARN("Failed to enable priority inheritance on the mutex of %s", getName().c_str());
+    }
+}
+
+bool LssMaster::initDevice() {
+    bus_->addCanMessage(RxId, this, &LssMaster::parseResponse);
+    setState(Active);
+    return true;
+}
+
+bool LssMaster::configureDevice(const CanMsg& /*msg*/) {
+    return true;
+}
+
+bool LssMaster::switchStateGlobal(const bool configuration) {
+    return request(createRequest(SwitchStateGlobal, configuration ? 1 : 0), 0, std::chrono::milliseconds(0));
+}
+
+bool LssMaster::switchStateSelective(const LssAddress& address) {
+    const std::chrono::milliseconds timeout(getOptions()->timeout_);
+    const uint32_t values[4] = {address.vendorId_, address.productCode_, address.revisionNumber_, address.serialNumber_};
+    for(uint8_t i=0; i<3; ++i) {
+        request(createRequest(static_cast<uint8_t>(SwitchStateSelectiveVendorId + i), values[i]), 0, timeout);
+    }
+    return request(createRequest(static_cast<uint8_t>(SwitchStateSelectiveVendorId + 3), values[3]), SwitchStateSelectiveAnswer, timeout);
+}
+
+bool LssMaster::configureNodeId(const uint8_t nodeId) {
+    return requestConfiguration(createRequest(ConfigureNodeId, nodeId), "configure node-ID");
+}
+
+bool LssMaster::configureBitTiming(const BitRate bitRate) {
+    // table selector 0 (standard bit timing table) in byte 1, table index in byte 2
+    return requestConfiguration(createRequest(ConfigureBitTiming, static_cast<uint32_t>(bitRate) << 8), "configure bit timing");
+}
+
+bool LssMaster::activateBitTiming(const uint16_t switchDelay) {
+    return request(createRequest(ActivateBitTiming, switchDelay), 0, std::chrono::milliseconds(0));
+}
+
+bool LssMaster::storeConfiguration() {
+    return requestConfiguration(createRequest(StoreConfiguration), "store configuration");
+}
+
+bool LssMaster::inquireNodeId(uint8_t& nodeId) {
+    CanMsg response(RxId);
+    if(!request(createRequest(InquireNodeId), InquireNodeId, std::chrono::milliseconds(getOptions()->timeout_), &response)) {
+        return false;
+    }
+    nodeId = response.getData()[1];
+    return true;
+}
+
+bool LssMaster::identifyUnconfiguredSlaves() {
+    return request(createRequest(IdentifyUnconfiguredSlaves), IdentifyUnconfiguredSlavesAnswer, std::chrono::milliseconds(getOptions()->timeout_));
+}
+
+bool LssMaster::fastscan(LssAddress& address) {
+    if(!sendFastscan(0, FastscanReset, 0, 0)) {
+        return false;
+    }
+
+    const LssMasterOptions* options = getOptions();
+    const bool isKnown[4] = {options->isVendorIdKnown_, options->isProductCodeKnown_, false, false};
+    uint32_t idNumbers[4] = {options->vendorId_, options->productCode_, 0, 0};
+    for(uint8_t lssSub=0; lssSub<4; ++lssSub) {
+        if(!isKnown[lssSub]) {
+            // a step is answered by the slaves whose bits down to bitChecked equal idNumber, so an unanswered step means the bit is 1
+            idNumbers[lssSub] = 0;
+            for(int bit=31; bit>=0; --bit) {
+                if(!sendFastscan(idNumbers[lssSub], static_cast<uint8_t>(bit), lssSub, lssSub)) {
+                    idNumbers[lssSub] |= (1u << bit);
+                }
+            }
+        }
+
+        // the slave confirms the complete value and continues with the next part, after the serial number it enters configuration state.
+        // If the part is known, no slave may match it.
+        if(!sendFastscan(idNumbers[lssSub], 0, lssSub, static_cast<uint8_t>((lssSub + 1) % 4))) {
+            if(!isKnown[lssSub]) {
+                MELO_WARN("%s: Fastscan lost the slave at part %u.", getName().c_str(), lssSub);
+            }
+            return false;
+        }
+    }
+
+    address = LssAddress{idNumbers[0], idNumbers[1], idNumbers[2], idNumbers[3]};
+    return true;
+}
+
+bool LssMaster::configureUnconfiguredSlaves(const NodeIdAssigner& assigner, std::vector<LssSlave>& slaves) {
+    slaves.clear();
+    LssAddress address;
+    while(true) {
+        // if no slave answered the reset of the scan, all slaves are configured. Otherwise a slave was lost.
+        const unsigned int numSteps = numFastscanSteps_;
+        if(!fastscan(address)) {
+            return numFastscanSteps_ == numSteps + 1;
+        }
+
+        const uint8_t nodeId = assigner(address);
+        const bool isConfigured = configureNodeId(nodeId) && (!getOptions()->storeConfiguration_ || storeConfiguration());
+        switchStateGlobal(false);
+        if(!isConfigured) {
+            MELO_ERROR("%s: failed to configure the slave with vendor-ID 0x%08X, product code 0x%08X, revision 0x%08X, serial number 0x%08X.",
+                       getName().c_str(), address.vendorId_, address.productCode_, address.revisionNumber_, address.serialNumber_);
+            return false;
+        }
+
+        slaves.push_back(LssSlave{address, nodeId});
+        MELO_INFO("%s: assigned node-ID %u to the slave with vendor-ID 0x%08X, product code 0x%08X, revision 0x%08X, serial number 0x%08X.",
+                  getName().c_str(), nodeId, address.vendorId_, address.productCode_, address.revisionNumber_, address.serialNumber_);
+    }
+}
+
+bool LssMaster::configureBitRateOfAllSlaves(const BitRate bitRate, const uint16_t switchDelay) {
+    return switchStateGlobal(true) && configureBitTiming(bitRate) && storeConfiguration() && activateBitTiming(switchDelay);
+}
+
+bool LssMaster::parseResponse(const CanMsg& msg) {
+    if(msg.getLength() == 0) {
+        return true;
+    }
+
+    std::lock_guard<tcan::PriorityInheritanceMutex> guard(responseMutex_);
+    if(!isAnswered_ && msg.getData()[0] == expectedCommand_) {
+        std::fill(response_, response_ + CanMsg::Capacity, 0);
+        std::copy(msg.getData(), msg.getData() + msg.getLength(), response_);
+        isAnswered_ = true;
+        responseCond_.notify_all();
+    }
+    return true;
+}
+
+bool LssMaster::request(const CanMsg& request, const uint8_t responseCommand, const std::chrono::milliseconds& timeout, CanMsg* response,
+                        const bool waitForAllAnswers) {
+    {
+        std::lock_guard<tcan::PriorityInheritanceMutex> guard(responseMutex_);
+        expectedCommand_ = responseCommand;
+        isAnswered_ = false;
+    }
+    if(!bus_->sendMessage(request)) {
+        return false;
+    }
+    if(responseCommand == 0) {
+        return true;
+    }
+
+    std::unique_lock<tcan::PriorityInheritanceMutex> lock(responseMutex_);
+    const auto deadline = tcan::Clock::now() + timeout;
+    while((!isAnswered_ || waitForAllAnswers) && tcan::Clock::now() < deadline) {
+        tcan::Clock::waitUntil(responseCond_, lock, deadline);
+    }
+    expectedCommand_ = 0;
+    if(isAnswered_ && response != nullptr) {
+        response->setData(CanMsg::Capacity, response_);
+    }
+    return isAnswered_;
+}
+
+bool LssMaster::requestConfiguration(const CanMsg& request, const char* service) {
+    CanMsg response(RxId);
+    if(!this->request(request, request.getData()[0], std::chrono::milliseconds(getOptions()->timeout_), &response)) {
+        MELO_WARN("%s: no answer to %s.", getName().c_str(), service);
+        return false;
+    }
+    if(response.getData()[1] != 0) {
+        MELO_WARN("%s: %s failed with error code %u.", getName().c_str(), service, response.getData()[1]);
+        return false;
+    }
+    return true;
+}
+
+bool LssMaster::sendFastscan(const uint32_t idNumber, const uint8_t bitChecked, const uint8_t lssSub, const uint8_t lssNext) {
+    ++numFastscanSteps_;
+    // the answers of several slaves are identical and may arrive one after the other, so each step lasts the full timeout, such that a
+    // late answer is not taken as answer of the next step
+    if(!request(createRequest(Fastscan, idNumber, bitChecked, lssSub, lssNext), IdentifySlave, std::chrono::milliseconds(getOptions()->fastscanTimeout_),
+                nullptr, true)) {
+        ++numUnansweredFastscanSteps_;
+        return false;
+    }
+    return true;
+}
+
+} /* namespace tcan_can */
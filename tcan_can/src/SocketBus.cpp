@@ -1,4 +1,10 @@
 #include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
 #include <linux/can.h>
 #include <linux/can/raw.h>
 #include <linux/can/error.h>
@@ -24,14 +30,88 @@ SocketBus::SocketBus(std::unique_ptr<SocketBusOptions>&& options):
     CanBus(std::move(options)),
     socket_(-1),
     recvFlag_(0),
-    sendFlag_(0)
+    sendFlag_(0),
+    receiveMode_(SocketBusOptions::ReceiveMode::Blocking),
+    hybridSpinWindow_(0),
+    lastReceptionTime_(),
+    numBlockingReceptions_(0),
+    numSpinReceptions_(0),
+    numEmptyPolls_(0),
+    rxBuffer_(),
+    txFrames_(),
+    txIovecs_(),
+    txMsgs_(),
+    ringSocket_(-1),
+    ring_(nullptr),
+    ringSize_(0),
+    ringBlockIndex_(0),
+    receiveGroups_(),
+    pollSocket_(-1)
 {
+    const SocketBusOptions* socketOptions = static_cast<const SocketBusOptions*>(options_.get());
+    const unsigned int batchSize = std::max(1u, socketOptions->batchSize_);
+    rxBuffer_.resize(batchSize);
+    if(batchSize > 1) {
+        txFrames_.resize(batchSize);
+        txIovecs_.resize(batchSize);
+        txMsgs_.resize(batchSize);
+        for(unsigned int i=0; i<batchSize; ++i) {
+            txIovecs_[i] = {&txFrames_[i], sizeof(can_frame)};
+            txMsgs_[i] = mmsghdr{};
+            txMsgs_[i].msg_hdr.msg_iov = &txIovecs_[i];
+            txMsgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    if(!socketOptions->useReceiveRing_) {
+        for(const auto& groupOptions : socketOptions->receiveGroups_) {
+            receiveGroups_.emplace_back(new ReceiveGroup(groupOptions, batchSize));
+        }
+    }
 }
 
 SocketBus::~SocketBus()
 {
     stopThreads();
     close(socket_);
+    if(ring_ != nullptr) {
+        munmap(ring_, ringSize_);
+    }
+    if(ringSocket_ >= 0) {
+        close(ringSocket_);
+    }
+    for(const auto& group : receiveGroups_) {
+        if(group->socket_ >= 0) {
+            close(group->socket_);
+        }
+    }
+    if(pollSocket_ >= 0) {
+        close(pollSocket_);
+    }
+}
+
+void SocketBus::ReceiveBuffer::resize(const unsigned int batchSize) {
+    frames_.resize(batchSize);
+    if(batchSize > 1) {
+        iovecs_.resize(batchSize);
+        msgs_.resize(batchSize);
+        for(unsigned int i=0; i<batchSize; ++i) {
+            iovecs_[i] = {&frames_[i], sizeof(can_frame)};
+            msgs_[i] = mmsghdr{};
+            msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+}
+
+SocketBus::ReceiveGroup::ReceiveGroup(const SocketBusOptions::ReceiveGroup& options, const unsigned int batchSize):
+    options_(options),
+    socket_(-1),
+    buffer_(),
+    thread_(),
+    numFrames_(0)
+{
+    buffer_.resize(batchSize);
 }
 
 bool SocketBus::initializeInterface()
@@ -116,12 +196,27 @@ bool SocketBus::initializeInterface()
         }
     }
 
+    // let the kernel busy-poll the device queue in blocking reads
+    if(options->busyPollTime_ != 0) {
+        int busyPollTime = options->busyPollTime_;
+        if(setsockopt(socket_, SOL_SOCKET, SO_BUSY_POLL, &busyPollTime, sizeof(busyPollTime)) != 0) {
+            MELO_WARN("Failed to set busy poll time: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
     // set nonblocking flags for synchronous mode
     if(!isAsynchronous()) {
         recvFlag_ = MSG_DONTWAIT;
         if(!options_->synchronousBlockingWrite_) {
             sendFlag_ = MSG_DONTWAIT;
         }
+    }else{
+        // spinning modes are only available with a dedicated receive thread
+        receiveMode_ = options->receiveMode_;
+        hybridSpinWindow_ = std::chrono::microseconds(options->hybridSpinWindow_);
+        if(receiveMode_ == SocketBusOptions::ReceiveMode::BusyPoll) {
+            recvFlag_ = MSG_DONTWAIT;
+        }
     }
 
     /* bind socket */
@@ -134,44 +229,370 @@ bool SocketBus::initializeInterface()
         return false;
     }
 
+    if(options->useReceiveRing_) {
+        if(!initializeReceiveRing(ifr.ifr_ifindex)) {
+            return false;
+        }
+
+        // frames are received from the ring. Disable reception on the CAN_RAW socket, such that its queue does not fill up.
+        if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FILTER, nullptr, 0) != 0) {
+            MELO_WARN("Failed to disable reception on CAN raw socket: (%d)\n  %s", errno, strerror(errno));
+        }
+        can_err_mask_t noErrors = 0;
+        setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &noErrors, sizeof(noErrors));
+
+        if(!options->receiveGroups_.empty()) {
+            MELO_WARN("Receive groups of %s are not available with the receive ring and are ignored.", interface);
+        }
+    }
+
+    if(!receiveGroups_.empty()) {
+        if(!initializeReceiveGroups(ifr.ifr_ifindex) || (!isAsynchronous() && !initializePollSocket())) {
+            return false;
+        }
+    }
+
     MELO_INFO("Opened socket %s.", interface);
 
     return true;
 }
 
+bool SocketBus::initializeReceiveGroups(const int interfaceIndex) {
+    const SocketBusOptions* options = static_cast<const SocketBusOptions*>(options_.get());
+    const char* interface = options->name_.c_str();
+
+    for(const auto& group : receiveGroups_) {
+        group->socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+        if(group->socket_ < 0) {
+            MELO_FATAL("Opening receive group socket of %s failed: (%d)\n  %s", interface, errno, strerror(errno));
+            return false;
+        }
+
+        // error frames and own messages are only received by the main socket
+        can_err_mask_t noErrors = 0;
+        setsockopt(group->socket_, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &noErrors, sizeof(noErrors));
+
+        const std::vector<can_filter>& filters = group->options_.canFilters_;
+        if(setsockopt(group->socket_, SOL_CAN_RAW, CAN_RAW_FILTER, filters.empty() ? nullptr : &filters[0], sizeof(can_filter)*filters.size()) != 0) {
+            MELO_FATAL("Failed to set CAN raw filters of receive group of %s: (%d)\n  %s", interface, errno, strerror(errno));
+            return false;
+        }
+
+        if(group->options_.rcvBufLength_ != 0) {
+            if(setsockopt(group->socket_, SOL_SOCKET, SO_RCVBUF, &(group->options_.rcvBufLength_), sizeof(group->options_.rcvBufLength_)) != 0) {
+                MELO_WARN("Failed to set rcvBuf length of receive group of %s: (%d)\n  %s", interface, errno, strerror(errno));
+            }
+        }
+
+        // the receive thread of the group checks running_ after the read timeout
+        if(options->readTimeout_.tv_sec != 0 || options->readTimeout_.tv_usec != 0) {
+            if(setsockopt(group->socket_, SOL_SOCKET, SO_RCVTIMEO, (char*)&options->readTimeout_, sizeof(options->readTimeout_)) != 0) {
+                MELO_WARN("Failed to set read timeout of receive group of %s: (%d)\n  %s", interface, errno, strerror(errno));
+            }
+        }
+
+        struct sockaddr_can addr;
+        memset(&addr, 0, sizeof(struct sockaddr_can));
+        addr.can_family  = AF_CAN;
+        addr.can_ifindex = interfaceIndex;
+        if(bind(group->socket_, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            MELO_FATAL("Error in receive group socket %s bind: (%d)\n  %s", interface, errno, strerror(errno));
+            return false;
+        }
+    }
+
+    // Exclude the frames of the groups from the main socket: a frame passes the joined inverted filters only if it matches none of them.
+    if(options->canFilters_.empty()) {
+        std::vector<can_filter> inverseFilters;
+        for(const auto& group : receiveGroups_) {
+            for(can_filter filter : group->options_.canFilters_) {
+                filter.can_id |= CAN_INV_FILTER;
+                inverseFilters.push_back(filter);
+            }
+        }
+
+        int joinFilters = 1;
+        if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_JOIN_FILTERS, &joinFilters, sizeof(joinFilters)) != 0 ||
+           (!inverseFilters.empty() && setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FILTER, &inverseFilters[0], sizeof(can_filter)*inverseFilters.size()) != 0)) {
+            MELO_FATAL("Failed to exclude the receive groups from the main socket of %s: (%d)\n  %s", interface, errno, strerror(errno));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SocketBus::initializePollSocket() {
+    pollSocket_ = epoll_create1(EPOLL_CLOEXEC);
+    if(pollSocket_ < 0) {
+        MELO_FATAL("Failed to create epoll descriptor of %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+        return false;
+    }
+
+    std::vector<int> sockets{socket_};
+    for(const auto& group : receiveGroups_) {
+        sockets.push_back(group->socket_);
+    }
+    for(const int socket : sockets) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = socket;
+        if(epoll_ctl(pollSocket_, EPOLL_CTL_ADD, socket, &event) != 0) {
+            MELO_FATAL("Failed to add socket to epoll descriptor of %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SocketBus::initializeReceiveRing(const int interfaceIndex) {
+    const SocketBusOptions* options = static_cast<const SocketBusOptions*>(options_.get());
+    const char* interface = options->name_.c_str();
+
+    ringSocket_ = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_CAN));
+    if(ringSocket_ < 0) {
+        MELO_FATAL("Opening packet socket for receive ring of %s failed: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if(setsockopt(ringSocket_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+        MELO_FATAL("Failed to set TPACKET_V3 on %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    // the frame size is only used by the kernel to validate the request with TPACKET_V3
+    constexpr unsigned int frameSize = 128;
+    tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = options->ringBlockSize_;
+    req.tp_block_nr = options->ringNumBlocks_;
+    req.tp_frame_size = frameSize;
+    req.tp_frame_nr = (options->ringBlockSize_ / frameSize) * options->ringNumBlocks_;
+    req.tp_retire_blk_tov = options->ringBlockTimeout_;
+    if(setsockopt(ringSocket_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+        MELO_FATAL("Failed to create receive ring on %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    ringSize_ = static_cast<std::size_t>(req.tp_block_size) * req.tp_block_nr;
+    void* ring = mmap(nullptr, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, ringSocket_, 0);
+    if(ring == MAP_FAILED) {
+        ring = mmap(nullptr, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED, ringSocket_, 0);
+    }
+    if(ring == MAP_FAILED) {
+        MELO_FATAL("Failed to map receive ring of %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+    ring_ = static_cast<uint8_t*>(ring);
+    ringBlockIndex_ = 0;
+
+    sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_CAN);
+    addr.sll_ifindex = interfaceIndex;
+    if(bind(ringSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        MELO_FATAL("Error in packet socket %s bind: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+int SocketBus::readReceiveRing(const int recvFlag) {
+    tpacket_block_desc* block = reinterpret_cast<tpacket_block_desc*>(ring_ + static_cast<std::size_t>(ringBlockIndex_) * static_cast<const SocketBusOptions*>(options_.get())->ringBlockSize_);
+
+    if((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+        if(recvFlag == MSG_DONTWAIT) {
+            errno = EAGAIN;
+            return -1;
+        }
+
+        pollfd fd = {ringSocket_, POLLIN | POLLERR, 0};
+        const int ret = poll(&fd, 1, tcan::calculatePollTimeoutMs(options_->readTimeout_));
+        if(ret <= 0) {
+            if(ret == 0 || errno == EINTR) {
+                errno = EAGAIN;
+            }
+            return -1;
+        }
+        if((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+
+    // the frames are handled in place, without copying them out of the ring
+    int numFrames = 0;
+    const uint32_t numPackets = block->hdr.bh1.num_pkts;
+    const tpacket3_hdr* packet = reinterpret_cast<const tpacket3_hdr*>(reinterpret_cast<const uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt);
+    for(uint32_t i=0; i<numPackets; ++i) {
+        const sockaddr_ll* link = reinterpret_cast<const sockaddr_ll*>(reinterpret_cast<const uint8_t*>(packet) + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+        // the frames sent from this host come back as PACKET_OUTGOING and PACKET_LOOPBACK (local and driver echo). They are dropped
+        // like the own frames of a CAN_RAW socket without CAN_RAW_RECV_OWN_MSGS, the packet socket cannot tell which socket sent them.
+        const bool isOwnFrame = (link->sll_pkttype == PACKET_OUTGOING || link->sll_pkttype == PACKET_LOOPBACK);
+        if(!isOwnFrame && packet->tp_snaplen >= sizeof(can_frame)) {
+            handleFrame(*reinterpret_cast<const can_frame*>(reinterpret_cast<const uint8_t*>(packet) + packet->tp_net));
+            ++numFrames;
+        }
+        packet = reinterpret_cast<const tpacket3_hdr*>(reinterpret_cast<const uint8_t*>(packet) + packet->tp_next_offset);
+    }
+
+    // return the block to the kernel
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    ringBlockIndex_ = (ringBlockIndex_ + 1) % static_cast<const SocketBusOptions*>(options_.get())->ringNumBlocks_;
+
+    if(numFrames == 0) {
+        // block only contained own frames
+        errno = EAGAIN;
+        return -1;
+    }
+    return numFrames;
+}
+
 
 bool SocketBus::readData() {
+    if(receiveGroups_.empty() || isAsynchronous()) {
+        return readMainSocket();
+    }
+
+    // the receive groups carry the time-critical frames and are read first. All sockets are non-blocking in these modes.
+    bool hasReadFrames = false;
+    for(const auto& group : receiveGroups_) {
+        hasReadFrames |= readReceiveGroup(*group, MSG_DONTWAIT);
+    }
+    return readMainSocket() || hasReadFrames;
+}
+
+bool SocketBus::readMainSocket() {
 
     // In synchronous mode, the socket is non-blocking, so this function returns as soon as there is no data available to be read
     // If asynchronous, we set the socket to blocking and have a separate thread reading from it.
 
-    can_frame frame;
-    const int bytes_read = recv( socket_, &frame, sizeof(struct can_frame), recvFlag_);
-    //	printf("CanManager_ bytes read: %i\n", bytes_read);
+    // In ReceiveMode::Hybrid, the read is non-blocking within the spin window after the last received frame.
+    int recvFlag = recvFlag_;
+    if(receiveMode_ == SocketBusOptions::ReceiveMode::Hybrid && std::chrono::steady_clock::now() - lastReceptionTime_ < hybridSpinWindow_) {
+        recvFlag = MSG_DONTWAIT;
+    }
 
-    if(bytes_read <= 0) {
+    const int numFrames = (ring_ != nullptr) ? readReceiveRing(recvFlag) : receiveFrames(socket_, rxBuffer_, recvFlag);
+
+    if(numFrames <= 0) {
         if(errno != EAGAIN && errno != EWOULDBLOCK) {
             MELO_ERROR("Failed to read data from bus %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
             hasBusError_ = true;
         }else{
             hasBusError_ = false;
+            if(recvFlag == MSG_DONTWAIT && receiveMode_ != SocketBusOptions::ReceiveMode::Blocking) {
+                // only written by the receive thread, so a relaxed load and store avoids a locked increment in the spin loop
+                numEmptyPolls_.store(numEmptyPolls_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
         }
         return false;
     }
+
+    if(receiveMode_ != SocketBusOptions::ReceiveMode::Blocking) {
+        if(recvFlag == MSG_DONTWAIT) {
+            numSpinReceptions_.store(numSpinReceptions_.load(std::memory_order_relaxed) + numFrames, std::memory_order_relaxed);
+        }else{
+            numBlockingReceptions_.store(numBlockingReceptions_.load(std::memory_order_relaxed) + numFrames, std::memory_order_relaxed);
+        }
+        if(receiveMode_ == SocketBusOptions::ReceiveMode::Hybrid) {
+            lastReceptionTime_ = std::chrono::steady_clock::now();
+        }
+    }
 //	pintf("CanManager:bus_routine: Data received from iBus %i, n. Bytes: %i \n", iBus, bytes_read);
     hasBusError_ = false;
 
-    if(frame.can_id > CAN_ERR_FLAG && frame.can_id < CAN_RTR_FLAG) {
-        handleBusErrorMessage( frame );
-    }else{
-        handleMessage( CanMsg(frame.can_id, frame.can_dlc, frame.data) );
+    // frames from the receive ring were already handled
+    if(ring_ == nullptr) {
+        for(int i=0; i<numFrames; ++i) {
+            handleFrame(rxBuffer_.frames_[i]);
+        }
+    }
+
+    return true;
+}
+
+int SocketBus::receiveFrames(const int socket, ReceiveBuffer& buffer, const int recvFlag) {
+    if(buffer.msgs_.empty()) {
+        const int bytes_read = recv( socket, &buffer.frames_[0], sizeof(struct can_frame), recvFlag);
+        return (bytes_read <= 0) ? bytes_read : 1;
+    }
+
+    // a blocking recvmmsg waits until the whole batch is filled, so only wait for the first frame
+    return recvmmsg(socket, buffer.msgs_.data(), buffer.msgs_.size(), (recvFlag == 0) ? MSG_WAITFORONE : recvFlag, nullptr);
+}
+
+bool SocketBus::readReceiveGroup(ReceiveGroup& group, const int recvFlag) {
+    const int numFrames = receiveFrames(group.socket_, group.buffer_, recvFlag);
+    if(numFrames <= 0) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            MELO_ERROR("Failed to read data from receive group of bus %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+            hasBusError_ = true;
+        }
+        return false;
     }
 
+    // only written by the thread reading the group
+    group.numFrames_.store(group.numFrames_.load(std::memory_order_relaxed) + numFrames, std::memory_order_relaxed);
+
+    // the group sockets receive no error frames
+    for(int i=0; i<numFrames; ++i) {
+        const can_frame& frame = group.buffer_.frames_[i];
+        handleMessage( CanMsg(frame.can_id, frame.can_dlc, frame.data) );
+    }
     return true;
 }
 
+void SocketBus::startAdditionalThreads() {
+    for(const auto& group : receiveGroups_) {
+        group->thread_ = std::thread(&SocketBus::receiveGroupWorker, this, group.get());
+        if(!tcan::setThreadPriority(group->thread_, group->options_.priority_)) {
+            MELO_WARN("Failed to set receive group thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
+        }
+        if(!tcan::setThreadAffinity(group->thread_, group->options_.cpu_)) {
+            MELO_WARN("Failed to pin receive group thread of bus %s to CPU %d:\n  %s", options_->name_.c_str(), group->options_.cpu_, strerror(errno));
+        }
+    }
+}
+
+void SocketBus::joinAdditionalThreads() {
+    for(const auto& group : receiveGroups_) {
+        if(group->thread_.joinable()) {
+            group->thread_.join();
+        }
+    }
+}
 
-bool SocketBus::writeData(std::unique_lock<std::mutex>* lock) {
+void SocketBus::receiveGroupWorker(ReceiveGroup* group) {
+    initializeWorkerThread("receive group", group->options_.priority_, group->options_.cpu_, tcan::DeadlineParameters());
+
+    while(running_) {
+        readReceiveGroup(*group, 0);
+    }
+
+    MELO_INFO("receive group thread for bus %s terminated", options_->name_.c_str());
+}
+
+unsigned int SocketBus::getNumReceiveGroupFrames(const unsigned int group) const {
+    return (group < receiveGroups_.size()) ? receiveGroups_[group]->numFrames_.load() : 0;
+}
+
+
+void SocketBus::getReceiveStatistics(ReceiveStatistics& statistics) const {
+    statistics.numBlockingReceptions_ = numBlockingReceptions_;
+    statistics.numSpinReceptions_ = numSpinReceptions_;
+    statistics.numEmptyPolls_ = numEmptyPolls_;
+}
+
+bool SocketBus::writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) {
+
+    if(!txMsgs_.empty() && outgoingMsgs_.size() > 1 && isBatchWriteAllowedWithoutLock()) {
+        return writeBatch(lock);
+    }
 
     CanMsg cmsg = outgoingMsgs_.front();
     if(lock != nullptr) {
@@ -200,10 +621,82 @@ bool SocketBus::writeData(std::unique_lock<std::mutex>* lock) {
     }
 
     hasBusError_ = false;
-    outgoingMsgs_.pop_front();
+    removeWrittenMessageWithoutLock(cmsg);
     return true;
 }
 
+bool SocketBus::writeBatch(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) {
+
+    const unsigned int numFrames = std::min(outgoingMsgs_.size(), txFrames_.size());
+    for(unsigned int i=0; i<numFrames; ++i) {
+        const CanMsg& cmsg = outgoingMsgs_[i];
+        can_frame& frame = txFrames_[i];
+        frame.can_id = cmsg.getCobId();
+        frame.can_dlc = cmsg.getLength();
+        std::copy(cmsg.getData(), &(cmsg.getData()[frame.can_dlc]), frame.data);
+    }
+
+    if(lock != nullptr) {
+        lock->unlock();
+    }
+
+    const int ret = sendmmsg(socket_, txMsgs_.data(), numFrames, sendFlag_);
+
+    if(lock != nullptr) {
+        lock->lock();
+    }
+
+    if(ret <= 0) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            MELO_ERROR("Error at sending CAN message %x on bus %s (return value=%d): (%d)\n  %s", txFrames_[0].can_id, options_->name_.c_str(), ret, errno, strerror(errno));
+            hasBusError_ = true;
+        }else{
+            hasBusError_ = false;
+        }
+        return false;
+    }
+
+    // on a partial write, the remaining messages stay in the queue
+    hasBusError_ = false;
+    outgoingMsgs_.erase(outgoingMsgs_.begin(), outgoingMsgs_.begin() + ret);
+    return true;
+}
+
+bool SocketBus::initializeIoUringEndpoint(tcan::IoUringEngine::Endpoint& endpoint) {
+    if(ring_ != nullptr || receiveMode_ != SocketBusOptions::ReceiveMode::Blocking) {
+        return false;
+    }
+
+    endpoint.fileDescriptor_ = socket_;
+    endpoint.isSocket_ = true;
+    endpoint.receiveBufferSize_ = sizeof(can_frame);
+    endpoint.transmitBufferSize_ = sizeof(can_frame);
+    return true;
+}
+
+void SocketBus::handleIoUringData(uint8_t* data, const unsigned int length) {
+    if(length != sizeof(can_frame)) {
+        MELO_WARN("Received incomplete CAN frame of %u bytes on bus %s.", length, options_->name_.c_str());
+        return;
+    }
+    can_frame frame;
+    memcpy(&frame, data, sizeof(can_frame));
+    handleFrame(frame);
+}
+
+int SocketBus::encodeIoUringMessage(const CanMsg& msg, uint8_t* buffer, const unsigned int capacity) {
+    if(capacity < sizeof(can_frame)) {
+        return -1;
+    }
+    can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = msg.getCobId();
+    frame.can_dlc = msg.getLength();
+    std::copy(msg.getData(), &(msg.getData()[frame.can_dlc]), frame.data);
+    memcpy(buffer, &frame, sizeof(can_frame));
+    return sizeof(can_frame);
+}
+
 void SocketBus::handleBusErrorMessage(const can_frame& msg) {
 
     errorMsgFlagPersistent_ = true;
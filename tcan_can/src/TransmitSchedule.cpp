@@ -0,0 +1,195 @@
+#include "tcan_can/TransmitSchedule.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace tcan_can {
+
+TransmitSchedule::Slot::Slot(const unsigned int offset, const CanMsg& msg):
+    offset_(offset),
+    msg_(msg),
+    numSent_(0),
+    minLateness_(Clock::duration::max()),
+    maxLateness_(Clock::duration::zero()),
+    sumLateness_(Clock::duration::zero())
+{
+}
+
+TransmitSchedule::TransmitSchedule(const Reference reference, const unsigned int cycleTime):
+    reference_(reference),
+    cycleTime_(cycleTime),
+    slots_(),
+    order_(),
+    isRunning_(false),
+    cycleStart_(),
+    nextSlot_(0),
+    pendingSlots_(),
+    numSkippedSlots_(0)
+{
+}
+
+unsigned int TransmitSchedule::addSlot(const unsigned int offset, const CanMsg& msg) {
+    const unsigned int index = slots_.size();
+    slots_.emplace_back(offset, msg);
+    slots_.back().msg_.setTag(getTag(index));
+    // the pending list is bounded to the number of slots, see processDueSlots(..)
+    pendingSlots_.reserve(slots_.size());
+
+    // keep order_ sorted by offset. Slots with equal offset are sent in order of insertion.
+    auto position = std::upper_bound(order_.begin(), order_.end(), index, [this](const unsigned int lhs, const unsigned int rhs) {
+        return slots_[lhs].offset_ < slots_[rhs].offset_;
+    });
+
+    // do not disturb the slot sequence of a running cycle
+    const unsigned int insertPosition = position - order_.begin();
+    order_.insert(position, index);
+    if(insertPosition < nextSlot_) {
+        ++nextSlot_;
+    }
+
+    return index;
+}
+
+bool TransmitSchedule::setSlotMessage(const unsigned int index, const CanMsg& msg) {
+    if(index >= slots_.size()) {
+        return false;
+    }
+    slots_[index].msg_ = msg;
+    slots_[index].msg_.setTag(getTag(index));
+    return true;
+}
+
+bool TransmitSchedule::start(const Clock::time_point& cycleStart) {
+    if(reference_ == Reference::Cycle && cycleTime_.count() == 0) {
+        return false;
+    }
+
+    isRunning_ = true;
+    cycleStart_ = cycleStart;
+    pendingSlots_.clear();
+
+    // with reference Sync, wait for the first SYNC
+    nextSlot_ = (reference_ == Reference::Cycle) ? 0 : order_.size();
+    return true;
+}
+
+void TransmitSchedule::stop() {
+    isRunning_ = false;
+    pendingSlots_.clear();
+}
+
+void TransmitSchedule::trigger(const Clock::time_point& syncTime) {
+    if(!isRunning_ || reference_ != Reference::Sync) {
+        return;
+    }
+
+    numSkippedSlots_ += order_.size() - nextSlot_;
+    cycleStart_ = syncTime;
+    nextSlot_ = 0;
+}
+
+unsigned int TransmitSchedule::queueDueMessages(const Clock::time_point& now, MsgQueue& queue, const unsigned int maxQueueSize,
+                                                Clock::time_point& wakeupTime) {
+    return processDueSlots(now, &queue, maxQueueSize, wakeupTime);
+}
+
+void TransmitSchedule::skipDueMessages(const Clock::time_point& now, Clock::time_point& wakeupTime) {
+    numSkippedSlots_ += processDueSlots(now, nullptr, 0, wakeupTime);
+}
+
+unsigned int TransmitSchedule::processDueSlots(const Clock::time_point& now, MsgQueue* queue, const unsigned int maxQueueSize,
+                                               Clock::time_point& wakeupTime) {
+    unsigned int numDue = 0;
+
+    while(isRunning_ && !order_.empty()) {
+        if(nextSlot_ >= order_.size()) {
+            if(reference_ == Reference::Sync) {
+                break; // wait for the next SYNC
+            }
+            cycleStart_ += cycleTime_;
+            nextSlot_ = 0;
+        }
+
+        const unsigned int index = order_[nextSlot_];
+        const Clock::time_point slotTime = cycleStart_ + slots_[index].offset_;
+        if(slotTime > now) {
+            wakeupTime = std::min(wakeupTime, slotTime);
+            break;
+        }
+
+        ++nextSlot_;
+
+        if(cycleTime_.count() != 0 && (reference_ == Reference::Cycle ? (now - slotTime >= cycleTime_) : (slots_[index].offset_ >= cycleTime_))) {
+            // more than one cycle late (e.g. after the transmit thread was stalled) or outside of the SYNC window
+            ++numSkippedSlots_;
+            continue;
+        }
+
+        if(queue != nullptr) {
+            if(queue->size() >= maxQueueSize) {
+                // the bus is stalled, do not grow the queue
+                ++numSkippedSlots_;
+                continue;
+            }
+            queue->insert(queue->begin() + numDue, slots_[index].msg_);
+
+            // bound the pending list in case messages are dropped without being written
+            if(pendingSlots_.size() >= slots_.size()) {
+                pendingSlots_.pop_front();
+            }
+            pendingSlots_.push_back({index, slotTime});
+        }
+        ++numDue;
+    }
+
+    return numDue;
+}
+
+void TransmitSchedule::handleMessageWritten(const uint16_t tag, const Clock::time_point& now) {
+    if(tag == 0) {
+        return;
+    }
+
+    // messages of other slots may have been dropped or held back by a transmit limit
+    auto pending = std::find_if(pendingSlots_.begin(), pendingSlots_.end(), [tag](const PendingSlot& slot) {
+        return getTag(slot.index_) == tag;
+    });
+    if(pending == pendingSlots_.end()) {
+        return;
+    }
+
+    Slot& slot = slots_[pending->index_];
+    const Clock::duration lateness = now - pending->slotTime_;
+    ++slot.numSent_;
+    slot.minLateness_ = std::min(slot.minLateness_, lateness);
+    slot.maxLateness_ = std::max(slot.maxLateness_, lateness);
+    slot.sumLateness_ += lateness;
+
+    pendingSlots_.erase(pending);
+}
+
+bool TransmitSchedule::getSlotStatistics(const unsigned int index, ScheduleSlotStatistics& statistics) const {
+    if(index >= slots_.size()) {
+        return false;
+    }
+
+    using Microseconds = std::chrono::duration<double, std::micro>;
+    const Slot& slot = slots_[index];
+    statistics.numSent_ = slot.numSent_;
+    if(slot.numSent_ == 0) {
+        statistics.minLateness_ = statistics.maxLateness_ = statistics.meanLateness_ = 0.0;
+        return true;
+    }
+
+    statistics.minLateness_ = Microseconds(slot.minLateness_).count();
+    statistics.maxLateness_ = Microseconds(slot.maxLateness_).count();
+    statistics.meanLateness_ = Microseconds(slot.sumLateness_).count() / slot.numSent_;
+    return true;
+}
+
+uint16_t TransmitSchedule::getTag(const unsigned int index) {
+    // slots beyond the range of the tag are sent without statistics
+    return (index < std::numeric_limits<uint16_t>::max()) ? static_cast<uint16_t>(index + 1) : 0;
+}
+
+} /* namespace tcan_can */
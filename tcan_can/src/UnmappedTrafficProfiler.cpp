@@ -0,0 +1,77 @@
+#include "tcan_can/UnmappedTrafficProfiler.hpp"
+#include "tcan/helper_functions.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tcan_can {
+
+constexpr uint32_t UnmappedTrafficProfiler::emptyCobId;
+
+UnmappedTrafficProfiler::UnmappedTrafficProfiler(const unsigned int capacity):
+    slots_(new Slot[tcan::roundUpToPowerOfTwo(std::max(1u, capacity))]),
+    mask_(tcan::roundUpToPowerOfTwo(std::max(1u, capacity)) - 1),
+    numFrames_(0),
+    numOverflowFrames_(0),
+    lastEntriesTime_(tcan::Clock::now())
+{
+}
+
+void UnmappedTrafficProfiler::record(const CanMsg& msg) {
+    numFrames_.fetch_add(1, std::memory_order_relaxed);
+
+    const uint32_t cobId = msg.getCobId();
+    // Fibonacci hashing spreads consecutive node ids over the table
+    unsigned int index = static_cast<unsigned int>((cobId * 2654435761u) >> 16) & mask_;
+    for(unsigned int probe=0; probe<=mask_; ++probe, index=(index + 1) & mask_) {
+        Slot& slot = slots_[index];
+        uint32_t slotCobId = slot.cobId_.load(std::memory_order_acquire);
+        if(slotCobId == emptyCobId) {
+            // claim the slot. If another receive thread was faster, check whether it claimed it for the same identifier.
+            if(!slot.cobId_.compare_exchange_strong(slotCobId, cobId, std::memory_order_acq_rel) && slotCobId != cobId) {
+                continue;
+            }
+        }else if(slotCobId != cobId) {
+            continue;
+        }
+
+        uint64_t data = 0;
+        std::memcpy(&data, msg.getData(), std::min<std::size_t>(msg.getLength(), sizeof(data)));
+        slot.data_.store(data, std::memory_order_relaxed);
+        slot.length_.store(msg.getLength(), std::memory_order_relaxed);
+        slot.numFrames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    numOverflowFrames_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<UnmappedTrafficProfiler::Entry> UnmappedTrafficProfiler::getEntries(const Clock::time_point& now) {
+    const double interval = std::chrono::duration<double>(now - lastEntriesTime_).count();
+    lastEntriesTime_ = now;
+
+    std::vector<Entry> entries;
+    for(unsigned int i=0; i<=mask_; ++i) {
+        Slot& slot = slots_[i];
+        const uint32_t cobId = slot.cobId_.load(std::memory_order_acquire);
+        if(cobId == emptyCobId) {
+            continue;
+        }
+
+        Entry entry;
+        entry.cobId_ = cobId;
+        entry.numFrames_ = slot.numFrames_.load(std::memory_order_relaxed);
+        entry.numNewFrames_ = entry.numFrames_ - slot.numReportedFrames_;
+        entry.rate_ = (interval > 0.0) ? entry.numNewFrames_ / interval : 0.0;
+        entry.length_ = slot.length_.load(std::memory_order_relaxed);
+        const uint64_t data = slot.data_.load(std::memory_order_relaxed);
+        std::memcpy(entry.data_, &data, sizeof(entry.data_));
+        slot.numReportedFrames_ = entry.numFrames_;
+        entries.push_back(entry);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.cobId_ < b.cobId_; });
+    return entries;
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <tcan/AllocationTracker.hpp>
+#include <tcan/CycleRunner.hpp>
+#include <tcan_can/CanBusManager.hpp>
+#include <tcan_can/SocketBus.hpp>
+#include <tcan_ip/IpBusManager.hpp>
+
+// The tests run the cyclic path of the CAN backends for some cycles to reach the steady state, and then check that the real-time
+// threads do not allocate memory anymore.
+
+static constexpr unsigned int numWarmupCycles = 100;
+static constexpr unsigned int numCycles = 1000;
+
+struct BarDevice : public tcan_can::CanDevice {
+	template<typename... Args>
+	explicit BarDevice(Args&&... args) : tcan_can::CanDevice(std::forward<Args>(args)...) {}
+	bool initDevice() override { return true; }
+	bool configureDevice(const tcan_can::CanMsg& /*msg*/) override { return true; }
+
+	bool callMe(const tcan_can::CanMsg& /*msg*/) {
+		++numCalls;
+		return true;
+	}
+
+	std::atomic<unsigned int> numCalls{0};
+};
+
+struct FakeBus : public tcan_can::CanBus {
+	explicit FakeBus(std::unique_ptr<tcan_can::CanBusOptions>&& options) : tcan_can::CanBus(std::move(options)) {}
+
+	unsigned int numWritten = 0;
+
+protected:
+	bool initializeInterface() override { return true; }
+	bool readData() override {
+		handleMessage(tcan_can::CanMsg{0x181, {1, 2, 3, 4}});
+		return false;
+	}
+	bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* /*lock*/) override {
+		outgoingMsgs_.pop_front();
+		++numWritten;
+		return true;
+	}
+};
+
+// SocketBus on one end of a datagram socket pair instead of a CAN interface
+struct PairedSocketBus : public tcan_can::SocketBus {
+	PairedSocketBus(std::unique_ptr<tcan_can::SocketBusOptions>&& options, const int socket) :
+		tcan_can::SocketBus(std::move(options)), pairedSocket(socket) {}
+
+protected:
+	bool initializeInterface() override {
+		socket_ = pairedSocket;
+		recvFlag_ = MSG_DONTWAIT;
+		sendFlag_ = MSG_DONTWAIT;
+		return true;
+	}
+
+	const int pairedSocket;
+};
+
+// IpBus counting the received bytes
+struct CountingIpBus : public tcan_ip::IpBus {
+	using tcan_ip::IpBus::IpBus;
+
+	void handleMessage(const tcan_ip::IpMsg& msg) override {
+		numReceivedBytes += msg.getLength();
+	}
+
+	unsigned int numReceivedBytes = 0;
+};
+
+class SteadyState {
+public:
+	explicit SteadyState(const bool trackCallingThread) : trackCallingThread_(trackCallingThread) {
+		tcan::markRealtimeThread(trackCallingThread_);
+		tcan::AllocationTracker::markSteadyState();
+	}
+
+	~SteadyState() {
+		stop();
+	}
+
+	void stop() {
+		tcan::AllocationTracker::stopRecording();
+		if(trackCallingThread_) {
+			tcan::markRealtimeThread(false);
+		}
+	}
+
+private:
+	const bool trackCallingThread_;
+};
+
+void sendFrames(const int socket, const unsigned int numFrames) {
+	can_frame frame{};
+	frame.can_id = 0x181;
+	frame.can_dlc = 4;
+	for(unsigned int i=0; i<numFrames; i++) {
+		ASSERT_EQ(static_cast<int>(sizeof(can_frame)), send(socket, &frame, sizeof(can_frame), 0));
+	}
+}
+
+unsigned int receiveFrames(const int socket) {
+	can_frame frame{};
+	unsigned int numFrames = 0;
+	while(recv(socket, &frame, sizeof(can_frame), MSG_DONTWAIT) == static_cast<int>(sizeof(can_frame))) {
+		++numFrames;
+	}
+	return numFrames;
+}
+
+TEST(allocation_free, synchronous_can_bus) {
+	auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->transmitLimits_.emplace(0x202, tcan_can::TransmitLimit{0, 1e7, 100}); // token bucket, never exhausted
+	FakeBus* bus = new FakeBus(std::move(options));
+	BarDevice* dev = new BarDevice(0x181, "Bar");
+
+	tcan_can::CanBusManager manager;
+	ASSERT_TRUE(manager.addBus(bus));
+	ASSERT_TRUE(bus->addDevice(dev));
+	ASSERT_TRUE(bus->addCanMessage(0x181, dev, &BarDevice::callMe));
+
+	auto cycle = [&]() {
+		manager.readMessagesSynchronous();
+		manager.sanityCheckSynchronous();
+		bus->sendMessage(tcan_can::CanMsg{0x201, {1, 2, 3, 4, 5, 6, 7, 8}});
+		bus->sendMessage(tcan_can::CanMsg{0x202, {1, 2}});
+		manager.writeMessagesSynchronous();
+	};
+
+	for(unsigned int i=0; i<numWarmupCycles; i++) {
+		cycle();
+	}
+
+	SteadyState steadyState(true);
+	for(unsigned int i=0; i<numCycles; i++) {
+		cycle();
+	}
+	steadyState.stop();
+
+	EXPECT_EQ(0u, tcan::AllocationTracker::getNumAllocations()) << tcan::AllocationTracker::getReport();
+	EXPECT_EQ(numWarmupCycles + numCycles, dev->numCalls);
+	EXPECT_EQ(2*(numWarmupCycles + numCycles), bus->numWritten);
+}
+
+TEST(allocation_free, cycle_runner) {
+	auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	FakeBus* bus = new FakeBus(std::move(options));
+	BarDevice* dev = new BarDevice(0x181, "Bar");
+
+	tcan_can::CanBusManager manager;
+	ASSERT_TRUE(manager.addBus(bus));
+	ASSERT_TRUE(bus->addDevice(dev));
+	ASSERT_TRUE(bus->addCanMessage(0x181, dev, &BarDevice::callMe));
+
+	tcan::CycleRunnerOptions runnerOptions(100);
+	tcan::CycleRunner<tcan_can::CanMsg> runner(manager, runnerOptions);
+	std::atomic<unsigned int> numCallbacks{0};
+	runner.setCycleCallback([&]() {
+		bus->sendMessage(tcan_can::CanMsg{0x201, {1, 2, 3, 4}});
+		if(++numCallbacks == numWarmupCycles) {
+			tcan::AllocationTracker::markSteadyState();
+		}else if(numCallbacks == numWarmupCycles + numCycles) {
+			tcan::AllocationTracker::stopRecording();
+			runner.stop();
+		}
+	});
+
+	// run() marks the calling thread while the cycles run
+	SteadyState steadyState(false);
+	ASSERT_TRUE(runner.run());
+	steadyState.stop();
+
+	EXPECT_EQ(0u, tcan::AllocationTracker::getNumAllocations()) << tcan::AllocationTracker::getReport();
+	EXPECT_FALSE(tcan::isRealtimeThread());
+}
+
+TEST(allocation_free, synchronous_socket_bus) {
+	int sockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+
+	for(const unsigned int batchSize : {1u, 8u}) {
+		auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+		options->mode_ = tcan::BusOptions::Mode::Synchronous;
+		options->batchSize_ = batchSize;
+		PairedSocketBus* bus = new PairedSocketBus(std::move(options), sockets[0]);
+		BarDevice* dev = new BarDevice(0x181, "Bar");
+
+		tcan_can::CanBusManager manager;
+		ASSERT_TRUE(manager.addBus(bus));
+		ASSERT_TRUE(bus->addDevice(dev));
+		ASSERT_TRUE(bus->addCanMessage(0x181, dev, &BarDevice::callMe));
+
+		unsigned int numReceivedByPeer = 0;
+		auto cycle = [&]() {
+			sendFrames(sockets[1], 4);
+			manager.readMessagesSynchronous();
+			manager.sanityCheckSynchronous();
+			for(unsigned int i=0; i<4; i++) {
+				bus->sendMessage(tcan_can::CanMsg{0x201, {1, 2, 3, 4, 5, 6, 7, 8}});
+			}
+			manager.writeMessagesSynchronous();
+			numReceivedByPeer += receiveFrames(sockets[1]);
+		};
+
+		for(unsigned int i=0; i<numWarmupCycles; i++) {
+			cycle();
+		}
+
+		SteadyState steadyState(true);
+		for(unsigned int i=0; i<numCycles; i++) {
+			cycle();
+		}
+		steadyState.stop();
+
+		EXPECT_EQ(0u, tcan::AllocationTracker::getNumAllocations()) << "batch size " << batchSize << ": " << tcan::AllocationTracker::getReport();
+		EXPECT_EQ(4*(numWarmupCycles + numCycles), dev->numCalls);
+		EXPECT_EQ(4*(numWarmupCycles + numCycles), numReceivedByPeer);
+
+		// the bus manager closes the socket
+		ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+	}
+
+	close(sockets[0]);
+	close(sockets[1]);
+}
+
+TEST(allocation_free, semi_synchronous_receive_thread) {
+	int sockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::SemiSynchronous;
+	options->sanityCheckInterval_ = 10;
+	PairedSocketBus* bus = new PairedSocketBus(std::move(options), sockets[0]);
+	BarDevice* dev = new BarDevice(0x181, "Bar");
+
+	tcan_can::CanBusManager manager;
+	ASSERT_TRUE(manager.addBus(bus));
+	ASSERT_TRUE(bus->addDevice(dev));
+	ASSERT_TRUE(bus->addCanMessage(0x181, dev, &BarDevice::callMe));
+	manager.startThreads();
+
+	auto waitForCallbacks = [&](const unsigned int numCalls) {
+		const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while(dev->numCalls < numCalls && std::chrono::steady_clock::now() < timeout) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	};
+
+	sendFrames(sockets[1], numWarmupCycles);
+	waitForCallbacks(numWarmupCycles);
+
+	// the calling thread is not tracked, only the receive and sanity check threads of the bus manager
+	SteadyState steadyState(false);
+	for(unsigned int i=0; i<10; i++) {
+		sendFrames(sockets[1], numCycles/10);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	waitForCallbacks(numWarmupCycles + numCycles);
+	steadyState.stop();
+
+	EXPECT_EQ(0u, tcan::AllocationTracker::getNumAllocations()) << tcan::AllocationTracker::getReport();
+	EXPECT_EQ(numWarmupCycles + numCycles, dev->numCalls);
+
+	manager.closeBuses();
+	close(sockets[1]);
+}
+
+TEST(allocation_free, synchronous_ip_bus) {
+	// loopback TCP server the bus connects to
+	const int server = socket(AF_INET, SOCK_STREAM, 0);
+	ASSERT_LE(0, server);
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	socklen_t addressLength = sizeof(address);
+	ASSERT_EQ(0, bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+	ASSERT_EQ(0, listen(server, 1));
+	ASSERT_EQ(0, getsockname(server, reinterpret_cast<sockaddr*>(&address), &addressLength));
+
+	auto options = std::make_unique<tcan_ip::IpBusOptions>("127.0.0.1", ntohs(address.sin_port));
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->maxDeviceTimeoutCounter_ = 0;
+	CountingIpBus* bus = new CountingIpBus(std::move(options));
+
+	tcan_ip::IpBusManager manager;
+	ASSERT_TRUE(manager.addBus(bus));
+	const int peer = accept(server, nullptr, nullptr);
+	ASSERT_LE(0, peer);
+
+	// the received chunks are longer than the inline buffer of the messages, the sent messages fit into it
+	const std::vector<uint8_t> request(100, 0x42);
+	const tcan_ip::IpMsg response(tcan_ip::IpMsg::InlineCapacity, request.data());
+	unsigned int numReceivedByPeer = 0;
+	auto cycle = [&]() {
+		ASSERT_EQ(static_cast<ssize_t>(request.size()), send(peer, request.data(), request.size(), 0));
+		manager.readMessagesSynchronous();
+		manager.sanityCheckSynchronous();
+		bus->sendMessage(response);
+		manager.writeMessagesSynchronous();
+		uint8_t buffer[256];
+		ssize_t length;
+		while((length = recv(peer, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+			numReceivedByPeer += length;
+		}
+	};
+
+	for(unsigned int i=0; i<numWarmupCycles; i++) {
+		cycle();
+	}
+
+	SteadyState steadyState(true);
+	for(unsigned int i=0; i<numCycles; i++) {
+		cycle();
+	}
+	steadyState.stop();
+
+	EXPECT_EQ(0u, tcan::AllocationTracker::getNumAllocations()) << tcan::AllocationTracker::getReport();
+	EXPECT_EQ((numWarmupCycles + numCycles)*request.size(), bus->numReceivedBytes);
+	EXPECT_EQ((numWarmupCycles + numCycles)*tcan_ip::IpMsg::InlineCapacity, numReceivedByPeer);
+
+	close(peer);
+	close(server);
+}
+
+int main(int argc, char* argv[]) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -1,5 +1,20 @@
 #include <gtest/gtest.h>
 
+#include <linux/if_packet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <tcan/BusManager.hpp>
+#include <tcan/Clock.hpp>
+#include <tcan/CycleRunner.hpp>
+#include <tcan/RcuPointer.hpp>
+#include <tcan_can/DeviceCanOpen.hpp>
+#include <tcan_can/IsoTpChannel.hpp>
+#include <tcan_can/LssMaster.hpp>
 #include <tcan_can/SocketBus.hpp>
 
 struct BarDevice : public tcan_can::CanDevice {
@@ -10,6 +25,7 @@ struct BarDevice : public tcan_can::CanDevice {
 
 	bool callMe(const tcan_can::CanMsg& /*msg*/) {
 		isCalled = true;
+		++numCalls;
 		return true;
 	}
 
@@ -19,10 +35,170 @@ struct BarDevice : public tcan_can::CanDevice {
 		return wasCalled;
 	}
 
+	unsigned int numCalls = 0;
+
 private:
 	bool isCalled = false;
 };
 
+struct FakeBus : public tcan_can::CanBus {
+	explicit FakeBus(std::unique_ptr<tcan_can::CanBusOptions>&& options) : tcan_can::CanBus(std::move(options)) {}
+
+	unsigned int writeAll() {
+		unsigned int numWritten = 0;
+		while(hasMessageToWriteWithoutLock()) {
+			writeMessages(nullptr);
+			++numWritten;
+		}
+		return numWritten;
+	}
+
+	std::vector<uint32_t> written;
+
+protected:
+	bool initializeInterface() override { return true; }
+	bool readData() override { return false; }
+	bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* /*lock*/) override {
+		written.push_back(outgoingMsgs_.front().getCobId());
+		outgoingMsgs_.pop_front();
+		return true;
+	}
+};
+
+// fake bus which hands the written frames to another bus
+struct LinkedBus : public FakeBus {
+	using FakeBus::FakeBus;
+
+	LinkedBus* peer = nullptr;
+	std::vector<tcan_can::CanMsg> frames;
+
+protected:
+	bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) override {
+		frames.push_back(outgoingMsgs_.front());
+		FakeBus::writeData(lock);
+		peer->handleMessage(frames.back());
+		return true;
+	}
+};
+
+// bus with a slow initialization, e.g. a network connect
+struct SlowInitBus : public FakeBus {
+	SlowInitBus(const std::string& name, const unsigned int initTimeMs, const bool initResult) :
+		FakeBus(std::make_unique<tcan_can::CanBusOptions>(name)), initTimeMs(initTimeMs), initResult(initResult) {}
+
+	const unsigned int initTimeMs;
+	const bool initResult;
+
+protected:
+	bool initializeInterface() override {
+		std::this_thread::sleep_for(std::chrono::milliseconds(initTimeMs));
+		return initResult;
+	}
+};
+
+// SocketBus on one end of a datagram socket pair instead of a CAN interface
+struct PairedSocketBus : public tcan_can::SocketBus {
+	PairedSocketBus(std::unique_ptr<tcan_can::SocketBusOptions>&& options, const int socket) : tcan_can::SocketBus(std::move(options)) {
+		socket_ = socket;
+		recvFlag_ = MSG_DONTWAIT;
+		sendFlag_ = MSG_DONTWAIT;
+	}
+
+	using tcan_can::SocketBus::readData;
+	using tcan_can::SocketBus::outgoingMsgs_;
+};
+
+// PairedSocketBus which applies the receive mode of its options like SocketBus::initializeInterface() in asynchronous mode
+struct ReceiveModeSocketBus : public PairedSocketBus {
+	ReceiveModeSocketBus(std::unique_ptr<tcan_can::SocketBusOptions>&& options, const int socket) : PairedSocketBus(std::move(options), socket) {
+		const auto* socketOptions = static_cast<const tcan_can::SocketBusOptions*>(options_.get());
+		receiveMode_ = socketOptions->receiveMode_;
+		hybridSpinWindow_ = std::chrono::microseconds(socketOptions->hybridSpinWindow_);
+		recvFlag_ = (receiveMode_ == tcan_can::SocketBusOptions::ReceiveMode::BusyPoll) ? MSG_DONTWAIT : 0;
+	}
+};
+
+// PairedSocketBus reading from a receive ring in memory, filled by the test instead of the kernel
+struct RingSocketBus : public PairedSocketBus {
+	RingSocketBus(std::unique_ptr<tcan_can::SocketBusOptions>&& options, const int socket, uint8_t* ring) : PairedSocketBus(std::move(options), socket) {
+		ring_ = ring;
+		ringBlockIndex_ = 0;
+	}
+
+	~RingSocketBus() override {
+		ring_ = nullptr; // not mapped
+	}
+};
+
+// PairedSocketBus whose first receive group reads from a second socket pair
+struct GroupedSocketBus : public PairedSocketBus {
+	GroupedSocketBus(std::unique_ptr<tcan_can::SocketBusOptions>&& options, const int socket, const int groupSocket) : PairedSocketBus(std::move(options), socket) {
+		receiveGroups_[0]->socket_ = groupSocket;
+		initializePollSocket();
+	}
+};
+
+// PairedSocketBus added to a bus manager, whose initialization keeps the socket pair. Reads blocking like an asynchronous SocketBus,
+// with a timeout such that the receive thread of the fallback without io_uring terminates.
+struct ManagedSocketBus : public PairedSocketBus {
+	ManagedSocketBus(std::unique_ptr<tcan_can::SocketBusOptions>&& options, const int socket) : PairedSocketBus(std::move(options), socket) {
+		recvFlag_ = 0;
+		const timeval timeout{0, 100000};
+		setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	}
+
+protected:
+	bool initializeInterface() override { return true; }
+};
+
+// counts the received frames, which are handled by a bus thread or the io_uring engine
+struct ReceptionCounter : public BarDevice {
+	using BarDevice::BarDevice;
+
+	bool count(const tcan_can::CanMsg& /*msg*/) {
+		++numReceived;
+		return true;
+	}
+
+	bool waitForReceived(const unsigned int num) {
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while(numReceived < num && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return numReceived == num;
+	}
+
+	std::atomic<unsigned int> numReceived{0};
+};
+
+// records the order of the received frames
+struct RecordingDevice : public BarDevice {
+	using BarDevice::BarDevice;
+
+	bool record(const tcan_can::CanMsg& msg) {
+		received.push_back(msg.getCobId());
+		return true;
+	}
+
+	std::vector<uint32_t> received;
+};
+
+// device with a callback which takes a while
+struct SlowDevice : public BarDevice {
+	using BarDevice::BarDevice;
+
+	bool sleep(const tcan_can::CanMsg& /*msg*/) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		return true;
+	}
+};
+
+std::unique_ptr<tcan_can::CanBusOptions> synchronousOptions() {
+	auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	return options;
+}
+
 TEST(can_bus, handle_exact_cob) {
 	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
 	BarDevice dev {0x123, "Bar"};
@@ -56,6 +232,1316 @@ TEST(can_bus, handle_cob_mask) {
 	ASSERT_TRUE(dev.wasCalled());
 }
 
+TEST(can_bus, unmapped_traffic_profiler) {
+	auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+	options->unmappedTrafficTableSize_ = 2;
+	FakeBus bus { std::move(options) };
+	BarDevice dev {0x123, "Bar"};
+	bus.addCanMessage(0x181, &dev, &BarDevice::callMe);
+
+	ASSERT_TRUE(bus.getUnmappedTrafficReport().empty());
+
+	for(int i=0; i<3; i++) {
+		bus.handleMessage(tcan_can::CanMsg{0x701, {static_cast<uint8_t>(i)}});
+	}
+	bus.handleMessage(tcan_can::CanMsg{0x181});
+	bus.handleMessage(tcan_can::CanMsg{0x702});
+	bus.handleMessage(tcan_can::CanMsg{0x703}); // exceeds the table
+	ASSERT_TRUE(dev.wasCalled());
+	ASSERT_EQ(5u, bus.getUnmappedTrafficProfiler().getNumFrames());
+	ASSERT_EQ(1u, bus.getUnmappedTrafficProfiler().getNumOverflowFrames());
+
+	const std::string report = bus.getUnmappedTrafficReport();
+	ASSERT_NE(std::string::npos, report.find("COB_ID 0x701: 3 frames")) << report;
+	ASSERT_NE(std::string::npos, report.find("last payload: 0x02")) << report;
+	ASSERT_NE(std::string::npos, report.find("COB_ID 0x702: 1 frames")) << report;
+	ASSERT_NE(std::string::npos, report.find("{0x181, 0xFFFFFFFF}")) << report;
+
+	// only identifiers with new frames are reported
+	ASSERT_TRUE(bus.getUnmappedTrafficReport().empty());
+	bus.handleMessage(tcan_can::CanMsg{0x702});
+	const auto entries = bus.getUnmappedTrafficProfiler().getEntries();
+	ASSERT_EQ(2u, entries.size());
+	ASSERT_EQ(0x701u, entries[0].cobId_);
+	ASSERT_EQ(0u, entries[0].numNewFrames_);
+	ASSERT_EQ(2u, entries[1].numFrames_);
+	ASSERT_EQ(1u, entries[1].numNewFrames_);
+}
+
+TEST(can_bus, callback_profiling) {
+	// disabled by default
+	{
+		FakeBus bus { std::make_unique<tcan_can::CanBusOptions>("Foo") };
+		BarDevice dev {0x123, "Bar"};
+		bus.addCanMessage(0x181, &dev, &BarDevice::callMe);
+		ASSERT_EQ(nullptr, bus.getCallbackProfile(tcan_can::CanBus::CanFrameIdentifier{0x181}));
+		ASSERT_TRUE(bus.getCallbackProfileReport().empty());
+	}
+
+	auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+	options->profileCallbacks_ = true;
+	options->slowCallbackThreshold_ = 1000;
+	FakeBus bus { std::move(options) };
+	SlowDevice dev {0x123, "Slow"};
+	bus.addCanMessage(0x181, &dev, &SlowDevice::callMe);
+	bus.addCanMessage(0x281, &dev, &SlowDevice::sleep);
+
+	for(int i=0; i<3; i++) {
+		bus.handleMessage(tcan_can::CanMsg{0x181});
+	}
+	bus.handleMessage(tcan_can::CanMsg{0x281});
+
+	const auto fastProfile = bus.getCallbackProfile(tcan_can::CanBus::CanFrameIdentifier{0x181});
+	const auto slowProfile = bus.getCallbackProfile(tcan_can::CanBus::CanFrameIdentifier{0x281});
+	const auto deviceProfile = bus.getDeviceCallbackProfile(&dev);
+	ASSERT_NE(nullptr, fastProfile);
+	ASSERT_NE(nullptr, slowProfile);
+	ASSERT_NE(nullptr, deviceProfile);
+	ASSERT_EQ(3u, fastProfile->getHistogram().getNumSamples());
+	ASSERT_EQ(0u, fastProfile->getNumSlowCalls());
+	ASSERT_EQ(1u, slowProfile->getNumSlowCalls());
+	ASSERT_GE(slowProfile->getMaxSlowCallDuration(), 2000.0);
+	ASSERT_EQ(4u, deviceProfile->getHistogram().getNumSamples());
+	ASSERT_EQ(1u, deviceProfile->getNumSlowCalls());
+	// the histogram is assembled from the counters of the profile
+	const tcan::ExecutionTimeHistogram slowHistogram = slowProfile->getHistogram();
+	ASSERT_DOUBLE_EQ(slowHistogram.getMin(), slowHistogram.getMax());
+	ASSERT_DOUBLE_EQ(slowProfile->getMaxSlowCallDuration(), slowHistogram.getMax());
+	ASSERT_EQ(1u, slowHistogram.getNumOverflows()); // beyond the default range of 200us
+
+	// the slowest callback is reported first
+	const std::string report = bus.getCallbackProfileReport();
+	ASSERT_LT(report.find("COB_ID 0x281/0xFFFFFFFF (Slow): n=1"), report.find("COB_ID 0x181/0xFFFFFFFF (Slow): n=3")) << report;
+	ASSERT_NE(std::string::npos, report.find("device Slow: n=4")) << report;
+
+	// the alarm of the sanity check consumes the new slow calls
+	bus.sanityCheck();
+	ASSERT_EQ(0u, slowProfile->takeNumNewSlowCalls());
+	ASSERT_EQ(1u, slowProfile->getNumSlowCalls());
+}
+
+TEST(can_bus, trace_recorder) {
+	const std::string filename = "/tmp/tcan_test_trace_" + std::to_string(getpid()) + ".json";
+	auto options = std::make_unique<tcan_can::CanBusOptions>("TraceBus");
+	options->maxQueueSize_ = 2;
+	FakeBus bus { std::move(options) };
+	BarDevice dev {0x123, "Bar"};
+	bus.addCanMessage(0x181, &dev, &BarDevice::callMe);
+
+	// nothing is recorded before start
+	bus.handleMessage(tcan_can::CanMsg{0x181});
+	ASSERT_FALSE(tcan::TraceRecorder::isEnabled());
+
+	ASSERT_TRUE(tcan::TraceRecorder::start(filename));
+	ASSERT_TRUE(tcan::TraceRecorder::isEnabled());
+	bus.sendSync();
+	bus.sendMessage(tcan_can::CanMsg{0x201});
+	ASSERT_FALSE(bus.sendMessage(tcan_can::CanMsg{0x202}));
+	ASSERT_EQ(2u, bus.writeAll());
+	bus.handleMessage(tcan_can::CanMsg{0x182});
+	bus.handleMessage(tcan_can::CanMsg{0x80});
+	bus.sanityCheck();
+	// the events of a thread which exited are still written
+	std::thread thread([&bus]() {
+		tcan::TraceRecorder::registerThread();
+		bus.handleMessage(tcan_can::CanMsg{0x183});
+	});
+	thread.join();
+	tcan::TraceRecorder::stop();
+	ASSERT_FALSE(tcan::TraceRecorder::isEnabled());
+	ASSERT_EQ(0u, tcan::TraceRecorder::getNumDroppedEvents());
+
+	std::ifstream file(filename);
+	std::stringstream trace;
+	trace << file.rdbuf();
+	std::remove(filename.c_str());
+	const std::string json = trace.str();
+	ASSERT_EQ('[', json.front());
+	ASSERT_EQ("]\n", json.substr(json.size() - 2));
+	ASSERT_NE(std::string::npos, json.find("\"name\":\"thread_name\"")) << json;
+	ASSERT_NE(std::string::npos, json.find("{\"name\":\"SYNC queued\",\"cat\":\"TraceBus\",\"ph\":\"i\"")) << json;
+	ASSERT_NE(std::string::npos, json.find("\"args\":{\"id\":\"0x201\"}")) << json;
+	// the dropped message is only traced as dropped
+	const std::string dropped = "\"args\":{\"id\":\"0x202\"}";
+	const std::size_t drop = json.find("{\"name\":\"drop\",\"cat\":\"TraceBus\",\"ph\":\"i\"");
+	ASSERT_NE(std::string::npos, drop) << json;
+	ASSERT_EQ(json.find(dropped), json.find(dropped, drop)) << json;
+	ASSERT_EQ(std::string::npos, json.find(dropped, json.find(dropped) + 1)) << json;
+	ASSERT_NE(std::string::npos, json.find("{\"name\":\"write\",\"cat\":\"TraceBus\",\"ph\":\"X\"")) << json;
+	ASSERT_NE(std::string::npos, json.find("{\"name\":\"dispatch\"")) << json;
+	ASSERT_NE(std::string::npos, json.find("\"args\":{\"id\":\"0x182\"}")) << json;
+	ASSERT_NE(std::string::npos, json.find("\"args\":{\"id\":\"0x183\"}")) << json;
+	ASSERT_EQ(std::string::npos, json.find("\"args\":{\"id\":\"0x181\"}")) << json;
+	ASSERT_NE(std::string::npos, json.find("{\"name\":\"SYNC received\"")) << json;
+	ASSERT_NE(std::string::npos, json.find("{\"name\":\"sanity check\"")) << json;
+}
+
+TEST(can_bus, transmit_inhibit_time) {
+	auto options = synchronousOptions();
+	options->transmitLimits_.emplace(0x201, tcan_can::TransmitLimit{10000000}); // 10s
+	FakeBus bus { std::move(options) };
+
+	bus.sendMessage(tcan_can::CanMsg{0x201});
+	bus.sendMessage(tcan_can::CanMsg{0x201});
+	bus.sendMessage(tcan_can::CanMsg{0x301});
+
+	ASSERT_EQ(2u, bus.writeAll());
+	ASSERT_EQ((std::vector<uint32_t>{0x201, 0x301}), bus.written);
+	ASSERT_EQ(1u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_EQ(1u, bus.getNumThrottlingEvents());
+	ASSERT_EQ(1u, bus.getNumThrottlingEvents(0x201));
+
+	// the held back message is not counted twice
+	ASSERT_EQ(0u, bus.writeAll());
+	ASSERT_EQ(1u, bus.getNumThrottlingEvents());
+
+	bus.removeTransmitLimit(0x201);
+	ASSERT_EQ(1u, bus.writeAll());
+	ASSERT_EQ(0u, bus.getNumOutgoingMessagesWithoutLock());
+}
+
+TEST(can_bus, transmit_token_bucket) {
+	FakeBus bus { synchronousOptions() };
+	bus.setTransmitLimit(0x181, tcan_can::TransmitLimit{0, 0.1, 3});
+
+	for(unsigned int i=0; i<5; ++i) {
+		bus.sendMessage(tcan_can::CanMsg{0x181});
+	}
+
+	ASSERT_EQ(3u, bus.writeAll());
+	ASSERT_EQ(2u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_EQ(1u, bus.getNumThrottlingEvents(0x181));
+}
+
+// bus whose receive thread blocks instead of spinning, such that it does not starve the other bus threads
+struct IdleBus : public FakeBus {
+	using FakeBus::FakeBus;
+
+protected:
+	bool readData() override {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return false;
+	}
+};
+
+struct CountingDevice : public BarDevice {
+	using BarDevice::BarDevice;
+	bool sanityCheck() override {
+		++numSanityChecks;
+		return BarDevice::sanityCheck();
+	}
+	std::atomic<unsigned int> numSanityChecks{0};
+};
+
+// switches to virtual time for the scope, restores the steady clock after the bus threads stopped, also if an assertion fails
+struct VirtualTime {
+	VirtualTime() { tcan::Clock::startVirtualTime(); }
+	~VirtualTime() { tcan::Clock::stopVirtualTime(); }
+};
+
+TEST(can_bus, virtual_time) {
+	VirtualTime virtualTime;
+
+	auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+	options->sanityCheckInterval_ = 100;
+	options->transmitLimits_.emplace(0x201, tcan_can::TransmitLimit{10000000}); // 10s
+	IdleBus bus { std::move(options) };
+	auto deviceOptions = std::make_unique<tcan_can::CanDeviceOptions>(0x1, "A");
+	deviceOptions->maxDeviceTimeoutCounter_ = 100; // 10s
+	auto dev = new CountingDevice {std::move(deviceOptions)};
+	ASSERT_TRUE(bus.addDevice(dev));
+	for(unsigned int i=0; i<3; ++i) {
+		bus.sendMessage(tcan_can::CanMsg{0x201});
+	}
+
+	// a minute of sanity checks and rate limited messages
+	const auto realStart = std::chrono::steady_clock::now();
+	const auto start = tcan::Clock::now();
+	bus.startThreads();
+	for(unsigned int i=0; i<600; ++i) {
+		ASSERT_TRUE(tcan::Clock::waitForSleepers(1)) << i;
+		tcan::Clock::advance(std::chrono::milliseconds(100));
+	}
+	ASSERT_TRUE(tcan::Clock::waitForSleepers(1));
+	bus.stopThreads();
+
+	ASSERT_EQ(std::chrono::seconds(60), tcan::Clock::now() - start);
+	ASSERT_LT(std::chrono::steady_clock::now() - realStart, std::chrono::seconds(10));
+	ASSERT_EQ(600u, dev->numSanityChecks);
+	ASSERT_TRUE(dev->isMissing());
+	ASSERT_EQ(3u, bus.written.size());
+}
+
+TEST(can_bus, cycle_runner) {
+	using Microseconds = std::chrono::microseconds;
+	using OverrunPolicy = tcan::CycleRunnerOptions::OverrunPolicy;
+	// the third and sixth cycle take longer than the period of 1ms
+	const std::vector<Microseconds> work{Microseconds(100), Microseconds(100), Microseconds(2500), Microseconds(100), Microseconds(100),
+	                                     Microseconds(1500), Microseconds(100), Microseconds(100)};
+	const std::vector<std::vector<long>> expectedStarts{{0, 1000, 2000, 5000, 6000, 7000, 9000, 10000},
+	                                                    {0, 1000, 2000, 4500, 4600, 5000, 6500, 7000}};
+
+	for(const OverrunPolicy policy : {OverrunPolicy::Skip, OverrunPolicy::CatchUp}) {
+		VirtualTime virtualTime;
+		tcan::BusManager<tcan_can::CanMsg> manager;
+		FakeBus* bus = new FakeBus(synchronousOptions());
+		ASSERT_TRUE(manager.addBus(bus));
+
+		tcan::CycleRunnerOptions options(1000);
+		options.overrunPolicy_ = policy;
+		tcan::CycleRunner<tcan_can::CanMsg> runner(manager, options);
+		const auto start = tcan::Clock::now();
+		std::vector<long> starts;
+		runner.setCycleCallback([&]() {
+			starts.push_back(std::chrono::duration_cast<Microseconds>(tcan::Clock::now() - start).count());
+			bus->sendMessage(tcan_can::CanMsg{0x201});
+			tcan::Clock::advance(work[starts.size() - 1]);
+			if(starts.size() == work.size()) {
+				runner.stop();
+			}
+		});
+
+		// the runner sleeps until the start of the next cycle
+		ASSERT_TRUE(runner.start());
+		while(runner.isRunning()) {
+			if(tcan::Clock::waitForSleepers(1, std::chrono::milliseconds(10))) {
+				tcan::Clock::advanceToNextDeadline();
+			}
+		}
+		runner.stop();
+
+		const unsigned int index = (policy == OverrunPolicy::Skip) ? 0 : 1;
+		ASSERT_EQ(expectedStarts[index], starts);
+		ASSERT_EQ(work.size(), bus->written.size());
+		const tcan::CycleStatistics statistics = runner.getStatistics();
+		ASSERT_EQ(work.size(), statistics.numCycles_);
+		ASSERT_EQ(policy == OverrunPolicy::Skip ? 2u : 3u, statistics.numOverruns_);
+		ASSERT_EQ(policy == OverrunPolicy::Skip ? 3u : 0u, statistics.numSkippedCycles_);
+		ASSERT_DOUBLE_EQ(policy == OverrunPolicy::Skip ? 0.0 : 1500.0, statistics.wakeupLatency_.getMax());
+		ASSERT_DOUBLE_EQ(2500.0, statistics.total_.getMax());
+		// the phases are measured in real time, not in the virtual time spent by the callback
+		ASSERT_EQ(work.size(), statistics.callback_.getNumSamples());
+		ASSERT_LT(statistics.callback_.getMax(), 1500.0);
+	}
+}
+
+TEST(can_bus, cycle_runner_stop) {
+	tcan::BusManager<tcan_can::CanMsg> manager;
+	ASSERT_TRUE(manager.addBus(new FakeBus(synchronousOptions())));
+
+	// stop() wakes the runner waiting for the next cycle instead of waiting for the rest of the period
+	tcan::CycleRunner<tcan_can::CanMsg> runner(manager, tcan::CycleRunnerOptions(60000000));
+	unsigned int numCycles = 0;
+	runner.setCycleCallback([&numCycles]() { ++numCycles; });
+	ASSERT_TRUE(runner.start());
+	while(runner.getStatistics().numCycles_ == 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	const auto stopStart = std::chrono::steady_clock::now();
+	runner.stop();
+	ASSERT_LT(std::chrono::steady_clock::now() - stopStart, std::chrono::seconds(10));
+	ASSERT_FALSE(runner.isRunning());
+	ASSERT_EQ(1u, numCycles);
+}
+
+TEST(can_bus, transmit_bandwidth_budget) {
+	VirtualTime virtualTime;
+	auto options = synchronousOptions();
+	options->bandwidthBudget_.bitrate_ = 10000;
+	options->bandwidthBudget_.cycleTime_ = 100000; // 100ms
+	options->bandwidthBudget_.cyclicLoad_ = 70000;
+	FakeBus bus { std::move(options) };
+
+	// an SDO takes 13.5ms at 10kbit/s, so two of them fit into the 30ms left per cycle
+	ASSERT_EQ(135u, tcan_can::estimateFrameBits(8, false));
+	bus.sendMessage(tcan_can::CanMsg{0x80, 0, nullptr});
+	for(unsigned int i=0; i<5; ++i) {
+		bus.sendMessage(tcan_can::CanMsg{0x601, {0x40, 0x00, 0x10, 0x00, 0, 0, 0, 0}});
+	}
+	bus.sendMessage(tcan_can::CanMsg{0x201, {1, 2, 3, 4, 5, 6, 7, 8}});
+
+	// the cyclic frame overtakes the deferred SDOs
+	ASSERT_EQ(4u, bus.writeAll());
+	ASSERT_EQ((std::vector<uint32_t>{0x80, 0x601, 0x601, 0x201}), bus.written);
+	ASSERT_EQ(3u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_EQ(1u, bus.getNumBudgetDeferredCycles());
+	ASSERT_EQ(0u, bus.writeAll());
+
+	tcan::Clock::advance(std::chrono::milliseconds(100));
+	ASSERT_EQ(2u, bus.writeAll());
+	ASSERT_EQ(1u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_EQ(2u, bus.getNumBudgetDeferredCycles());
+}
+
+TEST(can_bus, transmit_schedule_cycle) {
+	using Clock = tcan_can::TransmitSchedule::Clock;
+	tcan_can::TransmitSchedule schedule {tcan_can::TransmitSchedule::Reference::Cycle, 1000};
+	const unsigned int late = schedule.addSlot(500, tcan_can::CanMsg{0x202});
+	const unsigned int early = schedule.addSlot(100, tcan_can::CanMsg{0x201});
+
+	const auto start = Clock::now();
+	ASSERT_TRUE(schedule.start(start));
+
+	tcan_can::TransmitSchedule::MsgQueue queue;
+	queue.push_back(tcan_can::CanMsg{0x601});
+	auto wakeupTime = Clock::time_point::max();
+	ASSERT_EQ(0u, schedule.queueDueMessages(start, queue, 10, wakeupTime));
+	ASSERT_TRUE(wakeupTime == start + std::chrono::microseconds(100));
+
+	// both slots are due, they are put in front of the other messages in order of their offset
+	wakeupTime = Clock::time_point::max();
+	ASSERT_EQ(2u, schedule.queueDueMessages(start + std::chrono::microseconds(600), queue, 10, wakeupTime));
+	ASSERT_TRUE(wakeupTime == start + std::chrono::microseconds(1100));
+	ASSERT_EQ(3u, queue.size());
+	ASSERT_EQ(0x201u, queue[0].getCobId());
+	ASSERT_EQ(0x202u, queue[1].getCobId());
+
+	// messages which were not queued by the schedule are ignored, even with the identifier of a slot
+	ASSERT_EQ(0u, queue[2].getTag());
+	schedule.handleMessageWritten(tcan_can::CanMsg{0x201}.getTag(), start + std::chrono::microseconds(605));
+	// the slots are matched by their tag if they are written out of order
+	schedule.handleMessageWritten(queue[1].getTag(), start + std::chrono::microseconds(610));
+	schedule.handleMessageWritten(queue[0].getTag(), start + std::chrono::microseconds(620));
+	tcan_can::ScheduleSlotStatistics statistics;
+	ASSERT_TRUE(schedule.getSlotStatistics(early, statistics));
+	ASSERT_EQ(1u, statistics.numSent_);
+	ASSERT_DOUBLE_EQ(520.0, statistics.maxLateness_);
+	ASSERT_TRUE(schedule.getSlotStatistics(late, statistics));
+	ASSERT_EQ(1u, statistics.numSent_);
+	ASSERT_DOUBLE_EQ(110.0, statistics.maxLateness_);
+
+	// a stalled cycle is skipped
+	queue.clear();
+	ASSERT_EQ(2u, schedule.queueDueMessages(start + std::chrono::microseconds(3200), queue, 10, wakeupTime));
+	ASSERT_EQ(3u, schedule.getNumSkippedSlots());
+
+	// a full queue does not grow, the slots are skipped
+	ASSERT_EQ(0u, schedule.queueDueMessages(start + std::chrono::microseconds(4600), queue, 2, wakeupTime));
+	ASSERT_EQ(2u, queue.size());
+	ASSERT_EQ(6u, schedule.getNumSkippedSlots());
+}
+
+TEST(can_bus, transmit_schedule_sync) {
+	using Clock = tcan_can::TransmitSchedule::Clock;
+	tcan_can::TransmitSchedule schedule {tcan_can::TransmitSchedule::Reference::Sync, 0};
+	schedule.addSlot(200, tcan_can::CanMsg{0x201});
+
+	const auto start = Clock::now();
+	ASSERT_TRUE(schedule.start(start));
+
+	tcan_can::TransmitSchedule::MsgQueue queue;
+	auto wakeupTime = Clock::time_point::max();
+	ASSERT_EQ(0u, schedule.queueDueMessages(start + std::chrono::microseconds(5000), queue, 10, wakeupTime));
+	ASSERT_TRUE(wakeupTime == Clock::time_point::max());
+
+	schedule.trigger(start + std::chrono::microseconds(6000));
+	ASSERT_EQ(0u, schedule.queueDueMessages(start + std::chrono::microseconds(6100), queue, 10, wakeupTime));
+	ASSERT_TRUE(wakeupTime == start + std::chrono::microseconds(6200));
+	ASSERT_EQ(1u, schedule.queueDueMessages(start + std::chrono::microseconds(6200), queue, 10, wakeupTime));
+	ASSERT_EQ(0u, schedule.queueDueMessages(start + std::chrono::microseconds(9000), queue, 10, wakeupTime));
+}
+
+TEST(can_bus, socket_batch_read_write) {
+	int sockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->batchSize_ = 4;
+	PairedSocketBus bus { std::move(options), sockets[0] };
+	BarDevice dev {0x123, "Bar"};
+	bus.addCanMessage(tcan_can::CanBus::CanFrameIdentifier{0x180, 0x7F0}, &dev, &BarDevice::callMe);
+
+	// six queued messages are written with two calls
+	for(uint32_t i=0; i<6; i++) {
+		bus.sendMessage(tcan_can::CanMsg{0x201 + i, {static_cast<uint8_t>(i)}});
+	}
+	ASSERT_TRUE(bus.writeMessages(nullptr));
+	ASSERT_EQ(2u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_TRUE(bus.writeMessages(nullptr));
+	ASSERT_EQ(0u, bus.getNumOutgoingMessagesWithoutLock());
+
+	for(uint32_t i=0; i<6; i++) {
+		can_frame frame;
+		ASSERT_EQ(static_cast<int>(sizeof(can_frame)), recv(sockets[1], &frame, sizeof(can_frame), MSG_DONTWAIT));
+		ASSERT_EQ(0x201 + i, frame.can_id);
+		ASSERT_EQ(1, frame.can_dlc);
+		ASSERT_EQ(i, frame.data[0]);
+	}
+
+	// five received frames are read with two calls
+	for(uint32_t i=0; i<5; i++) {
+		can_frame frame{};
+		frame.can_id = 0x181 + i;
+		ASSERT_EQ(static_cast<int>(sizeof(can_frame)), send(sockets[1], &frame, sizeof(can_frame), 0));
+	}
+	ASSERT_TRUE(bus.readData());
+	ASSERT_EQ(4u, dev.numCalls);
+	ASSERT_TRUE(bus.readData());
+	ASSERT_EQ(5u, dev.numCalls);
+	ASSERT_FALSE(bus.readData());
+
+	close(sockets[1]);
+}
+
+TEST(can_bus, socket_receive_modes) {
+	const auto sendFrame = [](const int socket) {
+		can_frame frame{};
+		frame.can_id = 0x181;
+		return send(socket, &frame, sizeof(can_frame), 0) == static_cast<int>(sizeof(can_frame));
+	};
+	tcan_can::SocketBus::ReceiveStatistics statistics;
+
+	// busy polling counts the empty polls and the frames received while spinning
+	int sockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->receiveMode_ = tcan_can::SocketBusOptions::ReceiveMode::BusyPoll;
+	ReceiveModeSocketBus busyPollBus { std::move(options), sockets[0] };
+	ASSERT_FALSE(busyPollBus.readData());
+	ASSERT_FALSE(busyPollBus.readData());
+	ASSERT_TRUE(sendFrame(sockets[1]));
+	ASSERT_TRUE(busyPollBus.readData());
+	busyPollBus.getReceiveStatistics(statistics);
+	ASSERT_EQ(0u, statistics.numBlockingReceptions_);
+	ASSERT_EQ(1u, statistics.numSpinReceptions_);
+	ASSERT_EQ(2u, statistics.numEmptyPolls_);
+	close(sockets[1]);
+
+	// the hybrid mode spins after a received frame and blocks again after the spin window. The frames are sent before reading, so a
+	// blocking read returns immediately.
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+	options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->receiveMode_ = tcan_can::SocketBusOptions::ReceiveMode::Hybrid;
+	options->hybridSpinWindow_ = 100000; // 100ms
+	ReceiveModeSocketBus hybridBus { std::move(options), sockets[0] };
+	ASSERT_TRUE(sendFrame(sockets[1]));
+	ASSERT_TRUE(hybridBus.readData());
+	ASSERT_FALSE(hybridBus.readData());
+	ASSERT_TRUE(sendFrame(sockets[1]));
+	ASSERT_TRUE(hybridBus.readData());
+	hybridBus.getReceiveStatistics(statistics);
+	ASSERT_EQ(1u, statistics.numBlockingReceptions_);
+	ASSERT_EQ(1u, statistics.numSpinReceptions_);
+	ASSERT_EQ(1u, statistics.numEmptyPolls_);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(150));
+	ASSERT_TRUE(sendFrame(sockets[1]));
+	ASSERT_TRUE(hybridBus.readData());
+	hybridBus.getReceiveStatistics(statistics);
+	ASSERT_EQ(2u, statistics.numBlockingReceptions_);
+	ASSERT_EQ(1u, statistics.numSpinReceptions_);
+	ASSERT_EQ(1u, statistics.numEmptyPolls_);
+	close(sockets[1]);
+}
+
+TEST(can_bus, socket_receive_ring) {
+	int sockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->ringBlockSize_ = 4096;
+	options->ringNumBlocks_ = 2;
+	std::vector<uint64_t> ring(2 * 4096 / sizeof(uint64_t));
+	uint8_t* blocks = reinterpret_cast<uint8_t*>(ring.data());
+	RingSocketBus bus { std::move(options), sockets[0], blocks };
+	BarDevice dev {0x123, "Bar"};
+	bus.addCanMessage(tcan_can::CanBus::CanFrameIdentifier{0x180, 0x7F0}, &dev, &BarDevice::callMe);
+
+	// fills a block with frames in the TPACKET_V3 layout: block descriptor, then per packet the header, the link address and the frame
+	const auto fillBlock = [blocks](const unsigned int blockIndex, const std::vector<std::pair<uint32_t, uint8_t>>& frames) {
+		uint8_t* block = blocks + blockIndex * 4096;
+		auto* descriptor = reinterpret_cast<tpacket_block_desc*>(block);
+		descriptor->hdr.bh1.num_pkts = frames.size();
+		descriptor->hdr.bh1.offset_to_first_pkt = TPACKET_ALIGN(sizeof(tpacket_block_desc));
+		const unsigned int linkOffset = TPACKET_ALIGN(sizeof(tpacket3_hdr));
+		const unsigned int frameOffset = TPACKET_ALIGN(linkOffset + sizeof(sockaddr_ll));
+		const unsigned int packetSize = TPACKET_ALIGN(frameOffset + sizeof(can_frame));
+		uint8_t* packet = block + descriptor->hdr.bh1.offset_to_first_pkt;
+		for(const auto& frame : frames) {
+			auto* header = reinterpret_cast<tpacket3_hdr*>(packet);
+			header->tp_next_offset = packetSize;
+			header->tp_snaplen = sizeof(can_frame);
+			header->tp_net = frameOffset;
+			reinterpret_cast<sockaddr_ll*>(packet + linkOffset)->sll_pkttype = frame.second;
+			can_frame canFrame{};
+			canFrame.can_id = frame.first;
+			std::memcpy(packet + frameOffset, &canFrame, sizeof(can_frame));
+			packet += packetSize;
+		}
+		descriptor->hdr.bh1.block_status = TP_STATUS_USER;
+	};
+
+	// no filled block
+	ASSERT_FALSE(bus.readData());
+
+	// the frames sent from this host are dropped
+	fillBlock(0, {{0x181, PACKET_HOST}, {0x182, PACKET_OUTGOING}, {0x183, PACKET_LOOPBACK}, {0x184, PACKET_BROADCAST}});
+	ASSERT_TRUE(bus.readData());
+	ASSERT_EQ(2u, dev.numCalls);
+	auto* firstBlock = reinterpret_cast<tpacket_block_desc*>(blocks);
+	ASSERT_EQ(static_cast<uint32_t>(TP_STATUS_KERNEL), firstBlock->hdr.bh1.block_status);
+
+	// a block with only own frames is returned to the kernel, the next block is read from the start of the ring
+	fillBlock(1, {{0x185, PACKET_LOOPBACK}, {0x186, PACKET_OUTGOING}});
+	ASSERT_FALSE(bus.readData());
+	fillBlock(0, {{0x187, PACKET_HOST}});
+	ASSERT_TRUE(bus.readData());
+	ASSERT_EQ(3u, dev.numCalls);
+	ASSERT_FALSE(bus.readData());
+
+	close(sockets[1]);
+}
+
+TEST(can_bus, socket_receive_groups) {
+	int sockets[2];
+	int groupSockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, groupSockets));
+
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	tcan_can::SocketBusOptions::ReceiveGroup pdos;
+	pdos.canFilters_.push_back(can_filter{0x180, 0x780});
+	options->receiveGroups_.push_back(pdos);
+	GroupedSocketBus bus { std::move(options), sockets[0], groupSockets[0] };
+	RecordingDevice dev {0x123, "Bar"};
+	bus.addCanMessage(tcan_can::CanBus::CanFrameIdentifier{0x000, 0x000}, &dev, &RecordingDevice::record);
+
+	// nothing to read
+	pollfd fd = {bus.getPollableFileDescriptor(), POLLIN, 0};
+	ASSERT_EQ(0, poll(&fd, 1, 0));
+
+	// a diagnostics frame queued before a PDO does not delay it
+	can_frame frame{};
+	frame.can_id = 0x601;
+	ASSERT_EQ(static_cast<int>(sizeof(can_frame)), send(sockets[1], &frame, sizeof(can_frame), 0));
+	frame.can_id = 0x181;
+	ASSERT_EQ(static_cast<int>(sizeof(can_frame)), send(groupSockets[1], &frame, sizeof(can_frame), 0));
+
+	ASSERT_EQ(1, poll(&fd, 1, 0));
+	ASSERT_TRUE(bus.readData());
+	ASSERT_EQ((std::vector<uint32_t>{0x181, 0x601}), dev.received);
+	ASSERT_EQ(1u, bus.getNumReceiveGroupFrames(0));
+	ASSERT_FALSE(bus.readData());
+	ASSERT_EQ(0, poll(&fd, 1, 0));
+
+	close(sockets[1]);
+	close(groupSockets[1]);
+}
+
+TEST(can_bus, io_uring_engine) {
+	constexpr unsigned int numBuses = 2;
+	constexpr unsigned int numFrames = 20;
+	tcan::BusManager<tcan_can::CanMsg> manager;
+	int sockets[numBuses][2];
+	ManagedSocketBus* buses[numBuses];
+	ReceptionCounter bar {0x1, "Bar"};
+	ReceptionCounter baz {0x2, "Baz"};
+	ReceptionCounter* devices[numBuses] {&bar, &baz};
+	for(unsigned int i=0; i<numBuses; i++) {
+		ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets[i]));
+		auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo" + std::to_string(i));
+		options->useIoUring_ = true;
+		options->startPassive_ = true;
+		options->sanityCheckInterval_ = 0;
+		buses[i] = new ManagedSocketBus(std::move(options), sockets[i][0]);
+		buses[i]->addCanMessage(tcan_can::CanBus::CanFrameIdentifier{0x180, 0x7F0}, devices[i], &ReceptionCounter::count);
+		ASSERT_TRUE(manager.addBus(buses[i]));
+	}
+	manager.startThreads();
+
+	// falls back to the bus threads if the kernel does not support io_uring
+	tcan::IoUringEngine& engine = manager.getIoUringEngine();
+	const bool isEngineRunning = engine.isRunning();
+	for(unsigned int i=0; i<numBuses; i++) {
+		ASSERT_EQ(isEngineRunning, buses[i]->isIoUringEngineAttached());
+	}
+
+	// the frames of both buses are received by the single completion loop
+	for(unsigned int i=0; i<numBuses; i++) {
+		for(uint32_t j=0; j<numFrames; j++) {
+			can_frame frame{};
+			frame.can_id = 0x181 + (j % 8);
+			ASSERT_EQ(static_cast<int>(sizeof(can_frame)), send(sockets[i][1], &frame, sizeof(can_frame), 0));
+		}
+	}
+	for(unsigned int i=0; i<numBuses; i++) {
+		ASSERT_TRUE(devices[i]->waitForReceived(numFrames)) << devices[i]->numReceived;
+	}
+
+	// the messages queued while the bus was passive are submitted at once, in order
+	for(uint32_t j=0; j<numFrames; j++) {
+		buses[0]->sendMessage(tcan_can::CanMsg{0x201 + j, {static_cast<uint8_t>(j)}});
+	}
+	tcan::IoUringEngine::Statistics before;
+	engine.getStatistics(before);
+	buses[0]->activate();
+	{
+		std::unique_lock<tcan::PriorityInheritanceMutex> lock;
+		buses[0]->waitForEmptyQueue(lock);
+	}
+	for(uint32_t j=0; j<numFrames; j++) {
+		can_frame frame;
+		ASSERT_EQ(static_cast<int>(sizeof(can_frame)), recv(sockets[0][1], &frame, sizeof(can_frame), MSG_DONTWAIT));
+		ASSERT_EQ(0x201 + j, frame.can_id);
+		ASSERT_EQ(1, frame.can_dlc);
+		ASSERT_EQ(j, frame.data[0]);
+	}
+	ASSERT_FALSE(buses[0]->hasBusError());
+
+	if(isEngineRunning) {
+		tcan::IoUringEngine::Statistics after;
+		engine.getStatistics(after);
+		ASSERT_LT(after.numEnterCalls_ - before.numEnterCalls_, numFrames / 2);
+		if(engine.isMultishotReceiveSupported()) {
+			ASSERT_EQ(0u, after.numReceiveRearms_);
+		}
+	}
+
+	// a removed bus is no longer served, the other bus is
+	ASSERT_TRUE(manager.removeBus(buses[1]));
+	ASSERT_FALSE(buses[1]->isIoUringEngineAttached());
+	delete buses[1];
+	can_frame frame{};
+	frame.can_id = 0x181;
+	ASSERT_EQ(static_cast<int>(sizeof(can_frame)), send(sockets[0][1], &frame, sizeof(can_frame), 0));
+	ASSERT_TRUE(bar.waitForReceived(numFrames + 1));
+
+	manager.closeBuses();
+	for(unsigned int i=0; i<numBuses; i++) {
+		close(sockets[i][1]);
+	}
+}
+
+TEST(can_bus, external_event_loop) {
+	int sockets[2];
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets));
+
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->synchronousBlockingWrite_ = false;
+	options->sanityCheckInterval_ = 100;
+	options->transmitLimits_.emplace(0x201, tcan_can::TransmitLimit{10000}); // 10ms
+	const auto start = std::chrono::steady_clock::now();
+	PairedSocketBus bus { std::move(options), sockets[0] };
+	BarDevice dev {0x123, "Bar"};
+	bus.addCanMessage(0x181, &dev, &BarDevice::callMe);
+
+	ASSERT_EQ(POLLIN, bus.getPollEvents());
+	const auto sanityCheckTime = bus.getNextTimerDeadline();
+	ASSERT_GE(sanityCheckTime, start + std::chrono::milliseconds(100));
+	ASSERT_LE(sanityCheckTime, std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+
+	// the second message is held back by its inhibit time, which is reported as timer deadline
+	bus.sendMessage(tcan_can::CanMsg{0x201});
+	bus.sendMessage(tcan_can::CanMsg{0x201});
+	ASSERT_EQ(POLLIN | POLLOUT, bus.getPollEvents());
+	ASSERT_TRUE(bus.onWritable());
+	ASSERT_EQ(1u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_EQ(POLLIN, bus.getPollEvents());
+	ASSERT_LT(bus.getNextTimerDeadline(), sanityCheckTime);
+
+	can_frame frame{};
+	ASSERT_EQ(static_cast<int>(sizeof(can_frame)), recv(sockets[1], &frame, sizeof(can_frame), MSG_DONTWAIT));
+	ASSERT_EQ(0x201u, frame.can_id);
+
+	// the queries do not reorder the queue, the message behind the held back one is moved to the front when it is written
+	bus.sendMessage(tcan_can::CanMsg{0x202});
+	ASSERT_EQ(POLLIN | POLLOUT, bus.getPollEvents());
+	ASSERT_EQ(sanityCheckTime, bus.getNextTimerDeadline());
+	ASSERT_EQ(0x201u, bus.outgoingMsgs_.front().getCobId());
+	ASSERT_TRUE(bus.onWritable());
+	ASSERT_EQ(1u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_EQ(0x201u, bus.outgoingMsgs_.front().getCobId());
+	ASSERT_EQ(static_cast<int>(sizeof(can_frame)), recv(sockets[1], &frame, sizeof(can_frame), MSG_DONTWAIT));
+	ASSERT_EQ(0x202u, frame.can_id);
+
+	// received frames are handled until the socket would block
+	frame.can_id = 0x181;
+	for(int i=0; i<3; i++) {
+		ASSERT_EQ(static_cast<int>(sizeof(can_frame)), send(sockets[1], &frame, sizeof(can_frame), 0));
+	}
+	pollfd fd = {bus.getPollableFileDescriptor(), bus.getPollEvents(), 0};
+	ASSERT_EQ(1, poll(&fd, 1, 0));
+	ASSERT_TRUE(fd.revents & POLLIN);
+	ASSERT_EQ(3u, bus.onReadable());
+	ASSERT_EQ(3u, dev.numCalls);
+	ASSERT_EQ(0u, bus.onReadable());
+
+	// the sanity check is rescheduled after it ran
+	bus.onTimer(sanityCheckTime);
+	bus.removeTransmitLimit(0x201);
+	ASSERT_EQ(sanityCheckTime + std::chrono::milliseconds(100), bus.getNextTimerDeadline());
+
+	close(sockets[1]);
+}
+
+// fake bus whose reads and writes take some time, and which records the threads reading and writing it
+struct PhaseRecordingBus : public FakeBus {
+	using FakeBus::FakeBus;
+
+	static constexpr std::chrono::milliseconds delay{1};
+	unsigned int numReads = 0;
+	std::thread::id readThread;
+	std::thread::id writeThread;
+
+protected:
+	bool readData() override {
+		std::this_thread::sleep_for(delay);
+		++numReads;
+		readThread = std::this_thread::get_id();
+		return false;
+	}
+	bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) override {
+		std::this_thread::sleep_for(delay);
+		writeThread = std::this_thread::get_id();
+		return FakeBus::writeData(lock);
+	}
+};
+
+constexpr std::chrono::milliseconds PhaseRecordingBus::delay;
+
+TEST(can_bus, parallel_synchronous) {
+	tcan::BusManager<tcan_can::CanMsg> manager;
+	std::vector<PhaseRecordingBus*> buses;
+	for(unsigned int i=0; i<3; ++i) {
+		buses.push_back(new PhaseRecordingBus(synchronousOptions()));
+		ASSERT_TRUE(manager.addBus(buses.back()));
+	}
+
+	// every bus is read and written once per phase by its worker
+	ASSERT_TRUE(manager.startParallelSynchronous());
+	ASSERT_FALSE(manager.startParallelSynchronous());
+	for(unsigned int cycle=1; cycle<=5; ++cycle) {
+		for(auto bus : buses) {
+			bus->sendMessage(tcan_can::CanMsg{0x201});
+		}
+		manager.readMessagesSynchronous();
+		ASSERT_TRUE(manager.writeMessagesSynchronous());
+		for(auto bus : buses) {
+			ASSERT_EQ(cycle, bus->numReads);
+			ASSERT_EQ(cycle, bus->written.size());
+			ASSERT_NE(std::this_thread::get_id(), bus->readThread);
+			ASSERT_EQ(bus->readThread, bus->writeThread);
+		}
+	}
+	ASSERT_NE(buses[0]->readThread, buses[1]->readThread);
+
+	tcan::BusManager<tcan_can::CanMsg>::PhaseTiming timing;
+	for(unsigned int i=0; i<buses.size(); ++i) {
+		ASSERT_TRUE(manager.getSynchronousPhaseTiming(i, timing));
+		ASSERT_GE(timing.lastRead_, PhaseRecordingBus::delay);
+		ASSERT_GE(timing.maxRead_, timing.lastRead_);
+		ASSERT_GE(timing.lastWrite_, PhaseRecordingBus::delay);
+		ASSERT_GE(timing.maxWrite_, timing.lastWrite_);
+	}
+	ASSERT_FALSE(manager.getSynchronousPhaseTiming(buses.size(), timing));
+
+	// afterwards, the calling thread handles the buses again
+	manager.stopParallelSynchronous();
+	ASSERT_FALSE(manager.getSynchronousPhaseTiming(0, timing));
+	for(auto bus : buses) {
+		bus->sendMessage(tcan_can::CanMsg{0x201});
+	}
+	manager.readMessagesSynchronous();
+	ASSERT_TRUE(manager.writeMessagesSynchronous());
+	for(auto bus : buses) {
+		ASSERT_EQ(6u, bus->numReads);
+		ASSERT_EQ(6u, bus->written.size());
+		ASSERT_EQ(std::this_thread::get_id(), bus->readThread);
+		ASSERT_EQ(std::this_thread::get_id(), bus->writeThread);
+	}
+}
+
+TEST(can_bus, runtime_registration) {
+	FakeBus bus { synchronousOptions() };
+	BarDevice dev {0x123, "Bar"};
+	auto removedDev = new BarDevice {0x124, "Baz"};
+	ASSERT_TRUE(bus.addDevice(removedDev));
+	ASSERT_TRUE(bus.addCanMessage(0x181, &dev, &BarDevice::callMe));
+	ASSERT_TRUE(bus.addCanMessage(0x182, removedDev, &BarDevice::callMe));
+	ASSERT_FALSE(bus.addCanMessage(0x181, &dev, &BarDevice::callMe));
+
+	// the unmapped callback modifies the dispatch table it is called from
+	bus.setUnmappedMessageCallback([&bus, &dev](const tcan_can::CanMsg& msg) {
+		return bus.addCanMessage(msg.getCobId(), &dev, &BarDevice::callMe);
+	});
+	bus.handleMessage(tcan_can::CanMsg{0x183});
+	ASSERT_FALSE(dev.wasCalled());
+	bus.handleMessage(tcan_can::CanMsg{0x183});
+	ASSERT_TRUE(dev.wasCalled());
+
+	ASSERT_TRUE(bus.removeCanMessage(0x181));
+	ASSERT_FALSE(bus.removeCanMessage(0x181));
+	bus.handleMessage(tcan_can::CanMsg{0x181}); // re-added by the unmapped callback
+	ASSERT_FALSE(dev.wasCalled());
+
+	bus.handleMessage(tcan_can::CanMsg{0x182});
+	ASSERT_EQ(1u, removedDev->numCalls);
+	ASSERT_EQ(1u, bus.getDeviceContainer().size());
+	{
+		// a snapshot keeps the device list alive while devices are added
+		const auto devices = bus.getDeviceContainerSnapshot();
+		BarDevice* addedDev = new BarDevice(0x125, "Added");
+		bus.addDevice(addedDev);
+		ASSERT_EQ(1u, devices->size());
+		ASSERT_EQ(2u, bus.getDeviceContainer().size());
+		ASSERT_EQ(removedDev, devices->front());
+	}
+	ASSERT_TRUE(bus.removeDevice(removedDev));
+	ASSERT_EQ(1u, bus.getDeviceContainer().size());
+	ASSERT_FALSE(bus.removeCanMessage(0x182));
+}
+
+TEST(can_bus, rcu_grace_period) {
+	// the replaced value holds a reference to the shared value until it is freed
+	auto shared = std::make_shared<int>(1);
+	tcan::RcuPointer<std::shared_ptr<int>> rcu(shared);
+	using ReadGuard = tcan::RcuPointer<std::shared_ptr<int>>::ReadGuard;
+
+	// overlapping readers, so that there is always an active reader
+	std::atomic<bool> isRunning(true);
+	std::atomic<unsigned int> numReads(0);
+	std::thread reader([&rcu, &isRunning, &numReads]() {
+		auto current = std::make_unique<ReadGuard>(rcu.read());
+		while(isRunning) {
+			auto next = std::make_unique<ReadGuard>(rcu.read());
+			current = std::move(next);
+			++numReads;
+		}
+	});
+	while(numReads < 100) {
+		std::this_thread::yield();
+	}
+
+	ASSERT_TRUE(rcu.update([](std::shared_ptr<int>& value) { value.reset(); return true; }));
+	rcu.synchronize();
+	ASSERT_EQ(1, shared.use_count());
+
+	// the writers and reclaim() free the replaced values without waiting
+	ASSERT_TRUE(rcu.update([&shared](std::shared_ptr<int>& value) { value = shared; return true; }));
+	ASSERT_TRUE(rcu.update([](std::shared_ptr<int>& value) { value.reset(); return true; }));
+	const auto start = std::chrono::steady_clock::now();
+	while(shared.use_count() != 1 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+		rcu.reclaim();
+		std::this_thread::yield();
+	}
+	ASSERT_EQ(1, shared.use_count());
+
+	isRunning = false;
+	reader.join();
+}
+
+TEST(can_bus, concurrent_bus_initialization) {
+	using Result = tcan::BusManager<tcan_can::CanMsg>::BusInitResult;
+	tcan::BusManager<tcan_can::CanMsg> manager;
+	manager.registerBus(new SlowInitBus("A", 100, true));
+	manager.registerBus(new SlowInitBus("B", 100, false));
+	manager.registerBus(new SlowInitBus("C", 100, true));
+	manager.registerBus(new SlowInitBus("D", 1000, true));
+	ASSERT_EQ(0u, manager.getSize());
+
+	std::vector<Result> results;
+	const auto start = std::chrono::steady_clock::now();
+	ASSERT_FALSE(manager.initRegisteredBuses(std::chrono::milliseconds(400), &results));
+	const auto duration = std::chrono::steady_clock::now() - start;
+
+	// the buses are initialized in parallel, so the call returns at the timeout
+	ASSERT_GE(duration, std::chrono::milliseconds(400));
+	ASSERT_LT(duration, std::chrono::milliseconds(700));
+
+	ASSERT_EQ(4u, results.size());
+	ASSERT_EQ("A", results[0].bus_->getName());
+	ASSERT_EQ(Result::Status::Initialized, results[0].status_);
+	ASSERT_EQ(Result::Status::Failed, results[1].status_);
+	ASSERT_EQ(Result::Status::Initialized, results[2].status_);
+	ASSERT_EQ(Result::Status::TimedOut, results[3].status_);
+	ASSERT_GE(results[0].duration_, std::chrono::milliseconds(100));
+
+	// failed buses are added like in addBus(), timed out buses are not
+	ASSERT_EQ(3u, manager.getSize());
+}
+
+TEST(can_bus, device_state_table) {
+	tcan::BusManager<tcan_can::CanMsg> manager;
+	auto bus = new FakeBus(synchronousOptions());
+	auto devA = new BarDevice {0x1, "A"};
+	auto devB = new BarDevice {0x2, "B"};
+	ASSERT_TRUE(bus->addDevice(devA));
+	ASSERT_TRUE(bus->addCanMessage(0x181, devA, &BarDevice::callMe));
+	ASSERT_TRUE(manager.addBus(bus));
+	ASSERT_TRUE(bus->addDevice(devB)); // registered when added
+
+	const tcan::DeviceStateTable& table = manager.getDeviceStateTable();
+	std::vector<tcan::DeviceStateTable::Entry> entries;
+	const uint64_t version = table.getSnapshot(entries);
+	ASSERT_EQ(2u, entries.size());
+	ASSERT_EQ("A", *entries[0].name_);
+	ASSERT_EQ("B", *entries[1].name_);
+	ASSERT_EQ(tcan_can::CanDevice::Initializing, entries[0].state_);
+	ASSERT_EQ(version, table.getChanges(version, entries));
+	ASSERT_TRUE(entries.empty());
+
+	// the first message configures the device
+	bus->handleMessage(tcan_can::CanMsg{0x181});
+	bus->handleMessage(tcan_can::CanMsg{0x181});
+	const uint64_t newVersion = table.getChanges(version, entries);
+	ASSERT_EQ(version + 1, newVersion);
+	ASSERT_EQ(1u, entries.size());
+	ASSERT_EQ("A", *entries[0].name_);
+	ASSERT_EQ(tcan_can::CanDevice::Active, entries[0].state_);
+
+	// removed devices are reported as changes, but not in snapshots
+	ASSERT_TRUE(bus->removeDevice(devB));
+	table.getChanges(newVersion, entries);
+	ASSERT_EQ(1u, entries.size());
+	ASSERT_EQ("B", *entries[0].name_);
+	ASSERT_FALSE(entries[0].isRegistered_);
+	table.getSnapshot(entries);
+	ASSERT_EQ(1u, entries.size());
+	ASSERT_EQ(tcan_can::CanDevice::Active, entries[0].state_);
+}
+
+TEST(can_bus, device_state_events) {
+	using Event = tcan::DeviceStateEventQueue::Event;
+	tcan::BusManager<tcan_can::CanMsg> manager;
+	auto bus = new FakeBus(synchronousOptions());
+	ASSERT_TRUE(manager.addBus(bus));
+	auto options = std::make_unique<tcan_can::CanDeviceOptions>(0x1, "A");
+	options->maxDeviceTimeoutCounter_ = 1;
+	auto dev = new BarDevice {std::move(options)};
+	ASSERT_TRUE(bus->addDevice(dev));
+	ASSERT_TRUE(bus->addCanMessage(0x181, dev, &BarDevice::callMe));
+
+	// short transitions between two polls are all reported
+	for(unsigned int i=0; i<2; ++i) {
+		bus->handleMessage(tcan_can::CanMsg{0x181});
+		while(!dev->isMissing()) {
+			dev->sanityCheck();
+		}
+	}
+
+	std::vector<Event> events;
+	ASSERT_EQ(5u, manager.getDeviceStateEvents().popAll(events));
+	ASSERT_EQ(Event::Type::Registered, events[0].type_);
+	ASSERT_EQ("A", *events[0].name_);
+	const std::vector<std::pair<int, int>> transitions {{0, 1}, {1, -1}, {-1, 1}, {1, -1}};
+	for(unsigned int i=0; i<transitions.size(); ++i) {
+		ASSERT_EQ(Event::Type::StateChanged, events[i+1].type_);
+		ASSERT_EQ(transitions[i].first, events[i+1].previousState_);
+		ASSERT_EQ(transitions[i].second, events[i+1].state_);
+		ASSERT_GE(events[i+1].stamp_, events[i].stamp_);
+	}
+	ASSERT_EQ(0u, manager.getDeviceStateEvents().popAll(events));
+	ASSERT_EQ(0u, manager.getDeviceStateEvents().takeNumDroppedEvents());
+
+	ASSERT_TRUE(bus->removeDevice(dev));
+	ASSERT_EQ(1u, manager.getDeviceStateEvents().popAll(events));
+	ASSERT_EQ(Event::Type::Unregistered, events[0].type_);
+
+	// overflow is counted
+	tcan::DeviceStateEventQueue queue(2);
+	const Event event {Event::Type::StateChanged, nullptr, 0, 0, 1, tcan::DeviceStateEventQueue::Clock::now()};
+	ASSERT_TRUE(queue.push(event));
+	ASSERT_TRUE(queue.push(event));
+	ASSERT_FALSE(queue.push(event));
+	ASSERT_EQ(1u, queue.takeNumDroppedEvents());
+	ASSERT_EQ(0u, queue.takeNumDroppedEvents());
+	ASSERT_EQ(2u, queue.popAll(events));
+	ASSERT_TRUE(queue.push(event));
+}
+
+struct SequenceDevice : public tcan_can::DeviceCanOpen {
+	using tcan_can::DeviceCanOpen::DeviceCanOpen;
+	bool initDevice() override {
+		bus_->addCanMessage(TxSDOId + getNodeId(), this, &DeviceCanOpen::parseSDOAnswer);
+		bus_->addCanMessage(TxNMTId + getNodeId(), this, &DeviceCanOpen::parseHeartBeat);
+		return true;
+	}
+	bool configureDevice(const tcan_can::CanMsg& /*msg*/) override { return true; }
+};
+
+TEST(can_bus, config_sequence) {
+	using Sequence = tcan_can::ConfigSequence;
+	FakeBus bus { synchronousOptions() };
+	auto dev1 = new SequenceDevice(1, "Dev1");
+	auto dev2 = new SequenceDevice(2, "Dev2");
+	ASSERT_TRUE(bus.addDevice(dev1));
+	ASSERT_TRUE(bus.addDevice(dev2));
+
+	// the value read from 0x1018/2 decides which objects are written
+	bool done1 = false;
+	Sequence sequence1;
+	sequence1.sdoRead(0x1018, 0x02, [](const tcan_can::SdoMsg& answer, Sequence& s) {
+		if(answer.readuint32(4) == 42) {
+			s.sdoWrite(tcan_can::SdoMsg::Command::WRITE_2_BYTE, 0x1017, 0x00, 100);
+		}
+		return true;
+	}).sdoWrite(tcan_can::SdoMsg::Command::WRITE_1_BYTE, 0x6060, 0x00, 1)
+	  .waitHeartbeat(1000, Sequence::heartbeatOperational)
+	  .onDone([&done1](const bool success) { done1 = success; });
+
+	Sequence sequence2;
+	sequence2.sdoWrite(tcan_can::SdoMsg::Command::WRITE_4_BYTE, 0x2000, 0x01, 5);
+
+	// both devices are configured concurrently, their first SDOs are sent immediately
+	ASSERT_TRUE(dev1->startConfigSequence(std::move(sequence1)));
+	ASSERT_TRUE(dev2->startConfigSequence(std::move(sequence2)));
+	ASSERT_FALSE(dev1->startConfigSequence(Sequence()));
+	bus.writeAll();
+	ASSERT_EQ((std::vector<uint32_t>{0x601, 0x602}), bus.written);
+
+	bus.handleMessage(tcan_can::CanMsg{0x582, {0x60, 0x00, 0x20, 0x01, 0, 0, 0, 0}});
+	ASSERT_EQ(Sequence::Status::Done, dev2->getConfigSequenceStatus());
+
+	bus.handleMessage(tcan_can::CanMsg{0x581, {0x43, 0x18, 0x10, 0x02, 42, 0, 0, 0}});
+	bus.handleMessage(tcan_can::CanMsg{0x581, {0x60, 0x17, 0x10, 0x00, 0, 0, 0, 0}});
+	bus.handleMessage(tcan_can::CanMsg{0x581, {0x60, 0x60, 0x60, 0x00, 0, 0, 0, 0}});
+	ASSERT_EQ(Sequence::Status::Running, dev1->getConfigSequenceStatus());
+	bus.handleMessage(tcan_can::CanMsg{0x701, {0x7F}});
+	ASSERT_EQ(Sequence::Status::Running, dev1->getConfigSequenceStatus());
+	bus.handleMessage(tcan_can::CanMsg{0x701, {0x05}});
+	ASSERT_EQ(Sequence::Status::Done, dev1->getConfigSequenceStatus());
+	ASSERT_TRUE(done1);
+	bus.writeAll();
+	ASSERT_EQ((std::vector<uint32_t>{0x601, 0x602, 0x601, 0x601}), bus.written);
+
+	// an SDO error fails the sequence
+	Sequence sequence3;
+	sequence3.sdoWrite(tcan_can::SdoMsg::Command::WRITE_1_BYTE, 0x6060, 0x00, 8).sdoWrite(tcan_can::SdoMsg::Command::WRITE_1_BYTE, 0x6040, 0x00, 6);
+	ASSERT_TRUE(dev1->startConfigSequence(std::move(sequence3)));
+	bus.handleMessage(tcan_can::CanMsg{0x581, {0x80, 0x60, 0x60, 0x00, 0x30, 0x00, 0x09, 0x06}});
+	ASSERT_EQ(Sequence::Status::Failed, dev1->getConfigSequenceStatus());
+}
+
+TEST(can_bus, iso_tp_userspace) {
+	LinkedBus tester { synchronousOptions() };
+	LinkedBus ecu { synchronousOptions() };
+	tester.peer = &ecu;
+	ecu.peer = &tester;
+	const auto exchangeFrames = [&tester, &ecu]() { while(tester.writeAll() + ecu.writeAll() > 0) { } };
+
+	auto testerOptions = std::make_unique<tcan_can::IsoTpChannelOptions>(0x7E0, 0x7E8, "tester");
+	testerOptions->implementation_ = tcan_can::IsoTpChannelOptions::Implementation::Userspace;
+	testerOptions->padding_ = true;
+	testerOptions->maxMessageLength_ = 100;
+	auto ecuOptions = std::make_unique<tcan_can::IsoTpChannelOptions>(0x7E8, 0x7E0, "ecu");
+	ecuOptions->implementation_ = tcan_can::IsoTpChannelOptions::Implementation::Userspace;
+	ecuOptions->blockSize_ = 4;
+	auto testerChannel = tester.addDevice<tcan_can::IsoTpChannel>(std::move(testerOptions));
+	auto ecuChannel = ecu.addDevice<tcan_can::IsoTpChannel>(std::move(ecuOptions));
+	ASSERT_TRUE(testerChannel.second);
+	ASSERT_TRUE(ecuChannel.second);
+	ASSERT_FALSE(testerChannel.first->isKernelImplementation());
+
+	// single frame, padded
+	const std::vector<uint8_t> request{0x22, 0xF1, 0x90};
+	std::vector<uint8_t> received;
+	ASSERT_TRUE(testerChannel.first->startTransmission(request.data(), request.size()));
+	exchangeFrames();
+	ASSERT_TRUE(testerChannel.first->waitForTransmission(std::chrono::milliseconds(0)));
+	ASSERT_TRUE(ecuChannel.first->receive(received));
+	ASSERT_EQ(request, received);
+	ASSERT_EQ(8u, tester.frames.back().getLength());
+
+	// 1 first and 142 consecutive frames, with a flow control frame after the first frame and every 4 consecutive frames
+	std::vector<uint8_t> download(1000);
+	for(unsigned int i=0; i<download.size(); ++i) {
+		download[i] = static_cast<uint8_t>(i);
+	}
+	tester.frames.clear();
+	ASSERT_TRUE(testerChannel.first->startTransmission(download.data(), download.size()));
+	ASSERT_FALSE(testerChannel.first->startTransmission(request.data(), request.size()));
+	exchangeFrames();
+	ASSERT_TRUE(testerChannel.first->waitForTransmission(std::chrono::milliseconds(0)));
+	ASSERT_TRUE(ecuChannel.first->receive(received));
+	ASSERT_EQ(download, received);
+	ASSERT_EQ(143u, tester.frames.size());
+	ASSERT_EQ(36u, ecu.frames.size());
+	ASSERT_FALSE(ecuChannel.first->receive(received));
+
+	// messages longer than maxMessageLength_ are rejected by the receiver
+	ASSERT_TRUE(ecuChannel.first->startTransmission(download.data(), 200));
+	exchangeFrames();
+	ASSERT_FALSE(ecuChannel.first->waitForTransmission(std::chrono::milliseconds(0)));
+	ASSERT_FALSE(testerChannel.first->receive(received));
+	ASSERT_EQ(1u, ecuChannel.first->getNumFailedTransfers());
+	ASSERT_EQ(1u, testerChannel.first->getNumFailedTransfers());
+
+	// STmin byte of the flow control frames
+	ASSERT_EQ(0x00, tcan_can::IsoTpChannel::encodeSeparationTime(0));
+	ASSERT_EQ(0xF1, tcan_can::IsoTpChannel::encodeSeparationTime(50));
+	ASSERT_EQ(0xF9, tcan_can::IsoTpChannel::encodeSeparationTime(900));
+	ASSERT_EQ(0x02, tcan_can::IsoTpChannel::encodeSeparationTime(1500));
+	ASSERT_EQ(0x7F, tcan_can::IsoTpChannel::encodeSeparationTime(500000));
+	ASSERT_EQ(300u, tcan_can::IsoTpChannel::decodeSeparationTime(0xF3));
+	ASSERT_EQ(20000u, tcan_can::IsoTpChannel::decodeSeparationTime(0x14));
+	ASSERT_EQ(127000u, tcan_can::IsoTpChannel::decodeSeparationTime(0xFA));
+}
+
+TEST(can_bus, iso_tp_userspace_window) {
+	VirtualTime virtualTime;
+
+	auto testerBusOptions = synchronousOptions();
+	testerBusOptions->maxQueueSize_ = 4;
+	testerBusOptions->transmitLimits_.emplace(0x7E0, tcan_can::TransmitLimit{50});
+	LinkedBus tester { std::move(testerBusOptions) };
+	LinkedBus ecu { synchronousOptions() };
+	tester.peer = &ecu;
+	ecu.peer = &tester;
+
+	auto testerOptions = std::make_unique<tcan_can::IsoTpChannelOptions>(0x7E0, 0x7E8, "tester");
+	testerOptions->implementation_ = tcan_can::IsoTpChannelOptions::Implementation::Userspace;
+	testerOptions->maxQueuedFrames_ = 2;
+	auto ecuOptions = std::make_unique<tcan_can::IsoTpChannelOptions>(0x7E8, 0x7E0, "ecu");
+	ecuOptions->implementation_ = tcan_can::IsoTpChannelOptions::Implementation::Userspace;
+	ecuOptions->separationTime_ = 1000;
+	auto testerChannel = tester.addDevice<tcan_can::IsoTpChannel>(std::move(testerOptions));
+	auto ecuChannel = ecu.addDevice<tcan_can::IsoTpChannel>(std::move(ecuOptions));
+	ASSERT_TRUE(testerChannel.second);
+	ASSERT_TRUE(ecuChannel.second);
+
+	// 142 consecutive frames without block size pass through an output queue of 4 messages, 1ms apart
+	std::vector<uint8_t> download(1000);
+	for(unsigned int i=0; i<download.size(); ++i) {
+		download[i] = static_cast<uint8_t>(i);
+	}
+	const auto start = tcan::Clock::now();
+	ASSERT_TRUE(testerChannel.first->startTransmission(download.data(), download.size()));
+	for(unsigned int i=0; i<1000 && !testerChannel.first->waitForTransmission(std::chrono::milliseconds(0)); ++i) {
+		while(tester.writeAll() + ecu.writeAll() > 0) { }
+		tcan::Clock::advance(std::chrono::milliseconds(1));
+	}
+	ASSERT_TRUE(testerChannel.first->waitForTransmission(std::chrono::milliseconds(0)));
+	std::vector<uint8_t> received;
+	ASSERT_TRUE(ecuChannel.first->receive(received));
+	ASSERT_EQ(download, received);
+	ASSERT_EQ(143u, tester.frames.size());
+	ASSERT_LE(std::chrono::milliseconds(141), tcan::Clock::now() - start);
+
+	// the transmit limit of the application is restored after the transfer
+	tcan_can::TransmitLimit limit;
+	ASSERT_TRUE(tester.getTransmitLimit(0x7E0, limit));
+	ASSERT_EQ(50u, limit.inhibitTime_);
+	ASSERT_FALSE(ecu.getTransmitLimit(0x7E8, limit));
+}
+
+// LSS slaves (CiA 305) answering the requests written to the bus
+struct LssSlaveBus : public IdleBus {
+	using IdleBus::IdleBus;
+
+	struct Slave {
+		uint32_t address[4];
+		uint8_t nodeId;
+		uint8_t pendingNodeId;
+		uint8_t bitTiming;
+		uint8_t lssPos;
+		bool isConfigurationState;
+	};
+
+	void addSlave(const tcan_can::LssAddress& address, const uint8_t nodeId = 0xFF) {
+		slaves.push_back(Slave{{address.vendorId_, address.productCode_, address.revisionNumber_, address.serialNumber_}, nodeId, nodeId, 0xFF, 0, false});
+	}
+
+	std::vector<Slave> slaves;
+
+protected:
+	bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) override {
+		const tcan_can::CanMsg request = outgoingMsgs_.front();
+		outgoingMsgs_.pop_front();
+		// the answers are dispatched like received frames, without the output queue locked
+		lock->unlock();
+		for(Slave& slave : slaves) {
+			answer(slave, request.getData());
+		}
+		lock->lock();
+		return true;
+	}
+
+	void answer(Slave& slave, const uint8_t* data) {
+		const uint32_t value = data[1] | (data[2] << 8) | (data[3] << 16) | (static_cast<uint32_t>(data[4]) << 24);
+		switch(data[0]) {
+			case 0x04: // switch state global
+				slave.isConfigurationState = (data[1] == 1);
+				slave.nodeId = slave.pendingNodeId;
+				break;
+			case 0x11: // configure node-ID
+			case 0x13: // configure bit timing
+			case 0x17: // store configuration
+				if(slave.isConfigurationState) {
+					if(data[0] == 0x11) {
+						slave.pendingNodeId = data[1];
+					}else if(data[0] == 0x13) {
+						slave.bitTiming = data[2];
+					}
+					reply({data[0], 0});
+				}
+				break;
+			case 0x4C: // identify non-configured slaves
+				if(slave.nodeId == 0xFF) {
+					reply({0x50});
+				}
+				break;
+			case 0x51: // Fastscan
+				if(slave.nodeId != 0xFF || slave.isConfigurationState) {
+					break;
+				}
+				if(data[5] == 0x80) {
+					slave.lssPos = 0;
+					reply({0x4F});
+				}else if(data[6] == slave.lssPos && ((value ^ slave.address[data[6]]) >> data[5]) == 0) {
+					// a complete match which wraps around to the vendor-ID switches to the configuration state
+					reply({0x4F});
+					slave.lssPos = data[7];
+					slave.isConfigurationState = (data[5] == 0 && data[7] < data[6]);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	void reply(const std::initializer_list<uint8_t> data) {
+		handleMessage(tcan_can::CanMsg(tcan_can::LssMaster::RxId, data));
+	}
+};
+
+TEST(can_bus, lss_fastscan) {
+	auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+	options->sanityCheckInterval_ = 0;
+	LssSlaveBus bus { std::move(options) };
+	bus.addSlave({0x29A, 0x30001, 0x10002, 0x12345678});
+	bus.addSlave({0x29A, 0x30001, 0x10002, 0x12345600});
+	bus.addSlave({0x29A, 0x20001, 0x10000, 0xDEADBEEF});
+	bus.addSlave({0x29A, 0x10001, 0x10000, 0x1}, 5);
+	auto masterOptions = std::make_unique<tcan_can::LssMasterOptions>();
+	masterOptions->fastscanTimeout_ = 1;
+	auto master = bus.addDevice<tcan_can::LssMaster>(std::move(masterOptions));
+	ASSERT_TRUE(master.second);
+	bus.startThreads();
+
+	// the slaves are found in the order of their addresses, the slave with node-ID does not take part
+	ASSERT_TRUE(master.first->identifyUnconfiguredSlaves());
+	std::vector<tcan_can::LssSlave> configured;
+	uint8_t nextNodeId = 10;
+	ASSERT_TRUE(master.first->configureUnconfiguredSlaves([&nextNodeId](const tcan_can::LssAddress&) { return nextNodeId++; }, configured));
+	ASSERT_EQ(3u, configured.size());
+	ASSERT_EQ((tcan_can::LssAddress{0x29A, 0x20001, 0x10000, 0xDEADBEEF}), configured[0].address_);
+	ASSERT_EQ((tcan_can::LssAddress{0x29A, 0x30001, 0x10002, 0x12345600}), configured[1].address_);
+	ASSERT_EQ((tcan_can::LssAddress{0x29A, 0x30001, 0x10002, 0x12345678}), configured[2].address_);
+	ASSERT_EQ((std::vector<uint8_t>{12, 11, 10, 5}), (std::vector<uint8_t>{bus.slaves[0].nodeId, bus.slaves[1].nodeId, bus.slaves[2].nodeId, bus.slaves[3].nodeId}));
+	ASSERT_EQ(3u * 133u + 1u, master.first->getNumFastscanSteps());
+	ASSERT_FALSE(master.first->identifyUnconfiguredSlaves());
+
+	ASSERT_TRUE(master.first->configureBitRateOfAllSlaves(tcan_can::LssMaster::BitRate::Kbps500, 10));
+	for(const auto& slave : bus.slaves) {
+		ASSERT_EQ(static_cast<uint8_t>(tcan_can::LssMaster::BitRate::Kbps500), slave.bitTiming);
+	}
+	bus.stopThreads();
+}
+
 int main(int argc, char* argv[]) {
 	testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
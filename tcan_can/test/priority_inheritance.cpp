@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <pthread.h>
+#include <thread>
+
+#include <tcan_can/SocketBus.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// switches the calling thread to SCHED_FIFO on CPU 0, such that the test threads compete for the same CPU
+bool makeRealtime(const int priority) {
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(0, &cpuSet);
+	sched_param sched;
+	sched.sched_priority = priority;
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0 &&
+		   pthread_setschedparam(pthread_self(), SCHED_FIFO, &sched) == 0;
+}
+
+void spinUntil(const Clock::time_point& time) {
+	while(Clock::now() < time) {
+	}
+}
+
+} // anonymous namespace
+
+// A low-priority thread holds the output queue mutex and is preempted by a medium-priority thread which does not use the mutex.
+// Without priority inheritance, the high-priority thread calling sendMessage() is blocked until the medium-priority thread finishes.
+TEST(priority_inheritance, bounded_blocking_of_output_queue) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+
+	const Clock::time_point start = Clock::now() + std::chrono::milliseconds(50);
+	const std::chrono::milliseconds lowHoldTime(20);
+	const std::chrono::milliseconds mediumSpinTime(200);
+
+	std::atomic<bool> isRealtime{true};
+	std::atomic<bool> lowHasLock{false};
+	Clock::duration highBlockingTime{0};
+
+	std::thread low([&]() {
+		if(!makeRealtime(10)) {
+			isRealtime = false;
+		}
+		std::this_thread::sleep_until(start);
+		std::lock_guard<tcan::PriorityInheritanceMutex> guard(bus.getOutgoingMsgsMutex());
+		lowHasLock = true;
+		spinUntil(start + lowHoldTime);
+	});
+
+	std::thread medium([&]() {
+		if(!makeRealtime(50)) {
+			isRealtime = false;
+		}
+		std::this_thread::sleep_until(start + std::chrono::milliseconds(5));
+		spinUntil(start + mediumSpinTime);
+	});
+
+	std::thread high([&]() {
+		if(!makeRealtime(90)) {
+			isRealtime = false;
+		}
+		std::this_thread::sleep_until(start + std::chrono::milliseconds(10));
+		const Clock::time_point lockStart = Clock::now();
+		bus.sendMessage(tcan_can::CanMsg(0x123));
+		highBlockingTime = Clock::now() - lockStart;
+	});
+
+	low.join();
+	medium.join();
+	high.join();
+
+	if(!isRealtime) {
+		GTEST_SKIP() << "SCHED_FIFO is not permitted";
+	}
+
+	ASSERT_TRUE(lowHasLock);
+	EXPECT_EQ(bus.getNumOutgoingMessagesWithoutLock(), 1u);
+
+	// with priority inheritance, the low-priority thread finishes its critical section at the priority of the high-priority thread
+	// (without it, the high-priority thread is blocked for almost mediumSpinTime)
+	const auto blockingTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(highBlockingTime).count();
+	EXPECT_LT(blockingTimeMs, lowHoldTime.count() + 30);
+}
+
+int main(int argc, char* argv[]) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
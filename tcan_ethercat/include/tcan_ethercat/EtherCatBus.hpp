@@ -21,6 +21,7 @@
 #include <soem/soem/ethercat.h>
 
 #include "tcan/Bus.hpp"
+#include "tcan/CallbackProfile.hpp"
 #include "tcan_ethercat/EtherCatBusOptions.hpp"
 #include "tcan_ethercat/EtherCatSlave.hpp"
 
@@ -115,9 +116,23 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
     inline bool addSlave(EtherCatSlave* slave) {
         // assign the slave some id to calculate the offset in ethernet frame address
         slaves_.push_back(slave);
+        if (deviceStateTable_ != nullptr) {
+            slave->setStateTableInternal(deviceStateTable_);
+        }
         return slave->initDeviceInternal(this);
     }
 
+    /*!
+     * Register the slaves in a state table, see tcan::Bus::setDeviceStateTable(..).
+     * @param table State table, nullptr to unregister the slaves.
+     */
+    void setDeviceStateTable(tcan::DeviceStateTable* table) override {
+        deviceStateTable_ = table;
+        for (EtherCatSlave* slave : slaves_) {
+            slave->setStateTableInternal(table);
+        }
+    }
+
     /*!
      * Add a TxPDO callback method. Every slave can only register one callback method.
      * @param slave    Slave to call method from.
@@ -126,7 +141,38 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
      */
     template <class T>
     inline bool addTxPdoCallback(T* slave, bool(std::common_type<T>::type::*function)(const EtherCatDatagram&)) {
-        return txPdoCallbackMap_.emplace(slave, std::bind(function, slave, std::placeholders::_1)).second;
+        if (!txPdoCallbackMap_.emplace(slave, std::bind(function, slave, std::placeholders::_1)).second) {
+            return false;
+        }
+        if (options_->profileCallbacks_) {
+            callbackProfiles_.emplace(slave, std::make_shared<tcan::CallbackProfile>(std::chrono::microseconds(options_->slowCallbackThreshold_)));
+        }
+        return true;
+    }
+
+    /*!
+     * Execution time profile of the TxPDO callback of a slave (see BusOptions::profileCallbacks_).
+     * @param slave Slave the callback was added for.
+     * @return Profile, nullptr if profiling is disabled or the slave has no callback.
+     */
+    std::shared_ptr<tcan::CallbackProfile> getCallbackProfile(EtherCatSlave* slave) const {
+        auto profile = callbackProfiles_.find(slave);
+        return (profile != callbackProfiles_.end()) ? profile->second : nullptr;
+    }
+
+    /*!
+     * Formats the execution time histograms of the TxPDO callbacks. Allocates, do not call from a real-time thread.
+     * @return Report, empty if profiling is disabled.
+     */
+    std::string getCallbackProfileReport() const {
+        if (!options_->profileCallbacks_) {
+            return std::string();
+        }
+        std::string report = "Callback execution times on bus " + options_->name_ + ":";
+        for (const auto& profile : callbackProfiles_) {
+            report += "\n  slave " + profile.first->getName() + ": " + profile.second->getHistogram().getSummary();
+        }
+        return report;
     }
 
     /*!
@@ -527,7 +573,13 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
             slave->resetDeviceTimeoutCounter();
             auto callback = txPdoCallbackMap_.find(slave);
             if (callback != txPdoCallbackMap_.end()) {
-                callback->second(msg.rxAndTxPdoDatagrams_.at(slave->getAddress()).second); //TODO improve access
+                tcan::CallbackProfile* profile = nullptr;
+                if (options_->profileCallbacks_) {
+                    auto it = callbackProfiles_.find(slave);
+                    profile = (it != callbackProfiles_.end()) ? it->second.get() : nullptr;
+                }
+                // a slave has a single callback, so the callback profile is also the profile of the slave
+                tcan::callProfiled(callback->second, profile, nullptr, msg.rxAndTxPdoDatagrams_.at(slave->getAddress()).second); //TODO improve access
             }
         }
     }
@@ -556,7 +608,7 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
      * Write datagrams to the device driver.
      * @return True the data has been written successfully.
      */
-    bool writeData(std::unique_lock<std::mutex>* lock) override {
+    bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) override {
         // Copy the datagrams to send to the sent datagrams.
         sentDatagrams_.reset(new EtherCatDatagrams(outgoingMsgs_.front()));
         if (lock != nullptr) {
@@ -688,6 +740,16 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
         allDevicesActive_ = allActive;
         allDevicesMissing_ = allMissing;
 
+        if (options_->slowCallbackThreshold_ > 0) {
+            for (const auto& profile : callbackProfiles_) {
+                const unsigned int numNewSlowCalls = profile.second->takeNumNewSlowCalls();
+                if (numNewSlowCalls > 0) {
+                    MELO_WARN("TxPDO callback of slave %s on bus %s exceeded %u us %u times (longest call %.1f us).", profile.first->getName().c_str(),
+                              options_->name_.c_str(), options_->slowCallbackThreshold_, numNewSlowCalls, profile.second->getMaxSlowCallDuration());
+                }
+            }
+        }
+
         return !(isMissingOrError || hasBusError_);
     }
 
@@ -858,6 +920,12 @@ protected:
     // Map mapping COB id to parse functions.
     TxPdoCallbackMap txPdoCallbackMap_;
 
+    // Execution time profiles of the callbacks, if BusOptions::profileCallbacks_ is set.
+    std::unordered_map<EtherCatSlave*, std::shared_ptr<tcan::CallbackProfile>> callbackProfiles_;
+
+    // State table the slaves are registered in, see setDeviceStateTable(..).
+    tcan::DeviceStateTable* deviceStateTable_ = nullptr;
+
     // Datagrams staged for sending.
     std::shared_ptr<EtherCatDatagrams> stagedDatagrams_;
     // Datagrams which have been sent.
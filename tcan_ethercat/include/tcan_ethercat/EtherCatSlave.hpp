@@ -6,6 +6,8 @@
 
 #include "tcan_ethercat/EtherCatSlaveOptions.hpp"
 #include "tcan_ethercat/EtherCatDatagram.hpp"
+#include "tcan/DeviceStateTable.hpp"
+#include "tcan/probes.hpp"
 
 #include "message_logger/message_logger.hpp"
 
@@ -70,7 +72,7 @@ class EtherCatSlave {
     virtual bool sanityCheck() {
         if(!isMissing()) {
             if(isTimedOut()) {
-                state_ = Missing;
+                setState(Missing);
                 MELO_WARN("Slave %s timed out!", getName().c_str());
             }
         }
@@ -139,6 +141,26 @@ class EtherCatSlave {
         deviceTimeoutCounter_ = 0;
     }
 
+    /*!
+     * Registers the slave in a state table, which is updated with getState() on every state change, or unregisters it.
+     * This function is automatically called by the bus, see tcan::Bus::setDeviceStateTable(..).
+     * @param table State table, nullptr to unregister the slave.
+     */
+    inline void setStateTableInternal(tcan::DeviceStateTable* table) {
+        const int slot = stateSlot_.exchange(-1);
+        if (slot >= 0) {
+            stateTable_->unregisterDevice(slot);
+        }
+        if (table != nullptr) {
+            stateTable_ = table;
+            const int newSlot = table->registerDevice(getName(), getState());
+            if (newSlot < 0) {
+                MELO_WARN("Device state table is full, state of slave %s is not published.", getName().c_str());
+            }
+            stateSlot_ = newSlot;
+        }
+    }
+
     /*!
      * Synchronize the distribute clock.
      * @param activate True to activate, false to deactivate.
@@ -168,6 +190,27 @@ class EtherCatSlave {
     bool sendSdoRead(const uint16_t index, const uint8_t subindex, const bool completeAccess, Value& value);
 
  protected:
+    /*!
+     * Set the state of the slave. Fires the device_state probe (see tcan/probes.hpp) and updates the state table if the state changed.
+     * @param state New state.
+     */
+    inline void setState(const State state) {
+        if (state_.exchange(state) != state) {
+            TCAN_PROBE3(device_state, options_->name_.c_str(), options_->address_, static_cast<int>(state));
+            updateStateTable();
+        }
+    }
+
+    /*!
+     * Write getState() to the state table. Call it if getState() changes without a change of the state.
+     */
+    inline void updateStateTable() {
+        const int slot = stateSlot_;
+        if (slot >= 0) {
+            stateTable_->setState(slot, getState());
+        }
+    }
+
     /*!
      * Check if the device is timed out.
      * @return True if the device timed out.
@@ -189,6 +232,10 @@ class EtherCatSlave {
 
     //! Pointer to the EtherCat bus the device is connected to.
     EtherCatBus* bus_ = nullptr;
+
+    //! State table the slave is registered in, see setStateTableInternal(..). stateSlot_ is -1 if the slave is not registered.
+    tcan::DeviceStateTable* stateTable_ = nullptr;
+    std::atomic<int> stateSlot_{-1};
 };
 
 } /* namespace tcan_ethercat */
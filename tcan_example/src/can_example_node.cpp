@@ -1,6 +1,8 @@
 #include <chrono>
 #include <signal.h>
 
+#include "tcan/CycleRunner.hpp"
+
 #include "tcan_example/CanDeviceExample.hpp"
 #include "tcan_example/CanManagerExample.hpp"
 
@@ -17,13 +19,12 @@ int main() {
 	tcan_example::CanManagerExample canManager_;
 	canManager_.init();
 
-	auto nextStep = std::chrono::steady_clock::now();
-
-	while(g_running) {
-		// these two calls affect synchronous buses only, BUS3 in this case
-		canManager_.readMessagesSynchronous();
-		canManager_.sanityCheckSynchronous();
+	tcan::CycleRunnerOptions runnerOptions(100000);
+	runnerOptions.overrunPolicy_ = tcan::CycleRunnerOptions::OverrunPolicy::Skip;
+	tcan::CycleRunner<tcan_can::CanMsg> runner(canManager_, runnerOptions);
 
+	// the runner reads and sanity checks the synchronous buses (BUS3 in this case), calls this function and writes the output queues
+	runner.setCycleCallback([&canManager_]() {
 		for(auto device : canManager_.getDeviceExampleContainer()) {
 //			MELO_INFO_STREAM("Measurement " << device.second->getName() << " = " << device.second->getMeasurement());
 			device.second->setCommand(0.f);
@@ -32,13 +33,20 @@ int main() {
 		// write the messages on the synchronous and semi-synchronous buses.
 		canManager_.writeMessagesSynchronous();
 
-      	canManager_.sendSyncOnAllBuses(true); 	// call this function after writeMessagesSynchronous() for synchronous and semi-synchonous buses,
+		canManager_.sendSyncOnAllBuses(true); 	// call this function after writeMessagesSynchronous() for synchronous and semi-synchonous buses,
 												// to ensure that the output queues are empty such that the SYNC messages can be put
-												// on all buses at the same time
-		canManager_.writeMessagesSynchronous(); // now write the SYNC messages to the synchronous and semi-synchronous buses
+												// on all buses at the same time. The SYNC messages are written by the runner.
+	});
 
-		nextStep += std::chrono::microseconds(100000);
-		std::this_thread::sleep_until( nextStep );
+	runner.start();
+	while(g_running) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	}
+	runner.stop();
+
+	const tcan::CycleStatistics statistics = runner.getStatistics();
+	MELO_INFO("cycles: %u, overruns: %u, skipped: %u", statistics.numCycles_, statistics.numOverruns_, statistics.numSkippedCycles_);
+	MELO_INFO("wakeup latency: %s", statistics.wakeupLatency_.getSummary().c_str());
+	MELO_INFO("total:          %s", statistics.total_.getSummary().c_str());
 	return 0;
 }
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <signal.h>
+
+#include "tcan_can/SocketBus.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+// Sends four time-triggered RxPDOs per 1ms cycle and prints the slot timing accuracy on exit.
+// Usage: can_schedule_example_node [interface], e.g. after "rosrun tcan_utils vcan.sh start vcan0"
+
+std::atomic<bool> g_running{true};
+
+void signal_handler(int) {
+	g_running = false;
+}
+
+int main(int argc, char** argv) {
+	signal(SIGINT, signal_handler);
+
+	std::unique_ptr<tcan_can::SocketBusOptions> options(new tcan_can::SocketBusOptions(argc > 1 ? argv[1] : "vcan0"));
+	options->mode_ = tcan::BusOptions::Mode::Asynchronous;
+	options->scheduleReference_ = tcan_can::TransmitSchedule::Reference::Cycle;
+	options->scheduleCycleTime_ = 1000;
+
+	tcan_can::SocketBus bus(std::move(options));
+	if(!bus.initBus()) {
+		return 1;
+	}
+
+	constexpr unsigned int numSlots = 4;
+	for(unsigned int i=0; i<numSlots; i++) {
+		bus.addScheduleSlot(100 + 200*i, tcan_can::CanMsg(0x201 + i, {0, 0, 0, 0}));
+	}
+
+	bus.startThreads();
+	bus.startSchedule();
+
+	// update the payloads at the application rate, the slots are sent by the transmit thread
+	uint32_t counter = 0;
+	auto nextStep = std::chrono::steady_clock::now();
+	while(g_running) {
+		for(unsigned int i=0; i<numSlots; i++) {
+			tcan_can::CanMsg msg(0x201 + i);
+			msg.write(counter);
+			bus.setScheduleSlotMessage(i, msg);
+		}
+		++counter;
+
+		nextStep += std::chrono::milliseconds(10);
+		std::this_thread::sleep_until(nextStep);
+	}
+
+	bus.stopSchedule();
+
+	for(unsigned int i=0; i<numSlots; i++) {
+		tcan_can::ScheduleSlotStatistics statistics;
+		bus.getScheduleSlotStatistics(i, statistics);
+		MELO_INFO("slot %u: sent %u, lateness [us] min %.1f / mean %.1f / max %.1f", i, statistics.numSent_,
+				  statistics.minLateness_, statistics.meanLateness_, statistics.maxLateness_);
+	}
+	MELO_INFO("skipped slots: %u", bus.getNumSkippedScheduleSlots());
+
+	return 0;
+}
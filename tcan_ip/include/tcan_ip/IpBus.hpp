@@ -24,7 +24,11 @@ class IpBus : public tcan::Bus<IpMsg> {
 protected:
     bool initializeInterface() override;
     bool readData() override;
-    bool writeData(std::unique_lock<std::mutex>* lock) override;
+    bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) override;
+
+    bool initializeIoUringEndpoint(tcan::IoUringEngine::Endpoint& endpoint) override;
+    void handleIoUringData(uint8_t* data, const unsigned int length) override;
+    int encodeIoUringMessage(const IpMsg& msg, uint8_t* buffer, const unsigned int capacity) override;
 
  private:
     int socket_;
@@ -32,6 +36,10 @@ protected:
     int sendFlag_;
 
     unsigned int deviceTimeoutCounter_;
+
+    //! last received and last written message. Reused, such that the cyclic path only allocates for payloads larger than all before.
+    IpMsg receivedMsg_;
+    IpMsg writtenMsg_;
 };
 
 } /* namespace tcan_ip */
@@ -19,7 +19,9 @@ IpBus::IpBus(std::unique_ptr<IpBusOptions>&& options):
 	socket_(-1),
 	recvFlag_(0),
 	sendFlag_(0),
-    deviceTimeoutCounter_(0)
+    deviceTimeoutCounter_(0),
+    receivedMsg_(),
+    writtenMsg_()
 {
 }
 
@@ -105,13 +107,16 @@ bool IpBus::readData() {
     }
 
     hasBusError_ = false;
-    handleMessage( IpMsg(bytes_read, buf) );
+    receivedMsg_.assign(bytes_read, buf);
+    handleMessage( receivedMsg_ );
     return true;
 }
 
-bool IpBus::writeData(std::unique_lock<std::mutex>* lock) {
+bool IpBus::writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) {
 
-    IpMsg msg = outgoingMsgs_.front();
+    // the queue may change while it is unlocked
+    IpMsg& msg = writtenMsg_;
+    msg = outgoingMsgs_.front();
     if(lock != nullptr) {
         lock->unlock();
     }
@@ -137,4 +142,25 @@ bool IpBus::writeData(std::unique_lock<std::mutex>* lock) {
     return true;
 }
 
+bool IpBus::initializeIoUringEndpoint(tcan::IoUringEngine::Endpoint& endpoint) {
+    endpoint.fileDescriptor_ = socket_;
+    endpoint.isSocket_ = true;
+    endpoint.receiveBufferSize_ = maxMessageSize;
+    endpoint.transmitBufferSize_ = maxMessageSize;
+    return true;
+}
+
+void IpBus::handleIoUringData(uint8_t* data, const unsigned int length) {
+    receivedMsg_.assign(length, data);
+    handleMessage( receivedMsg_ );
+}
+
+int IpBus::encodeIoUringMessage(const IpMsg& msg, uint8_t* buffer, const unsigned int capacity) {
+    if(msg.getLength() > capacity) {
+        return -1;
+    }
+    std::copy(msg.getData(), msg.getData() + msg.getLength(), buffer);
+    return msg.getLength();
+}
+
 } /* namespace tcan_ip */
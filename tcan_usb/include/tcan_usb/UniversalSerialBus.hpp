@@ -2,6 +2,7 @@
 
 #include <termios.h> // tcgettatr
 #include <memory>
+#include <vector>
 
 #include "tcan/Bus.hpp"
 #include "tcan_usb/UniversalSerialBusOptions.hpp"
@@ -23,7 +24,12 @@ class UniversalSerialBus : public tcan::Bus<UsbMsg> {
 protected:
     bool initializeInterface() override;
     bool readData() override;
-    bool writeData(std::unique_lock<std::mutex>* lock) override;
+    bool writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) override;
+
+    //! Makes the file descriptor blocking, the engine waits for it in the kernel
+    bool initializeIoUringEndpoint(tcan::IoUringEngine::Endpoint& endpoint) override;
+    void handleIoUringData(uint8_t* data, const unsigned int length) override;
+    int encodeIoUringMessage(const UsbMsg& msg, uint8_t* buffer, const unsigned int capacity) override;
 
  private:
     void configureInterface();
@@ -34,6 +40,13 @@ protected:
     termios savedAttributes_;
 
     unsigned int deviceTimeoutCounter_;
+
+    //! receive buffer of UniversalSerialBusOptions::bufferSize bytes plus terminating \0, allocated once
+    std::vector<uint8_t> readBuffer_;
+
+    //! last received and last written message. Reused, such that the cyclic path only allocates for payloads larger than all before.
+    UsbMsg receivedMsg_;
+    UsbMsg writtenMsg_;
 };
 
 } /* namespace tcan_usb */
@@ -14,7 +14,10 @@ namespace tcan_usb {
 UniversalSerialBus::UniversalSerialBus(std::unique_ptr<UniversalSerialBusOptions>&& options):
     tcan::Bus<UsbMsg>(std::move(options)),
     fileDescriptor_(0),
-    deviceTimeoutCounter_(0)
+    deviceTimeoutCounter_(0),
+    readBuffer_(static_cast<const UniversalSerialBusOptions*>(options_.get())->bufferSize + 1),
+    receivedMsg_(),
+    writtenMsg_()
 {
 }
 
@@ -83,8 +86,8 @@ bool UniversalSerialBus::readData() {
         }
     }
 
-    const unsigned int bufSize = static_cast<const UniversalSerialBusOptions*>(options_.get())->bufferSize;
-    std::vector<uint8_t> buf(bufSize+1); // +1 to have space for terminating \0
+    std::vector<uint8_t>& buf = readBuffer_;
+    const unsigned int bufSize = buf.size() - 1; // -1 to have space for terminating \0
     const int bytes_read = read( fileDescriptor_, buf.data(), bufSize);
     //  printf("CanManager_ bytes read: %i\n", bytes_read);
 
@@ -100,14 +103,17 @@ bool UniversalSerialBus::readData() {
 
     hasBusError_ = false;
     buf[bytes_read] = '\0';
-    handleMessage( UsbMsg(bytes_read, buf.data()) );
+    receivedMsg_.assign(bytes_read, buf.data());
+    handleMessage( receivedMsg_ );
 
     return true;
 }
 
-bool UniversalSerialBus::writeData(std::unique_lock<std::mutex>* lock) {
+bool UniversalSerialBus::writeData(std::unique_lock<tcan::PriorityInheritanceMutex>* lock) {
 
-    UsbMsg msg = outgoingMsgs_.front();
+    // the queue may change while it is unlocked
+    UsbMsg& msg = writtenMsg_;
+    msg = outgoingMsgs_.front();
     if(lock != nullptr) {
         lock->unlock();
     }
@@ -145,6 +151,37 @@ bool UniversalSerialBus::writeData(std::unique_lock<std::mutex>* lock) {
     return false;
 }
 
+bool UniversalSerialBus::initializeIoUringEndpoint(tcan::IoUringEngine::Endpoint& endpoint) {
+    // io_uring completes reads of non-blocking files with EAGAIN instead of waiting for data
+    int flags;
+    if( (flags = fcntl(fileDescriptor_, F_GETFL, 0)) == -1 || fcntl(fileDescriptor_, F_SETFL, flags & ~O_NONBLOCK) == -1) {
+        MELO_WARN("Failed to make the file descriptor of interface %s blocking:\n  %s", options_->name_.c_str(), strerror(errno));
+        return false;
+    }
+
+    const unsigned int bufferSize = static_cast<const UniversalSerialBusOptions*>(options_.get())->bufferSize;
+    endpoint.fileDescriptor_ = fileDescriptor_;
+    endpoint.isSocket_ = false;
+    endpoint.receiveBufferSize_ = bufferSize;
+    endpoint.transmitBufferSize_ = bufferSize;
+    return true;
+}
+
+void UniversalSerialBus::handleIoUringData(uint8_t* data, const unsigned int length) {
+    // the engine leaves a spare byte after the data
+    data[length] = '\0';
+    receivedMsg_.assign(length, data);
+    handleMessage( receivedMsg_ );
+}
+
+int UniversalSerialBus::encodeIoUringMessage(const UsbMsg& msg, uint8_t* buffer, const unsigned int capacity) {
+    if(msg.getLength() > capacity) {
+        return -1;
+    }
+    std::copy(msg.getData(), msg.getData() + msg.getLength(), buffer);
+    return msg.getLength();
+}
+
 
 /** code from CuteCom */
 void UniversalSerialBus::configureInterface()